@@ -14,6 +14,7 @@
 #include <appbase/application.hpp>
 
 #include <hive/utilities/io_primitives.hpp>
+#include <hive/utilities/performance_metrics.hpp>
 
 #include <boost/thread/mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
@@ -377,6 +378,10 @@ namespace hive { namespace chain {
       if (block_num == head_block->get_block_num())
         return head_block;
 
+      static const hive::utilities::performance_metrics::histogram_id read_metric_id =
+        hive::utilities::performance_metrics::instance().get_histogram_id("block_decoding", "read_block");
+      hive::utilities::performance_metrics::scoped_timer read_timer(read_metric_id);
+
       // if we're still here, we know that it's in the block log, and the block after it is also
       // in the block log (which means we can determine its size)
       std::tuple<std::unique_ptr<char[]>, size_t, block_log_artifacts::artifacts_t> raw_block_data = read_raw_block_data_by_num(block_num);
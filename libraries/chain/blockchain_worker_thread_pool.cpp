@@ -24,6 +24,18 @@ struct blockchain_worker_thread_pool::impl
 
   public:
 
+  // task shared by calling thread and helpers; helpers that come late (after caller finished) skip it
+  struct parallel_task_type
+  {
+    explicit parallel_task_type(const std::function<void()>& _task) : task(_task) {}
+
+    const std::function<void()>& task;
+    std::mutex mutex;
+    std::condition_variable finished_condition;
+    uint32_t running_helpers = 0;
+    bool closed = false;
+  };
+
   struct work_request_type
   {
     struct transaction_work_request_type
@@ -31,7 +43,7 @@ struct blockchain_worker_thread_pool::impl
       std::weak_ptr<full_transaction_type> full_transaction;
       std::optional<uint32_t> block_number; // if this transaction was received in a block, it's number
     };
-    std::variant<std::weak_ptr<full_block_type>, transaction_work_request_type> block_or_transaction;
+    std::variant<std::weak_ptr<full_block_type>, transaction_work_request_type, std::shared_ptr<parallel_task_type>> block_or_transaction;
     blockchain_worker_thread_pool::data_source_type data_source;
   };
   typedef boost::lockfree::queue<work_request_type*> queue_type;
@@ -66,6 +78,7 @@ struct blockchain_worker_thread_pool::impl
 
   void perform_work(const std::weak_ptr<full_block_type>& full_block, data_source_type data_source);
   void perform_work(const work_request_type::transaction_work_request_type& transaction_work_request, data_source_type data_source);
+  void perform_work(const std::shared_ptr<parallel_task_type>& parallel_task, data_source_type data_source);
   void thread_function();
   void lazy_init( uint32_t new_thread_pool_size );
 };
@@ -386,6 +399,22 @@ void blockchain_worker_thread_pool::impl::perform_work(const work_request_type::
   }
 }
 
+void blockchain_worker_thread_pool::impl::perform_work(const std::shared_ptr<parallel_task_type>& parallel_task, data_source_type data_source)
+{
+  {
+    std::unique_lock<std::mutex> lock(parallel_task->mutex);
+    if (parallel_task->closed)
+      return;
+    ++parallel_task->running_helpers;
+  }
+  parallel_task->task();
+  {
+    std::unique_lock<std::mutex> lock(parallel_task->mutex);
+    --parallel_task->running_helpers;
+  }
+  parallel_task->finished_condition.notify_all();
+}
+
 namespace
 {
   blockchain_worker_thread_pool::impl::priority_type get_priority_for_block(blockchain_worker_thread_pool::data_source_type data_source)
@@ -486,6 +515,34 @@ void blockchain_worker_thread_pool::enqueue_work(const std::vector<std::shared_p
   my->work_queue_condition_variable.notify_all();
 }
 
+void blockchain_worker_thread_pool::run_in_parallel(const std::function<void()>& task, uint32_t helper_count)
+{
+  helper_count = my->allow_enqueue_work() ? std::min<uint32_t>(helper_count, my->threads.size()) : 0;
+  if (helper_count == 0)
+  {
+    task();
+    return;
+  }
+
+  auto parallel_task = std::make_shared<impl::parallel_task_type>(task);
+  {
+    std::unique_lock<std::mutex> lock(my->work_queue_mutex);
+    for (uint32_t i = 0; i < helper_count; ++i)
+    {
+      my->work_queues[(unsigned)impl::priority_type::high].push(new impl::work_request_type{parallel_task, data_source_type::parallel_task});
+      ++my->number_of_items_in_queue;
+    }
+  }
+  my->work_queue_condition_variable.notify_all();
+
+  task();
+
+  // helpers that did not start yet won't touch the task anymore; wait for those that did
+  std::unique_lock<std::mutex> lock(parallel_task->mutex);
+  parallel_task->closed = true;
+  parallel_task->finished_condition.wait(lock, [&]() { return parallel_task->running_helpers == 0; });
+}
+
 void blockchain_worker_thread_pool::set_p2p_force_validate()
 {
   my->p2p_force_validate = true;
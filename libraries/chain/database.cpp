@@ -38,6 +38,8 @@
 
 #include <hive/jsonball/jsonball.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #include <fc/smart_ref_impl.hpp>
 #include <fc/uint128.hpp>
 
@@ -47,6 +49,7 @@
 
 #include <boost/scope_exit.hpp>
 
+#include <atomic>
 #include <iostream>
 
 #include <cstdint>
@@ -106,6 +109,8 @@ FC_REFLECT( hive::chain::db_schema, (types)(object_types)(operation_type)(custom
 
 namespace hive { namespace chain {
 
+using hive::utilities::performance_metrics;
+
 struct reward_fund_context
 {
   uint128_t   recent_claims = 0;
@@ -113,7 +118,7 @@ struct reward_fund_context
   share_type  hive_awarded = 0;
 };
 
-class database_impl
+class database_impl : public chainbase::lock_observer
 {
   public:
     database_impl( database& self );
@@ -131,9 +136,60 @@ class database_impl
     // will happen if we get mismatched values
     std::atomic<uint32_t>                             _last_pushed_block_number = {0};
     std::atomic<uint32_t>                             _last_pushed_block_time = {0}; // the value from a time_point_sec
+
+    // performance metrics histograms of evaluators indexed by operation type (registered on first use)
+    performance_metrics::histogram_id get_evaluator_metric_id( const operation& op );
+    std::vector< performance_metrics::histogram_id >  _evaluator_metric_ids;
+
+    // performance metrics of chainbase lock
+    virtual void on_read_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) override;
+    virtual void on_write_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) override;
+    performance_metrics::histogram_id                 _read_lock_wait_metric_id;
+    performance_metrics::histogram_id                 _read_lock_hold_metric_id;
+    performance_metrics::histogram_id                 _write_lock_wait_metric_id;
+    performance_metrics::histogram_id                 _write_lock_hold_metric_id;
 };
 
-database_impl::database_impl( database& self ) : _self(self), _evaluator_registry(self) {}
+database_impl::database_impl( database& self ) : _self(self), _evaluator_registry(self),
+  _evaluator_metric_ids( operation::count(), std::numeric_limits< performance_metrics::histogram_id >::max() ),
+  _read_lock_wait_metric_id( performance_metrics::instance().get_histogram_id( "chain_lock", "read_wait" ) ),
+  _read_lock_hold_metric_id( performance_metrics::instance().get_histogram_id( "chain_lock", "read_hold" ) ),
+  _write_lock_wait_metric_id( performance_metrics::instance().get_histogram_id( "chain_lock", "write_wait" ) ),
+  _write_lock_hold_metric_id( performance_metrics::instance().get_histogram_id( "chain_lock", "write_hold" ) ) {}
+
+void database_impl::on_read_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time )
+{
+  auto& metrics = performance_metrics::instance();
+  if( metrics.is_enabled() )
+  {
+    metrics.record( _read_lock_wait_metric_id, wait_time.count() );
+    metrics.record( _read_lock_hold_metric_id, hold_time.count() );
+  }
+}
+
+void database_impl::on_write_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time )
+{
+  auto& metrics = performance_metrics::instance();
+  if( metrics.is_enabled() )
+  {
+    metrics.record( _write_lock_wait_metric_id, wait_time.count() );
+    metrics.record( _write_lock_hold_metric_id, hold_time.count() );
+  }
+}
+
+performance_metrics::histogram_id database_impl::get_evaluator_metric_id( const operation& op )
+{
+  auto& id = _evaluator_metric_ids[ op.which() ];
+  if( BOOST_UNLIKELY( id == std::numeric_limits< performance_metrics::histogram_id >::max() ) )
+  {
+    std::string name = _evaluator_registry.get_evaluator( op ).get_name( op );
+    auto pos = name.rfind( "::" );
+    if( pos != std::string::npos )
+      name.erase( 0, pos + 2 );
+    id = performance_metrics::instance().get_histogram_id( "evaluator", name );
+  }
+  return id;
+}
 
 void database_impl::register_new_type(util::abstract_type_registrar& r)
 {
@@ -148,7 +204,9 @@ void database_impl::delete_decoded_types_data_storage()
 
 database::database( appbase::application& app )
   : rc(*this), _my( new database_impl(*this) ), theApp( app )
-{}
+{
+  set_lock_observer( _my.get() );
+}
 
 void database::begin_type_register_process(util::abstract_type_registrar& r)
 {
@@ -166,12 +224,20 @@ void database::open( const open_args& args )
   {
     init_schema();
 
+    if( args.chainbase_flags & chainbase::database::read_only )
+    {
+      open_read_replica( args );
+      return;
+    }
+
     helpers::environment_extension_resources environment_extension(
                                                 theApp.get_version_string(),
                                                 theApp.get_plugins_names(),
                                                 []( const std::string& message ){ wlog( message.c_str() ); }
                                               );
     const bool wipe_shared_file = args.force_replay || args.load_snapshot;
+    set_mapping_options( args.shared_file_mapping );
+    set_max_replica_reader_wait( std::chrono::milliseconds( args.max_replica_reader_wait ) );
     chainbase::database::open( args.shared_mem_dir, args.chainbase_flags, args.shared_file_size, args.database_cfg, &environment_extension, wipe_shared_file );
     const bool throw_an_error_on_state_definitions_mismatch = chainbase::database::check_plugins(&environment_extension);
     initialize_state_independent_data(args, throw_an_error_on_state_definitions_mismatch);
@@ -181,6 +247,57 @@ void database::open( const open_args& args )
   FC_CAPTURE_LOG_AND_RETHROW( (args.data_dir)(args.shared_mem_dir)(args.shared_file_size) )
 }
 
+void database::open_read_replica( const open_args& args )
+{
+  FC_ASSERT( !args.force_replay && !args.load_snapshot && !args.compact_shared_file,
+    "Read replica can't modify shared memory file of its writer" );
+
+  helpers::environment_extension_resources environment_extension(
+                                              theApp.get_version_string(),
+                                              theApp.get_plugins_names(),
+                                              []( const std::string& message ){ wlog( message.c_str() ); }
+                                            );
+  set_mapping_options( args.shared_file_mapping );
+  chainbase::database::open( args.shared_mem_dir, args.chainbase_flags, 0, args.database_cfg, &environment_extension );
+
+  _my->create_new_decoded_types_data_storage();
+  _my->_decoded_types_data_storage->register_new_type<irreversible_object_type>();
+
+  // replica runs only subset of plugins of the writer, but all indexes it uses have to match
+  initialize_indexes();
+  verify_match_of_state_objects_definitions_from_shm( true );
+  initialize_evaluators();
+  initialize_irreversible_storage();
+
+  with_read_lock( [&]()
+  {
+    FC_ASSERT( find< dynamic_global_property_object >() != nullptr, "Writer did not initialize state in shared memory file yet" );
+    ilog( "Read replica opened state of writer at head block ${hb} and last irreversible block ${lib}",
+      ( "hb", head_block_num() )( "lib", get_last_irreversible_block_num() ) );
+  } );
+
+  describe_performance_metrics();
+
+  init_hardforks();
+  verify_hardforks_and_set_chain_id();
+}
+
+void database::describe_performance_metrics()
+{
+  auto& metrics = performance_metrics::instance();
+  metrics.describe_family( "evaluator", "Time spent in operation evaluators" );
+  metrics.describe_family( "block_phase", "Time spent in consecutive phases of block application" );
+  metrics.describe_family( "plugin_handler", "Time spent in plugin handlers of database signals" );
+  metrics.describe_family( "block_decoding", "Time spent reading, decompressing and decoding blocks and transactions" );
+  metrics.describe_family( "chain_lock", "Time spent waiting for and holding state lock" );
+}
+
+void database::on_replica_remapped()
+{
+  // irreversible storage is not an index, so its address has to be found again
+  initialize_irreversible_storage();
+}
+
 void database::initialize_state_independent_data(const open_args& args, const bool throw_an_error_on_state_definitions_mismatch)
 {
   _my->create_new_decoded_types_data_storage();
@@ -204,13 +321,20 @@ void database::initialize_state_independent_data(const open_args& args, const bo
 
   _benchmark_dumper.set_enabled(args.benchmark_is_enabled);
   if( _benchmark_dumper.is_enabled() &&
-      ( !_pre_apply_operation_signal.empty() || !_post_apply_operation_signal.empty() ) )
+      ( !_pre_apply_operation_signal.empty() || !_post_apply_operation_signal.empty() ||
+        !_pre_apply_operation_handlers_by_type.empty() || !_post_apply_operation_handlers_by_type.empty() ) )
   {
     wlog( "BENCHMARK will run into nested measurements - data on operations that emit vops will be lost!!!" );
   }
 
+  describe_performance_metrics();
+
   _shared_file_full_threshold = args.shared_file_full_threshold;
   _shared_file_scale_rate = args.shared_file_scale_rate;
+  _comment_cashout_threads = args.comment_cashout_threads;
+  _worker_thread_pool = args.worker_thread_pool;
+  _validate_invariants_per_block = args.validate_invariants_per_block;
+  _full_invariants_validation_interval = args.full_invariants_validation_interval;
 
   /// Initialize all static (state independent) specific to hardforks
   init_hardforks();
@@ -250,6 +374,11 @@ void database::load_state_initial_data(const open_args& args)
       validate_invariants();
   });
 
+  if (args.compact_shared_file)
+    with_write_lock([&]() { compact_shared_memory(); });
+
+  with_write_lock([&]() { reserve_hashed_index_buckets(); });
+
   if (head_block_num())
   {
     std::shared_ptr<full_block_type> head_block = 
@@ -260,6 +389,11 @@ void database::load_state_initial_data(const open_args& args)
     ("block_number1", head_block_num())("block_hash1", head_block_id())("block_number2", head_block ? head_block->get_block_num() : 0)("block_hash2", head_block ? head_block->get_block_id() : block_id_type()));
   }
 
+  verify_hardforks_and_set_chain_id();
+}
+
+void database::verify_hardforks_and_set_chain_id()
+{
   with_read_lock([&]() {
     const auto& hardforks = get_hardfork_property_object();
     FC_ASSERT(hardforks.last_hardfork <= HIVE_NUM_HARDFORKS, "Chain knows of more hardforks than configuration", ("hardforks.last_hardfork", hardforks.last_hardfork)("HIVE_NUM_HARDFORKS", HIVE_NUM_HARDFORKS));
@@ -308,6 +442,8 @@ void database::close()
     // DB state (issue #336).
     clear_pending();
 
+    flush_async_notifications();
+
     chainbase::database::flush();
 
     auto lib = this->get_last_irreversible_block_num();
@@ -408,6 +544,16 @@ const account_object* database::find_account( const account_name_type& name )con
   return find< account_object, by_name >( name );
 }
 
+const account_cold_object& database::get_account_cold( const account_id_type id )const
+{ try {
+  return get< account_cold_object, by_id >( account_cold_object::id_type( id ) );
+} FC_CAPTURE_AND_RETHROW( (id) ) }
+
+const account_cold_object& database::get_account_cold( const account_object& account )const
+{
+  return get_account_cold( account.get_id() );
+}
+
 const comment_object& database::get_comment( comment_id_type comment_id )const try
 {
   return get< comment_object, by_id >( comment_id );
@@ -840,11 +986,15 @@ void database::post_push_virtual_operation( const operation& op, const fc::optio
 void database::notify_pre_apply_operation( const operation_notification& note )
 {
   HIVE_TRY_NOTIFY( _pre_apply_operation_signal, note )
+  HIVE_TRY_NOTIFY( notify_typed_operation_handlers, _pre_apply_operation_handlers_by_type, note )
 }
 
 void database::notify_post_apply_operation( const operation_notification& note )
 {
   HIVE_TRY_NOTIFY( _post_apply_operation_signal, note )
+  HIVE_TRY_NOTIFY( notify_typed_operation_handlers, _post_apply_operation_handlers_by_type, note )
+  if( _async_block_note )
+    _async_block_note->operations.emplace_back( note );
 }
 
 void database::notify_pre_apply_block( const block_notification& note )
@@ -1567,9 +1717,12 @@ void database::lock_account( const account_object& account )
 
   modify( account, []( account_object& a )
   {
-    a.set_recovery_account( a );
     a.memo_key = public_key_type();
   } );
+  modify( get_account_cold( account ), [&]( account_cold_object& a )
+  {
+    a.set_recovery_account( account );
+  } );
 
   auto rec_req = find< account_recovery_request_object, by_account >( account.get_name() );
   if( rec_req )
@@ -2291,12 +2444,11 @@ void database::process_vesting_withdrawals()
 }
 
 /**
-  *  This method will iterate through all comment_vote_objects and give them
-  *  (max_rewards * weight) / c.total_vote_weight.
-  *
-  *  @returns unclaimed rewards.
+  *  Collects curation claims of all votes on given comment: (max_rewards * weight) / c.total_vote_weight.
+  *  Only reads state, so it is safe to call for many comments in parallel.
   */
-share_type database::pay_curators( const comment_object& comment, const comment_cashout_object& comment_cashout, share_type& max_rewards )
+void database::compute_curator_claims( const comment_object& comment, const comment_cashout_object& comment_cashout,
+  share_type max_rewards, curator_claims_type& claims ) const
 {
   struct cmp
   {
@@ -2309,6 +2461,37 @@ share_type database::pay_curators( const comment_object& comment, const comment_
     }
   };
 
+  uint128_t total_weight( comment_cashout.get_total_vote_weight() );
+
+  const auto& cvidx = get_index<comment_vote_index, by_comment_voter>();
+  auto itr = cvidx.lower_bound( comment.get_id() );
+
+  std::set< const comment_vote_object*, cmp > proxy_set;
+  while( itr != cvidx.end() && itr->get_comment() == comment.get_id() )
+  {
+    proxy_set.insert( &( *itr ) );
+    ++itr;
+  }
+
+  claims.reserve( proxy_set.size() );
+  for( auto& item : proxy_set )
+  {
+    uint128_t weight( item->get_weight() );
+    auto claim = fc::uint128_to_uint64( ( max_rewards.value * weight ) / total_weight );
+    if( claim > 0 ) // min_amt is non-zero satoshis
+      claims.emplace_back( item, claim );
+  }
+}
+
+/**
+  *  This method will iterate through all comment_vote_objects and give them
+  *  (max_rewards * weight) / c.total_vote_weight.
+  *
+  *  @returns unclaimed rewards.
+  */
+share_type database::pay_curators( const comment_object& comment, const comment_cashout_object& comment_cashout, share_type& max_rewards,
+  const curator_claims_type* precomputed_claims )
+{
   try
   {
     share_type unclaimed_rewards = max_rewards;
@@ -2320,42 +2503,33 @@ share_type database::pay_curators( const comment_object& comment, const comment_
     }
     else if( comment_cashout.get_total_vote_weight() > 0 )
     {
-      uint128_t total_weight( comment_cashout.get_total_vote_weight() );
-
-      const auto& cvidx = get_index<comment_vote_index, by_comment_voter>();
-      auto itr = cvidx.lower_bound( comment.get_id() );
-
-      std::set< const comment_vote_object*, cmp > proxy_set;
-      while( itr != cvidx.end() && itr->get_comment() == comment.get_id() )
+      curator_claims_type claims;
+      if( precomputed_claims == nullptr )
       {
-        proxy_set.insert( &( *itr ) );
-        ++itr;
+        compute_curator_claims( comment, comment_cashout, max_rewards, claims );
+        precomputed_claims = &claims;
       }
 
       const auto& comment_author_name = get_account( comment_cashout.get_author_id() ).get_name();
-      for( auto& item : proxy_set )
+      for( auto& item : *precomputed_claims )
       { try {
-        uint128_t weight( item->get_weight() );
-        auto claim = fc::uint128_to_uint64( ( max_rewards.value * weight ) / total_weight );
-        if( claim > 0 ) // min_amt is non-zero satoshis
-        {
-          unclaimed_rewards -= claim;
-          const auto& voter = get( item->get_voter() );
-          operation vop = curation_reward_operation( voter.get_name(), asset(0, VESTS_SYMBOL), comment_author_name, to_string( comment_cashout.get_permlink() ), has_hardfork( HIVE_HARDFORK_0_17__659 ) );
-          create_vesting2( *this, voter, asset( claim, HIVE_SYMBOL ), has_hardfork( HIVE_HARDFORK_0_17__659 ),
-            [&]( const asset& reward )
-            {
-              vop.get< curation_reward_operation >().reward = reward;
-              pre_push_virtual_operation( vop );
-            } );
+        const share_type claim = item.second;
+        unclaimed_rewards -= claim;
+        const auto& voter = get( item.first->get_voter() );
+        operation vop = curation_reward_operation( voter.get_name(), asset(0, VESTS_SYMBOL), comment_author_name, to_string( comment_cashout.get_permlink() ), has_hardfork( HIVE_HARDFORK_0_17__659 ) );
+        create_vesting2( *this, voter, asset( claim, HIVE_SYMBOL ), has_hardfork( HIVE_HARDFORK_0_17__659 ),
+          [&]( const asset& reward )
+          {
+            vop.get< curation_reward_operation >().reward = reward;
+            pre_push_virtual_operation( vop );
+          } );
 
-            modify( voter, [&]( account_object& a )
-            {
-              a.curation_rewards.amount += claim;
-            });
-          post_push_virtual_operation( vop );
-        }
-      } FC_CAPTURE_AND_RETHROW( (*item) ) }
+          modify( voter, [&]( account_object& a )
+          {
+            a.curation_rewards.amount += claim;
+          });
+        post_push_virtual_operation( vop );
+      } FC_CAPTURE_AND_RETHROW( (*item.first) ) }
     }
     max_rewards -= unclaimed_rewards;
 
@@ -2363,8 +2537,87 @@ share_type database::pay_curators( const comment_object& comment, const comment_
   } FC_CAPTURE_AND_RETHROW( (max_rewards) )
 }
 
+void database::fill_comment_reward_context( util::comment_reward_context& ctx, const comment_cashout_object& comment_cashout,
+  const comment_cashout_ex_object* comment_cashout_ex ) const
+{
+  ctx.rshares = comment_cashout.get_net_rshares();
+  ctx.max_hbd = comment_cashout.get_max_accepted_payout();
+  if( comment_cashout_ex )
+    ctx.reward_weight = comment_cashout_ex->get_reward_weight();
+  else
+    ctx.reward_weight = HIVE_100_PERCENT;
+
+  if( has_hardfork( HIVE_HARDFORK_0_17__774 ) )
+  {
+    const auto& rf = get_reward_fund();
+    ctx.reward_curve = rf.author_reward_curve;
+    ctx.content_constant = rf.content_constant;
+  }
+}
+
+/**
+  *  Computes rewards and curation claims for given comments on calling thread helped by workers of
+  *  blockchain thread pool. Must only be called
+  *  when reward fund state is snapshotted for the whole block (after HF17), because then each result
+  *  depends only on state of its own comment. Nothing is modified, so results are the same as if
+  *  computed serially right before payout of each comment.
+  *
+  *  @returns false when there is too little work to be worth sharing it (results are empty then).
+  */
+bool database::precompute_comment_payouts( const util::comment_reward_context& ctx,
+  const std::vector< const comment_cashout_object* >& comment_cashouts,
+  std::vector< comment_payout_precomputation >& results ) const
+{
+  // below that number of comments per thread the cost of handing work over is bigger than the gain
+  const size_t min_comments_per_thread = 16;
+  const size_t thread_count = std::min< size_t >( _comment_cashout_threads, comment_cashouts.size() / min_comments_per_thread );
+  if( thread_count < 2 || _worker_thread_pool == nullptr )
+    return false;
+
+  results.clear();
+  results.resize( comment_cashouts.size() );
+  const uint16_t curation_rewards_percent = get_curation_rewards_percent();
+
+  std::atomic< size_t > next_comment = { 0 };
+  auto worker = [&]()
+  {
+    for( size_t i = next_comment++; i < comment_cashouts.size(); i = next_comment++ )
+    {
+      const comment_cashout_object& comment_cashout = *comment_cashouts[i];
+      comment_payout_precomputation& result = results[i];
+      try
+      {
+        if( comment_cashout.get_net_rshares() > 0 )
+        {
+          const comment_object& comment = get_comment( comment_cashout );
+          util::comment_reward_context comment_ctx = ctx;
+          fill_comment_reward_context( comment_ctx, comment_cashout, find_comment_cashout_ex( comment ) );
+          result.reward = util::get_rshare_reward( comment_ctx );
+
+          uint128_t reward_tokens = uint128_t( result.reward.value );
+          if( reward_tokens > 0 && comment_cashout.allows_curation_rewards() && comment_cashout.get_total_vote_weight() > 0 )
+          {
+            share_type curation_tokens = fc::uint128_to_uint64( ( reward_tokens * curation_rewards_percent ) / HIVE_100_PERCENT );
+            compute_curator_claims( comment, comment_cashout, curation_tokens, result.curator_claims );
+          }
+        }
+        result.valid = true;
+      }
+      catch( ... )
+      {
+        // leave it invalid - serial processing will repeat the computation and report the error
+        result = comment_payout_precomputation();
+      }
+    }
+  };
+
+  _worker_thread_pool->run_in_parallel( worker, thread_count - 1 );
+  return true;
+}
+
 share_type database::cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment,
-  const comment_cashout_object& comment_cashout, const comment_cashout_ex_object* comment_cashout_ex, bool forward_curation_remainder )
+  const comment_cashout_object& comment_cashout, const comment_cashout_ex_object* comment_cashout_ex, bool forward_curation_remainder,
+  const comment_payout_precomputation* precomputed )
 {
   try
   {
@@ -2372,21 +2625,9 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
 
     if( comment_cashout.get_net_rshares() > 0 )
     {
-      ctx.rshares = comment_cashout.get_net_rshares();
-      ctx.max_hbd = comment_cashout.get_max_accepted_payout();
-      if( comment_cashout_ex )
-        ctx.reward_weight = comment_cashout_ex->get_reward_weight();
-      else
-        ctx.reward_weight = HIVE_100_PERCENT;
-
-      if( has_hardfork( HIVE_HARDFORK_0_17__774 ) )
-      {
-        const auto& rf = get_reward_fund();
-        ctx.reward_curve = rf.author_reward_curve;
-        ctx.content_constant = rf.content_constant;
-      }
+      fill_comment_reward_context( ctx, comment_cashout, comment_cashout_ex );
 
-      const share_type reward = util::get_rshare_reward( ctx );
+      const share_type reward = precomputed ? precomputed->reward : share_type( util::get_rshare_reward( ctx ) );
       uint128_t reward_tokens = uint128_t( reward.value );
       share_type curation_tokens;
       share_type author_tokens;
@@ -2396,7 +2637,8 @@ share_type database::cashout_comment_helper( util::comment_reward_context& ctx,
         curation_tokens = fc::uint128_to_uint64( ( reward_tokens * get_curation_rewards_percent() ) / HIVE_100_PERCENT );
         author_tokens = fc::uint128_to_uint64(reward_tokens) - curation_tokens;
 
-        share_type curation_remainder = pay_curators( comment, comment_cashout, curation_tokens );
+        share_type curation_remainder = pay_curators( comment, comment_cashout, curation_tokens,
+          precomputed ? &precomputed->curator_claims : nullptr );
 
         if( forward_curation_remainder )
           author_tokens += curation_remainder;
@@ -2598,6 +2840,8 @@ void database::process_comment_cashout()
   const auto& com_by_root = get_index< comment_cashout_ex_index, by_root >();
 
   auto _current = cidx.begin();
+  std::vector< const comment_cashout_object* > due_cashouts;
+  std::vector< comment_payout_precomputation > precomputed_payouts;
   // add all rshares about to be cashed out to the reward funds. This ensures equal satoshi per rshare payment
   if( has_hardfork( HIVE_HARDFORK_0_17__771 ) )
   {
@@ -2608,11 +2852,23 @@ void database::process_comment_cashout()
         const auto& rf = get_reward_fund();
         funds[ rf.get_id() ].recent_claims += util::evaluate_reward_curve( _current->get_net_rshares(), rf.author_reward_curve, rf.content_constant );
       }
+      if( _comment_cashout_threads > 1 )
+        due_cashouts.push_back( &( *_current ) );
 
       ++_current;
     }
 
     _current = cidx.begin();
+
+    // reward fund state is now fixed for the whole block, so the math part of all payouts can be done up front
+    if( !due_cashouts.empty() )
+    {
+      auto fund_id = get_reward_fund().get_id();
+      ctx.total_reward_shares2 = funds[ fund_id ].recent_claims;
+      ctx.total_reward_fund_hive = funds[ fund_id ].reward_balance;
+      if( !precompute_comment_payouts( ctx, due_cashouts, precomputed_payouts ) )
+        due_cashouts.clear();
+    }
   }
 
   bool forward_curation_remainder = !has_hardfork( HIVE_HARDFORK_0_20__1877 );
@@ -2640,9 +2896,15 @@ void database::process_comment_cashout()
       ctx.total_reward_shares2 = funds[ fund_id ].recent_claims;
       ctx.total_reward_fund_hive = funds[ fund_id ].reward_balance;
 
+      // payouts are made in the same order in which they were precomputed; in case of any mismatch
+      // we just compute the payout in place
+      const comment_payout_precomputation* precomputed = nullptr;
+      if( size_t( count ) < due_cashouts.size() && due_cashouts[ count ] == &( *_current ) && precomputed_payouts[ count ].valid )
+        precomputed = &precomputed_payouts[ count ];
+
       const comment_object& _comment = get_comment( *_current );
       funds[ fund_id ].hive_awarded += cashout_comment_helper( ctx, _comment, *_current,
-        find_comment_cashout_ex( _comment ), forward_curation_remainder );
+        find_comment_cashout_ex( _comment ), forward_curation_remainder, precomputed );
       ++count;
     }
     else
@@ -3142,11 +3404,12 @@ void database::account_recovery_processing()
   while( change_req != change_req_idx.end() && change_req->get_execution_time() <= head_block_time() )
   {
     const auto& account = get_account( change_req->get_account_to_recover() );
+    const auto& account_cold = get_account_cold( account );
     account_name_type old_recovery_account_name;
-    if( account.has_recovery_account() )
-      old_recovery_account_name = get_account( account.get_recovery_account() ).get_name();
+    if( account_cold.has_recovery_account() )
+      old_recovery_account_name = get_account( account_cold.get_recovery_account() ).get_name();
     const auto& new_recovery_account = get_account( change_req->get_recovery_account() );
-    modify( account, [&]( account_object& a )
+    modify( account_cold, [&]( account_cold_object& a )
     {
       a.set_recovery_account( new_recovery_account );
     });
@@ -3360,7 +3623,15 @@ void database::initialize_indexes()
 void database::initialize_irreversible_storage()
 {
   auto s = get_segment_manager();
-  irreversible_object = s->find_or_construct<irreversible_object_type>( "irreversible" )();
+  if( is_read_only() )
+  {
+    irreversible_object = s->find_no_lock<irreversible_object_type>( "irreversible" ).first;
+    FC_ASSERT( irreversible_object != nullptr, "Irreversible storage not found in shared memory file opened read-only" );
+  }
+  else
+  {
+    irreversible_object = s->find_or_construct<irreversible_object_type>( "irreversible" )();
+  }
 }
 
 void database::verify_match_of_state_objects_definitions_from_shm(const bool throw_an_error_on_state_definitions_mismatch)
@@ -3369,7 +3640,10 @@ void database::verify_match_of_state_objects_definitions_from_shm(const bool thr
   const std::string decoded_state_objects_data = get_decoded_state_objects_data_from_shm();
 
   if (decoded_state_objects_data.empty())
+  {
+    FC_ASSERT( !is_read_only(), "Definitions of state objects not found in shared memory file opened read-only" );
     set_decoded_state_objects_data(_my->_decoded_types_data_storage->generate_decoded_types_data_json_string());
+  }
   else
   {
     auto result = _my->_decoded_types_data_storage->check_if_decoded_types_data_json_matches_with_current_decoded_data(decoded_state_objects_data);
@@ -3499,7 +3773,13 @@ void database::init_genesis()
     // Create blockchain accounts
     public_key_type      init_public_key(HIVE_INIT_PUBLIC_KEY);
 
-    create< account_object >( HIVE_MINER_ACCOUNT, HIVE_GENESIS_TIME );
+    const auto create_genesis_account = [&]( const account_name_type& account_name, const public_key_type& memo_key )
+    {
+      const auto& account = create< account_object >( account_name, memo_key );
+      create< account_cold_object >( account, HIVE_GENESIS_TIME );
+    };
+
+    create_genesis_account( HIVE_MINER_ACCOUNT, public_key_type() );
     create< account_authority_object >( [&]( account_authority_object& auth )
     {
       auth.account = HIVE_MINER_ACCOUNT;
@@ -3507,7 +3787,7 @@ void database::init_genesis()
       auth.active.weight_threshold = 1;
     });
 
-    create< account_object >( HIVE_NULL_ACCOUNT, HIVE_GENESIS_TIME );
+    create_genesis_account( HIVE_NULL_ACCOUNT, public_key_type() );
     create< account_authority_object >( [&]( account_authority_object& auth )
     {
       auth.account = HIVE_NULL_ACCOUNT;
@@ -3516,11 +3796,11 @@ void database::init_genesis()
     });
 
 #if defined(IS_TEST_NET) || defined(HIVE_CONVERTER_ICEBERG_PLUGIN_ENABLED)
-    create< account_object >( OBSOLETE_TREASURY_ACCOUNT, HIVE_GENESIS_TIME );
-    create< account_object >( NEW_HIVE_TREASURY_ACCOUNT, HIVE_GENESIS_TIME );
+    create_genesis_account( OBSOLETE_TREASURY_ACCOUNT, public_key_type() );
+    create_genesis_account( NEW_HIVE_TREASURY_ACCOUNT, public_key_type() );
 #endif
 
-    create< account_object >( HIVE_TEMP_ACCOUNT, HIVE_GENESIS_TIME );
+    create_genesis_account( HIVE_TEMP_ACCOUNT, public_key_type() );
     create< account_authority_object >( [&]( account_authority_object& auth )
     {
       auth.account = HIVE_TEMP_ACCOUNT;
@@ -3530,7 +3810,7 @@ void database::init_genesis()
 
     const auto init_witness = [&]( const account_name_type& account_name )
     {
-      create< account_object >( account_name, HIVE_GENESIS_TIME, init_public_key );
+      create_genesis_account( account_name, init_public_key );
 
       create< account_authority_object >( [&]( account_authority_object& auth )
       {
@@ -3566,7 +3846,8 @@ void database::init_genesis()
     {
       const char* STEEM_ACCOUNT_NAME = "steem";
       auto STEEM_PUBLIC_KEY = public_key_type( HIVE_ADDRESS_PREFIX"65wH1LZ7BfSHcK69SShnqCAH5xdoSZpGkUjmzHJ5GCuxEK9V5G" );
-      create< account_object >( STEEM_ACCOUNT_NAME, STEEM_PUBLIC_KEY, HIVE_GENESIS_TIME, true, nullptr, true, asset( 0, VESTS_SYMBOL ) );
+      const auto& steem_account = create< account_object >( STEEM_ACCOUNT_NAME, STEEM_PUBLIC_KEY, HIVE_GENESIS_TIME, true, asset( 0, VESTS_SYMBOL ) );
+      create< account_cold_object >( steem_account, HIVE_GENESIS_TIME, true, nullptr );
       create< account_authority_object >( [&]( account_authority_object& auth )
       {
         auth.account = STEEM_ACCOUNT_NAME;
@@ -3696,23 +3977,35 @@ void database::set_flush_interval( uint32_t flush_blocks )
 //////////////////// private methods ////////////////////
 
 void database::apply_block( const std::shared_ptr<full_block_type>& full_block, uint32_t skip, const block_flow_control* block_ctrl )
+{
+  auto async_note = apply_block_internal( full_block, skip, block_ctrl );
+  if( async_note )
+    _async_notification_dispatcher.enqueue( std::move( async_note ) );
+}
+
+std::shared_ptr< async_block_notification > database::apply_block_internal( const std::shared_ptr<full_block_type>& full_block,
+  uint32_t skip, const block_flow_control* block_ctrl )
 { try {
   //fc::time_point begin_time = fc::time_point::now();
+  BOOST_SCOPE_EXIT( this_ ) { this_->_async_block_note.reset(); } BOOST_SCOPE_EXIT_END
 
   detail::with_skip_flags( *this, skip, [&]()
   {
     _apply_block( full_block, block_ctrl );
   } );
 
-  /*try
+  uint32_t block_num = full_block->get_block_num();
+
+  if( _validate_invariants_per_block && !( skip & skip_validate_invariants ) )
   {
-  /// check invariants
-  if( is_in_control() || !( skip & skip_validate_invariants ) )
-    validate_invariants();
+    if( _full_invariants_validation_interval != 0 && ( block_num % _full_invariants_validation_interval ) == 0 )
+      validate_invariants();
+    else if( !validate_block_invariants() && !_block_invariants_skip_reported )
+    {
+      wlog( "Changes made by blocks are not known while undo is disabled (f.e. during replay) - validation of invariants per block is skipped, only full validation with set interval is performed" );
+      _block_invariants_skip_reported = true;
+    }
   }
-  FC_CAPTURE_AND_RETHROW( (next_block) );*/
-
-  uint32_t block_num = full_block->get_block_num();
 
   //fc::time_point end_time = fc::time_point::now();
   //fc::microseconds dt = end_time - begin_time;
@@ -3743,6 +4036,7 @@ void database::apply_block( const std::shared_ptr<full_block_type>& full_block,
     }
   }
 
+  return std::move( _async_block_note );
 } FC_CAPTURE_AND_RETHROW((full_block->get_block())) }
 
 void database::apply_block_extended(
@@ -3754,9 +4048,42 @@ void database::apply_block_extended(
   BOOST_SCOPE_EXIT( this_ ) { this_->clear_tx_status(); } BOOST_SCOPE_EXIT_END
   set_tx_status( database::TX_STATUS_P2P_BLOCK );
 
-  auto session = start_undo_session();
-  apply_block( full_block, skip, block_ctrl );
-  session.push();
+  static const performance_metrics::histogram_id undo_metric_id =
+    performance_metrics::instance().get_histogram_id( "block_phase", "undo_session" );
+
+  std::shared_ptr< async_block_notification > async_note;
+  {
+    auto session = start_undo_session();
+    async_note = apply_block_internal( full_block, skip, block_ctrl );
+    performance_metrics::scoped_timer undo_timer( undo_metric_id );
+    session.push();
+  }
+  // observers only learn about block whose changes were committed
+  if( async_note )
+    _async_notification_dispatcher.enqueue( std::move( async_note ) );
+}
+
+void database::compact_shared_memory()
+{
+  // irreversible storage is not an index, so it has to be recreated in new file
+  const uint32_t last_irreversible_block = get_last_irreversible_block_num();
+
+  ilog( "Compacting shared memory file..." );
+  auto stats = compact();
+
+  initialize_irreversible_storage();
+  irreversible_object->last_irreversible_block_num = last_irreversible_block;
+
+  ilog( "Shared memory file compacted: used ${b}M before, ${a}M after, ${r}M reclaimed",
+    ( "b", stats.used_before / ( 1024 * 1024 ) )( "a", stats.used_after / ( 1024 * 1024 ) )
+    ( "r", stats.get_reclaimed() / ( 1024 * 1024 ) ) );
+}
+
+void database::reserve_hashed_index_buckets()
+{
+  auto& comments = get_mutable_index< comment_index >();
+  const size_t count = comments.indices().size();
+  comments.reserve_buckets( count + count / 2 );
 }
 
 void database::check_free_memory( bool force_print, uint32_t current_block_num )
@@ -3798,6 +4125,15 @@ void database::check_free_memory( bool force_print, uint32_t current_block_num )
   }
 }
 
+/// measures time of given block processing phase with performance_metrics (histogram is registered once per call site)
+#define HIVE_MEASURE_BLOCK_PHASE( phase, call ) \
+  do { \
+    static const performance_metrics::histogram_id _phase_metric_id = \
+      performance_metrics::instance().get_histogram_id( "block_phase", #phase ); \
+    performance_metrics::scoped_timer _phase_timer( _phase_metric_id ); \
+    call; \
+  } while( false )
+
 void database::_apply_block( const std::shared_ptr<full_block_type>& full_block, const block_flow_control* block_ctrl )
 {
   const signed_block& block = full_block->get_block();
@@ -3813,6 +4149,8 @@ void database::_apply_block( const std::shared_ptr<full_block_type>& full_block,
     this_->_currently_processing_block_id.reset();
   } BOOST_SCOPE_EXIT_END
   _currently_processing_block_id = full_block->get_block_id();
+  if( _async_notification_dispatcher.has_handlers() )
+    _async_block_note = std::make_shared< async_block_notification >( note );
 
   uint32_t skip = get_node_skip_flags();
   _current_block_num    = block_num;
@@ -3919,16 +4257,21 @@ void database::_apply_block( const std::shared_ptr<full_block_type>& full_block,
               (witness)(block.witness)(hardfork_state));
   }
 
-  for( const std::shared_ptr<full_transaction_type>& trx : full_block->get_full_transactions() )
   {
-    /* We do not need to push the undo state for each transaction
-      * because they either all apply and are valid or the
-      * entire block fails to apply.  We only need an "undo" state
-      * for transactions when validating broadcast transactions or
-      * when building a block.
-      */
-    apply_transaction( trx, skip );
-    ++_current_trx_in_block;
+    static const performance_metrics::histogram_id transactions_metric_id =
+      performance_metrics::instance().get_histogram_id( "block_phase", "apply_transactions" );
+    performance_metrics::scoped_timer transactions_timer( transactions_metric_id );
+    for( const std::shared_ptr<full_transaction_type>& trx : full_block->get_full_transactions() )
+    {
+      /* We do not need to push the undo state for each transaction
+        * because they either all apply and are valid or the
+        * entire block fails to apply.  We only need an "undo" state
+        * for transactions when validating broadcast transactions or
+        * when building a block.
+        */
+      apply_transaction( trx, skip );
+      ++_current_trx_in_block;
+    }
   }
 
   _current_trx_in_block = -1;
@@ -3941,45 +4284,45 @@ void database::_apply_block( const std::shared_ptr<full_block_type>& full_block,
     block_ctrl->on_end_of_transactions();
   }
 
-  update_global_dynamic_data(block);
-  update_signing_witness(signing_witness, block);
+  HIVE_MEASURE_BLOCK_PHASE( update_global_dynamic_data, update_global_dynamic_data(block) );
+  HIVE_MEASURE_BLOCK_PHASE( update_signing_witness, update_signing_witness(signing_witness, block) );
 
   uint32_t old_last_irreversible = update_last_irreversible_block( std::optional<switch_forks_t>() );
 
-  create_block_summary(full_block);
-  clear_expired_transactions();
-  clear_expired_orders();
-  clear_expired_delegations();
+  HIVE_MEASURE_BLOCK_PHASE( create_block_summary, create_block_summary(full_block) );
+  HIVE_MEASURE_BLOCK_PHASE( clear_expired_transactions, clear_expired_transactions() );
+  HIVE_MEASURE_BLOCK_PHASE( clear_expired_orders, clear_expired_orders() );
+  HIVE_MEASURE_BLOCK_PHASE( clear_expired_delegations, clear_expired_delegations() );
 
-  update_witness_schedule(*this);
+  HIVE_MEASURE_BLOCK_PHASE( update_witness_schedule, update_witness_schedule(*this) );
 
-  update_median_feed();
-  update_virtual_supply(); //accommodate potentially new price
+  HIVE_MEASURE_BLOCK_PHASE( update_median_feed, update_median_feed() );
+  HIVE_MEASURE_BLOCK_PHASE( update_virtual_supply_after_feed, update_virtual_supply() ); //accommodate potentially new price
 
-  clear_null_account_balance();
-  consolidate_treasury_balance();
-  process_funds();
-  process_conversions();
-  process_comment_cashout();
-  process_vesting_withdrawals();
-  process_savings_withdraws();
-  process_subsidized_accounts();
-  pay_liquidity_reward();
-  update_virtual_supply(); //cover changes in HBD supply from above processes
+  HIVE_MEASURE_BLOCK_PHASE( clear_null_account_balance, clear_null_account_balance() );
+  HIVE_MEASURE_BLOCK_PHASE( consolidate_treasury_balance, consolidate_treasury_balance() );
+  HIVE_MEASURE_BLOCK_PHASE( process_funds, process_funds() );
+  HIVE_MEASURE_BLOCK_PHASE( process_conversions, process_conversions() );
+  HIVE_MEASURE_BLOCK_PHASE( process_comment_cashout, process_comment_cashout() );
+  HIVE_MEASURE_BLOCK_PHASE( process_vesting_withdrawals, process_vesting_withdrawals() );
+  HIVE_MEASURE_BLOCK_PHASE( process_savings_withdraws, process_savings_withdraws() );
+  HIVE_MEASURE_BLOCK_PHASE( process_subsidized_accounts, process_subsidized_accounts() );
+  HIVE_MEASURE_BLOCK_PHASE( pay_liquidity_reward, pay_liquidity_reward() );
+  HIVE_MEASURE_BLOCK_PHASE( update_virtual_supply_after_processing, update_virtual_supply() ); //cover changes in HBD supply from above processes
 
-  account_recovery_processing();
-  expire_escrow_ratification();
-  process_decline_voting_rights();
-  process_proposals( note ); //new HBD converted here does not count towards limit
-  process_delayed_voting( note );
-  remove_expired_governance_votes();
+  HIVE_MEASURE_BLOCK_PHASE( account_recovery_processing, account_recovery_processing() );
+  HIVE_MEASURE_BLOCK_PHASE( expire_escrow_ratification, expire_escrow_ratification() );
+  HIVE_MEASURE_BLOCK_PHASE( process_decline_voting_rights, process_decline_voting_rights() );
+  HIVE_MEASURE_BLOCK_PHASE( process_proposals, process_proposals( note ) ); //new HBD converted here does not count towards limit
+  HIVE_MEASURE_BLOCK_PHASE( process_delayed_voting, process_delayed_voting( note ) );
+  HIVE_MEASURE_BLOCK_PHASE( remove_expired_governance_votes, remove_expired_governance_votes() );
 
-  process_recurrent_transfers();
+  HIVE_MEASURE_BLOCK_PHASE( process_recurrent_transfers, process_recurrent_transfers() );
 
-  rc.handle_expired_delegations();
-  rc.finalize_block();
+  HIVE_MEASURE_BLOCK_PHASE( handle_expired_delegations, rc.handle_expired_delegations() );
+  HIVE_MEASURE_BLOCK_PHASE( finalize_block, rc.finalize_block() );
 
-  process_hardforks();
+  HIVE_MEASURE_BLOCK_PHASE( process_hardforks, process_hardforks() );
 
   // notify observers that the block has been applied
   notify_post_apply_block( note );
@@ -3996,6 +4339,8 @@ void database::_apply_block( const std::shared_ptr<full_block_type>& full_block,
   _my->_last_pushed_block_time.store(gprops.time.sec_since_epoch(), std::memory_order_release);
 } FC_CAPTURE_CALL_LOG_AND_RETHROW( std::bind( &database::notify_fail_apply_block, this, note ), (block_num) ) }
 
+#undef HIVE_MEASURE_BLOCK_PHASE
+
 struct process_header_visitor
 {
   process_header_visitor( const std::string& witness, database& db ) :
@@ -4280,6 +4625,10 @@ void database::validate_transaction(const std::shared_ptr<full_transaction_type>
       if( _benchmark_dumper.is_enabled() )
         _benchmark_dumper.begin();
 
+      static const performance_metrics::histogram_id authority_metric_id =
+        performance_metrics::instance().get_histogram_id( "block_phase", "verify_authority" );
+      performance_metrics::scoped_timer authority_timer( authority_metric_id );
+
       const flat_set<public_key_type>& signature_keys = full_transaction->get_signature_keys();
       const required_authorities_type& required_authorities = full_transaction->get_required_authorities();
 
@@ -4404,7 +4753,10 @@ void database::apply_operation(const operation& op)
   if( has_hardfork( HIVE_HARDFORK_0_20 ) )
     rc.handle_operation_discount< operation >( op );
 
-  _my->_evaluator_registry.get_evaluator( op ).apply( op );
+  {
+    performance_metrics::scoped_timer evaluator_timer( _my->get_evaluator_metric_id( op ) );
+    _my->_evaluator_registry.get_evaluator( op ).apply( op );
+  }
 
   if( _benchmark_dumper.is_enabled() )
     _benchmark_dumper.end( name );
@@ -4421,25 +4773,30 @@ struct fcall<TResult(TArgs...)>
 
   fcall() = default;
   fcall(const TNotification& func, util::advanced_benchmark_dumper& dumper,
-    const abstract_plugin& plugin, const std::string& context, const std::string& item_name)
-    : _func(func), _benchmark_dumper(dumper), _context(context), _name(item_name) {}
+    const abstract_plugin& plugin, const std::string& context, const std::string& item_name,
+    performance_metrics::histogram_id metric_id)
+    : _func(func), _benchmark_dumper(dumper), _context(context), _name(item_name), _metric_id(metric_id) {}
 
   void operator () (TArgs&&... args)
   {
     if (_benchmark_dumper.is_enabled())
       _benchmark_dumper.begin();
 
-    _func(std::forward<TArgs>(args)...);
+    {
+      performance_metrics::scoped_timer handler_timer( _metric_id );
+      _func(std::forward<TArgs>(args)...);
+    }
 
     if (_benchmark_dumper.is_enabled())
       _benchmark_dumper.end( _context, _name );
   }
 
 private:
-  TNotification                    _func;
-  util::advanced_benchmark_dumper& _benchmark_dumper;
-  std::string                      _context;
-  std::string                      _name;
+  TNotification                     _func;
+  util::advanced_benchmark_dumper&  _benchmark_dumper;
+  std::string                       _context;
+  std::string                       _name;
+  performance_metrics::histogram_id _metric_id;
 };
 
 template <typename TResult, typename... TArgs>
@@ -4450,22 +4807,58 @@ struct fcall<std::function<TResult(TArgs...)>>
   using TBase::TBase;
 };
 
+/// metric name of plugin handler, f.e. "account_history_rocksdb.post_operation" (item names contain spaces, not allowed in label values)
+template <bool IS_PRE_OPERATION>
+performance_metrics::histogram_id get_plugin_handler_metric_id( const abstract_plugin& plugin, const std::string& item_name )
+{
+  std::string name = plugin.get_name() + ( IS_PRE_OPERATION ? ".pre_" : ".post_" ) + item_name;
+  std::replace( name.begin(), name.end(), ' ', '_' );
+  return performance_metrics::instance().get_histogram_id( "plugin_handler", name );
+}
+
 template <bool IS_PRE_OPERATION, typename TSignal, typename TNotification>
 boost::signals2::connection database::connect_impl( TSignal& signal, const TNotification& func,
   const abstract_plugin& plugin, int32_t group, const std::string& item_name )
 {
   fcall<TNotification> fcall_wrapper( func, _benchmark_dumper, plugin,
-    util::advanced_benchmark_dumper::generate_context_desc<IS_PRE_OPERATION>( plugin.get_name() ), item_name );
+    util::advanced_benchmark_dumper::generate_context_desc<IS_PRE_OPERATION>( plugin.get_name() ), item_name,
+    get_plugin_handler_metric_id<IS_PRE_OPERATION>( plugin, item_name ) );
 
   return signal.connect(group, fcall_wrapper);
 }
 
+void database::notify_typed_operation_handlers( const typed_operation_handlers_t& handlers, const operation_notification& note )
+{
+  const size_t type = note.op.which();
+  if( type >= handlers.size() )
+    return;
+
+  for( const auto& handler : handlers[ type ] )
+  {
+    if( handler.alive->load( std::memory_order_relaxed ) )
+      handler.func( note );
+  }
+}
+
+void database::remove_disconnected_typed_operation_handlers()
+{
+  for( auto* handlers : { &_pre_apply_operation_handlers_by_type, &_post_apply_operation_handlers_by_type } )
+  {
+    for( auto& type_handlers : *handlers )
+    {
+      type_handlers.erase( std::remove_if( type_handlers.begin(), type_handlers.end(),
+        []( const typed_operation_handler& h ) { return !h.alive->load( std::memory_order_relaxed ); } ), type_handlers.end() );
+    }
+  }
+}
+
 template< bool IS_PRE_OPERATION >
-boost::signals2::connection database::any_apply_operation_handler_impl( const apply_operation_handler_t& func,
-  const abstract_plugin& plugin, int32_t group )
+database::apply_operation_handler_t database::wrap_apply_operation_handler( const apply_operation_handler_t& func,
+  const abstract_plugin& plugin )
 {
   std::string context = util::advanced_benchmark_dumper::generate_context_desc< IS_PRE_OPERATION >( plugin.get_name() );
-  auto complex_func = [this, func, &plugin, context]( const operation_notification& o )
+  performance_metrics::histogram_id metric_id = get_plugin_handler_metric_id< IS_PRE_OPERATION >( plugin, "operation" );
+  return [this, func, &plugin, context, metric_id]( const operation_notification& o )
   {
     std::string name;
 
@@ -4475,11 +4868,21 @@ boost::signals2::connection database::any_apply_operation_handler_impl( const ap
       _benchmark_dumper.begin();
     }
 
-    func( o );
+    {
+      performance_metrics::scoped_timer handler_timer( metric_id );
+      func( o );
+    }
 
     if (_benchmark_dumper.is_enabled())
       _benchmark_dumper.end( context, name );
   };
+}
+
+template< bool IS_PRE_OPERATION >
+boost::signals2::connection database::any_apply_operation_handler_impl( const apply_operation_handler_t& func,
+  const abstract_plugin& plugin, int32_t group )
+{
+  auto complex_func = wrap_apply_operation_handler< IS_PRE_OPERATION >( func, plugin );
 
   if( IS_PRE_OPERATION )
     return _pre_apply_operation_signal.connect(group, complex_func);
@@ -4487,6 +4890,49 @@ boost::signals2::connection database::any_apply_operation_handler_impl( const ap
     return _post_apply_operation_signal.connect(group, complex_func);
 }
 
+template< bool IS_PRE_OPERATION >
+boost::signals2::connection database::typed_apply_operation_handler_impl( const apply_operation_handler_t& func,
+  const operation_type_set& types, const abstract_plugin& plugin, int32_t group )
+{
+  auto complex_func = wrap_apply_operation_handler< IS_PRE_OPERATION >( func, plugin );
+  auto& handlers = IS_PRE_OPERATION ? _pre_apply_operation_handlers_by_type : _post_apply_operation_handlers_by_type;
+  handlers.resize( operation::count() );
+
+  remove_disconnected_typed_operation_handlers();
+  // slot holds the only reference to the guard once connected - it is released (clearing the flag) on disconnect
+  auto alive = std::make_shared< std::atomic< bool > >( true );
+  std::shared_ptr< void > guard( nullptr, [alive]( void* ) { alive->store( false ); } );
+  boost::signals2::connection connection = _typed_operation_handler_registry.connect( [guard](){} );
+  guard.reset();
+  for( int64_t type : types )
+  {
+    FC_ASSERT( type >= 0 && type < operation::count(), "Invalid operation type ${t} in handler of plugin ${p}",
+      ( "t", type )( "p", plugin.get_name() ) );
+    auto& type_handlers = handlers[ type ];
+    // same ordering as in signal - by group, then in order of registration
+    auto position = std::upper_bound( type_handlers.begin(), type_handlers.end(), group,
+      []( int32_t g, const typed_operation_handler& h ) { return g < h.group; } );
+    type_handlers.insert( position, typed_operation_handler{ alive, group, complex_func } );
+  }
+  return connection;
+}
+
+boost::signals2::connection database::add_async_post_apply_block_handler( const async_apply_block_handler_t& func,
+  const abstract_plugin& plugin )
+{
+  performance_metrics::histogram_id metric_id = get_plugin_handler_metric_id< false >( plugin, "async block" );
+  return _async_notification_dispatcher.connect( [func, metric_id]( const async_block_notification& note )
+  {
+    performance_metrics::scoped_timer handler_timer( metric_id );
+    func( note );
+  } );
+}
+
+void database::flush_async_notifications()
+{
+  _async_notification_dispatcher.flush();
+}
+
 boost::signals2::connection database::add_pre_apply_operation_handler( const apply_operation_handler_t& func,
   const abstract_plugin& plugin, int32_t group )
 {
@@ -4499,6 +4945,18 @@ boost::signals2::connection database::add_post_apply_operation_handler( const ap
   return any_apply_operation_handler_impl< false/*IS_PRE_OPERATION*/ >( func, plugin, group );
 }
 
+boost::signals2::connection database::add_pre_apply_operation_handler( const apply_operation_handler_t& func,
+  const operation_type_set& types, const abstract_plugin& plugin, int32_t group )
+{
+  return typed_apply_operation_handler_impl< true/*IS_PRE_OPERATION*/ >( func, types, plugin, group );
+}
+
+boost::signals2::connection database::add_post_apply_operation_handler( const apply_operation_handler_t& func,
+  const operation_type_set& types, const abstract_plugin& plugin, int32_t group )
+{
+  return typed_apply_operation_handler_impl< false/*IS_PRE_OPERATION*/ >( func, types, plugin, group );
+}
+
 boost::signals2::connection database::add_pre_apply_transaction_handler( const apply_transaction_handler_t& func,
   const abstract_plugin& plugin, int32_t group )
 {
@@ -4951,7 +5409,12 @@ void database::migrate_irreversible_state(uint32_t old_last_irreversible)
                                 dpo.head_block_number );
 
     // This deletes undo state
-    commit( get_last_irreversible_block_num() );
+    {
+      static const performance_metrics::histogram_id commit_metric_id =
+        performance_metrics::instance().get_histogram_id( "block_phase", "undo_commit" );
+      performance_metrics::scoped_timer commit_timer( commit_metric_id );
+      commit( get_last_irreversible_block_num() );
+    }
 
     if (old_last_irreversible < get_last_irreversible_block_num())
     {
@@ -6120,7 +6583,10 @@ void database::apply_hardfork( uint32_t hardfork )
       // Create the treasury account if it does not exist
       // This may sometimes happen in the mirrornet, when we do not have the account created upon the HF 21 application or any dependent operation
       if( find_account(treasury_name) == nullptr )
-        create< account_object >( treasury_name, head_block_time() );
+      {
+        const auto& treasury = create< account_object >( treasury_name );
+        create< account_cold_object >( treasury, head_block_time() );
+      }
 
       lock_account( get_treasury() );
 
@@ -6223,7 +6689,10 @@ void database::apply_hardfork( uint32_t hardfork )
     const auto treasury_name = get_treasury_name();
 
     if( find_account(treasury_name) == nullptr )
-      create< account_object >( treasury_name, head_block_time() );
+    {
+      const auto& treasury = create< account_object >( treasury_name );
+      create< account_cold_object >( treasury, head_block_time() );
+    }
 
     lock_account( get_treasury() );
     //the following routine can only be called effectively after hardfork was marked as applied
@@ -6244,6 +6713,129 @@ void database::retally_liquidity_weight() {
   }
 }
 
+namespace {
+  /// sums of tokens held in chain objects that are compared against supply recorded in dynamic global properties
+  struct supply_totals
+  {
+    asset       hive = asset( 0, HIVE_SYMBOL );
+    asset       hbd = asset( 0, HBD_SYMBOL );
+    asset       vesting = asset( 0, VESTS_SYMBOL );
+    asset       pending_vesting_hive = asset( 0, HIVE_SYMBOL );
+    share_type  vsf_votes = share_type( 0 );
+    ushare_type delayed_votes = ushare_type( 0 );
+  };
+
+  void collect_supply( supply_totals& totals, const account_object& a )
+  {
+    totals.hive += a.get_balance();
+    totals.hive += a.get_savings();
+    totals.hive += a.get_rewards();
+    totals.hbd += a.get_hbd_balance();
+    totals.hbd += a.get_hbd_savings();
+    totals.hbd += a.get_hbd_rewards();
+    totals.vesting += a.get_vesting();
+    totals.vesting += a.get_vest_rewards();
+    totals.pending_vesting_hive += a.get_vest_rewards_as_hive();
+    totals.vsf_votes += ( !a.has_proxy() ?
+                    a.get_governance_vote_power() :
+                    ( HIVE_MAX_PROXY_RECURSION_DEPTH > 0 ?
+                        a.proxied_vsf_votes[HIVE_MAX_PROXY_RECURSION_DEPTH - 1] :
+                        a.get_direct_governance_vote_power() ) );
+    totals.delayed_votes += a.sum_delayed_votes;
+  }
+
+  void collect_supply( supply_totals& totals, const convert_request_object& c )
+  {
+    totals.hbd += c.get_convert_amount();
+  }
+
+  void collect_supply( supply_totals& totals, const collateralized_convert_request_object& c )
+  {
+    totals.hive += c.get_collateral_amount();
+    // don't collect get_converted_amount() - it is not balance object; that tokens are already on owner's balance
+  }
+
+  void collect_supply( supply_totals& totals, const limit_order_object& o )
+  {
+    if( o.sell_price.base.symbol == HIVE_SYMBOL )
+      totals.hive += asset( o.for_sale, HIVE_SYMBOL );
+    else if ( o.sell_price.base.symbol == HBD_SYMBOL )
+      totals.hbd += asset( o.for_sale, HBD_SYMBOL );
+  }
+
+  void collect_supply( supply_totals& totals, const escrow_object& e )
+  {
+    totals.hive += e.get_hive_balance();
+    totals.hbd += e.get_hbd_balance();
+
+    if( e.get_fee().symbol == HIVE_SYMBOL )
+      totals.hive += e.get_fee();
+    else if( e.get_fee().symbol == HBD_SYMBOL )
+      totals.hbd += e.get_fee();
+    else
+      FC_ASSERT( false, "found escrow pending fee that is not HBD or HIVE" );
+  }
+
+  void collect_supply( supply_totals& totals, const savings_withdraw_object& w )
+  {
+    if( w.amount.symbol == HIVE_SYMBOL )
+      totals.hive += w.amount;
+    else if( w.amount.symbol == HBD_SYMBOL )
+      totals.hbd += w.amount;
+    else
+      FC_ASSERT( false, "found savings withdraw that is not HBD or HIVE" );
+  }
+
+  void collect_supply( supply_totals& totals, const reward_fund_object& r )
+  {
+    totals.hive += r.reward_balance;
+  }
+
+#ifdef HIVE_ENABLE_SMT
+  void collect_supply( supply_totals& totals, const smt_contribution_object& c )
+  {
+    totals.hive += c.contribution;
+  }
+#endif
+
+  void collect_supply( supply_totals& totals, const dynamic_global_property_object& gpo )
+  {
+    totals.hive += gpo.get_total_vesting_fund_hive() + gpo.get_total_reward_fund_hive() + gpo.get_pending_rewarded_vesting_hive();
+  }
+
+  /// adds values of objects changed in last undo state to before/after totals
+  template< typename IndexType >
+  bool collect_supply_changes( const database& db, supply_totals& before, supply_totals& after )
+  {
+    return db.get_index< IndexType >().visit_undo_state_changes( [&]( const auto* old_value, const auto* new_value )
+    {
+      if( old_value != nullptr )
+        collect_supply( before, *old_value );
+      if( new_value != nullptr )
+        collect_supply( after, *new_value );
+    } );
+  }
+
+  void validate_delayed_votes( const account_object& a )
+  {
+    ushare_type sum_delayed_votes{ 0ul };
+    for( auto& dv : a.delayed_votes )
+      sum_delayed_votes += dv.val;
+    FC_ASSERT( sum_delayed_votes == a.sum_delayed_votes, "", ("sum_delayed_votes",sum_delayed_votes)("itr->sum_delayed_votes",a.sum_delayed_votes) );
+    FC_ASSERT( sum_delayed_votes.value <= a.get_vesting().amount, "", ("sum_delayed_votes",sum_delayed_votes)("itr->vesting_shares.amount",a.get_vesting().amount)("account",a.get_name()) );
+  }
+
+  void validate_virtual_supply( const dynamic_global_property_object& gpo, const price& current_median_history )
+  {
+    FC_ASSERT( gpo.virtual_supply >= gpo.current_supply );
+    if ( !current_median_history.is_null() )
+    {
+      FC_ASSERT( gpo.get_current_hbd_supply()* current_median_history + gpo.current_supply
+        == gpo.virtual_supply, "", ("gpo.current_hbd_supply",gpo.get_current_hbd_supply())("get_feed_history().current_median_history",current_median_history)("gpo.current_supply",gpo.current_supply)("gpo.virtual_supply",gpo.virtual_supply) );
+    }
+  }
+}
+
 /**
   * Verifies all supply invariantes check out
   */
@@ -6252,12 +6844,7 @@ void database::validate_invariants()const
   try
   {
     const auto& account_idx = get_index< account_index, by_name >();
-    asset total_supply = asset( 0, HIVE_SYMBOL );
-    asset total_hbd = asset( 0, HBD_SYMBOL );
-    asset total_vesting = asset( 0, VESTS_SYMBOL );
-    asset pending_vesting_hive = asset( 0, HIVE_SYMBOL );
-    share_type total_vsf_votes = share_type( 0 );
-    ushare_type total_delayed_votes = ushare_type( 0 );
+    supply_totals totals;
 
     uint64_t witness_no = 0;
     uint64_t account_no = 0;
@@ -6281,41 +6868,22 @@ void database::validate_invariants()const
 
     for( auto itr = account_idx.begin(); itr != account_idx.end(); ++itr )
     {
-      total_supply += itr->get_balance();
-      total_supply += itr->get_savings();
-      total_supply += itr->get_rewards();
-      total_hbd += itr->get_hbd_balance();
-      total_hbd += itr->get_hbd_savings();
-      total_hbd += itr->get_hbd_rewards();
-      total_vesting += itr->get_vesting();
-      total_vesting += itr->get_vest_rewards();
-      pending_vesting_hive += itr->get_vest_rewards_as_hive();
-      total_vsf_votes += ( !itr->has_proxy() ?
-                      itr->get_governance_vote_power() :
-                      ( HIVE_MAX_PROXY_RECURSION_DEPTH > 0 ?
-                          itr->proxied_vsf_votes[HIVE_MAX_PROXY_RECURSION_DEPTH - 1] :
-                          itr->get_direct_governance_vote_power() ) );
-      total_delayed_votes += itr->sum_delayed_votes;
-      ushare_type sum_delayed_votes{ 0ul };
-      for( auto& dv : itr->delayed_votes )
-        sum_delayed_votes += dv.val;
-      FC_ASSERT( sum_delayed_votes == itr->sum_delayed_votes, "", ("sum_delayed_votes",sum_delayed_votes)("itr->sum_delayed_votes",itr->sum_delayed_votes) );
-      FC_ASSERT( sum_delayed_votes.value <= itr->get_vesting().amount, "", ("sum_delayed_votes",sum_delayed_votes)("itr->vesting_shares.amount",itr->get_vesting().amount)("account",itr->get_name()) );
+      collect_supply( totals, *itr );
+      validate_delayed_votes( *itr );
       ++account_no;
     }
 
     const auto& convert_request_idx = get_index< convert_request_index >().indices();
     for( auto itr = convert_request_idx.begin(); itr != convert_request_idx.end(); ++itr )
     {
-      total_hbd += itr->get_convert_amount();
+      collect_supply( totals, *itr );
       ++convert_no;
     }
 
     const auto& collateralized_convert_request_idx = get_index< collateralized_convert_request_index >().indices();
     for( auto itr = collateralized_convert_request_idx.begin(); itr != collateralized_convert_request_idx.end(); ++itr )
     {
-      total_supply += itr->get_collateral_amount();
-      // don't collect get_converted_amount() - it is not balance object; that tokens are already on owner's balance
+      collect_supply( totals, *itr );
       ++collateralized_convert_no;
     }
 
@@ -6323,14 +6891,7 @@ void database::validate_invariants()const
 
     for( auto itr = limit_order_idx.begin(); itr != limit_order_idx.end(); ++itr )
     {
-      if( itr->sell_price.base.symbol == HIVE_SYMBOL )
-      {
-        total_supply += asset( itr->for_sale, HIVE_SYMBOL );
-      }
-      else if ( itr->sell_price.base.symbol == HBD_SYMBOL )
-      {
-        total_hbd += asset( itr->for_sale, HBD_SYMBOL );
-      }
+      collect_supply( totals, *itr );
       ++order_no;
     }
 
@@ -6338,15 +6899,7 @@ void database::validate_invariants()const
 
     for( auto itr = escrow_idx.begin(); itr != escrow_idx.end(); ++itr )
     {
-      total_supply += itr->get_hive_balance();
-      total_hbd += itr->get_hbd_balance();
-
-      if( itr->get_fee().symbol == HIVE_SYMBOL )
-        total_supply += itr->get_fee();
-      else if( itr->get_fee().symbol == HBD_SYMBOL )
-        total_hbd += itr->get_fee();
-      else
-        FC_ASSERT( false, "found escrow pending fee that is not HBD or HIVE" );
+      collect_supply( totals, *itr );
       ++escrow_no;
     }
 
@@ -6354,12 +6907,7 @@ void database::validate_invariants()const
 
     for( auto itr = savings_withdraw_idx.begin(); itr != savings_withdraw_idx.end(); ++itr )
     {
-      if( itr->amount.symbol == HIVE_SYMBOL )
-        total_supply += itr->amount;
-      else if( itr->amount.symbol == HBD_SYMBOL )
-        total_hbd += itr->amount;
-      else
-        FC_ASSERT( false, "found savings withdraw that is not HBD or HIVE" );
+      collect_supply( totals, *itr );
       ++withdrawal_no;
     }
 
@@ -6367,7 +6915,7 @@ void database::validate_invariants()const
 
     for( auto itr = reward_idx.begin(); itr != reward_idx.end(); ++itr )
     {
-      total_supply += itr->reward_balance;
+      collect_supply( totals, *itr );
       ++reward_fund_no;
     }
 
@@ -6376,25 +6924,20 @@ void database::validate_invariants()const
 
     for ( auto itr = smt_contribution_idx.begin(); itr != smt_contribution_idx.end(); ++itr )
     {
-      total_supply += itr->contribution;
+      collect_supply( totals, *itr );
       ++contribution_no;
     }
 #endif
 
-    total_supply += gpo.get_total_vesting_fund_hive() + gpo.get_total_reward_fund_hive() + gpo.get_pending_rewarded_vesting_hive();
+    collect_supply( totals, gpo );
 
-    FC_ASSERT( gpo.current_supply == total_supply, "", ("gpo.current_supply",gpo.current_supply)("total_supply",total_supply) );
-    FC_ASSERT( gpo.get_current_hbd_supply() == total_hbd, "", ("gpo.current_hbd_supply",gpo.get_current_hbd_supply())("total_hbd",total_hbd) );
-    FC_ASSERT( gpo.total_vesting_shares + gpo.pending_rewarded_vesting_shares == total_vesting, "", ("gpo.total_vesting_shares",gpo.total_vesting_shares)("total_vesting",total_vesting) );
-    FC_ASSERT( gpo.total_vesting_shares.amount == total_vsf_votes + total_delayed_votes.value, "", ("total_vesting_shares",gpo.total_vesting_shares)("total_vsf_votes + total_delayed_votes",total_vsf_votes + total_delayed_votes.value) );
-    FC_ASSERT( gpo.get_pending_rewarded_vesting_hive() == pending_vesting_hive, "", ("pending_rewarded_vesting_hive",gpo.get_pending_rewarded_vesting_hive())("pending_vesting_hive", pending_vesting_hive));
+    FC_ASSERT( gpo.current_supply == totals.hive, "", ("gpo.current_supply",gpo.current_supply)("total_supply",totals.hive) );
+    FC_ASSERT( gpo.get_current_hbd_supply() == totals.hbd, "", ("gpo.current_hbd_supply",gpo.get_current_hbd_supply())("total_hbd",totals.hbd) );
+    FC_ASSERT( gpo.total_vesting_shares + gpo.pending_rewarded_vesting_shares == totals.vesting, "", ("gpo.total_vesting_shares",gpo.total_vesting_shares)("total_vesting",totals.vesting) );
+    FC_ASSERT( gpo.total_vesting_shares.amount == totals.vsf_votes + totals.delayed_votes.value, "", ("total_vesting_shares",gpo.total_vesting_shares)("total_vsf_votes + total_delayed_votes",totals.vsf_votes + totals.delayed_votes.value) );
+    FC_ASSERT( gpo.get_pending_rewarded_vesting_hive() == totals.pending_vesting_hive, "", ("pending_rewarded_vesting_hive",gpo.get_pending_rewarded_vesting_hive())("pending_vesting_hive", totals.pending_vesting_hive));
 
-    FC_ASSERT( gpo.virtual_supply >= gpo.current_supply );
-    if ( !get_feed_history().current_median_history.is_null() )
-    {
-      FC_ASSERT( gpo.get_current_hbd_supply()* get_feed_history().current_median_history + gpo.current_supply
-        == gpo.virtual_supply, "", ("gpo.current_hbd_supply",gpo.get_current_hbd_supply())("get_feed_history().current_median_history",get_feed_history().current_median_history)("gpo.current_supply",gpo.current_supply)("gpo.virtual_supply",gpo.virtual_supply) );
-    }
+    validate_virtual_supply( gpo, get_feed_history().current_median_history );
 
     ilog( "validate_invariants @${b}:", ( "b", head_block_num() ) );
     ilog( "successful scan of ${p} witnesses, ${a} accounts, ${c} convert requests, ${cc} collateralized convert requests, ${o} limit orders, ${e} escrow transfers, ${w} saving withdrawals, ${r} reward funds and ${s} SMT contributions.",
@@ -6407,6 +6950,77 @@ void database::validate_invariants()const
   FC_CAPTURE_LOG_AND_RETHROW( (head_block_num()) );
 }
 
+/**
+  * Verifies that supply invariants still check out after the last block, assuming they were met before it.
+  * Instead of scanning all objects it only looks at the ones changed by the block, as recorded in its
+  * undo state, and checks that changes of held tokens match changes of supply.
+  */
+bool database::validate_block_invariants()const
+{
+  try
+  {
+    supply_totals before, after;
+
+    if( !collect_supply_changes< account_index >( *this, before, after ) )
+      return false; // undo is disabled, f.e. during replay
+
+    collect_supply_changes< convert_request_index >( *this, before, after );
+    collect_supply_changes< collateralized_convert_request_index >( *this, before, after );
+    collect_supply_changes< limit_order_index >( *this, before, after );
+    collect_supply_changes< escrow_index >( *this, before, after );
+    collect_supply_changes< savings_withdraw_index >( *this, before, after );
+    collect_supply_changes< reward_fund_index >( *this, before, after );
+#ifdef HIVE_ENABLE_SMT
+    collect_supply_changes< smt_contribution_index >( *this, before, after );
+#endif
+
+    const auto& gpo = get_dynamic_global_properties();
+    const dynamic_global_property_object* old_gpo = &gpo;
+    get_index< dynamic_global_property_index >().visit_undo_state_changes(
+      [&]( const dynamic_global_property_object* old_value, const dynamic_global_property_object* )
+      {
+        if( old_value != nullptr )
+          old_gpo = old_value;
+      } );
+    collect_supply( before, *old_gpo );
+    collect_supply( after, gpo );
+
+    get_index< account_index >().visit_undo_state_changes( [&]( const account_object*, const account_object* new_value )
+    {
+      if( new_value != nullptr )
+        validate_delayed_votes( *new_value );
+    } );
+
+    const auto& witness_idx = get_index< witness_index, by_vote_name >();
+    if( !witness_idx.empty() )
+      FC_ASSERT( witness_idx.begin()->votes <= gpo.total_vesting_shares.amount, "", ("itr",*witness_idx.begin()) );
+
+    const asset hive_change = after.hive - before.hive;
+    const asset hbd_change = after.hbd - before.hbd;
+    const asset vesting_change = after.vesting - before.vesting;
+    const asset pending_vesting_hive_change = after.pending_vesting_hive - before.pending_vesting_hive;
+    const share_type votes_change = ( after.vsf_votes - before.vsf_votes ) +
+      ( share_type( after.delayed_votes.value ) - share_type( before.delayed_votes.value ) );
+
+    FC_ASSERT( gpo.current_supply - old_gpo->current_supply == hive_change, "",
+      ("gpo.current_supply",gpo.current_supply)("old current_supply",old_gpo->current_supply)("hive_change",hive_change) );
+    FC_ASSERT( gpo.get_current_hbd_supply() - old_gpo->get_current_hbd_supply() == hbd_change, "",
+      ("gpo.current_hbd_supply",gpo.get_current_hbd_supply())("old current_hbd_supply",old_gpo->get_current_hbd_supply())("hbd_change",hbd_change) );
+    FC_ASSERT( ( gpo.total_vesting_shares + gpo.pending_rewarded_vesting_shares ) -
+      ( old_gpo->total_vesting_shares + old_gpo->pending_rewarded_vesting_shares ) == vesting_change, "",
+      ("gpo.total_vesting_shares",gpo.total_vesting_shares)("old total_vesting_shares",old_gpo->total_vesting_shares)("vesting_change",vesting_change) );
+    FC_ASSERT( gpo.total_vesting_shares.amount - old_gpo->total_vesting_shares.amount == votes_change, "",
+      ("total_vesting_shares",gpo.total_vesting_shares)("old total_vesting_shares",old_gpo->total_vesting_shares)("votes_change",votes_change) );
+    FC_ASSERT( gpo.get_pending_rewarded_vesting_hive() - old_gpo->get_pending_rewarded_vesting_hive() == pending_vesting_hive_change, "",
+      ("pending_rewarded_vesting_hive",gpo.get_pending_rewarded_vesting_hive())("old pending_rewarded_vesting_hive",old_gpo->get_pending_rewarded_vesting_hive())
+      ("pending_vesting_hive_change",pending_vesting_hive_change) );
+
+    validate_virtual_supply( gpo, get_feed_history().current_median_history );
+    return true;
+  }
+  FC_CAPTURE_LOG_AND_RETHROW( (head_block_num()) );
+}
+
 #ifdef HIVE_ENABLE_SMT
 
 namespace {
@@ -6716,6 +7330,7 @@ database::node_status_t database::get_node_status()
   node_status_t result;
   result.last_processed_block_num = _my->_last_pushed_block_number.load(std::memory_order_consume);
   result.last_processed_block_time = fc::time_point_sec(_my->_last_pushed_block_time.load(std::memory_order_consume));
+  result.shared_memory = get_mapping_statistics();
   return result;
 }
 
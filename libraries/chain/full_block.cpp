@@ -3,6 +3,7 @@
 #include <fc/bitutil.hpp>
 
 #include <fc/io/json.hpp>
+#include <hive/utilities/performance_metrics.hpp>
 
 namespace hive { namespace chain {
 
@@ -185,6 +186,10 @@ void full_block_type::decompress_block() const
     assert(has_compressed_block);
     FC_ASSERT(has_compressed_block.load(std::memory_order_consume), "Nothing to decompress");
 
+    static const hive::utilities::performance_metrics::histogram_id decompress_metric_id =
+      hive::utilities::performance_metrics::instance().get_histogram_id("block_decoding", "decompress");
+    hive::utilities::performance_metrics::scoped_timer decompress_timer(decompress_metric_id);
+
     decoded_block_storage = std::make_shared<decoded_block_storage_type>();
     std::tie(decoded_block_storage->uncompressed_block.raw_bytes, decoded_block_storage->uncompressed_block.raw_size) = 
       block_log::decompress_raw_block(compressed_block.compressed_bytes.get(), 
@@ -382,6 +387,10 @@ void full_block_type::decode_block() const
   {
     decode_block_header(); // force decompression and decoding through the block header to happen now, if it hasn't happened yet
 
+    static const hive::utilities::performance_metrics::histogram_id unpack_metric_id =
+      hive::utilities::performance_metrics::instance().get_histogram_id("block_decoding", "unpack");
+    hive::utilities::performance_metrics::scoped_timer unpack_timer(unpack_metric_id);
+
     fc::time_point decode_block_begin = fc::time_point::now();
     // decoded_block_storage->block should now have the signed_block_header slice valid, the remainder (the transactions) empty
     assert(decoded_block_storage->block);
@@ -2,6 +2,7 @@
 #include <hive/chain/full_block.hpp>
 #include <hive/protocol/exceptions.hpp>
 #include <hive/protocol/hardfork.hpp>
+#include <hive/utilities/performance_metrics.hpp>
 #include <boost/scope_exit.hpp>
 #include <boost/lockfree/queue.hpp>
 #include <mutex>
@@ -119,6 +120,10 @@ void full_transaction_type::compute_signature_keys() const
   std::lock_guard<std::mutex> guard(results_mutex);
   if (!has_signature_info.load(std::memory_order_consume))
   {
+    static const hive::utilities::performance_metrics::histogram_id recover_metric_id =
+      hive::utilities::performance_metrics::instance().get_histogram_id("block_decoding", "recover_signature_keys");
+    hive::utilities::performance_metrics::scoped_timer recover_timer(recover_metric_id);
+
     fc::time_point computation_start = fc::time_point::now();
     // look up the chain_id and signature type required to validate this transaction.  If this transaction was part
     // of a block, validate based on the rules effective at the block's timestamp.  If it's a standalone transaction,
@@ -285,8 +285,10 @@ const account_object& create_account( database& db, const account_name_type& nam
     rc_adjustment_from_fee = ( fee_for_rc_adjustment * dgpo.get_vesting_share_price() ).amount.value;
   }
 
-  return db.create< account_object >( name, key, time, mined, recovery_account,
+  const auto& new_account = db.create< account_object >( name, key, time,
     !db.has_hardfork( HIVE_HARDFORK_0_20__2539 ) /*voting mana 100%*/, initial_delegation, rc_adjustment_from_fee );
+  db.create< account_cold_object >( new_account, time, mined, recovery_account );
+  return new_account;
 }
 
 void account_create_evaluator::do_apply( const account_create_operation& o )
@@ -544,11 +546,15 @@ void account_update_evaluator::do_apply( const account_update_operation& o )
   if( o.posting && ( _db.has_hardfork( HIVE_HARDFORK_0_15__465 ) ) )
     verify_authority_accounts_exist( _db, *o.posting, o.account, authority::posting );
 
-  _db.modify( account, [&]( account_object& acc )
+  if( o.memo_key != public_key_type() )
+  {
+    _db.modify( account, [&]( account_object& acc )
+    {
+      acc.memo_key = o.memo_key;
+    });
+  }
+  _db.modify( _db.get_account_cold( account ), [&]( account_cold_object& acc )
   {
-    if( o.memo_key != public_key_type() )
-        acc.memo_key = o.memo_key;
-
     acc.last_account_update = _db.head_block_time();
   });
 
@@ -609,11 +615,15 @@ void account_update2_evaluator::do_apply( const account_update2_operation& o )
   if( o.posting )
     verify_authority_accounts_exist( _db, *o.posting, o.account, authority::posting );
 
-  _db.modify( account, [&]( account_object& acc )
+  if( o.memo_key && *o.memo_key != public_key_type() )
+  {
+    _db.modify( account, [&]( account_object& acc )
+    {
+      acc.memo_key = *o.memo_key;
+    });
+  }
+  _db.modify( _db.get_account_cold( account ), [&]( account_cold_object& acc )
   {
-    if( o.memo_key && *o.memo_key != public_key_type() )
-        acc.memo_key = *o.memo_key;
-
     acc.last_account_update = _db.head_block_time();
   });
 
@@ -2171,7 +2181,7 @@ void pow_apply( database& db, Operation o )
 #endif
   FC_ASSERT( o.block_id == db.head_block_id(), "pow not for last block" );
   if( db.has_hardfork( HIVE_HARDFORK_0_13__256 ) )
-    FC_ASSERT( worker_account.last_account_update < db.head_block_time(), "Worker account must not have updated their account this block." );
+    FC_ASSERT( db.get_account_cold( worker_account ).last_account_update < db.head_block_time(), "Worker account must not have updated their account this block." );
 
 #ifndef HIVE_CONVERTER_BUILD // due to the optimization issues with blockchain_converter performing proof of work for every pow operations, this check is applied only in mainnet
   fc::sha256 target = db.get_pow_target();
@@ -2569,10 +2579,11 @@ void create_claimed_account_evaluator::do_apply( const create_claimed_account_op
 void request_account_recovery_evaluator::do_apply( const request_account_recovery_operation& o )
 {
   const auto& account_to_recover = _db.get_account( o.account_to_recover );
+  const auto& account_to_recover_cold = _db.get_account_cold( account_to_recover );
 
-  if ( account_to_recover.has_recovery_account() ) // Make sure recovery matches expected recovery account
+  if ( account_to_recover_cold.has_recovery_account() ) // Make sure recovery matches expected recovery account
   {
-    const auto& recovery_account = _db.get_account( account_to_recover.get_recovery_account() );
+    const auto& recovery_account = _db.get_account( account_to_recover_cold.get_recovery_account() );
     FC_ASSERT( recovery_account.get_name() == o.recovery_account, "Cannot recover an account that does not have you as their recovery partner." );
     if( o.recovery_account == HIVE_TEMP_ACCOUNT )
       wlog( "Recovery by temp account" );
@@ -2634,9 +2645,10 @@ void request_account_recovery_evaluator::do_apply( const request_account_recover
 void recover_account_evaluator::do_apply( const recover_account_operation& o )
 {
   const auto& account = _db.get_account( o.account_to_recover );
+  const auto& account_cold = _db.get_account_cold( account );
 
   if( _db.has_hardfork( HIVE_HARDFORK_0_12 ) )
-    FC_ASSERT( util::owner_update_limit_mgr::check( _db.head_block_time(), account.get_last_account_recovery_time() ), "${m}", ("m", util::owner_update_limit_mgr::msg( _db.has_hardfork( HIVE_HARDFORK_1_26_AUTH_UPDATE ) ) ) );
+    FC_ASSERT( util::owner_update_limit_mgr::check( _db.head_block_time(), account_cold.get_last_account_recovery_time() ), "${m}", ("m", util::owner_update_limit_mgr::msg( _db.has_hardfork( HIVE_HARDFORK_1_26_AUTH_UPDATE ) ) ) );
 
   const auto& recovery_request_idx = _db.get_index< account_recovery_request_index, by_account >();
   auto request = recovery_request_idx.find( o.account_to_recover );
@@ -2659,7 +2671,7 @@ void recover_account_evaluator::do_apply( const recover_account_operation& o )
 
   _db.remove( *request ); // Remove first, update_owner_authority may invalidate iterator
   _db.update_owner_authority( account, o.new_owner_authority );
-  _db.modify( account, [&]( account_object& a )
+  _db.modify( account_cold, [&]( account_cold_object& a )
   {
     a.set_last_account_recovery_time( _db.head_block_time() );
   });
@@ -2679,7 +2691,7 @@ void change_recovery_account_evaluator::do_apply( const change_recovery_account_
     //ABW: it is possible to request change to currently set recovery agent (empty operation)
     _db.create< change_recovery_account_request_object >( account_to_recover, new_recovery_account, _db.head_block_time() + HIVE_OWNER_AUTH_RECOVERY_PERIOD );
   }
-  else if( account_to_recover.get_recovery_account() != new_recovery_account.get_id() ) // Change existing request
+  else if( _db.get_account_cold( account_to_recover ).get_recovery_account() != new_recovery_account.get_id() ) // Change existing request
   {
     //ABW: it is possible to request change to already requested new recovery agent (operation only resets timer)
     _db.modify( *request, [&]( change_recovery_account_request_object& req )
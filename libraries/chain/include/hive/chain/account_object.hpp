@@ -28,15 +28,10 @@ namespace hive { namespace chain {
       //constructor for creation of regular accounts
       template< typename Allocator >
       account_object( allocator< Allocator > a, uint64_t _id,
-        const account_name_type& _name, const public_key_type& _memo_key,
-        const time_point_sec& _creation_time, bool _mined,
-        const account_object* _recovery_account,
+        const account_name_type& _name, const public_key_type& _memo_key, const time_point_sec& _creation_time,
         bool _fill_mana, const asset& incoming_delegation, int64_t _rc_adjustment = 0 )
-      : id( _id ), name( _name ), rc_adjustment( _rc_adjustment ), created( _creation_time ),
-        mined( _mined ), memo_key( _memo_key ), delayed_votes( a )
+      : id( _id ), name( _name ), rc_adjustment( _rc_adjustment ), memo_key( _memo_key ), delayed_votes( a )
       {
-        if( _recovery_account != nullptr )
-          recovery_account = _recovery_account->get_id();
         received_vesting_shares += incoming_delegation;
         voting_manabar.last_update_time = _creation_time.sec_since_epoch();
         downvote_manabar.last_update_time = _creation_time.sec_since_epoch();
@@ -54,8 +49,8 @@ namespace hive { namespace chain {
       //minimal constructor used for creation of accounts at genesis and in tests
       template< typename Allocator >
       account_object( allocator< Allocator > a, uint64_t _id,
-        const account_name_type& _name, const time_point_sec& _creation_time, const public_key_type& _memo_key = public_key_type() )
-        : id( _id ), name( _name ), created( _creation_time ), memo_key( _memo_key ), delayed_votes( a )
+        const account_name_type& _name, const public_key_type& _memo_key = public_key_type() )
+        : id( _id ), name( _name ), memo_key( _memo_key ), delayed_votes( a )
       {}
 
       //liquid HIVE balance
@@ -120,10 +115,6 @@ namespace hive { namespace chain {
 
       //gives name of the account
       const account_name_type& get_name() const { return name; }
-      //account creation time
-      time_point_sec get_creation_time() const { return created; }
-      //tells if account was created through pow/pow2 mining operation or is one of builtin accounts created during genesis
-      bool was_mined() const { return mined; }
 
       //tells if account has some other account casting governance votes in its name
       bool has_proxy() const { return proxy != account_id_type(); }
@@ -138,31 +129,13 @@ namespace hive { namespace chain {
         proxy = new_proxy.get_id();
       }
 
-      //tells if account has some designated account that can initiate recovery (if not, top witness can)
-      bool has_recovery_account() const { return recovery_account != account_id_type(); }
-      //account's recovery account (if any), that is, an account that can authorize request_account_recovery_operation
-      account_id_type get_recovery_account() const { return recovery_account; }
-      //sets new recovery account
-      void set_recovery_account(const account_object& new_recovery_account)
-      {
-        recovery_account = new_recovery_account.get_id();
-      }
-      //timestamp of last time account owner authority was successfully recovered
-      time_point_sec get_last_account_recovery_time() const { return last_account_recovery; }
-      //sets time of owner authority recovery
-      void set_last_account_recovery_time( time_point_sec recovery_time )
-      {
-        last_account_recovery = recovery_time;
-      }
-
       //members are organized in such a way that the object takes up as little space as possible (note that object starts with 4byte id).
+      //data that is rarely modified is kept in account_cold_object, so frequent modifications of balances and manabars
+      //don't copy it to undo state (delayed votes stay here, since they change together with vesting)
 
     private:
       account_id_type   proxy;
 
-      account_id_type   recovery_account;
-      time_point_sec    last_account_recovery;
-
       account_name_type name;
 
     public:
@@ -207,10 +180,6 @@ namespace hive { namespace chain {
       time_point_sec    hbd_last_interest_payment; ///< used to pay interest at most once per month
       time_point_sec    savings_hbd_seconds_last_update; ///< the last time the hbd_seconds was updated
       time_point_sec    savings_hbd_last_interest_payment; ///< used to pay interest at most once per month
-    private:
-      time_point_sec    created; //(not read by consensus code)
-    public:
-      time_point_sec    last_account_update; //(only used by outdated consensus checks - up to HF17)
       time_point_sec    last_post; //(we could probably remove limit on posting replies)
       time_point_sec    last_root_post; //influenced root comment reward between HF12 and HF17
       time_point_sec    last_post_edit; //(we could probably remove limit on post edits)
@@ -231,10 +200,7 @@ namespace hive { namespace chain {
 
       uint8_t           savings_withdraw_requests = 0;
       bool              can_vote = true;
-    private:
-      bool              mined = true; //(not read by consensus code)
 
-    public:
       public_key_type   memo_key; //33 bytes with alignment of 1; (it belongs to metadata as it is not used by consensus, but witnesses need it here since they don't COLLECT_ACCOUNT_METADATA)
 
       fc::array<share_type, HIVE_MAX_PROXY_RECURSION_DEPTH> proxied_vsf_votes; ///< the total VFS votes proxied to this account
@@ -310,6 +276,73 @@ namespace hive { namespace chain {
     CHAINBASE_UNPACK_CONSTRUCTOR(account_object, (delayed_votes));
   };
 
+  /**
+    * Part of account data that is rarely modified or rarely read. Shares id with account_object (every account
+    * has exactly one such object). Kept separately so undo state of frequently modified account_object
+    * (balances, manabars, vesting) does not carry copies of it.
+    */
+  class account_cold_object : public object< account_cold_object_type, account_cold_object >
+  {
+    CHAINBASE_OBJECT( account_cold_object );
+    public:
+      //constructor for creation of regular accounts
+      template< typename Allocator >
+      account_cold_object( allocator< Allocator > a, uint64_t _id,
+        const account_object& _account, const time_point_sec& _creation_time, bool _mined,
+        const account_object* _recovery_account )
+      : id( _account.get_id() ), //note that it is possible because relation is 1->1 so we can share id
+        created( _creation_time ), mined( _mined )
+      {
+        if( _recovery_account != nullptr )
+          recovery_account = _recovery_account->get_id();
+      }
+
+      //minimal constructor used for creation of accounts at genesis and in tests
+      template< typename Allocator >
+      account_cold_object( allocator< Allocator > a, uint64_t _id,
+        const account_object& _account, const time_point_sec& _creation_time )
+      : id( _account.get_id() ), created( _creation_time )
+      {}
+
+      //id of account the data belongs to
+      account_id_type get_account_id() const { return account_object::id_type( id ); }
+
+      //account creation time
+      time_point_sec get_creation_time() const { return created; }
+      //tells if account was created through pow/pow2 mining operation or is one of builtin accounts created during genesis
+      bool was_mined() const { return mined; }
+
+      //tells if account has some designated account that can initiate recovery (if not, top witness can)
+      bool has_recovery_account() const { return recovery_account != account_id_type(); }
+      //account's recovery account (if any), that is, an account that can authorize request_account_recovery_operation
+      account_id_type get_recovery_account() const { return recovery_account; }
+      //sets new recovery account
+      void set_recovery_account(const account_object& new_recovery_account)
+      {
+        recovery_account = new_recovery_account.get_id();
+      }
+      //timestamp of last time account owner authority was successfully recovered
+      time_point_sec get_last_account_recovery_time() const { return last_account_recovery; }
+      //sets time of owner authority recovery
+      void set_last_account_recovery_time( time_point_sec recovery_time )
+      {
+        last_account_recovery = recovery_time;
+      }
+
+    private:
+      account_id_type   recovery_account;
+      time_point_sec    last_account_recovery;
+      time_point_sec    created; //(not read by consensus code)
+
+    public:
+      time_point_sec    last_account_update; //(only used by outdated consensus checks - up to HF17)
+
+    private:
+      bool              mined = true; //(not read by consensus code)
+
+    CHAINBASE_UNPACK_CONSTRUCTOR(account_cold_object);
+  };
+
   class account_metadata_object : public object< account_metadata_object_type, account_metadata_object >
   {
     CHAINBASE_OBJECT( account_metadata_object );
@@ -532,6 +565,18 @@ namespace hive { namespace chain {
     allocator< account_object >
   > account_index;
 
+  /**
+    * @ingroup object_index
+    */
+  typedef multi_index_container<
+    account_cold_object,
+    indexed_by<
+      ordered_unique< tag< by_id >,
+        const_mem_fun< account_cold_object, account_cold_object::id_type, &account_cold_object::get_id > >
+    >,
+    allocator< account_cold_object >
+  > account_cold_index;
+
   struct by_account {};
 
   typedef multi_index_container <
@@ -664,7 +709,7 @@ namespace hive { namespace chain {
 } }
 
 FC_REFLECT( hive::chain::account_object,
-          (id)(proxy)(recovery_account)(last_account_recovery)
+          (id)(proxy)
           (name)
           (hbd_seconds)
           (savings_hbd_seconds)
@@ -683,16 +728,22 @@ FC_REFLECT( hive::chain::account_object,
           (received_rc)(last_max_rc)
           (pending_claimed_accounts)(sum_delayed_votes)
           (hbd_seconds_last_update)(hbd_last_interest_payment)(savings_hbd_seconds_last_update)(savings_hbd_last_interest_payment)
-          (created)(last_account_update)(last_post)(last_root_post)
+          (last_post)(last_root_post)
           (last_post_edit)(last_vote_time)(next_vesting_withdrawal)(governance_vote_expiration_ts)
           (post_count)(post_bandwidth)(withdraw_routes)(pending_escrow_transfers)(open_recurrent_transfers)(witnesses_voted_for)
-          (savings_withdraw_requests)(can_vote)(mined)
+          (savings_withdraw_requests)(can_vote)
           (memo_key)
           (proxied_vsf_votes)
           (delayed_votes)
         )
 
 CHAINBASE_SET_INDEX_TYPE( hive::chain::account_object, hive::chain::account_index )
+CHAINBASE_SET_UNDO_JOURNAL( hive::chain::account_object )
+
+FC_REFLECT( hive::chain::account_cold_object,
+          (id)(recovery_account)(last_account_recovery)(created)(last_account_update)(mined)
+        )
+CHAINBASE_SET_INDEX_TYPE( hive::chain::account_cold_object, hive::chain::account_cold_index )
 
 FC_REFLECT( hive::chain::account_metadata_object,
           (id)(account)(json_metadata)(posting_json_metadata) )
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <memory>
 #include <hive/chain/full_block.hpp>
 #include <hive/chain/full_transaction.hpp>
@@ -60,13 +61,19 @@ public:
     block_log_destined_for_p2p_alternate_compressed,
     block_log_for_replay,
     block_log_for_decompressing,
-    block_log_for_artifact_generation
+    block_log_for_artifact_generation,
+    parallel_task
   };
   void enqueue_work(const std::shared_ptr<full_block_type>& full_block, data_source_type data_source);
   void enqueue_work(const std::shared_ptr<full_transaction_type>& full_transaction, data_source_type data_source);
   void enqueue_work(const std::vector<std::shared_ptr<full_transaction_type>>& full_transactions, data_source_type data_source,
                     std::optional<uint32_t> block_number);
 
+  // runs task on calling thread and, at the same time, on up to helper_count worker threads (only those that
+  // pick it up before calling thread is done with it); task has to split work between its runs by itself
+  // (f.e. with shared atomic counter) and must not throw. Returns when all started runs are finished.
+  void run_in_parallel(const std::function<void()>& task, uint32_t helper_count);
+
   void set_p2p_force_validate();
   void set_validate_during_replay();
   void set_is_block_producer();
@@ -440,8 +440,11 @@ namespace hive { namespace chain {
       /// CONSENSUS INDICES - used by evaluators
       ordered_unique< tag< by_id >,
         const_mem_fun< comment_object, comment_object::id_type, &comment_object::get_id > >,
-      ordered_unique< tag< by_permlink >, /// used by consensus to find posts referenced in ops
-        const_mem_fun< comment_object, const comment_object::author_and_permlink_hash_type&, &comment_object::get_author_and_permlink_hash > >
+      /// used by consensus to find posts referenced in ops (point lookups only); buckets are reserved ahead of
+      /// growth (see database::reserve_hashed_index_buckets), since rehash relinks all comments at once
+      hashed_unique< tag< by_permlink >,
+        const_mem_fun< comment_object, const comment_object::author_and_permlink_hash_type&, &comment_object::get_author_and_permlink_hash >,
+        std::hash< comment_object::author_and_permlink_hash_type > >
     >,
     allocator< comment_object >
   > comment_index;
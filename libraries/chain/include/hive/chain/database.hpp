@@ -14,6 +14,7 @@
 #include <hive/chain/rc/rc_utility.hpp>
 
 #include <hive/chain/util/advanced_benchmark_dumper.hpp>
+#include <hive/chain/util/async_notification_dispatcher.hpp>
 #include <hive/chain/util/signal.hpp>
 #include <hive/chain/util/type_registrar.hpp>
 
@@ -27,6 +28,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <atomic>
 #include <functional>
 #include <map>
 
@@ -87,7 +89,9 @@ namespace chain {
     uint64_t shared_file_size = 0;
     uint16_t shared_file_full_threshold = 0;
     uint16_t shared_file_scale_rate = 0;
+    chainbase::mapping_options shared_file_mapping;
     uint32_t chainbase_flags = 0;
+    uint32_t max_replica_reader_wait = 100; // milliseconds
     bool do_validate_invariants = false;
     bool benchmark_is_enabled = false;
     fc::variant database_cfg;
@@ -97,6 +101,11 @@ namespace chain {
     bool enable_block_log_auto_fixing = true;
     int block_log_compression_level = 15;
     bool load_snapshot = false;
+    uint32_t comment_cashout_threads = 0;
+    blockchain_worker_thread_pool* worker_thread_pool = nullptr; // source of threads for comment payouts
+    bool validate_invariants_per_block = false;
+    uint32_t full_invariants_validation_interval = 0;
+    bool compact_shared_file = false;
 
     // The following fields are only used on reindexing
     uint32_t stop_replay_at = 0;
@@ -210,6 +219,12 @@ namespace chain {
 
       void verify_match_of_state_objects_definitions_from_shm(const bool throw_an_error_on_state_definitions_mismatch);
 
+      /// Opens shared memory file of other (writer) process read-only - see chainbase::database::read_only.
+      void open_read_replica(const open_args& args);
+      /// Sets descriptions of performance metrics collected by database (common for writer and read replica).
+      void describe_performance_metrics();
+      void verify_hardforks_and_set_chain_id();
+
     public:
       /// Allows to load all required initial data from persistent storage held in shared memory file. Must be used directly after opening a database, but also after loading a snapshot.
       void load_state_initial_data(const open_args& args);
@@ -258,6 +273,10 @@ namespace chain {
       const account_object&  get_account(  const account_name_type& name )const;
       const account_object*  find_account( const account_name_type& name )const;
 
+      /// rarely modified part of account data (shares id with account_object)
+      const account_cold_object& get_account_cold( const account_id_type id )const;
+      const account_cold_object& get_account_cold( const account_object& account )const;
+
       const comment_object&  get_comment( comment_id_type comment_id )const;
 
       const comment_object&  get_comment(  const account_id_type& author, const shared_string& permlink )const;
@@ -354,6 +373,8 @@ namespace chain {
       void notify_finish_push_block( const block_notification& note );
 
       using apply_operation_handler_t = std::function< void(const operation_notification&) >;
+      /// set of operation types (values of `operation::which()`) handler is interested in
+      using operation_type_set = std::vector< int64_t >;
       using apply_transaction_handler_t = std::function< void(const transaction_notification&) >;
       using apply_block_handler_t = std::function< void(const block_notification&) >;
       using push_block_handler_t = std::function< void(const block_notification&) >;
@@ -366,6 +387,7 @@ namespace chain {
       using load_snapshot_data_supplement_handler_t = std::function < void(const load_snapshot_supplement_notification&) >;
       using comment_reward_notification_handler_t = std::function < void(const comment_reward_notification&) >;
       using end_of_syncing_notification_handler_t = std::function < void(void) >;
+      using async_apply_block_handler_t = std::function< void(const async_block_notification&) >;
 
       void notify_prepare_snapshot_data_supplement(const prepare_snapshot_supplement_notification& n);
       void notify_load_snapshot_data_supplement(const load_snapshot_supplement_notification& n);
@@ -378,14 +400,34 @@ namespace chain {
       boost::signals2::connection connect_impl( TSignal& signal, const TNotification& func,
         const abstract_plugin& plugin, int32_t group, const std::string& item_name = "" );
 
+      template< bool IS_PRE_OPERATION >
+      apply_operation_handler_t wrap_apply_operation_handler( const apply_operation_handler_t& func, const abstract_plugin& plugin );
+
       template< bool IS_PRE_OPERATION >
       boost::signals2::connection any_apply_operation_handler_impl( const apply_operation_handler_t& func,
         const abstract_plugin& plugin, int32_t group );
 
+      template< bool IS_PRE_OPERATION >
+      boost::signals2::connection typed_apply_operation_handler_impl( const apply_operation_handler_t& func,
+        const operation_type_set& types, const abstract_plugin& plugin, int32_t group );
+
     public:
 
+      template< typename... OperationTypes >
+      static operation_type_set make_operation_type_set() { return { operation::tag< OperationTypes >::value... }; }
+
       boost::signals2::connection add_pre_apply_operation_handler       ( const apply_operation_handler_t&           func, const abstract_plugin& plugin, int32_t group = -1 );
       boost::signals2::connection add_post_apply_operation_handler      ( const apply_operation_handler_t&           func, const abstract_plugin& plugin, int32_t group = -1 );
+      /**
+        * Handler registered with set of operation types (see make_operation_type_set) is called only for operations of
+        * those types - notification is dispatched through table indexed by operation type, so handlers of plugins
+        * interested in few operations don't add to the cost of all other operations. Unlike handlers registered for
+        * all operations, they are all called after those handlers, regardless of group (ordering by group applies only
+        * among typed handlers) - plugins relying on ordering with handlers of other plugins must not use typed handlers.
+        * Disconnected handler is no longer called, just like with handlers registered for all operations.
+        */
+      boost::signals2::connection add_pre_apply_operation_handler       ( const apply_operation_handler_t&           func, const operation_type_set& types, const abstract_plugin& plugin, int32_t group = -1 );
+      boost::signals2::connection add_post_apply_operation_handler      ( const apply_operation_handler_t&           func, const operation_type_set& types, const abstract_plugin& plugin, int32_t group = -1 );
       boost::signals2::connection add_pre_apply_transaction_handler     ( const apply_transaction_handler_t&         func, const abstract_plugin& plugin, int32_t group = -1 );
       boost::signals2::connection add_post_apply_transaction_handler    ( const apply_transaction_handler_t&         func, const abstract_plugin& plugin, int32_t group = -1 );
       boost::signals2::connection add_pre_apply_block_handler           ( const apply_block_handler_t&               func, const abstract_plugin& plugin, int32_t group = -1 );
@@ -423,6 +465,16 @@ namespace chain {
 
       boost::signals2::connection add_end_of_syncing_handler            (const end_of_syncing_notification_handler_t& func, const abstract_plugin& plugin, int32_t group = -1);
 
+      /**
+        * Registers read-only observer of applied blocks. Handler is called on separate thread after
+        * block is fully applied and its undo session committed (blocks that fail are never reported),
+        * with a copy of block notification that includes all operations of the block, so it does not
+        * add to block application time. Handler must not access chain state.
+        */
+      boost::signals2::connection add_async_post_apply_block_handler    (const async_apply_block_handler_t& func, const abstract_plugin& plugin);
+      /// waits until all pending asynchronous notifications are delivered (call before disconnecting async handler)
+      void flush_async_notifications();
+
       //////////////////// db_witness_schedule.cpp ////////////////////
 
       /**
@@ -516,10 +568,33 @@ namespace chain {
         */
       void clear_witness_votes( const account_object& a );
       void process_vesting_withdrawals();
-      share_type pay_curators( const comment_object& comment, const comment_cashout_object& comment_cashout, share_type& max_rewards );
+      /// curation claims (vote, claimed amount) in the order they are paid out
+      typedef std::vector< std::pair< const comment_vote_object*, share_type > > curator_claims_type;
+
+      /**
+        * Part of comment payout that only reads state, so it can be computed for all comments
+        * that cash out in given block in parallel (see precompute_comment_payouts)
+        */
+      struct comment_payout_precomputation
+      {
+        share_type          reward; // result of util::get_rshare_reward
+        curator_claims_type curator_claims;
+        // false when computation failed - such comment is processed entirely by cashout_comment_helper
+        bool                valid = false;
+      };
+
+      void fill_comment_reward_context( util::comment_reward_context& ctx, const comment_cashout_object& comment_cashout,
+        const comment_cashout_ex_object* comment_cashout_ex ) const;
+      void compute_curator_claims( const comment_object& comment, const comment_cashout_object& comment_cashout,
+        share_type max_rewards, curator_claims_type& claims ) const;
+      bool precompute_comment_payouts( const util::comment_reward_context& ctx,
+        const std::vector< const comment_cashout_object* >& comment_cashouts,
+        std::vector< comment_payout_precomputation >& results ) const;
+      share_type pay_curators( const comment_object& comment, const comment_cashout_object& comment_cashout, share_type& max_rewards,
+        const curator_claims_type* precomputed_claims = nullptr );
       share_type cashout_comment_helper( util::comment_reward_context& ctx, const comment_object& comment,
         const comment_cashout_object& comment_cashout, const comment_cashout_ex_object* comment_cashout_ex,
-        bool forward_curation_remainder = true );
+        bool forward_curation_remainder = true, const comment_payout_precomputation* precomputed = nullptr );
       void process_comment_cashout();
       void process_funds();
       void process_conversions();
@@ -603,6 +678,8 @@ namespace chain {
       void set_hardfork( uint32_t hardfork, bool process_now = true );
 
       void validate_invariants()const;
+      /// like validate_invariants but only looks at objects changed by last block (false when their changes are not known)
+      bool validate_block_invariants()const;
       /**
         * @}
         */
@@ -610,7 +687,17 @@ namespace chain {
       const std::string& get_json_schema() const;
 
       void set_flush_interval( uint32_t flush_blocks );
+      /// number of threads (calling one and workers of thread pool) used to compute comment payouts (0 or 1 means no parallel computation)
+      void set_comment_cashout_threads( uint32_t threads ) { _comment_cashout_threads = threads; }
       void check_free_memory( bool force_print, uint32_t current_block_num );
+      /// rebuilds shared memory file to reclaim fragmented space (only possible when there are no undo states)
+      void compact_shared_memory();
+      /**
+        * Reserves buckets of hashed indices (comment by_permlink) for half again as many objects as they hold, so
+        * their growth does not rehash (relink all comments) while block is processed. Done when state is loaded and
+        * when node enters live mode. Costs a pointer of shared memory per bucket. Requires write lock.
+        */
+      void reserve_hashed_index_buckets();
 
       void apply_transaction( const std::shared_ptr<full_transaction_type>& trx, uint32_t skip = skip_nothing );
 
@@ -642,13 +729,16 @@ namespace chain {
       // current witnesses_schedule_object; after, it's future_witness_schedule_object
       const witness_schedule_object& get_witness_schedule_object_for_irreversibility() const;
 
+      /// applies block directly to state (used in replay, without undo session) - async observers are notified right away
       void apply_block(const std::shared_ptr<full_block_type>& full_block, uint32_t skip = skip_nothing, const block_flow_control* block_ctrl = nullptr );
+      /// applies block in undo session - async observers are notified once the session is committed
       void apply_block_extended(  const std::shared_ptr<full_block_type>& full_block,
                                   uint32_t skip = skip_nothing,
                                   const block_flow_control* block_ctrl = nullptr );
       struct node_status_t {
         uint32_t last_processed_block_num;
         fc::time_point_sec last_processed_block_time;
+        chainbase::mapping_statistics shared_memory;
       };
       node_status_t get_node_status();
     protected:
@@ -656,9 +746,15 @@ namespace chain {
       //void pop_undo() { object_database::pop_undo(); }
       void notify_changed_objects();
 
+      virtual void on_replica_remapped() override;
+
     private:
       optional< chainbase::database::session > _pending_tx_session;
 
+      /// applies block with its checks; returns notification for async observers (null when there are none), to be
+      /// enqueued by caller once the block is final - notification of block that failed is dropped
+      std::shared_ptr< async_block_notification > apply_block_internal( const std::shared_ptr<full_block_type>& full_block,
+        uint32_t skip, const block_flow_control* block_ctrl );
       void _apply_block(const std::shared_ptr<full_block_type>& full_block, const block_flow_control* block_ctrl = nullptr );
       void validate_transaction(const std::shared_ptr<full_transaction_type>& full_transaction, uint32_t skip);
       void _apply_transaction( const std::shared_ptr<full_transaction_type>& trx );
@@ -805,6 +901,13 @@ namespace chain {
       uint16_t                      _shared_file_full_threshold = 0;
       uint16_t                      _shared_file_scale_rate = 0;
 
+      uint32_t                      _comment_cashout_threads = 0;
+      blockchain_worker_thread_pool* _worker_thread_pool = nullptr;
+
+      bool                          _validate_invariants_per_block = false;
+      uint32_t                      _full_invariants_validation_interval = 0;
+      bool                          _block_invariants_skip_reported = false; ///< per block validation was not possible and it was logged
+
       bool                          snapshot_loaded = false;
 
       flat_map< custom_id_type, std::shared_ptr< custom_operation_interpreter > >   _custom_operation_interpreters;
@@ -812,12 +915,36 @@ namespace chain {
 
       util::advanced_benchmark_dumper  _benchmark_dumper;
 
+      util::async_notification_dispatcher        _async_notification_dispatcher;
+      /// collects copies of operations of currently applied block (only when there are async observers)
+      std::shared_ptr< async_block_notification > _async_block_note;
+
       fc::signal<void(const operation_notification&)>       _pre_apply_operation_signal;
       /**
         *  This signal is emitted for plugins to process every operation after it has been fully applied.
         */
       fc::signal<void(const operation_notification&)>       _post_apply_operation_signal;
 
+      struct typed_operation_handler
+      {
+        /// cleared when connection returned to the owner of the handler is disconnected (checked without lock)
+        std::shared_ptr< std::atomic< bool > > alive;
+        int32_t                     group = 0;
+        apply_operation_handler_t   func;
+      };
+      /// handlers registered for selected operation types, indexed by operation type
+      using typed_operation_handlers_t = std::vector< std::vector< typed_operation_handler > >;
+
+      void notify_typed_operation_handlers( const typed_operation_handlers_t& handlers, const operation_notification& note );
+      /// drops typed handlers whose connections were disconnected (they are not called anymore, but still take space)
+      void remove_disconnected_typed_operation_handlers();
+
+      typed_operation_handlers_t                            _pre_apply_operation_handlers_by_type;
+      typed_operation_handlers_t                            _post_apply_operation_handlers_by_type;
+      /// never emitted - only source of connections returned for typed operation handlers; disconnection releases slot
+      /// of the connection, which clears alive flag of the handler
+      fc::signal<void()>                                    _typed_operation_handler_registry;
+
       fc::signal<void(const custom_operation_notification&)> _pre_apply_custom_operation_signal;
       fc::signal<void(const custom_operation_notification&)> _post_apply_custom_operation_signal;
 
@@ -78,6 +78,7 @@ enum object_type
   comment_cashout_object_type,
   comment_cashout_ex_object_type,
   recurrent_transfer_object_type,
+  account_cold_object_type,
   // RC objects
   rc_resource_param_object_type,
   rc_pool_object_type,
@@ -131,6 +132,7 @@ class proposal_vote_object;
 class comment_cashout_object;
 class comment_cashout_ex_object;
 class recurrent_transfer_object;
+class account_cold_object;
 
 class rc_resource_param_object;
 class rc_pool_object;
@@ -182,6 +184,7 @@ typedef oid_ref< proposal_vote_object                   > proposal_vote_id_type;
 typedef oid_ref< comment_cashout_object                 > comment_cashout_id_type;
 typedef oid_ref< comment_cashout_ex_object              > comment_cashout_ex_id_type;
 typedef oid_ref< recurrent_transfer_object              > recurrent_transfer_id_type;
+typedef oid_ref< account_cold_object                    > account_cold_id_type;
 typedef oid_ref< witness_schedule_object                > witness_schedule_object_id_type;
 
 typedef oid_ref< rc_resource_param_object               > rc_resource_param_id_type;
@@ -349,6 +352,7 @@ FC_REFLECT_ENUM( hive::chain::object_type,
             (comment_cashout_object_type)
             (comment_cashout_ex_object_type)
             (recurrent_transfer_object_type)
+            (account_cold_object_type)
 
             (rc_resource_param_object_type)
             (rc_pool_object_type)
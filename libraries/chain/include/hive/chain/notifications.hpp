@@ -49,6 +49,43 @@ struct operation_notification
   bool                virtual_op = false;
 };
 
+/**
+  * Self-contained copy of operation_notification, safe to use after the operation was applied
+  * (and on other threads).
+  */
+struct async_operation_notification
+{
+  explicit async_operation_notification( const operation_notification& note ) :
+    trx_id( note.trx_id ), block( note.block ), trx_in_block( note.trx_in_block ), op_in_trx( note.op_in_trx ),
+    op( note.op ), virtual_op( note.virtual_op ) {}
+
+  transaction_id_type        trx_id;
+  int64_t                    block = 0;
+  int64_t                    trx_in_block = 0;
+  int64_t                    op_in_trx = 0;
+  hive::protocol::operation  op;
+  bool                       virtual_op = false;
+};
+
+/**
+  * Immutable summary of applied block delivered to asynchronous observers after the block was fully
+  * applied. Contains all (also virtual) operations of the block in order of their post-apply notification.
+  */
+struct async_block_notification
+{
+  async_block_notification( const block_notification& note ) :
+    block_id( note.block_id ), prev_block_id( note.prev_block_id ), block_num( note.block_num ),
+    full_block( note.full_block ) {}
+
+  fc::time_point_sec get_block_timestamp() const { return full_block->get_block_header().timestamp; }
+
+  hive::protocol::block_id_type                  block_id;
+  hive::protocol::block_id_type                  prev_block_id;
+  uint32_t                                       block_num = 0;
+  std::shared_ptr<full_block_type>               full_block;
+  std::vector< async_operation_notification >    operations;
+};
+
 struct comment_reward_notification
 {
   comment_reward_notification( const share_type& _total_reward, share_type _author_tokens, share_type _curation_tokens )
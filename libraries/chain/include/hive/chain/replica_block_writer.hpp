@@ -0,0 +1,101 @@
+#pragma once
+
+#include <hive/chain/block_write_interface.hpp>
+
+#include <hive/chain/block_log.hpp>
+#include <hive/chain/block_log_reader.hpp>
+
+#include <appbase/application.hpp>
+
+namespace hive { namespace chain {
+
+  using appbase::application;
+
+  /**
+   * Block writer of read replica (see chainbase::database::read_only). Replica never writes blocks, it only
+   * reads block log appended by writer process. Since block log caches its head block, replica opens block
+   * log again (read-only) whenever writer's last irreversible block moves past head of currently open one, and
+   * replaces old instance, which is released when last reader holding it is done.
+   * Reversible blocks are held only in memory of writer, so replica serves just irreversible ones.
+   */
+  class replica_block_writer : public block_write_i
+  {
+  public:
+    replica_block_writer( application& app );
+    virtual ~replica_block_writer() = default;
+
+    virtual block_read_i& get_block_reader() override;
+
+    virtual void store_block( uint32_t current_irreversible_block_num,
+                              uint32_t state_head_block_number ) override
+      { FC_ASSERT( false, "Read replica does not write blocks" ); }
+
+    virtual void pop_block() override { FC_ASSERT( false, "Read replica does not write blocks" ); }
+
+    virtual std::optional<new_last_irreversible_block_t> find_new_last_irreversible_block(
+      const std::vector<const witness_object*>& scheduled_witness_objects,
+      const std::map<account_name_type, block_id_type>& last_fast_approved_block_by_witness,
+      const unsigned witnesses_required_for_irreversiblity,
+      const uint32_t old_last_irreversible ) const override
+      { FC_ASSERT( false, "Read replica does not write blocks" ); }
+
+    void open( const fc::path& file, hive::chain::blockchain_worker_thread_pool& thread_pool );
+    /// Opens block log again if its head is behind given block; returns true when new blocks became visible.
+    bool refresh( uint32_t last_irreversible_block_num, hive::chain::blockchain_worker_thread_pool& thread_pool );
+    void close();
+
+  private:
+    struct log_view
+    {
+      log_view( application& app ) : log( app ), reader( log ) {}
+
+      block_log         log;
+      block_log_reader  reader;
+    };
+
+    /// forwards all calls to most recently opened instance of block log
+    class reader : public block_read_i
+    {
+    public:
+      virtual ~reader() = default;
+
+      virtual std::shared_ptr<full_block_type> head_block() const override;
+      virtual uint32_t head_block_num(
+        fc::microseconds wait_for_microseconds = fc::microseconds() ) const override;
+      virtual block_id_type head_block_id(
+        fc::microseconds wait_for_microseconds = fc::microseconds() ) const override;
+      virtual std::shared_ptr<full_block_type> read_block_by_num( uint32_t block_num ) const override;
+      virtual void process_blocks( uint32_t starting_block_number, uint32_t ending_block_number,
+                                   block_processor_t processor, hive::chain::blockchain_worker_thread_pool& thread_pool ) const override;
+      virtual std::shared_ptr<full_block_type> fetch_block_by_number( uint32_t block_num,
+        fc::microseconds wait_for_microseconds = fc::microseconds() ) const override;
+      virtual std::shared_ptr<full_block_type> fetch_block_by_id(
+        const block_id_type& id ) const override;
+      virtual bool is_known_block( const block_id_type& id ) const override;
+      virtual std::deque<block_id_type>::const_iterator find_first_item_not_in_blockchain(
+        const std::deque<block_id_type>& item_hashes_received ) const override;
+      virtual block_id_type find_block_id_for_num( uint32_t block_num ) const override;
+      virtual std::vector<std::shared_ptr<full_block_type>> fetch_block_range(
+        const uint32_t starting_block_num, const uint32_t count,
+        fc::microseconds wait_for_microseconds = fc::microseconds() ) const override;
+      virtual std::vector<block_id_type> get_blockchain_synopsis(
+        const block_id_type& reference_point,
+        uint32_t number_of_blocks_after_reference_point ) const override;
+      virtual std::vector<block_id_type> get_block_ids(
+        const std::vector<block_id_type>& blockchain_synopsis,
+        uint32_t& remaining_item_count,
+        uint32_t limit) const override;
+
+      std::shared_ptr<const log_view> get_current() const;
+      void set_current( std::shared_ptr<const log_view> current );
+
+    private:
+      std::shared_ptr<const log_view> _current;
+    };
+
+    reader        _reader;
+    fc::path      _file;
+    application&  _app;
+  };
+
+} }
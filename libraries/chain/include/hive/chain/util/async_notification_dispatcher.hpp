@@ -0,0 +1,58 @@
+#pragma once
+
+#include <hive/chain/notifications.hpp>
+
+#include <fc/signals.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace hive { namespace chain { namespace util {
+
+/**
+  * Delivers notifications about applied blocks to read-only observers on a dedicated thread, so
+  * such observers don't add to block application time. Notifications are delivered in order.
+  * When the queue is full, enqueue waits - observers that can't keep up slow down block processing
+  * instead of consuming unlimited memory.
+  *
+  * Handlers must not access chain state (it might already reflect later blocks), only data
+  * contained in the notification.
+  */
+class async_notification_dispatcher
+{
+  public:
+    using handler_t = std::function< void( const async_block_notification& ) >;
+
+    explicit async_notification_dispatcher( size_t max_queue_size = 100 );
+    ~async_notification_dispatcher();
+
+    boost::signals2::connection connect( const handler_t& handler );
+    bool has_handlers() const { return !_signal.empty(); }
+
+    void enqueue( std::shared_ptr< const async_block_notification > note );
+    /// waits until all notifications enqueued so far are delivered
+    void flush();
+    /// delivers remaining notifications and stops worker thread
+    void stop();
+
+  private:
+    void worker_main();
+
+    boost::signals2::signal< void( const async_block_notification& ) >  _signal;
+
+    std::mutex                                                   _mutex;
+    std::condition_variable                                      _queue_cv;
+    std::condition_variable                                      _space_cv;
+    std::deque< std::shared_ptr< const async_block_notification > > _queue;
+    size_t                                                       _max_queue_size;
+    bool                                                         _running = false;
+    bool                                                         _busy = false;
+    bool                                                         _stop = false;
+    std::thread                                                  _worker;
+};
+
+} } } // hive::chain::util
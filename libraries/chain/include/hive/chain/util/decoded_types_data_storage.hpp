@@ -321,6 +321,7 @@ namespace decoders
       }
       /* Boost types. We control boost types via checking boost version, so only check if typeid of these types match (it will change in case of any template parameters change). */
       else if constexpr (is_specialization<T, boost::interprocess::allocator>::value ||
+                         is_specialization<T, chainbase::segment_allocator>::value ||
                          is_specialization<T, boost::container::basic_string>::value ||
                          is_specialization<T, boost::container::flat_map>::value ||
                          is_specialization<T, boost::container::flat_set>::value ||
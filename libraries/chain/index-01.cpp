@@ -11,6 +11,7 @@ void initialize_core_indexes_01( database& db )
 {
   HIVE_ADD_CORE_INDEX(db, dynamic_global_property_index);
   HIVE_ADD_CORE_INDEX(db, account_index);
+  HIVE_ADD_CORE_INDEX(db, account_cold_index);
   HIVE_ADD_CORE_INDEX(db, account_metadata_index);
 }
 
@@ -18,4 +19,5 @@ void initialize_core_indexes_01( database& db )
 
 HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::chain::dynamic_global_property_index)
 HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::chain::account_index)
+HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::chain::account_cold_index)
 HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::chain::account_metadata_index)
@@ -0,0 +1,138 @@
+#include <hive/chain/replica_block_writer.hpp>
+
+namespace hive { namespace chain {
+
+replica_block_writer::replica_block_writer( application& app )
+  : _app( app )
+{}
+
+block_read_i& replica_block_writer::get_block_reader()
+{
+  return _reader;
+}
+
+void replica_block_writer::open( const fc::path& file, hive::chain::blockchain_worker_thread_pool& thread_pool )
+{
+  _file = file;
+  auto view = std::make_shared< log_view >( _app );
+  view->log.open( _file, thread_pool, true );
+  _reader.set_current( view );
+}
+
+bool replica_block_writer::refresh( uint32_t last_irreversible_block_num, hive::chain::blockchain_worker_thread_pool& thread_pool )
+{
+  const uint32_t head_block_num = _reader.head_block_num();
+  if( head_block_num >= last_irreversible_block_num )
+    return false;
+
+  try
+  {
+    auto view = std::make_shared< log_view >( _app );
+    view->log.open( _file, thread_pool, true );
+    if( view->reader.head_block_num() <= head_block_num )
+      return false;
+    _reader.set_current( view );
+    return true;
+  }
+  catch( const fc::exception& e )
+  {
+    // writer might be in the middle of appending block (block log and artifacts don't match yet) - next try picks it up
+    dlog( "Unable to open block log of writer: ${e}", ( "e", e.to_detail_string() ) );
+    return false;
+  }
+}
+
+void replica_block_writer::close()
+{
+  _reader.set_current( std::shared_ptr< const log_view >() );
+}
+
+std::shared_ptr<const replica_block_writer::log_view> replica_block_writer::reader::get_current() const
+{
+  auto current = std::atomic_load( &_current );
+  FC_ASSERT( current, "Block log of read replica is not open" );
+  return current;
+}
+
+void replica_block_writer::reader::set_current( std::shared_ptr<const log_view> current )
+{
+  std::atomic_store( &_current, std::move( current ) );
+}
+
+std::shared_ptr<full_block_type> replica_block_writer::reader::head_block() const
+{
+  return get_current()->reader.head_block();
+}
+
+uint32_t replica_block_writer::reader::head_block_num(
+  fc::microseconds wait_for_microseconds /*= fc::microseconds()*/ ) const
+{
+  return get_current()->reader.head_block_num( wait_for_microseconds );
+}
+
+block_id_type replica_block_writer::reader::head_block_id(
+  fc::microseconds wait_for_microseconds /*= fc::microseconds()*/ ) const
+{
+  return get_current()->reader.head_block_id( wait_for_microseconds );
+}
+
+std::shared_ptr<full_block_type> replica_block_writer::reader::read_block_by_num( uint32_t block_num ) const
+{
+  return get_current()->reader.read_block_by_num( block_num );
+}
+
+void replica_block_writer::reader::process_blocks( uint32_t starting_block_number, uint32_t ending_block_number,
+  block_processor_t processor, hive::chain::blockchain_worker_thread_pool& thread_pool ) const
+{
+  get_current()->reader.process_blocks( starting_block_number, ending_block_number, processor, thread_pool );
+}
+
+std::shared_ptr<full_block_type> replica_block_writer::reader::fetch_block_by_number( uint32_t block_num,
+  fc::microseconds wait_for_microseconds /*= fc::microseconds()*/ ) const
+{
+  return get_current()->reader.fetch_block_by_number( block_num, wait_for_microseconds );
+}
+
+std::shared_ptr<full_block_type> replica_block_writer::reader::fetch_block_by_id(
+  const block_id_type& id ) const
+{
+  return get_current()->reader.fetch_block_by_id( id );
+}
+
+bool replica_block_writer::reader::is_known_block( const block_id_type& id ) const
+{
+  return get_current()->reader.is_known_block( id );
+}
+
+std::deque<block_id_type>::const_iterator replica_block_writer::reader::find_first_item_not_in_blockchain(
+  const std::deque<block_id_type>& item_hashes_received ) const
+{
+  return get_current()->reader.find_first_item_not_in_blockchain( item_hashes_received );
+}
+
+block_id_type replica_block_writer::reader::find_block_id_for_num( uint32_t block_num ) const
+{
+  return get_current()->reader.find_block_id_for_num( block_num );
+}
+
+std::vector<std::shared_ptr<full_block_type>> replica_block_writer::reader::fetch_block_range(
+  const uint32_t starting_block_num, const uint32_t count,
+  fc::microseconds wait_for_microseconds /*= fc::microseconds()*/ ) const
+{
+  return get_current()->reader.fetch_block_range( starting_block_num, count, wait_for_microseconds );
+}
+
+std::vector<block_id_type> replica_block_writer::reader::get_blockchain_synopsis(
+  const block_id_type& reference_point, uint32_t number_of_blocks_after_reference_point ) const
+{
+  return get_current()->reader.get_blockchain_synopsis( reference_point, number_of_blocks_after_reference_point );
+}
+
+std::vector<block_id_type> replica_block_writer::reader::get_block_ids(
+  const std::vector<block_id_type>& blockchain_synopsis, uint32_t& remaining_item_count,
+  uint32_t limit ) const
+{
+  return get_current()->reader.get_block_ids( blockchain_synopsis, remaining_item_count, limit );
+}
+
+} } //hive::chain
@@ -0,0 +1,105 @@
+#include <hive/chain/util/async_notification_dispatcher.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
+
+namespace hive { namespace chain { namespace util {
+
+async_notification_dispatcher::async_notification_dispatcher( size_t max_queue_size )
+  : _max_queue_size( max_queue_size ) {}
+
+async_notification_dispatcher::~async_notification_dispatcher()
+{
+  stop();
+}
+
+boost::signals2::connection async_notification_dispatcher::connect( const handler_t& handler )
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  if( !_running )
+  {
+    _stop = false;
+    _running = true;
+    _worker = std::thread( [this]() { worker_main(); } );
+  }
+  return _signal.connect( handler );
+}
+
+void async_notification_dispatcher::enqueue( std::shared_ptr< const async_block_notification > note )
+{
+  std::unique_lock< std::mutex > lock( _mutex );
+  if( !_running || _stop )
+    return;
+  _space_cv.wait( lock, [this]() { return _queue.size() < _max_queue_size || _stop; } );
+  if( _stop )
+    return;
+  _queue.emplace_back( std::move( note ) );
+  _queue_cv.notify_one();
+}
+
+void async_notification_dispatcher::flush()
+{
+  std::unique_lock< std::mutex > lock( _mutex );
+  _space_cv.wait( lock, [this]() { return ( _queue.empty() && !_busy ) || !_running; } );
+}
+
+void async_notification_dispatcher::stop()
+{
+  {
+    std::lock_guard< std::mutex > guard( _mutex );
+    if( !_running || _stop )
+      return;
+    _stop = true;
+  }
+  _queue_cv.notify_all();
+  _space_cv.notify_all();
+  _worker.join();
+  {
+    std::lock_guard< std::mutex > guard( _mutex );
+    _running = false;
+  }
+  _space_cv.notify_all();
+}
+
+void async_notification_dispatcher::worker_main()
+{
+  fc::set_thread_name( "async_notify" );
+  fc::thread::current().set_name( "async_notify" );
+
+  while( true )
+  {
+    std::shared_ptr< const async_block_notification > note;
+    {
+      std::unique_lock< std::mutex > lock( _mutex );
+      _queue_cv.wait( lock, [this]() { return !_queue.empty() || _stop; } );
+      if( _queue.empty() )
+        break; // stop requested and everything delivered
+      note = std::move( _queue.front() );
+      _queue.pop_front();
+      _busy = true;
+    }
+    _space_cv.notify_all();
+
+    try
+    {
+      _signal( *note );
+    }
+    catch( const fc::exception& e )
+    {
+      elog( "Caught exception in asynchronous plugin notification: ${e}", ( "e", e.to_detail_string() ) );
+    }
+    catch( const std::exception& e )
+    {
+      elog( "Caught exception in asynchronous plugin notification: ${e}", ( "e", e.what() ) );
+    }
+
+    {
+      std::lock_guard< std::mutex > guard( _mutex );
+      _busy = false;
+    }
+    _space_cv.notify_all();
+  }
+}
+
+} } } // hive::chain::util
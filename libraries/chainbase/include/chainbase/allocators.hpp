@@ -12,9 +12,13 @@
 #include <boost/interprocess/sync/sharable_lock.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
 
+#include <boost/multi_index/detail/index_node_base.hpp>
+
 #include <boost/thread.hpp>
 #include <boost/thread/locks.hpp>
 
+#include <chainbase/util/node_pool.hpp>
+
 #include <type_traits>
 
 namespace chainbase {
@@ -24,12 +28,98 @@ namespace chainbase {
   // If you want to use the std allocator instead of the boost::interprocess one (for testing purposes) uncomment the following line:
   // #define ENABLE_STD_ALLOCATOR // ENABLE_STD_ALLOCATOR option has been removed from CMake file.
 
+#ifndef ENABLE_STD_ALLOCATOR
+  namespace detail
+  {
+    template< typename Value, typename Allocator >
+    std::true_type is_multi_index_node_test( const boost::multi_index::detail::index_node_base< Value, Allocator >* );
+    std::false_type is_multi_index_node_test( ... );
+
+    template< typename T >
+    struct is_multi_index_node : decltype( is_multi_index_node_test( static_cast< T* >( nullptr ) ) ) {};
+
+    template< bool POOLED >
+    class node_pool_holder
+    {
+      protected:
+        void init_pool( node_pool::segment_manager*, size_t ) {}
+        node_pool* get_pool()const { return nullptr; }
+    };
+
+    template<>
+    class node_pool_holder< true >
+    {
+      protected:
+        void init_pool( node_pool::segment_manager* manager, size_t node_size ) { _pool = node_pool::get( manager, node_size ); }
+        node_pool* get_pool()const { return _pool.get(); }
+
+      private:
+        bip::offset_ptr< node_pool > _pool;
+    };
+  }
+
+  /**
+    * Allocator of shared memory segment. Nodes of multi_index containers (all chain object indexes) are taken
+    * from node_pool of their size instead of general purpose segment manager, other allocations (strings,
+    * vectors, undo state) go to segment manager like with plain bip::allocator.
+    */
+  template< typename T >
+  class segment_allocator : public bip::allocator< T, bip::managed_mapped_file::segment_manager >,
+    private detail::node_pool_holder< detail::is_multi_index_node< T >::value >
+  {
+    typedef bip::allocator< T, bip::managed_mapped_file::segment_manager > base_type;
+
+    public:
+      typedef typename base_type::segment_manager segment_manager;
+      typedef typename base_type::pointer         pointer;
+      typedef typename base_type::size_type       size_type;
+      typedef typename boost::intrusive::pointer_traits< typename base_type::void_pointer >::template
+        rebind_pointer< const void >::type        cvoid_pointer;
+
+      template< typename T2 >
+      struct rebind
+      {
+        typedef segment_allocator< T2 > other;
+      };
+
+      segment_allocator( segment_manager* manager ) : base_type( manager )
+      {
+        this->init_pool( manager, sizeof( T ) );
+      }
+
+      segment_allocator( const segment_allocator& other ) : base_type( other ), detail::node_pool_holder< detail::is_multi_index_node< T >::value >( other ) {}
+
+      template< typename T2 >
+      segment_allocator( const segment_allocator< T2 >& other ) : base_type( other.get_segment_manager() )
+      {
+        this->init_pool( other.get_segment_manager(), sizeof( T ) );
+      }
+
+      pointer allocate( size_type count, cvoid_pointer hint = cvoid_pointer() )
+      {
+        node_pool* pool = this->get_pool();
+        if( pool != nullptr && count == 1 )
+          return pointer( static_cast< T* >( pool->allocate( this->get_segment_manager() ) ) );
+        return base_type::allocate( count, hint );
+      }
+
+      void deallocate( const pointer& ptr, size_type count )
+      {
+        node_pool* pool = this->get_pool();
+        if( pool != nullptr && count == 1 )
+          pool->deallocate( bip::ipcdetail::to_raw_pointer( ptr ) );
+        else
+          base_type::deallocate( ptr, count );
+      }
+  };
+#endif
+
 #ifdef ENABLE_STD_ALLOCATOR
   template< typename T >
   using allocator = std::allocator< T >;
 #else
   template< typename T >
-  using allocator = bip::allocator<T, bip::managed_mapped_file::segment_manager>;
+  using allocator = segment_allocator< T >;
 #endif
 
   typedef boost::shared_mutex read_write_mutex;
@@ -6,7 +6,9 @@
 #include <boost/interprocess/containers/flat_map.hpp>
 #include <boost/interprocess/containers/deque.hpp>
 #include <boost/interprocess/containers/string.hpp>
+#include <boost/interprocess/containers/vector.hpp>
 #include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
 #include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
 #include <boost/interprocess/sync/sharable_lock.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
@@ -16,20 +18,29 @@
 #include <boost/config.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/range_c.hpp>
+#include <boost/mpl/size.hpp>
 #include <boost/thread.hpp>
 #include <boost/throw_exception.hpp>
 
 #include <chainbase/allocators.hpp>
 #include <chainbase/state_snapshot_support.hpp>
+#include <chainbase/util/memory_mapping.hpp>
 #include <chainbase/util/object_id.hpp>
+#include <chainbase/util/replica_sync.hpp>
+#include <chainbase/util/undo_journal.hpp>
 
 #include <fc/exception/exception.hpp>
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <stdexcept>
+#include <type_traits>
 #include <typeindex>
 #include <typeinfo>
 
@@ -82,8 +93,35 @@ namespace helpers
     size_t      _item_additional_allocation = 0;
     /// Additional memory used for container internal structures (like tree nodes).
     size_t      _additional_container_allocation = 0;
+    /// Memory reserved by pool of nodes of the index size class (shared with other indexes with the same node size)
+    size_t      _node_pool_reserved = 0;
+    /// Part of reserved node pool memory that is not used by any node (fragmentation of the size class)
+    size_t      _node_pool_free = 0;
   };
 
+  template <class SubIndexType, class = void>
+  struct is_hashed_index : std::false_type {};
+
+  template <class SubIndexType>
+  struct is_hashed_index<SubIndexType, std::void_t<decltype(std::declval<const SubIndexType&>().bucket_count())>> : std::true_type {};
+
+  /// Memory used by bucket arrays of hashed (sub)indices of given multi_index_container.
+  template <class IndexType>
+  size_t get_hashed_index_bucket_allocation(const IndexType& index)
+  {
+    typedef typename std::allocator_traits<typename IndexType::allocator_type>::void_pointer bucket_type;
+
+    size_t result = 0;
+    boost::mpl::for_each< boost::mpl::range_c< int, 0, boost::mpl::size< typename IndexType::index_type_list >::value > >(
+      [&]( auto n )
+      {
+        const auto& sub_index = index.template get< decltype( n )::value >();
+        if constexpr( is_hashed_index< std::decay_t< decltype( sub_index ) > >::value )
+          result += sub_index.bucket_count() * sizeof( bucket_type );
+      } );
+    return result;
+  }
+
   template <class IndexType>
   void gather_index_static_data(const IndexType& index, index_statistic_info* info)
   {
@@ -100,7 +138,19 @@ namespace helpers
     info->_item_additional_allocation = 0;
     size_t pureNodeSize = sizeof(typename IndexType::MULTIINDEX_NODE_TYPE) -
       sizeof(typename IndexType::value_type);
-    info->_additional_container_allocation = info->_item_count*pureNodeSize;
+    info->_additional_container_allocation = info->_item_count*pureNodeSize +
+      get_hashed_index_bucket_allocation(index);
+
+#ifndef ENABLE_STD_ALLOCATOR
+    const chainbase::node_pool* pool = chainbase::node_pool::find( index.get_allocator().get_segment_manager(),
+      sizeof(typename IndexType::MULTIINDEX_NODE_TYPE) );
+    if( pool != nullptr )
+    {
+      auto pool_info = pool->get_statistics();
+      info->_node_pool_reserved = pool_info.reserved;
+      info->_node_pool_free = pool_info.free;
+    }
+#endif
   }
 
   template <class IndexType>
@@ -225,19 +275,28 @@ namespace chainbase {
       typedef typename value_type::id_type                      id_type;
       typedef allocator< std::pair<const id_type, value_type> > id_value_allocator_type;
       typedef allocator< id_type >                              id_allocator_type;
+      typedef allocator< std::pair<const id_type, uint64_t> >   id_offset_allocator_type;
 
       template<typename T>
       undo_state( allocator<T> al )
       :old_values( id_value_allocator_type( al ) ),
         removed_values( id_value_allocator_type( al ) ),
-        new_ids( id_allocator_type( al ) ){}
+        new_ids( id_allocator_type( al ) ),
+        journal( allocator< char >( al ) ),
+        journal_ends( id_offset_allocator_type( al ) ){}
 
       typedef boost::interprocess::map< id_type, value_type, std::less<id_type>, id_value_allocator_type >  id_value_type_map;
       typedef boost::interprocess::set< id_type, std::less<id_type>, id_allocator_type >                    id_type_set;
+      typedef boost::interprocess::map< id_type, uint64_t, std::less<id_type>, id_offset_allocator_type >   id_offset_map;
 
       id_value_type_map            old_values;
       id_value_type_map            removed_values;
       id_type_set                  new_ids;
+      /// old values of changed members (only for types with undo_journal_enabled, which don't use old_values);
+      /// every modification of object adds records of members it changed
+      t_vector< char >             journal;
+      /// end of newest journal record of every object that has records (start of chain of its records)
+      id_offset_map                journal_ends;
       id_type                      old_next_id = id_type(0);
       int64_t                      revision = 0;
   };
@@ -304,6 +363,10 @@ namespace chainbase {
     *  constant function 'get_id'.  This will be the primary key and it will be assigned and managed by generic_index.
     *
     *  Additionally, the constructor for value_type must take an allocator
+    *
+    *  Since ids are allocated densely, next to the multi_index_container generic_index keeps a table of
+    *  pointers to objects indexed by id (slot table), so lookup by id does not need to walk the tree of primary
+    *  index. Ordered by_id index is still there for iteration and range queries.
     */
   template<typename MultiIndexType>
   class generic_index
@@ -320,12 +383,14 @@ namespace chainbase {
       typedef typename value_type::id_type                          id_type;
       typedef allocator< generic_index >                            allocator_type;
       typedef undo_state< value_type >                              undo_state_type;
+      typedef bip::offset_ptr< const value_type >                   slot_type;
+      typedef t_vector< slot_type >                                 slot_table_type;
 
       generic_index( allocator<value_type> a, bfs::path p )
-      :_stack(a),_indices( a, p ),_size_of_value_type( sizeof(typename MultiIndexType::value_type) ),_size_of_this(sizeof(*this)) {}
+      :_stack(a),_indices( a, p ),_slots( allocator<slot_type>( a ) ),_size_of_value_type( sizeof(typename MultiIndexType::value_type) ),_size_of_this(sizeof(*this)) {}
 
       generic_index( allocator<value_type> a )
-      :_stack(a),_indices( a ),_size_of_value_type( sizeof(typename MultiIndexType::value_type) ),_size_of_this(sizeof(*this)) {}
+      :_stack(a),_indices( a ),_slots( allocator<slot_type>( a ) ),_size_of_value_type( sizeof(typename MultiIndexType::value_type) ),_size_of_this(sizeof(*this)) {}
 
       /**
         * Construct a new element in the multi_index_container.
@@ -343,6 +408,7 @@ namespace chainbase {
         }
 
         ++_next_id;
+        set_slot( *insert_result.first );
         on_create( *insert_result.first );
         return *insert_result.first;
       }
@@ -370,12 +436,30 @@ namespace chainbase {
 
         ++_next_id;
 
+        set_slot(*insert_result.first);
         on_create(*insert_result.first);
         }
 
       template<typename Modifier>
       void modify( const value_type& obj, Modifier&& m ) {
+        if constexpr( undo_journal_enabled< value_type >::value )
+        {
+          if( enabled() && obj.get_id().get_value() < _stack.back().old_next_id.get_value() )
+          {
+            // snapshot is local and only used to find changed members (objects created within the session
+            // need no undo data)
+            undo_journal::snapshot< value_type > before( obj );
+            modify_object( obj, std::forward<Modifier>( m ), &before );
+            return;
+          }
+        }
         on_modify( obj );
+        modify_object( obj, std::forward<Modifier>( m ), nullptr );
+      }
+
+    private:
+      template<typename Modifier>
+      void modify_object( const value_type& obj, Modifier&& m, const undo_journal::snapshot< value_type >* before ) {
 
         fc::exception_ptr fc_exception_ptr;
         std::exception_ptr std_exception_ptr;
@@ -396,9 +480,16 @@ namespace chainbase {
         };
 
         auto itr = _indices.iterator_to( obj );
+        const id_type obj_id = obj.get_id();
 
         auto ok = _indices.modify( itr, safe_modifier);
 
+        if constexpr( undo_journal_enabled< value_type >::value )
+        {
+          if( before != nullptr )
+            on_journaled_modify( obj_id, *before, ok ? &obj : nullptr );
+        }
+
         if(fc_exception_ptr)
           fc_exception_ptr->dynamic_rethrow_exception();
         else if(std_exception_ptr)
@@ -406,13 +497,17 @@ namespace chainbase {
 
         if(!ok)
         {
+          // multi_index_container drops object that failed to be reindexed
+          clear_slot( obj_id );
           CHAINBASE_THROW_EXCEPTION(std::logic_error(
             "Could not modify object, most likely a uniqueness constraint was violated inside index holding types: " + get_type_name()));
         }
       }
 
+    public:
       void remove( const value_type& obj ) {
         on_remove( obj );
+        clear_slot( obj.get_id() );
         _indices.erase( _indices.iterator_to( obj ) );
       }
 
@@ -420,6 +515,7 @@ namespace chainbase {
       typename MultiIndexType::template index_iterator<ByIndex>::type erase(typename MultiIndexType::template index_iterator<ByIndex>::type objI) {
         auto& idx = _indices.template get< ByIndex >();
         on_remove( *objI );
+        clear_slot( objI->get_id() );
         return idx.erase(objI);
       }
 
@@ -436,6 +532,7 @@ namespace chainbase {
           ++nextI;
           if(allow_removal)
           {
+            clear_slot( objectI->get_id() );
             auto successor = idx.erase(objectI);
             FC_ASSERT(successor == nextI);
             objectI = successor;
@@ -450,9 +547,25 @@ namespace chainbase {
 
       template<typename CompatibleKey>
       const value_type* find( CompatibleKey&& key )const {
-        auto itr = _indices.find( std::forward<CompatibleKey>( key ) );
-        if( itr != _indices.end() ) return &*itr;
-        return nullptr;
+        if constexpr( std::is_convertible< CompatibleKey, id_type >::value )
+        {
+          return find_by_id( key );
+        }
+        else
+        {
+          auto itr = _indices.find( std::forward<CompatibleKey>( key ) );
+          if( itr != _indices.end() ) return &*itr;
+          return nullptr;
+        }
+      }
+
+      /// O(1) lookup of object by its id (uses slot table)
+      const value_type* find_by_id( const id_type& id )const {
+        size_t pos = id.get_value();
+        if( pos < _slot_base ) return nullptr;
+        pos -= _slot_base;
+        if( pos >= _slots.size() ) return nullptr;
+        return _slots[ pos ].get();
       }
 
       template<typename CompatibleKey>
@@ -466,7 +579,33 @@ namespace chainbase {
 
       const index_type& indices()const { return _indices; }
 
-      void clear() { _indices.clear(); }
+      void clear()
+      {
+        _indices.clear();
+        _slots.clear();
+        _slot_base = 0;
+        _leading_free_slots = 0;
+      }
+
+      /// memory allocated for slot table (used in index statistics)
+      size_t get_slot_table_allocation()const { return _slots.capacity() * sizeof( slot_type ); }
+
+      /**
+        * Makes hashed subindices (if any) able to hold given number of objects without rehashing. Rehash allocates
+        * new bucket array and relinks every node of subindex in single call, which on big index is a noticeable stall
+        * of whatever operation inserted the object - reserving moves that cost to the time of the call. Bucket costs
+        * a pointer in shared memory and buckets are never released, so reservation should not be excessive.
+        */
+      void reserve_buckets( size_t count )
+      {
+        boost::mpl::for_each< boost::mpl::range_c< int, 0, boost::mpl::size< typename index_type::index_type_list >::value > >(
+          [&]( auto n )
+          {
+            auto& sub_index = _indices.template get< decltype( n )::value >();
+            if constexpr( helpers::is_hashed_index< std::decay_t< decltype( sub_index ) > >::value )
+              sub_index.reserve( count );
+          } );
+      }
 
       class session {
         public:
@@ -523,6 +662,55 @@ namespace chainbase {
       const index_type& indicies()const { return _indices; }
       int64_t revision()const { return _revision; }
 
+      /**
+        * Calls visitor for every object changed within the most recent undo state, passing pointers to
+        * its value from before the change (nullptr for created objects) and its current value (nullptr
+        * for removed objects). Cost is proportional to the number of changed objects.
+        * Returns false when undo is disabled, that is, there are no changes recorded.
+        */
+      template< typename Visitor >
+      bool visit_undo_state_changes( Visitor&& visitor )const
+      {
+        if( !enabled() ) return false;
+
+        const auto& head = _stack.back();
+
+        auto get_current = [&]( const id_type& id ) -> const value_type&
+        {
+          auto itr = _indices.find( id );
+          if( itr == _indices.end() )
+          {
+            CHAINBASE_THROW_EXCEPTION(std::logic_error("unable to find object with id: " +
+              std::to_string(id) + "in the index holding types: " + get_type_name()));
+          }
+          return *itr;
+        };
+
+        for( const auto& item : head.old_values )
+          visitor( &item.second, &get_current( item.first ) );
+        for( const auto& id : head.new_ids )
+          visitor( static_cast< const value_type* >( nullptr ), &get_current( id ) );
+
+        for( const auto& item : head.removed_values )
+          visitor( &item.second, static_cast< const value_type* >( nullptr ) );
+
+        if constexpr( undo_journal_enabled< value_type >::value )
+        {
+          // values from before the change are reconstructed by reverting journal on copies (removed objects
+          // were already reported)
+          for( const auto& item : head.journal_ends )
+          {
+            if( !is_only_journaled( head, item.first ) )
+              continue;
+            const value_type& current = get_current( item.first );
+            value_type old_value = current.copy_chain_object();
+            revert_journaled_changes( head, old_value );
+            visitor( &old_value, &current );
+          }
+        }
+        return true;
+      }
+
       id_type get_next_id() const
       {
         return _next_id;
@@ -533,6 +721,31 @@ namespace chainbase {
         _next_id = next_id;
       }
 
+      /**
+        * Fills empty index with copies of all objects of source index (usually placed in different segment).
+        * Objects are copied in order of their ids, so they are also allocated in that order. Copy is made through
+        * fc::raw serialization used by snapshots, which correctly recreates members holding allocated memory.
+        * Source index can't have undo states.
+        */
+      void copy_from( const generic_index& source )
+      {
+        if( source.enabled() )
+          CHAINBASE_THROW_EXCEPTION( std::logic_error( "cannot copy index with undo states: " + get_type_name() ) );
+        if( !_indices.empty() || enabled() )
+          CHAINBASE_THROW_EXCEPTION( std::logic_error( "copy target has to be empty: " + get_type_name() ) );
+
+        std::vector< char > buffer;
+        for( const auto& item : source.indices().template get< by_id >() )
+        {
+          serialization::pack_to_buffer( buffer, item );
+          unpack_from_snapshot( item.get_id(),
+            [&buffer]( value_type& v ) { serialization::unpack_from_buffer( v, buffer ); },
+            [&item]( const fc::variant& ) { return "copy of object with id " + std::to_string( item.get_id() ); } );
+        }
+        _next_id = source._next_id;
+        _revision = source._revision;
+      }
+
       /**
         *  Restores the state to how it was prior to the current session discarding all changes
         *  made between the last revision and the current revision.
@@ -542,6 +755,51 @@ namespace chainbase {
 
         auto& head = _stack.back();
 
+        // same order as for objects with whole old values - changes are reverted before new objects are erased
+        // and removed ones restored (removed objects already hold values from before the session)
+        if constexpr( undo_journal_enabled< value_type >::value )
+        {
+          auto revert = [&]( id_type id, auto&& restore_members )
+          {
+            auto itr = _indices.find( id );
+            bool ok = _indices.modify( itr, restore_members );
+            if( !ok )
+            {
+              clear_slot( id );
+              CHAINBASE_THROW_EXCEPTION(std::logic_error(
+                "Could not modify object, most likely a uniqueness constraint was violated inside index holding types: "
+                  + get_type_name()));
+            }
+          };
+          // records of single modification are restored together, so object never gets mix of old and new members
+          // that could collide with other object
+          struct record { uint16_t member; const char* data; uint32_t size; };
+          std::vector< record > records;
+          id_type records_id( 0 );
+          auto flush_records = [&]()
+          {
+            if( records.empty() )
+              return;
+            revert( records_id, [&]( value_type& v ) {
+              for( const auto& r : records )
+                undo_journal::restore( v, r.member, r.data, r.size );
+            });
+            records.clear();
+          };
+          undo_journal::for_each_record_reversed( head.journal,
+            [&]( uint32_t id, uint16_t member, const char* data, uint32_t size )
+            {
+              id_type obj_id( id );
+              if( !records.empty() && obj_id != records_id )
+                flush_records();
+              if( !is_only_journaled( head, obj_id ) )
+                return;
+              records_id = obj_id;
+              records.push_back( { member, data, size } );
+            } );
+          flush_records();
+        }
+
         for( auto& item : head.old_values ) {
           bool ok = false;
           auto itr = _indices.find( item.second.get_id() );
@@ -550,10 +808,15 @@ namespace chainbase {
             ok = _indices.modify( itr, [&]( value_type& v ) {
               v = std::move( item.second );
             });
+            if( !ok )
+              clear_slot( item.first );
           }
           else
           {
-            ok = _indices.emplace( std::move( item.second ) ).second;
+            auto insert_result = _indices.emplace( std::move( item.second ) );
+            ok = insert_result.second;
+            if( ok )
+              set_slot( *insert_result.first );
           }
 
           if( !ok )
@@ -574,12 +837,17 @@ namespace chainbase {
               std::to_string(id) + "in the index holding types: " + get_type_name()));
           }
 
+            clear_slot( id );
             _indices.erase( position );
         }
         _next_id = head.old_next_id;
+        trim_slots();
 
         for( auto& item : head.removed_values ) {
-          bool ok = _indices.emplace( std::move( item.second ) ).second;
+          auto insert_result = _indices.emplace( std::move( item.second ) );
+          bool ok = insert_result.second;
+          if( ok )
+            set_slot( *insert_result.first );
           if( !ok )
           {
             CHAINBASE_THROW_EXCEPTION(std::logic_error(
@@ -664,6 +932,8 @@ namespace chainbase {
           }
           // del+upd -> N/A
           assert( prev_state.removed_values.find( item.second.get_id() ) == prev_state.removed_values.end() );
+          // journaled upd(was=X) + upd(was=Y) -> upd(was=X), type C (X reconstructed from Y with journal of A)
+          revert_journaled_changes( prev_state, item.second );
           // nop+upd(was=Y) -> upd(was=Y), type B
           prev_state.old_values.emplace( std::move(item) );
         }
@@ -691,10 +961,32 @@ namespace chainbase {
           }
           // del + del -> N/A
           assert( prev_state.removed_values.find( obj.second.get_id() ) == prev_state.removed_values.end() );
+          // journaled upd(was=X) + del(was=Y) -> del(was=X) (X reconstructed from Y with journal of A)
+          revert_journaled_changes( prev_state, obj.second );
           // nop + del(was=Y) -> del(was=Y)
           prev_state.removed_values.emplace( std::move(obj) ); //[obj.second->get_id()] = std::move(obj.second);
         }
 
+        // journal records are reverted newest first, so records of later state just go after those of earlier
+        // state, and chains of records of the same object are linked; records of objects created or removed in
+        // merged state are ignored
+        const uint64_t journal_offset = prev_state.journal.size();
+        prev_state.journal.insert( prev_state.journal.end(), state.journal.begin(), state.journal.end() );
+        for( const auto& item : state.journal_ends )
+        {
+          const uint64_t last_end = journal_offset + item.second;
+          auto found = prev_state.journal_ends.find( item.first );
+          if( found == prev_state.journal_ends.end() )
+          {
+            prev_state.journal_ends.emplace( item.first, last_end );
+          }
+          else
+          {
+            undo_journal::link_records( prev_state.journal, last_end, found->second );
+            found->second = last_end;
+          }
+        }
+
         _stack.pop_back();
         --_revision;
       }
@@ -728,6 +1020,68 @@ namespace chainbase {
     private:
       bool enabled()const { return _stack.size(); }
 
+      void set_slot( const value_type& v ) {
+        size_t id = v.get_id().get_value();
+        if( _slots.empty() )
+        {
+          _slot_base = id;
+          _leading_free_slots = 0;
+        }
+        else if( id < _slot_base )
+        {
+          // can only happen when undo restores object removed before leading part of the table was released
+          _slots.insert( _slots.begin(), _slot_base - id, slot_type() );
+          _leading_free_slots += _slot_base - id;
+          _slot_base = id;
+        }
+        size_t pos = id - _slot_base;
+        const bool all_free = _leading_free_slots == _slots.size();
+        if( pos >= _slots.size() )
+          _slots.resize( pos + 1 );
+        _slots[ pos ] = &v;
+        if( all_free || pos < _leading_free_slots )
+          _leading_free_slots = pos;
+      }
+
+      void clear_slot( const id_type& id ) {
+        size_t pos = id.get_value();
+        if( pos < _slot_base ) return;
+        pos -= _slot_base;
+        if( pos >= _slots.size() ) return;
+        _slots[ pos ] = slot_type();
+        if( pos != _leading_free_slots ) return;
+
+        while( _leading_free_slots < _slots.size() && !_slots[ _leading_free_slots ] )
+          ++_leading_free_slots;
+
+        // objects are usually removed in order of creation (f.e. expired transactions), release leading part
+        // of the table once it becomes mostly unused, so it does not grow with every id ever allocated
+        if( _leading_free_slots >= min_released_slots && 2 * _leading_free_slots >= _slots.size() )
+        {
+          _slots.erase( _slots.begin(), _slots.begin() + _leading_free_slots );
+          _slot_base += _leading_free_slots;
+          _leading_free_slots = 0;
+        }
+      }
+
+      /**
+        * drops unused slots past highest live id (after undo removes objects created in undone session);
+        * _next_id is not used as a limit, because objects that share id with object of other index
+        * (f.e. comment_cashout_object, account_cold_object) can have ids past _next_id of their own index
+        */
+      void trim_slots() {
+        size_t size = _slots.size();
+        while( size > _leading_free_slots && !_slots[ size - 1 ] )
+          --size;
+        if( size == _leading_free_slots )
+          size = 0;
+        _slots.resize( size );
+        if( _leading_free_slots > size )
+          _leading_free_slots = size;
+      }
+
+      static constexpr size_t min_released_slots = 1024;
+
       void on_modify( const value_type& v ) {
         if( !enabled() ) return;
 
@@ -743,6 +1097,51 @@ namespace chainbase {
         head.old_values.emplace( v.get_id(), v.copy_chain_object() );
       }
 
+      /// records changed members of modified object (after is null when object was dropped because it could not
+      /// be reindexed - it is then stored as removed with its value from before the session)
+      void on_journaled_modify( const id_type& id, const undo_journal::snapshot< value_type >& before, const value_type* after ) {
+        auto& head = _stack.back();
+        if( after != nullptr )
+        {
+          auto found = head.journal_ends.find( id );
+          uint64_t last_end = found != head.journal_ends.end() ? found->second : 0;
+          undo_journal::record_changes( head.journal, before, *after, last_end );
+          if( found != head.journal_ends.end() )
+            found->second = last_end;
+          else if( last_end != 0 )
+            head.journal_ends.emplace( id, last_end );
+        }
+        else
+        {
+          value_type old_value( _indices.get_allocator(), id.get_value(),
+            std::function< void( value_type& ) >( [&before]( value_type& v ) { before.restore( v ); } ) );
+          revert_journaled_changes( head, old_value );
+          head.removed_values.emplace( id, std::move( old_value ) );
+        }
+      }
+
+      /// turns value of object into its value from before given undo state by reverting its journal records
+      /// (cost is proportional to the number of records of that object)
+      void revert_journaled_changes( const undo_state_type& state, value_type& v )const {
+        if constexpr( undo_journal_enabled< value_type >::value )
+        {
+          auto found = state.journal_ends.find( v.get_id() );
+          if( found == state.journal_ends.end() )
+            return;
+          undo_journal::for_each_object_record_reversed( state.journal, found->second,
+            [&]( uint16_t member, const char* data, uint32_t size )
+            {
+              undo_journal::restore( v, member, data, size );
+            } );
+        }
+      }
+
+      /// true when changes of object in given state are described by journal alone
+      static bool is_only_journaled( const undo_state_type& state, const id_type& id ) {
+        return id < state.old_next_id && state.old_values.find( id ) == state.old_values.end() &&
+          state.removed_values.find( id ) == state.removed_values.end();
+      }
+
       void on_remove( const value_type& v ) {
         if( !enabled() ) return;
 
@@ -762,7 +1161,9 @@ namespace chainbase {
         if( head.removed_values.count( v.get_id() ) )
           return;
 
-        head.removed_values.emplace( v.get_id(), v.copy_chain_object() );
+        value_type old_value = v.copy_chain_object();
+        revert_journaled_changes( head, old_value );
+        head.removed_values.emplace( v.get_id(), std::move( old_value ) );
       }
 
       void on_create( const value_type& v ) {
@@ -783,6 +1184,11 @@ namespace chainbase {
       int64_t                         _revision = 0;
       id_type                         _next_id = id_type(0);
       index_type                      _indices;
+      /// pointers to objects indexed by (id - _slot_base), null for ids of removed objects
+      slot_table_type                 _slots;
+      size_t                          _slot_base = 0;
+      /// number of null slots at the start of the table
+      size_t                          _leading_free_slots = 0;
       uint32_t                        _size_of_value_type = 0;
       uint32_t                        _size_of_this = 0;
   };
@@ -842,6 +1248,8 @@ namespace chainbase {
 
       virtual void dump_snapshot(snapshot_writer& writer) const = 0;
       virtual void load_snapshot(snapshot_reader& reader) = 0;
+      /// fills this (empty) index with copies of objects of source index of the same type
+      virtual void copy_from(const abstract_index& source) = 0;
 
       void add_index_extension( std::shared_ptr< index_extension > ext )  { _extensions.push_back( ext ); }
       const index_extensions& get_index_extensions()const  { return _extensions; }
@@ -875,7 +1283,9 @@ namespace chainbase {
       {
         typedef typename BaseIndex::index_type index_type;
         helpers::index_statistic_provider<index_type> provider;
-        return provider.gather_statistics(_base.indices(), onlyStaticInfo);
+        statistic_info info = provider.gather_statistics(_base.indices(), onlyStaticInfo);
+        info._additional_container_allocation += _base.get_slot_table_allocation();
+        return info;
       }
 
       virtual size_t size() const override final
@@ -902,6 +1312,11 @@ namespace chainbase {
         _base.store_next_id(next_id);
       }
 
+      virtual void copy_from(const abstract_index& source) override final
+      {
+        _base.copy_from(*static_cast<const BaseIndex*>(source.get()));
+      }
+
     private:
       BaseIndex& _base;
   };
@@ -920,6 +1335,19 @@ namespace chainbase {
     virtual const char* what() const noexcept { return "Unable to acquire database lock"; }
   };
 
+  /**
+    * Receives time spent waiting for and holding database lock, after each release of the lock (see
+    * database::set_lock_observer). Called on the thread that held the lock, so it has to be cheap.
+    */
+  class lock_observer
+  {
+    public:
+      virtual ~lock_observer() {}
+
+      virtual void on_read_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) = 0;
+      virtual void on_write_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) = 0;
+  };
+
   /**
     *  This class
     */
@@ -947,14 +1375,67 @@ namespace chainbase {
       void wipe_indexes();
 
     public:
+      enum open_flags : uint32_t
+      {
+        /**
+          * Maps existing shared memory file read-only and follows changes made by writer process (read replica).
+          * Read locks also take sharable access to state of the writer (see replica_sync); any attempt to write throws.
+          */
+        read_only       = 0x1,
+        /// writer side of read_only - lets read replicas map the file and synchronize with this database
+        allow_replicas  = 0x2
+      };
+
       void open( const bfs::path& dir, uint32_t flags = 0, size_t shared_file_size = 0, const boost::any& database_cfg = nullptr, const helpers::environment_extension_resources* environment_extension = nullptr, const bool wipe_shared_file = false );
       bool check_plugins(const helpers::environment_extension_resources* environment_extension); // bool - throw error if state definitions mismatch
       void close();
       void flush();
       void wipe( const bfs::path& dir );
       void resize( size_t new_shared_file_size );
+
+      struct compaction_stats
+      {
+        /// memory of shared file in use before and after compaction
+        size_t used_before = 0;
+        size_t used_after = 0;
+
+        size_t get_reclaimed()const { return used_before > used_after ? used_before - used_after : 0; }
+      };
+
+      /**
+        * Rebuilds all indexes in a new shared memory file of the same size and replaces current file with it.
+        * Objects of each index are copied in order of ids into fresh memory, so space lost to fragmentation is
+        * reclaimed and objects that are close in id order are close in memory. New file replaces old one
+        * (with atomic rename) only after all data was copied. Can't be called while there are undo states.
+        * Named objects other than indexes are not copied - owner has to recreate them afterwards.
+        * Cost: every object is copied (time proportional to size of state, with write lock held) and until the
+        * old file is replaced, disk needs room for second copy of used part of the file - that is checked first.
+        */
+      compaction_stats compact();
+
+      bool is_read_only()const { return _flags & read_only; }
+      /// revision of state published by writer with last release of its write lock (-1 when not synchronized with writer)
+      int64_t get_replica_revision()const { return _replica_sync ? _replica_sync->get_revision() : -1; }
+      /// how long writer waits for read replicas when it needs to change state, before it terminates them (see replica_sync)
+      void set_max_replica_reader_wait( std::chrono::microseconds max_wait )
+      {
+        _max_replica_reader_wait = max_wait;
+        if( _replica_sync && !is_read_only() )
+          _replica_sync->set_max_reader_wait( max_wait.count() );
+      }
+
+      /// options applied to memory mapping of shared memory file whenever it is opened (call before open)
+      void set_mapping_options( const mapping_options& options ) { _mapping_options = options; }
+      /// statistics of memory mapping from last refresh; safe to call without lock (f.e. from lockless APIs)
+      mapping_statistics get_mapping_statistics()const;
+      /// samples residency of memory mapping (call with read or write lock held, mapping is refreshed on every open)
+      void refresh_mapping_statistics();
+
       void set_require_locking( bool enable_require_locking );
 
+      /// observer of lock wait and hold times (call before database is used by other threads; observer must outlive database)
+      void set_lock_observer( lock_observer* observer ) { _lock_observer = observer; }
+
 #ifdef CHAINBASE_CHECK_LOCKING
       void require_lock_fail( const char* method, const char* lock_type, const char* tname )const;
 
@@ -1158,10 +1639,7 @@ namespace chainbase {
       {
           CHAINBASE_REQUIRE_READ_LOCK("find", ObjectType);
           typedef typename get_index_type< ObjectType >::type index_type;
-          const auto& idx = get_index< index_type >().indices();
-          auto itr = idx.find( key );
-          if( itr == idx.end() ) return nullptr;
-          return &*itr;
+          return get_index< index_type >().find_by_id( key );
       }
 
       template< typename ObjectType, typename IndexedByType, typename CompatibleKey >
@@ -1243,6 +1721,10 @@ namespace chainbase {
                 ("_read_lock_count", _read_lock_count.load(std::memory_order_relaxed))
                 ("_write_lock_count", _write_lock_count.load(std::memory_order_relaxed))
                 (lock_serial_number));
+        lock_timer timer( _lock_observer, false );
+        replica_sync::sharable_guard replica_lock;
+        if( _replica_sync && is_read_only() )
+          replica_lock = lock_replica( wait_for_microseconds );
         read_lock lock(_rw_lock, boost::defer_lock_t());
 
 #ifdef CHAINBASE_CHECK_LOCKING
@@ -1265,6 +1747,7 @@ namespace chainbase {
                 ("_read_lock_count", _read_lock_count.load(std::memory_order_relaxed))
                 (lock_serial_number));
 
+        timer.acquired();
         return callback();
       }
 
@@ -1276,6 +1759,9 @@ namespace chainbase {
                 ("_read_lock_count", _read_lock_count.load(std::memory_order_relaxed))
                 ("_write_lock_count", _write_lock_count.load(std::memory_order_relaxed))
                 (lock_serial_number));
+        if( BOOST_UNLIKELY( is_read_only() ) )
+          CHAINBASE_THROW_EXCEPTION( std::logic_error( "database opened read-only can't be modified" ) );
+        lock_timer timer( _lock_observer, true );
         write_lock lock(_rw_lock, boost::defer_lock_t());
 #ifdef CHAINBASE_CHECK_LOCKING
         BOOST_ATTRIBUTE_UNUSED
@@ -1288,6 +1774,8 @@ namespace chainbase {
                 ("_write_lock_count", _write_lock_count.load(std::memory_order_relaxed))
                 (lock_serial_number));
 
+        replica_write_guard replica_lock( *this );
+        timer.acquired();
         return callback();
       }
 
@@ -1318,7 +1806,77 @@ namespace chainbase {
       bool get_is_open() const
         { return _is_open; }
 
+      /// called when read replica mapped shared memory file anew, after indexes were found in new mapping
+      virtual void on_replica_remapped() {}
+
     private:
+      /// reports lock times to observer (if any); has to be constructed before and destroyed after the lock it measures
+      class lock_timer
+      {
+        public:
+          lock_timer( lock_observer* observer, bool write ) : _observer( observer ), _write( write )
+          {
+            if( _observer != nullptr )
+              _requested = std::chrono::steady_clock::now();
+          }
+          ~lock_timer()
+          {
+            if( _observer == nullptr || _acquired == std::chrono::steady_clock::time_point() )
+              return; // lock was not acquired
+            const auto wait_time = _acquired - _requested;
+            const auto hold_time = std::chrono::steady_clock::now() - _acquired;
+            if( _write )
+              _observer->on_write_lock_released( wait_time, hold_time );
+            else
+              _observer->on_read_lock_released( wait_time, hold_time );
+          }
+
+          void acquired()
+          {
+            if( _observer != nullptr )
+              _acquired = std::chrono::steady_clock::now();
+          }
+
+        private:
+          lock_observer*                          _observer;
+          bool                                    _write;
+          std::chrono::steady_clock::time_point   _requested;
+          std::chrono::steady_clock::time_point   _acquired;
+      };
+
+      /// holds exclusive access of writer over read replicas (if they are allowed) and publishes revision on release
+      class replica_write_guard
+      {
+        public:
+          explicit replica_write_guard( database& db ) : _db( db ), _sync( db.is_read_only() ? nullptr : db._replica_sync.get() )
+          {
+            if( _sync != nullptr )
+              _sync->lock_exclusive();
+          }
+          ~replica_write_guard()
+          {
+            if( _sync != nullptr )
+              _sync->unlock_exclusive( _db.revision() );
+          }
+
+        private:
+          database&     _db;
+          replica_sync* _sync;
+      };
+
+      /// acquires sharable access of read replica, remapping shared memory file if writer changed it
+      replica_sync::sharable_guard lock_replica( fc::microseconds wait_for_microseconds );
+      void map_read_only( const bfs::path& abs_path );
+      /// takes lock of writer on given directory (once per open database), throws when other writer holds it
+      void lock_directory( const bfs::path& dir );
+
+      /// named objects are searched without locking in read-only mapping (lock of segment manager would be a write)
+      template< typename T >
+      std::pair< T*, std::size_t > find_named( const char* name )const
+      {
+        return is_read_only() ? _segment->find_no_lock< T >( name ) : _segment->find< T >( name );
+      }
+
       template<typename MultiIndexType>
       void add_index_helper() {
         const uint16_t type_id = generic_index<MultiIndexType>::value_type::type_id;
@@ -1335,9 +1893,11 @@ namespace chainbase {
 #ifdef ENABLE_STD_ALLOCATOR
         idx_ptr = new index_type( index_alloc() );
 #else
-        auto _found = _segment->find< index_type >( type_name.c_str() );
+        auto _found = find_named< index_type >( type_name.c_str() );
         if( !_found.first )
         {
+          if( is_read_only() )
+            CHAINBASE_THROW_EXCEPTION( std::logic_error( type_name + " not found in shared memory file opened read-only - writer does not track that index" ) );
           _is_index_new = true;
           idx_ptr = _segment->construct< index_type >( type_name.c_str() )( index_alloc( _segment->get_segment_manager() ) );
         }
@@ -1374,6 +1934,9 @@ namespace chainbase {
       unique_ptr<bip::managed_mapped_file>                        _segment;
       unique_ptr<bip::managed_mapped_file>                        _meta;
       bip::file_lock                                              _flock;
+      /// lock on shared_memory.lock of writer, held while database is open (also when shared_memory.bin is replaced)
+      bip::file_lock                                              _dir_lock;
+      bool                                                        _dir_locked = false;
 
       /**
         * This is a sparse list of known indicies kept to accelerate creation of undo sessions
@@ -1388,18 +1951,29 @@ namespace chainbase {
       vector<unique_ptr<abstract_index_type>>                     _index_types;
 
       bfs::path                                                   _data_dir;
+      uint32_t                                                    _flags = 0;
+      std::unique_ptr< replica_sync >                             _replica_sync;
+      /// mapping generation of writer that current mapping of read replica comes from
+      std::atomic<uint64_t>                                       _replica_generation = {0};
 
       std::atomic<int32_t>                                        _read_lock_count = {0};
       std::atomic<int32_t>                                        _write_lock_count = {0};
       std::atomic<uint32_t>                                       _next_read_lock_serial_number = {0};
       std::atomic<uint32_t>                                       _next_write_lock_serial_number = {0};
       bool                                                        _enable_require_locking = false;
+      lock_observer*                                              _lock_observer = nullptr;
 
       bool                                                        _is_open = false;
 
       int32_t                                                     _undo_session_count = 0;
       size_t                                                      _file_size = 0;
       boost::any                                                  _database_cfg = nullptr;
+      mapping_options                                             _mapping_options;
+      std::chrono::microseconds                                   _max_replica_reader_wait = std::chrono::microseconds( replica_sync::default_max_reader_wait_us );
+      /// whole file is prefaulted only when first mapped, not on reopen after resize or compaction
+      bool                                                        _mapping_prefaulted = false;
+      std::atomic<size_t>                                         _mapped_size = {0};
+      std::atomic<size_t>                                         _resident_size = {0};
 
       bool                                                        _at_least_one_index_was_created_earlier = false;
       bool                                                        _at_least_one_index_is_created_now = false;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chainbase
+{
+
+/**
+  * Kernel hints and placement applied to memory mapping of shared memory file (Linux only, ignored elsewhere).
+  *
+  * Huge pages: mapping is marked with MADV_HUGEPAGE. It takes effect when file lies on tmpfs mounted with
+  * huge=advise (or huge=always); file placed on hugetlbfs mount is backed by huge pages regardless of the hint.
+  *
+  * NUMA: policy is set on the mapping with mbind, which is honored for tmpfs and hugetlbfs backed files. Pages
+  * of regular files are placed according to policy of the thread that faults them in, so the policy is also
+  * set on prefault threads - when prefault is enabled, pages read at startup follow the requested policy.
+  */
+struct mapping_options
+{
+  enum class numa_policy_type { none, interleave, bind };
+
+  bool                    huge_pages = false;
+  /// number of threads touching all pages of the mapping at startup (0 - prefault disabled)
+  uint32_t                prefault_threads = 0;
+  numa_policy_type        numa_policy = numa_policy_type::none;
+  /// NUMA nodes used by policy; empty list for interleave means all online nodes
+  std::vector< uint32_t > numa_nodes;
+};
+
+struct mapping_statistics
+{
+  size_t    mapped_size = 0;
+  /// part of the mapping present in physical memory (estimated from sample of pages for large mappings)
+  size_t    resident_size = 0;
+};
+
+namespace memory_mapping
+{
+  /**
+    * Applies hints and NUMA policy to given range of memory, and prefaults it when `prefault` is set (new mapping
+    * of already used file, f.e. after resize, is not prefaulted again). Errors are logged, not thrown.
+    */
+  void apply( void* address, size_t size, const mapping_options& options, bool prefault );
+
+  /// checks residency of at most `max_sampled_pages` pages spread evenly over given range
+  mapping_statistics get_statistics( const void* address, size_t size, size_t max_sampled_pages = 4096 );
+
+  /// parses list of NUMA nodes in the form used by sysfs and numactl, f.e. "0-3,6"
+  std::vector< uint32_t > parse_node_list( const std::string& nodes );
+} // memory_mapping
+
+} // chainbase
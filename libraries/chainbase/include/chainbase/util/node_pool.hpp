@@ -0,0 +1,121 @@
+#pragma once
+
+#include <boost/interprocess/managed_mapped_file.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace chainbase
+{
+
+/**
+  * Pool of memory nodes of one size, kept in shared memory segment. Memory is taken from segment manager
+  * in blocks of many nodes and freed nodes are kept on the free list of the pool for reuse, so allocation
+  * and deallocation are O(1) and avoid search and locking done by segment manager. There is one pool for
+  * each node size (size class), shared by all containers with nodes of that size.
+  *
+  * Pool is not synchronized. It is used for nodes of multi_index containers holding chain objects, which are
+  * only allocated and released by changes of state, and those require write lock.
+  *
+  * Nodes are never returned to segment manager - free space is instead reported as part of index statistics,
+  * so fragmentation can be tracked.
+  */
+class node_pool
+{
+  public:
+    typedef boost::interprocess::managed_mapped_file::segment_manager segment_manager;
+
+    /// size of memory blocks allocated for nodes (block holds at least min_nodes_per_block nodes)
+    static constexpr size_t block_size = 64 * 1024;
+    static constexpr size_t min_nodes_per_block = 16;
+
+    struct statistics
+    {
+      size_t node_size = 0;
+      /// memory taken by pool from segment manager
+      size_t reserved = 0;
+      /// part of reserved memory not held by any node (released nodes and not yet used part of last block)
+      size_t free = 0;
+    };
+
+    explicit node_pool( size_t node_size )
+      : _node_size( std::max( node_size, sizeof( free_node ) ) ),
+        _nodes_per_block( std::max( min_nodes_per_block, block_size / _node_size ) ) {}
+
+    node_pool( const node_pool& ) = delete;
+    node_pool& operator=( const node_pool& ) = delete;
+
+    void* allocate( segment_manager* manager )
+    {
+      if( _free_list != nullptr )
+      {
+        free_node* node = _free_list.get();
+        _free_list = node->next;
+        --_free_count;
+        return node;
+      }
+      if( _unused_count == 0 )
+      {
+        _unused = static_cast< char* >( manager->allocate( _node_size * _nodes_per_block ) );
+        _unused_count = _nodes_per_block;
+        ++_block_count;
+      }
+      void* node = _unused.get();
+      _unused += _node_size;
+      --_unused_count;
+      return node;
+    }
+
+    void deallocate( void* p )
+    {
+      free_node* node = new( p ) free_node();
+      node->next = _free_list;
+      _free_list = node;
+      ++_free_count;
+    }
+
+    statistics get_statistics()const
+    {
+      statistics result;
+      result.node_size = _node_size;
+      result.reserved = _block_count * _nodes_per_block * _node_size;
+      result.free = ( _free_count + _unused_count ) * _node_size;
+      return result;
+    }
+
+    /// returns pool for nodes of given size, creating it if it does not exist yet
+    static node_pool* get( segment_manager* manager, size_t node_size )
+    {
+      return manager->find_or_construct< node_pool >( get_name( node_size ).c_str() )( node_size );
+    }
+
+    /// returns existing pool for nodes of given size or nullptr
+    static const node_pool* find( segment_manager* manager, size_t node_size )
+    {
+      return manager->find< node_pool >( get_name( node_size ).c_str() ).first;
+    }
+
+  private:
+    struct free_node
+    {
+      boost::interprocess::offset_ptr< free_node > next;
+    };
+
+    static std::string get_name( size_t node_size )
+    {
+      return "node_pool_" + std::to_string( node_size );
+    }
+
+    boost::interprocess::offset_ptr< free_node >  _free_list;
+    boost::interprocess::offset_ptr< char >       _unused;
+    size_t                                        _node_size = 0;
+    size_t                                        _nodes_per_block = 0;
+    size_t                                        _unused_count = 0;
+    size_t                                        _free_count = 0;
+    size_t                                        _block_count = 0;
+};
+
+} // chainbase
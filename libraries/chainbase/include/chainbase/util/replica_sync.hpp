@@ -0,0 +1,126 @@
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace chainbase
+{
+
+/**
+  * Coordination between writer of shared memory file (node applying blocks) and read replicas - separate
+  * processes that map the same file read-only to serve API calls. State needed for that lives in small
+  * separate file (shared_memory.sync next to shared_memory.bin), since replicas can't write to the main file.
+  *
+  * Writer holds exclusive access whenever it holds write lock of its database, so replicas, which hold sharable
+  * access for the duration of their read locks, never see state in the middle of a change. On release writer
+  * publishes revision of its state. Whenever writer maps the main file anew (open, resize, compaction) it
+  * increments mapping generation, telling replicas to remap before next read.
+  *
+  * No process-shared mutex is used, since such lock would stay taken when its holder dies. Instead each replica
+  * claims reader slot and counts threads reading through it, while writer announces itself with a flag and waits
+  * for active slots to drain. Writer never changes state while any reader of live replica is active:
+  * - replica holds open file description lock on byte of its slot for its lifetime; kernel releases it when
+  *   replica dies, so slot of dead replica is reclaimed regardless of pid reuse,
+  * - replica that keeps writer waiting longer than `max_reader_wait_us` (whole exclusive access, not per slot)
+  *   is terminated (its reads could not be stopped otherwise) and its slot is reclaimed once it is gone; readers
+  *   within the writer process can't be terminated, writer waits for them,
+  * - when writer dies, its flag stays set and replicas wait (or time out) until writer is restarted.
+  * Termination needs pids of replicas, so replica has to run in the same PID namespace as writer.
+  * Synchronization file is never reinitialized in place - writer that finds incompatible one replaces the file.
+  */
+class replica_sync
+{
+  public:
+    static const char* const file_name;
+    static constexpr int64_t default_max_reader_wait_us = 100000;
+
+    /// opens synchronization file of writer creating it if needed; starts new mapping generation
+    static std::unique_ptr< replica_sync > open_writer( const boost::filesystem::path& dir,
+      int64_t max_reader_wait_us = default_max_reader_wait_us );
+    /// opens synchronization file created by writer and claims reader slot; throws when writer does not allow replicas
+    static std::unique_ptr< replica_sync > open_replica( const boost::filesystem::path& dir );
+
+    ~replica_sync();
+
+    /// writer: acquires exclusive access to shared memory file
+    void lock_exclusive();
+    /// writer: publishes revision of state and releases exclusive access
+    void unlock_exclusive( int64_t revision );
+    /// writer: marks that shared memory file was mapped anew (call with exclusive access held)
+    void start_new_generation();
+    /// writer: how long replicas can hold sharable access while writer waits, before they are terminated
+    void set_max_reader_wait( int64_t max_reader_wait_us ) { _max_reader_wait_us = max_reader_wait_us; }
+
+    /// replica: acquires sharable access (wait_us == 0 means no timeout); false on timeout; recursive within thread
+    bool lock_sharable( int64_t wait_us = 0 );
+    /// replica: releases sharable access
+    void unlock_sharable();
+
+    int64_t get_revision()const { return _state->revision.load( std::memory_order_acquire ); }
+    uint64_t get_generation()const { return _state->generation.load( std::memory_order_acquire ); }
+
+    /// holds sharable access of replica for its lifetime
+    class sharable_guard
+    {
+      public:
+        sharable_guard() = default;
+        explicit sharable_guard( replica_sync* sync ) : _sync( sync ) {}
+        sharable_guard( sharable_guard&& other ) : _sync( other._sync ) { other._sync = nullptr; }
+        sharable_guard& operator=( sharable_guard&& other ) { release(); std::swap( _sync, other._sync ); return *this; }
+        ~sharable_guard() { release(); }
+
+        void release() { if( _sync != nullptr ) _sync->unlock_sharable(); _sync = nullptr; }
+
+      private:
+        replica_sync* _sync = nullptr;
+    };
+
+  private:
+    static constexpr uint32_t current_version = 3;
+    static constexpr uint32_t max_slots = 64;
+
+    struct reader_slot
+    {
+      std::atomic< int32_t >                                pid = { 0 }; // 0 - free
+      std::atomic< uint64_t >                               readers = { 0 };
+    };
+
+    struct shared_state
+    {
+      uint32_t                                              version = current_version;
+      std::atomic< int32_t >                                writer_pid = { 0 }; // nonzero while writer holds or waits for exclusive access
+      std::atomic< int64_t >                                revision = { -1 };
+      std::atomic< uint64_t >                               generation = { 0 };
+      std::atomic< uint64_t >                               pid_namespace = { 0 }; // of writer, 0 when unknown
+      reader_slot                                           slots[ max_slots ];
+    };
+
+    replica_sync( const boost::filesystem::path& path, bool writer );
+
+    void claim_slot();
+    /// writer: waits until given slot has no readers; reclaims slot of dead replica, terminates one that takes too long
+    void wait_for_slot( reader_slot& slot, std::chrono::steady_clock::time_point deadline );
+
+    /// locks of slots are held by replicas owning them; writer takes them only briefly when reclaiming slots
+    bool try_lock_slot( reader_slot& slot );
+    void unlock_slot( reader_slot& slot );
+    /// writer: resets slot when no live replica owns it; false when slot is owned
+    bool try_reclaim_slot( reader_slot& slot );
+    /// identifier of PID namespace of current process (0 when it can't be determined)
+    static uint64_t get_pid_namespace();
+
+    boost::interprocess::file_mapping                       _file;
+    boost::interprocess::mapped_region                      _region;
+    shared_state*                                           _state = nullptr;
+    int                                                     _fd = -1; // separate descriptor for slot locks
+    reader_slot*                                            _slot = nullptr; // replica only
+    int64_t                                                 _max_reader_wait_us = default_max_reader_wait_us;
+};
+
+} // chainbase
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <fc/io/datastream.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace chainbase
+{
+
+/**
+  * When specialized as true_type (use CHAINBASE_SET_UNDO_JOURNAL), generic_index records modifications of objects
+  * of given type as journal of old values of changed members instead of copying whole object into undo state.
+  * Cost of undo data is then proportional to the size of members that actually changed.
+  *
+  * All members of the type must be listed in FC_REFLECT (changes of members not listed would not be undone).
+  * Members that don't own memory (are trivially destructible) are compared and stored as raw bytes. Other members
+  * (like t_vector) are serialized with fc::raw before and after every modification, so they should be small.
+  */
+template< typename T >
+struct undo_journal_enabled : std::false_type {};
+
+/**
+  *  This macro must be used at global scope and OBJECT_TYPE must be fully qualified
+  */
+#define CHAINBASE_SET_UNDO_JOURNAL( OBJECT_TYPE ) \
+namespace chainbase { template<> struct undo_journal_enabled<OBJECT_TYPE> : std::true_type {}; }
+
+namespace undo_journal
+{
+
+/// true when member can be compared, stored and restored as raw bytes
+template< typename Member >
+using is_stored_as_bytes = std::is_trivially_destructible< Member >;
+
+/**
+  * Journal is a flat buffer of records, each made of old value of a member followed by record_header.
+  * Header is placed after data, so records can be read backwards - undo has to restore them in reverse order
+  * (when member was changed more than once, oldest value comes last). Records of the same object are also
+  * linked, so changes of single object can be reverted without reading the whole journal.
+  */
+struct record_header
+{
+  uint32_t id;
+  uint16_t member;
+  uint32_t size;
+  uint64_t previous; ///< distance to end of previous record of the same object (0 for its oldest record)
+};
+
+/// appends record linked to the one ending at last_end (0 when object has no records yet); last_end is set to its end
+template< typename Buffer >
+inline char* append_record( Buffer& journal, uint32_t id, uint16_t member, uint32_t size, uint64_t& last_end )
+{
+  size_t pos = journal.size();
+  uint64_t end = pos + size + sizeof( record_header );
+  journal.resize( end );
+  char* data = &journal[ pos ]; // not data(), since it returns offset_ptr for containers in shared memory
+  record_header header{ id, member, size, last_end != 0 ? end - last_end : 0 };
+  std::memcpy( data + size, &header, sizeof( record_header ) );
+  last_end = end;
+  return data;
+}
+
+/**
+  * Value of object from before modification: its bytes and fc::raw form of its members that are not stored
+  * as bytes. Unlike copy of the object it does not construct anything or allocate in shared memory.
+  */
+template< typename T >
+class snapshot
+{
+  public:
+    explicit snapshot( const T& obj )
+    {
+      std::memcpy( _bytes, static_cast< const void* >( &obj ), sizeof( T ) );
+      fc::reflector< T >::visit( packer( obj, _packed ) );
+    }
+
+    /// bytes of given member of obj (any object of type T) in the snapshot
+    template< typename Member >
+    const char* bytes_of( const T& obj, const Member& member )const
+    {
+      return _bytes + ( reinterpret_cast< const char* >( &member ) - reinterpret_cast< const char* >( &obj ) );
+    }
+
+    /// reads fc::raw form of next member that is not stored as bytes (pos starts at 0)
+    const char* next_packed( size_t& pos, uint32_t& size )const
+    {
+      std::memcpy( &size, _packed.data() + pos, sizeof( size ) );
+      const char* data = _packed.data() + pos + sizeof( size );
+      pos += sizeof( size ) + size;
+      return data;
+    }
+
+    /// sets all members of given object to values from the snapshot
+    void restore( T& obj )const
+    {
+      fc::reflector< T >::visit( unpacker( *this, obj ) );
+    }
+
+  private:
+    class packer
+    {
+      public:
+        packer( const T& obj, std::vector< char >& packed ) : _obj( obj ), _packed( packed ) {}
+
+        template< typename Member, class Class, Member (Class::*member) >
+        void operator()( const char* ) const
+        {
+          if constexpr( !is_stored_as_bytes< Member >::value )
+          {
+            uint32_t size = fc::raw::pack_size( _obj.*member );
+            size_t pos = _packed.size();
+            _packed.resize( pos + sizeof( size ) + size );
+            std::memcpy( _packed.data() + pos, &size, sizeof( size ) );
+            fc::datastream< char* > ds( _packed.data() + pos + sizeof( size ), size );
+            fc::raw::pack( ds, _obj.*member );
+          }
+        }
+
+      private:
+        const T&              _obj;
+        std::vector< char >&  _packed;
+    };
+
+    class unpacker
+    {
+      public:
+        unpacker( const snapshot& source, T& obj ) : _source( source ), _obj( obj ) {}
+
+        template< typename Member, class Class, Member (Class::*member) >
+        void operator()( const char* ) const
+        {
+          if constexpr( is_stored_as_bytes< Member >::value )
+          {
+            std::memcpy( static_cast< void* >( &( _obj.*member ) ), _source.bytes_of( _obj, _obj.*member ), sizeof( Member ) );
+          }
+          else
+          {
+            uint32_t size = 0;
+            const char* data = _source.next_packed( _pos, size );
+            fc::datastream< const char* > ds( data, size );
+            fc::raw::unpack( ds, _obj.*member );
+          }
+        }
+
+      private:
+        const snapshot&   _source;
+        T&                _obj;
+        mutable size_t    _pos = 0;
+    };
+
+    alignas( T ) char     _bytes[ sizeof( T ) ];
+    std::vector< char >   _packed;
+};
+
+template< typename T, typename Buffer >
+class change_recorder
+{
+  public:
+    change_recorder( Buffer& journal, uint32_t id, const snapshot< T >& before, const T& after, uint64_t& last_end )
+      : _journal( journal ), _id( id ), _before( before ), _after( after ), _last_end( last_end ) {}
+
+    template< typename Member, class Class, Member (Class::*member) >
+    void operator()( const char* ) const
+    {
+      const Member& new_value = _after.*member;
+      if constexpr( is_stored_as_bytes< Member >::value )
+      {
+        const char* old_value = _before.bytes_of( _after, new_value );
+        // byte comparison might report change when only padding differs, which is harmless (record is not needed)
+        if( std::memcmp( old_value, &new_value, sizeof( Member ) ) != 0 )
+          std::memcpy( append_record( _journal, _id, _member, sizeof( Member ), _last_end ), old_value, sizeof( Member ) );
+      }
+      else
+      {
+        uint32_t size = 0;
+        const char* old_value = _before.next_packed( _packed_pos, size );
+        std::vector< char > packed = fc::raw::pack_to_vector( new_value );
+        if( packed.size() != size || ( size != 0 && std::memcmp( old_value, packed.data(), size ) != 0 ) )
+          std::memcpy( append_record( _journal, _id, _member, size, _last_end ), old_value, size );
+      }
+      ++_member;
+    }
+
+  private:
+    Buffer&             _journal;
+    uint32_t            _id;
+    const snapshot< T >& _before;
+    const T&            _after;
+    uint64_t&           _last_end;
+    mutable uint16_t    _member = 0;
+    mutable size_t      _packed_pos = 0;
+};
+
+template< typename T >
+class member_restorer
+{
+  public:
+    member_restorer( T& obj, uint16_t member, const char* data, uint32_t size )
+      : _obj( obj ), _member( member ), _data( data ), _size( size ) {}
+
+    template< typename Member, class Class, Member (Class::*member) >
+    void operator()( const char* ) const
+    {
+      if( _current++ != _member )
+        return;
+      if constexpr( is_stored_as_bytes< Member >::value )
+      {
+        std::memcpy( static_cast< void* >( &( _obj.*member ) ), _data, sizeof( Member ) );
+      }
+      else
+      {
+        fc::datastream< const char* > ds( _data, _size );
+        fc::raw::unpack( ds, _obj.*member );
+      }
+    }
+
+  private:
+    T&                _obj;
+    uint16_t          _member;
+    const char*       _data;
+    uint32_t          _size;
+    mutable uint16_t  _current = 0;
+};
+
+/// appends records of members that differ between before and after, linked to previous records of the object
+template< typename T, typename Buffer >
+inline void record_changes( Buffer& journal, const snapshot< T >& before, const T& after, uint64_t& last_end )
+{
+  fc::reflector< T >::visit( change_recorder< T, Buffer >( journal, after.get_id().get_value(), before, after, last_end ) );
+}
+
+/// sets member of given object to value from record
+template< typename T >
+inline void restore( T& obj, uint16_t member, const char* data, uint32_t size )
+{
+  fc::reflector< T >::visit( member_restorer< T >( obj, member, data, size ) );
+}
+
+/// calls visitor( id, member, data, size ) for all records starting from the newest
+template< typename Buffer, typename Visitor >
+inline void for_each_record_reversed( const Buffer& journal, Visitor&& visitor )
+{
+  if( journal.empty() )
+    return;
+  const char* data = &journal[ 0 ];
+  size_t pos = journal.size();
+  while( pos > 0 )
+  {
+    record_header header;
+    pos -= sizeof( record_header );
+    std::memcpy( &header, data + pos, sizeof( record_header ) );
+    pos -= header.size;
+    visitor( header.id, header.member, data + pos, header.size );
+  }
+}
+
+/// calls visitor( member, data, size ) for records of single object, starting from its newest one ending at last_end
+template< typename Buffer, typename Visitor >
+inline void for_each_object_record_reversed( const Buffer& journal, uint64_t last_end, Visitor&& visitor )
+{
+  if( last_end == 0 )
+    return;
+  const char* data = &journal[ 0 ];
+  while( true )
+  {
+    record_header header;
+    std::memcpy( &header, data + last_end - sizeof( record_header ), sizeof( record_header ) );
+    visitor( header.member, data + last_end - sizeof( record_header ) - header.size, header.size );
+    if( header.previous == 0 )
+      return;
+    last_end -= header.previous;
+  }
+}
+
+/// links oldest record of chain ending at last_end to the chain ending at previous_end (earlier in the journal)
+template< typename Buffer >
+inline void link_records( Buffer& journal, uint64_t last_end, uint64_t previous_end )
+{
+  char* data = &journal[ 0 ];
+  while( true )
+  {
+    record_header header;
+    std::memcpy( &header, data + last_end - sizeof( record_header ), sizeof( record_header ) );
+    if( header.previous == 0 )
+    {
+      header.previous = last_end - previous_end;
+      std::memcpy( data + last_end - sizeof( record_header ), &header, sizeof( record_header ) );
+      return;
+    }
+    last_end -= header.previous;
+  }
+}
+
+} // undo_journal
+
+} // chainbase
@@ -57,6 +57,23 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
         return *this;
       }
 
+#ifndef ENABLE_STD_ALLOCATOR
+      /// copies data from environment stored in other segment (assignment would keep allocators of that segment)
+      void copy_from( const environment_check& other )
+      {
+        version_info = other.version_info.c_str();
+        decoded_state_objects_data_json = other.decoded_state_objects_data_json.c_str();
+        plugins.clear();
+        for( const auto& item : other.plugins )
+          plugins.insert( shared_string( item.c_str(), version_info.get_allocator() ) );
+        compiler_version = other.compiler_version;
+        debug = other.debug;
+        apple = other.apple;
+        windows = other.windows;
+        created_storage = other.created_storage;
+      }
+#endif
+
       std::string dump() const
       {
         std::string retVal("{\"compiler\":\"");
@@ -198,13 +215,44 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
     assert( dir.is_absolute() );
     bfs::create_directories( dir );
     if( _data_dir != dir ) close();
+#ifndef ENABLE_STD_ALLOCATOR
+    if( !( flags & read_only ) )
+      lock_directory( dir );
+#endif
     if( wipe_shared_file ) wipe( dir );
 
     _data_dir = dir;
     _database_cfg = database_cfg;
+    _flags = flags;
 #ifndef ENABLE_STD_ALLOCATOR
     auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
-    
+
+    if( is_read_only() )
+    {
+      if( !bfs::exists( abs_path ) )
+        BOOST_THROW_EXCEPTION( std::runtime_error( "Database opened read-only requires existing shared memory file " + abs_path.generic_string() ) );
+      if( !_replica_sync )
+        _replica_sync = replica_sync::open_replica( dir );
+
+      {
+        _replica_sync->lock_sharable();
+        replica_sync::sharable_guard replica_lock( _replica_sync.get() );
+        map_read_only( abs_path );
+      }
+
+      auto env = find_named< environment_check >( "environment" );
+      environment_check eCheck( allocator< environment_check >( _segment->get_segment_manager() ) );
+      if( !env.first || !( *env.first == eCheck ) )
+        BOOST_THROW_EXCEPTION( std::runtime_error( "Shared memory file opened read-only was created by a different compiler, build, or operating system" ) );
+      // newly created storage takes version of its creator - only the writer can do that
+      if( environment_extension && !env.first->created_storage )
+        env.first->test_version( *environment_extension );
+
+      ilog( "Shared memory file opened read-only, following writer at revision ${r}", ( "r", _replica_sync->get_revision() ) );
+      _is_open = true;
+      return;
+    }
+
     if( bfs::exists( abs_path ) )
     {
       _file_size = bfs::file_size( abs_path );
@@ -251,14 +299,107 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
     _flock = bip::file_lock( abs_path.generic_string().c_str() );
     if( !_flock.try_lock() )
       BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+
+    memory_mapping::apply( _segment->get_address(), _segment->get_size(), _mapping_options, !_mapping_prefaulted );
+    _mapping_prefaulted = true;
+    refresh_mapping_statistics();
+
+    if( flags & allow_replicas )
+    {
+      // reopen during resize or compaction happens with write lock (and so also exclusive access over replicas) held
+      if( _replica_sync )
+        _replica_sync->start_new_generation();
+      else
+        _replica_sync = replica_sync::open_writer( dir, _max_replica_reader_wait.count() );
+    }
 #endif
 
     _is_open = true;
   }
 
+  void database::lock_directory( const bfs::path& dir )
+  {
+#ifndef ENABLE_STD_ALLOCATOR
+    // lock on shared_memory.bin alone is lost for a moment when compaction replaces the file
+    if( _dir_locked )
+      return;
+    const auto lock_path = bfs::absolute( dir / "shared_memory.lock" );
+    std::ofstream( lock_path.generic_string(), std::ios::app ); // file_lock needs existing file
+    _dir_lock = bip::file_lock( lock_path.generic_string().c_str() );
+    if( !_dir_lock.try_lock() )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file directory " + dir.generic_string() ) );
+    _dir_locked = true;
+#endif
+  }
+
+  void database::map_read_only( const bfs::path& abs_path )
+  {
+#ifndef ENABLE_STD_ALLOCATOR
+    _replica_generation = _replica_sync->get_generation();
+    _segment.reset( new bip::managed_mapped_file( bip::open_read_only, abs_path.generic_string().c_str() ) );
+    _file_size = _segment->get_size();
+    memory_mapping::apply( _segment->get_address(), _segment->get_size(), _mapping_options, !_mapping_prefaulted );
+    _mapping_prefaulted = true;
+    refresh_mapping_statistics();
+#endif
+  }
+
+  replica_sync::sharable_guard database::lock_replica( fc::microseconds wait_for_microseconds )
+  {
+    if( !_replica_sync->lock_sharable( wait_for_microseconds.count() ) )
+      CHAINBASE_THROW_EXCEPTION( lock_exception() );
+    replica_sync::sharable_guard replica_lock( _replica_sync.get() );
+
+    // generation can't change while sharable lock is held, so once checked, mapping stays valid until released
+    if( BOOST_UNLIKELY( _replica_sync->get_generation() != _replica_generation ) )
+    {
+      write_lock lock( _rw_lock );
+      if( _replica_sync->get_generation() != _replica_generation )
+      {
+        ilog( "Writer mapped shared memory file anew - remapping it" );
+        std::map< uint32_t, index_extensions > extensions;
+        for( auto* item : _index_list )
+          extensions[ item->type_id() ] = item->get_index_extensions();
+
+        map_read_only( bfs::absolute( _data_dir / "shared_memory.bin" ) );
+
+        wipe_indexes();
+        for( auto& index_type : _index_types )
+          index_type->add_index( *this );
+        for( auto* item : _index_list )
+        {
+          for( const auto& ext : extensions[ item->type_id() ] )
+            item->add_index_extension( ext );
+        }
+        on_replica_remapped();
+      }
+    }
+    return replica_lock;
+  }
+
+  mapping_statistics database::get_mapping_statistics()const
+  {
+    mapping_statistics result;
+    result.mapped_size = _mapped_size.load( std::memory_order_relaxed );
+    result.resident_size = _resident_size.load( std::memory_order_relaxed );
+    return result;
+  }
+
+  void database::refresh_mapping_statistics()
+  {
+#ifndef ENABLE_STD_ALLOCATOR
+    if( _segment )
+    {
+      const auto stats = memory_mapping::get_statistics( _segment->get_address(), _segment->get_size() );
+      _mapped_size.store( stats.mapped_size, std::memory_order_relaxed );
+      _resident_size.store( stats.resident_size, std::memory_order_relaxed );
+    }
+#endif
+  }
+
   bool database::check_plugins(const helpers::environment_extension_resources* environment_extension)
   {
-    auto env = _segment->find< environment_check >( "environment" );
+    auto env = find_named< environment_check >( "environment" );
     assert(env.first);
     return env.first->test_set_plugins(environment_extension);
   }
@@ -276,10 +417,20 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
     {
       _segment.reset();
       _meta.reset();
+      _replica_sync.reset();
       _data_dir = bfs::path();
+      _mapping_prefaulted = false;
+      _mapped_size = 0;
+      _resident_size = 0;
 
       wipe_indexes();
+      // indexes are added anew after next open - remembered types would be added twice on resize or remap
+      _index_types.clear();
 
+#ifndef ENABLE_STD_ALLOCATOR
+      _dir_lock = bip::file_lock();
+      _dir_locked = false;
+#endif
       _is_open = false;
     }
   }
@@ -312,11 +463,13 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
   {
     if( _undo_session_count )
       BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot resize shared memory file while undo session is active" ) );
+    if( is_read_only() )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot resize shared memory file opened read-only" ) );
 
     _segment.reset();
     _meta.reset();
 
-    open( _data_dir, 0, new_shared_file_size );
+    open( _data_dir, _flags, new_shared_file_size );
 
     wipe_indexes();
 
@@ -326,6 +479,89 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
     }
   }
 
+  database::compaction_stats database::compact()
+  {
+#ifdef ENABLE_STD_ALLOCATOR
+    BOOST_THROW_EXCEPTION( std::runtime_error( "Compaction is only supported for database in shared memory file" ) );
+#else
+    if( _undo_session_count )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot compact shared memory file while undo session is active" ) );
+    if( is_read_only() )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot compact shared memory file opened read-only" ) );
+
+    compaction_stats stats;
+    stats.used_before = _file_size - get_free_memory();
+
+    const auto abs_path = bfs::absolute( _data_dir / "shared_memory.bin" );
+    const auto compact_path = bfs::absolute( _data_dir / "shared_memory.bin.compact" );
+    bfs::remove( compact_path );
+
+    // new file is sparse, but it gets all the data before old one is removed
+    const auto space = bfs::space( _data_dir );
+    if( space.available < stats.used_before )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Not enough disk space to compact shared memory file: " +
+        std::to_string( stats.used_before / ( 1024 * 1024 ) ) + "M needed, " + std::to_string( space.available / ( 1024 * 1024 ) ) + "M available" ) );
+
+    std::map< uint32_t, index_extensions > extensions;
+    for( auto* item : _index_list )
+      extensions[ item->type_id() ] = item->get_index_extensions();
+
+    {
+      unique_ptr< bip::managed_mapped_file > source( std::move( _segment ) );
+      vector< unique_ptr< abstract_index > > source_index_map( std::move( _index_map ) );
+      abstract_index_cntr_t source_index_list( std::move( _index_list ) );
+      const bool created_earlier = _at_least_one_index_was_created_earlier;
+      const bool created_now = _at_least_one_index_is_created_now;
+
+      try
+      {
+        _segment.reset( new bip::managed_mapped_file( bip::create_only, compact_path.generic_string().c_str(), _file_size ) );
+        environment_check* env = _segment->construct< environment_check >( "environment" )( allocator< environment_check >( _segment->get_segment_manager() ) );
+        env->copy_from( *source->find< environment_check >( "environment" ).first );
+
+        wipe_indexes();
+        for( auto& index_type : _index_types )
+          index_type->add_index( *this );
+        for( auto* item : _index_list )
+          item->copy_from( *source_index_map[ item->type_id() ] );
+
+        stats.used_after = _file_size - get_free_memory();
+        _segment->flush();
+        _segment.reset();
+      }
+      catch( ... )
+      {
+        _segment = std::move( source );
+        _index_map = std::move( source_index_map );
+        _index_list = std::move( source_index_list );
+        _at_least_one_index_was_created_earlier = created_earlier;
+        _at_least_one_index_is_created_now = created_now;
+        bfs::remove( compact_path );
+        throw;
+      }
+    }
+
+    // directory lock stays held, so no other writer can open the file between rename and reopen
+    bfs::rename( compact_path, abs_path );
+
+    open( _data_dir, _flags, _file_size, _database_cfg );
+
+    wipe_indexes();
+
+    for( auto& index_type : _index_types )
+    {
+      index_type->add_index( *this );
+    }
+    for( auto* item : _index_list )
+    {
+      for( const auto& ext : extensions[ item->type_id() ] )
+        item->add_index_extension( ext );
+    }
+
+    return stats;
+#endif
+  }
+
   void database::set_require_locking( bool enable_require_locking )
   {
 #ifdef CHAINBASE_CHECK_LOCKING
@@ -399,7 +635,7 @@ size_t snapshot_base_serializer::worker_common_base::get_serialized_object_cache
   std::string database::get_decoded_state_objects_data_from_shm() const
   {
     assert(_is_open);
-    const environment_check* const env = _segment->find< environment_check >( "environment" ).first;
+    const environment_check* const env = find_named< environment_check >( "environment" ).first;
     assert(env);
     return std::string(env->decoded_state_objects_data_json.c_str());
   }
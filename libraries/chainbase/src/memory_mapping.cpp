@@ -0,0 +1,201 @@
+#include <chainbase/util/memory_mapping.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace chainbase { namespace memory_mapping {
+
+std::vector< uint32_t > parse_node_list( const std::string& nodes )
+{
+  std::vector< uint32_t > result;
+  std::vector< std::string > ranges;
+  boost::split( ranges, nodes, boost::is_any_of( "," ) );
+  for( auto& range : ranges )
+  {
+    boost::trim( range );
+    if( range.empty() )
+      continue;
+    try
+    {
+      auto dash = range.find( '-' );
+      uint32_t first = std::stoul( range.substr( 0, dash ) );
+      uint32_t last = dash == std::string::npos ? first : std::stoul( range.substr( dash + 1 ) );
+      if( last < first )
+        BOOST_THROW_EXCEPTION( std::runtime_error( "invalid range of NUMA nodes: " + range ) );
+      for( uint32_t node = first; node <= last; ++node )
+        result.push_back( node );
+    }
+    catch( const std::logic_error& )
+    {
+      BOOST_THROW_EXCEPTION( std::runtime_error( "invalid NUMA node list: " + nodes ) );
+    }
+  }
+  std::sort( result.begin(), result.end() );
+  result.erase( std::unique( result.begin(), result.end() ), result.end() );
+  return result;
+}
+
+#ifdef __linux__
+
+namespace
+{
+  struct node_mask
+  {
+    std::vector< unsigned long > bits;
+    unsigned long max_node = 0;
+  };
+
+  constexpr size_t bits_per_word = 8 * sizeof( unsigned long );
+
+  node_mask make_node_mask( const std::vector< uint32_t >& nodes )
+  {
+    node_mask mask;
+    uint32_t highest = nodes.empty() ? 0 : *std::max_element( nodes.begin(), nodes.end() );
+    mask.bits.resize( highest / bits_per_word + 1, 0 );
+    for( uint32_t node : nodes )
+      mask.bits[ node / bits_per_word ] |= 1ul << ( node % bits_per_word );
+    // kernel reads max_node - 1 bits
+    mask.max_node = mask.bits.size() * bits_per_word + 1;
+    return mask;
+  }
+
+  std::vector< uint32_t > get_online_nodes()
+  {
+    std::ifstream file( "/sys/devices/system/node/online" );
+    std::string nodes;
+    if( !file || !std::getline( file, nodes ) )
+      return { 0 };
+    return parse_node_list( nodes );
+  }
+
+  int get_policy_mode( mapping_options::numa_policy_type policy )
+  {
+    return policy == mapping_options::numa_policy_type::bind ? MPOL_BIND : MPOL_INTERLEAVE;
+  }
+
+  void prefault( char* address, size_t size, const mapping_options& options, const node_mask* mask )
+  {
+    const size_t page_size = sysconf( _SC_PAGESIZE );
+    const size_t pages = ( size + page_size - 1 ) / page_size;
+    const uint32_t thread_count = std::max< uint32_t >( 1, std::min< size_t >( options.prefault_threads, pages ) );
+
+    madvise( address, size, MADV_WILLNEED );
+
+    std::vector< std::thread > threads;
+    threads.reserve( thread_count );
+    for( uint32_t t = 0; t < thread_count; ++t )
+    {
+      threads.emplace_back( [=]()
+      {
+        if( mask != nullptr )
+          syscall( SYS_set_mempolicy, get_policy_mode( options.numa_policy ), mask->bits.data(), mask->max_node );
+        // pages are only read - writing would make all of them dirty and force writeback of whole file
+        const size_t begin = pages * t / thread_count;
+        const size_t end = pages * ( t + 1 ) / thread_count;
+        unsigned char sum = 0;
+        for( size_t page = begin; page < end; ++page )
+          sum += *static_cast< volatile const char* >( address + page * page_size );
+        (void)sum;
+      } );
+    }
+    for( auto& thread : threads )
+      thread.join();
+  }
+}
+
+void apply( void* address, size_t size, const mapping_options& options, bool prefault_mapping )
+{
+  if( options.huge_pages )
+  {
+    if( madvise( address, size, MADV_HUGEPAGE ) != 0 )
+      wlog( "Unable to enable transparent huge pages for shared memory file: ${e}", ( "e", strerror( errno ) ) );
+    else
+      ilog( "Transparent huge pages requested for shared memory file" );
+  }
+
+  node_mask mask;
+  bool use_numa_policy = options.numa_policy != mapping_options::numa_policy_type::none;
+  if( use_numa_policy && options.numa_nodes.empty() && options.numa_policy == mapping_options::numa_policy_type::bind )
+  {
+    wlog( "NUMA bind policy for shared memory file requires list of nodes - policy not set" );
+    use_numa_policy = false;
+  }
+  if( use_numa_policy )
+  {
+    std::vector< uint32_t > nodes = options.numa_nodes.empty() ? get_online_nodes() : options.numa_nodes;
+    mask = make_node_mask( nodes );
+    if( syscall( SYS_mbind, address, size, get_policy_mode( options.numa_policy ), mask.bits.data(), mask.max_node, 0 ) != 0 )
+      wlog( "Unable to set NUMA policy for shared memory file: ${e}", ( "e", strerror( errno ) ) );
+    else
+      ilog( "NUMA policy for shared memory file set on nodes ${n}", ( "n", nodes ) );
+  }
+
+  if( prefault_mapping && options.prefault_threads > 0 )
+  {
+    ilog( "Prefaulting shared memory file (${s}M) with ${t} threads...", ( "s", size / ( 1024 * 1024 ) )( "t", options.prefault_threads ) );
+    prefault( static_cast< char* >( address ), size, options, use_numa_policy ? &mask : nullptr );
+    ilog( "Prefaulting shared memory file done" );
+  }
+}
+
+mapping_statistics get_statistics( const void* address, size_t size, size_t max_sampled_pages )
+{
+  mapping_statistics result;
+  result.mapped_size = size;
+
+  const size_t page_size = sysconf( _SC_PAGESIZE );
+  const size_t pages = ( size + page_size - 1 ) / page_size;
+  const size_t samples = std::min( pages, std::max< size_t >( 1, max_sampled_pages ) );
+  if( samples == 0 )
+    return result;
+
+  // whole mapping of big file can't be checked on every call - residency of evenly spread pages is extrapolated
+  char* begin = static_cast< char* >( const_cast< void* >( address ) );
+  size_t resident_samples = 0;
+  for( size_t i = 0; i < samples; ++i )
+  {
+    const size_t page = pages * i / samples;
+    unsigned char resident = 0;
+    if( mincore( begin + page * page_size, page_size, &resident ) != 0 )
+      return result;
+    if( resident & 1 )
+      ++resident_samples;
+  }
+  result.resident_size = std::min( size, resident_samples * pages / samples * page_size );
+  return result;
+}
+
+#else
+
+void apply( void* address, size_t size, const mapping_options& options, bool prefault_mapping )
+{
+  if( options.huge_pages || options.prefault_threads > 0 || options.numa_policy != mapping_options::numa_policy_type::none )
+    wlog( "Memory mapping options of shared memory file are supported only on Linux - ignored" );
+}
+
+mapping_statistics get_statistics( const void* address, size_t size, size_t max_sampled_pages )
+{
+  mapping_statistics result;
+  result.mapped_size = size;
+  return result;
+}
+
+#endif
+
+} } // chainbase::memory_mapping
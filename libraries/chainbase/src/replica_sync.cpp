@@ -0,0 +1,320 @@
+#include <chainbase/util/replica_sync.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/throw_exception.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace chainbase
+{
+
+namespace bfs = boost::filesystem;
+namespace bip = boost::interprocess;
+
+const char* const replica_sync::file_name = "shared_memory.sync";
+
+namespace
+{
+  /// sharable accesses held by current thread - nested read locks must not wait behind writer waiting for the first one
+  thread_local uint32_t sharable_lock_depth = 0;
+
+  /// sleeps increasingly longer (up to 1ms) between checks of state of other processes
+  class backoff
+  {
+    public:
+      void wait()
+      {
+        if( _step < 16 )
+          std::this_thread::yield();
+        else
+          std::this_thread::sleep_for( std::chrono::microseconds( std::min< int64_t >( 1000, int64_t( 1 ) << std::min< uint32_t >( _step - 16, 10 ) ) ) );
+        ++_step;
+      }
+
+    private:
+      uint32_t _step = 0;
+  };
+
+  int64_t elapsed_us( std::chrono::steady_clock::time_point since )
+  {
+    return std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - since ).count();
+  }
+}
+
+std::unique_ptr< replica_sync > replica_sync::open_writer( const bfs::path& dir, int64_t max_reader_wait_us )
+{
+  std::unique_ptr< replica_sync > result( new replica_sync( dir / file_name, true ) );
+  result->_max_reader_wait_us = max_reader_wait_us;
+  result->lock_exclusive();
+  result->start_new_generation();
+  result->unlock_exclusive( -1 );
+  return result;
+}
+
+std::unique_ptr< replica_sync > replica_sync::open_replica( const bfs::path& dir )
+{
+  std::unique_ptr< replica_sync > result( new replica_sync( dir / file_name, false ) );
+  result->claim_slot();
+  return result;
+}
+
+replica_sync::replica_sync( const bfs::path& path, bool writer )
+{
+  const std::string name = path.generic_string();
+  auto is_valid = [&]()
+  {
+    if( !bfs::exists( path ) || bfs::file_size( path ) != sizeof( shared_state ) )
+      return false;
+    uint32_t version = 0;
+    std::ifstream file( name, std::ios::binary );
+    file.read( reinterpret_cast< char* >( &version ), sizeof( version ) );
+    return file && version == current_version;
+  };
+
+  if( !bfs::exists( path ) && !writer )
+    BOOST_THROW_EXCEPTION( std::runtime_error( "Synchronization file " + name + " not found - writer of shared memory file does not allow read replicas" ) );
+
+  const bool valid = is_valid();
+  if( !valid )
+  {
+    if( !writer )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Synchronization file " + name + " was created by incompatible version of writer" ) );
+
+    // replicas of previous version might still have old file mapped - it is replaced, not overwritten
+    bfs::remove( path );
+    std::ofstream file( name, std::ios::binary | std::ios::trunc );
+    file.seekp( sizeof( shared_state ) - 1 );
+    file.put( 0 );
+    if( !file )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Unable to create synchronization file " + name ) );
+  }
+
+  _file = bip::file_mapping( name.c_str(), bip::read_write );
+  _region = bip::mapped_region( _file, bip::read_write, 0, sizeof( shared_state ) );
+  _state = static_cast< shared_state* >( _region.get_address() );
+
+  if( !valid )
+  {
+    new( _state ) shared_state();
+  }
+  else if( writer )
+  {
+    // there is only one writer (it holds file lock of shared memory file), so its own flag can be cleared safely
+    const int32_t previous_writer = _state->writer_pid.exchange( 0 );
+    if( previous_writer != 0 )
+      wlog( "Previous writer (pid ${p}) of ${f} died while changing state - read replicas resume with new writer", ( "p", previous_writer )( "f", name ) );
+  }
+
+  if( writer )
+  {
+    _state->pid_namespace.store( get_pid_namespace() );
+  }
+  else
+  {
+    const uint64_t writer_namespace = _state->pid_namespace.load();
+    const uint64_t own_namespace = get_pid_namespace();
+    if( writer_namespace != 0 && own_namespace != 0 && writer_namespace != own_namespace )
+      BOOST_THROW_EXCEPTION( std::runtime_error( "Read replica has to run in the same PID namespace as writer of " + name ) );
+  }
+
+  // locks of open file description (not of process) - released when descriptor is closed, also when process dies
+  _fd = ::open( name.c_str(), O_RDWR | O_CLOEXEC );
+  if( _fd < 0 )
+    BOOST_THROW_EXCEPTION( std::runtime_error( "Unable to open synchronization file " + name + ": " + strerror( errno ) ) );
+}
+
+replica_sync::~replica_sync()
+{
+  if( _slot != nullptr )
+  {
+    // reads of this replica are finished by now - slot goes back to pool when its lock is released below
+    _slot->readers.store( 0 );
+    _slot->pid.store( 0 );
+  }
+  if( _fd >= 0 )
+    ::close( _fd );
+}
+
+uint64_t replica_sync::get_pid_namespace()
+{
+  struct stat info;
+  if( ::stat( "/proc/self/ns/pid", &info ) != 0 )
+    return 0;
+  return info.st_ino;
+}
+
+namespace
+{
+  struct flock slot_lock_request( short type, const void* state, const void* slot )
+  {
+    struct flock request;
+    memset( &request, 0, sizeof( request ) );
+    request.l_type = type;
+    request.l_whence = SEEK_SET;
+    request.l_start = static_cast< const char* >( slot ) - static_cast< const char* >( state );
+    request.l_len = 1;
+    return request;
+  }
+}
+
+bool replica_sync::try_lock_slot( reader_slot& slot )
+{
+  struct flock request = slot_lock_request( F_WRLCK, _state, &slot );
+  if( ::fcntl( _fd, F_OFD_SETLK, &request ) == 0 )
+    return true;
+  if( errno != EAGAIN && errno != EACCES )
+    BOOST_THROW_EXCEPTION( std::runtime_error( std::string( "Unable to lock slot of read replica: " ) + strerror( errno ) ) );
+  return false;
+}
+
+void replica_sync::unlock_slot( reader_slot& slot )
+{
+  struct flock request = slot_lock_request( F_UNLCK, _state, &slot );
+  ::fcntl( _fd, F_OFD_SETLK, &request );
+}
+
+void replica_sync::claim_slot()
+{
+  for( auto& slot : _state->slots )
+  {
+    if( !try_lock_slot( slot ) )
+      continue; // owned by live replica
+    // lock is held for the lifetime of this object; readers of dead previous owner (if any) are gone
+    slot.pid.store( ::getpid() );
+    slot.readers.store( 0 );
+    _slot = &slot;
+    return;
+  }
+  BOOST_THROW_EXCEPTION( std::runtime_error( "Too many read replicas - all " + std::to_string( max_slots ) + " reader slots are taken" ) );
+}
+
+bool replica_sync::try_reclaim_slot( reader_slot& slot )
+{
+  // holding the lock while resetting the slot prevents new replica from claiming it in the meantime
+  if( !try_lock_slot( slot ) )
+    return false;
+  slot.readers.store( 0 );
+  slot.pid.store( 0 );
+  unlock_slot( slot );
+  return true;
+}
+
+void replica_sync::lock_exclusive()
+{
+  _state->writer_pid.store( ::getpid() );
+  // replicas check writer flag after announcing their readers (both sequentially consistent), so after
+  // all slots were seen drained no replica can be reading
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds( _max_reader_wait_us );
+  for( auto& slot : _state->slots )
+  {
+    if( slot.readers.load() != 0 )
+      wait_for_slot( slot, deadline );
+  }
+}
+
+void replica_sync::wait_for_slot( reader_slot& slot, std::chrono::steady_clock::time_point deadline )
+{
+  const auto start = std::chrono::steady_clock::now();
+  backoff delay;
+  bool deadline_handled = false;
+  while( slot.readers.load() != 0 )
+  {
+    const int32_t owner = slot.pid.load();
+    if( try_reclaim_slot( slot ) )
+    {
+      wlog( "Read replica (pid ${p}) died while reading shared memory file - reclaiming its slot", ( "p", owner ) );
+      return;
+    }
+
+    if( !deadline_handled && std::chrono::steady_clock::now() >= deadline )
+    {
+      deadline_handled = true;
+      if( owner == ::getpid() )
+      {
+        // reader within writer process (only in tests) can't be terminated
+        wlog( "Reader of shared memory file within writer process holds it for more than ${t}us - waiting for it",
+          ( "t", _max_reader_wait_us ) );
+      }
+      else if( owner != 0 )
+      {
+        // replica can't be stopped in the middle of its read, and changing state under it could crash it
+        // or make it loop on inconsistent data - it is terminated and its slot reclaimed once it is gone
+        wlog( "Read replica (pid ${p}) held shared memory file for more than ${t}us - terminating it",
+          ( "p", owner )( "t", _max_reader_wait_us ) );
+        ::kill( owner, SIGKILL );
+      }
+    }
+    delay.wait();
+  }
+  if( deadline_handled )
+    wlog( "Writer waited ${t}us for readers of shared memory file", ( "t", elapsed_us( start ) ) );
+}
+
+void replica_sync::unlock_exclusive( int64_t revision )
+{
+  _state->revision.store( revision, std::memory_order_release );
+  _state->writer_pid.store( 0 );
+}
+
+void replica_sync::start_new_generation()
+{
+  _state->generation.fetch_add( 1, std::memory_order_acq_rel );
+}
+
+bool replica_sync::lock_sharable( int64_t wait_us )
+{
+  if( sharable_lock_depth > 0 )
+  {
+    ++sharable_lock_depth;
+    return true;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  backoff delay;
+  while( true )
+  {
+    if( _state->writer_pid.load() == 0 )
+    {
+      _slot->readers.fetch_add( 1 );
+      sharable_lock_depth = 1;
+      if( _state->writer_pid.load() == 0 )
+        return true;
+      unlock_sharable(); // writer came first - let it work
+    }
+    if( wait_us != 0 && elapsed_us( start ) >= wait_us )
+      return false;
+    delay.wait();
+  }
+}
+
+void replica_sync::unlock_sharable()
+{
+  if( --sharable_lock_depth > 0 )
+    return;
+
+  uint64_t readers = _slot->readers.load();
+  do
+  {
+    if( readers == 0 )
+    {
+      elog( "Unbalanced release of read replica lock" );
+      return;
+    }
+  }
+  while( !_slot->readers.compare_exchange_weak( readers, readers - 1 ) );
+}
+
+} // chainbase
@@ -3,14 +3,24 @@
 #include <boost/test/unit_test.hpp>
 #include <chainbase/chainbase.hpp>
 
+#include <fc/container/flat.hpp>
+#include <fc/interprocess/container.hpp>
 #include <fc/io/raw.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <thread>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace chainbase;
 using namespace boost::multi_index;
@@ -43,6 +53,85 @@ CHAINBASE_SET_INDEX_TYPE( book, book_index )
 
 FC_REFLECT(book, (id)(a)(b))
 
+class magazine : public chainbase::object<1, magazine>
+{
+  CHAINBASE_OBJECT( magazine );
+
+public:
+  CHAINBASE_DEFAULT_CONSTRUCTOR( magazine )
+
+  uint64_t issn = 0;
+};
+
+struct by_issn {};
+
+typedef multi_index_container<
+  magazine,
+  indexed_by<
+    ordered_unique< tag< by_id >, const_mem_fun<magazine,magazine::id_type,&magazine::get_id> >,
+    hashed_unique< tag< by_issn >, BOOST_MULTI_INDEX_MEMBER(magazine,uint64_t,issn) >
+  >,
+  chainbase::allocator<magazine>
+> magazine_index;
+
+CHAINBASE_SET_INDEX_TYPE( magazine, magazine_index )
+
+FC_REFLECT(magazine, (id)(issn))
+
+class ledger : public chainbase::object<2, ledger>
+{
+  CHAINBASE_OBJECT( ledger );
+
+public:
+  CHAINBASE_DEFAULT_CONSTRUCTOR( ledger, (history) )
+
+  int      a = 0;
+  uint64_t balance = 0;
+  uint32_t counter = 0;
+  chainbase::t_vector< uint64_t > history; ///< member owning memory is journaled in serialized form
+};
+
+typedef multi_index_container<
+  ledger,
+  indexed_by<
+    ordered_unique< tag< by_id >, const_mem_fun<ledger,ledger::id_type,&ledger::get_id> >,
+    ordered_unique< BOOST_MULTI_INDEX_MEMBER(ledger,int,a) >
+  >,
+  chainbase::allocator<ledger>
+> ledger_index;
+
+CHAINBASE_SET_INDEX_TYPE( ledger, ledger_index )
+CHAINBASE_SET_UNDO_JOURNAL( ledger )
+
+FC_REFLECT(ledger, (id)(a)(balance)(counter)(history))
+
+/// shares id with book it was created for, like comment_cashout_object does with comment_object
+class bookmark : public chainbase::object<3, bookmark>
+{
+  CHAINBASE_OBJECT( bookmark );
+
+public:
+  template< typename Allocator >
+  bookmark( Allocator&& a, uint64_t _id, const book& _book )
+    : id( _book.get_id() ), page( _book.a ) {}
+
+  int page = 0;
+
+  CHAINBASE_UNPACK_CONSTRUCTOR( bookmark );
+};
+
+typedef multi_index_container<
+  bookmark,
+  indexed_by<
+    ordered_unique< tag< by_id >, const_mem_fun<bookmark,bookmark::id_type,&bookmark::get_id> >
+  >,
+  chainbase::allocator<bookmark>
+> bookmark_index;
+
+CHAINBASE_SET_INDEX_TYPE( bookmark, bookmark_index )
+
+FC_REFLECT(bookmark, (id)(page))
+
 namespace fc {namespace raw {
 template<typename Stream>
 inline void pack(Stream& s, const book&)
@@ -53,6 +142,44 @@ template<typename Stream>
 inline void unpack(Stream& s, book& id, uint32_t depth = 0)
   {
   }
+
+template<typename Stream>
+inline void pack(Stream& s, const magazine&)
+  {
+  }
+
+template<typename Stream>
+inline void unpack(Stream& s, magazine& id, uint32_t depth = 0)
+  {
+  }
+
+template<typename Stream>
+inline void pack(Stream& s, const bookmark&)
+  {
+  }
+
+template<typename Stream>
+inline void unpack(Stream& s, bookmark& id, uint32_t depth = 0)
+  {
+  }
+
+template<typename Stream>
+inline void pack(Stream& s, const ledger& l)
+  {
+  fc::raw::pack(s, l.a);
+  fc::raw::pack(s, l.balance);
+  fc::raw::pack(s, l.counter);
+  fc::raw::pack(s, l.history);
+  }
+
+template<typename Stream>
+inline void unpack(Stream& s, ledger& l, uint32_t depth = 0)
+  {
+  fc::raw::unpack(s, l.a, depth);
+  fc::raw::unpack(s, l.balance, depth);
+  fc::raw::unpack(s, l.counter, depth);
+  fc::raw::unpack(s, l.history, depth);
+  }
 }}
 
 
@@ -153,4 +280,737 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
   }
 }
 
-// BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
+BOOST_AUTO_TEST_CASE( visit_undo_state_changes ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< book_index >();
+
+    const auto& index = db.get_index< book_index >();
+    auto no_visit = []( const book*, const book* ) { BOOST_FAIL( "unexpected visit" ); };
+    BOOST_REQUIRE( !index.visit_undo_state_changes( no_visit ) ); /// no undo state
+
+    const auto& book1 = db.create<book>( []( book& b ) { b.a = 1; b.b = 2; } );
+    const auto& book2 = db.create<book>( []( book& b ) { b.a = 3; b.b = 4; } );
+
+    auto session = db.start_undo_session();
+    db.modify( book1, []( book& b ) { b.a = 5; } );
+    db.modify( book1, []( book& b ) { b.a = 6; } );
+    db.remove( book2 );
+    const auto& book3 = db.create<book>( []( book& b ) { b.a = 7; b.b = 8; } );
+
+    int modified = 0, created = 0, removed = 0;
+    BOOST_REQUIRE( index.visit_undo_state_changes( [&]( const book* old_value, const book* new_value )
+    {
+      if( old_value && new_value )
+      {
+        ++modified;
+        BOOST_REQUIRE_EQUAL( old_value->a, 1 );
+        BOOST_REQUIRE_EQUAL( new_value->a, 6 );
+        BOOST_REQUIRE( new_value == &book1 );
+      }
+      else if( new_value )
+      {
+        ++created;
+        BOOST_REQUIRE( new_value == &book3 );
+      }
+      else
+      {
+        ++removed;
+        BOOST_REQUIRE_EQUAL( old_value->a, 3 );
+      }
+    } ) );
+    BOOST_REQUIRE_EQUAL( modified, 1 );
+    BOOST_REQUIRE_EQUAL( created, 1 );
+    BOOST_REQUIRE_EQUAL( removed, 1 );
+
+    session.undo();
+    BOOST_REQUIRE( !index.visit_undo_state_changes( no_visit ) );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( slot_table_lookup ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< book_index >();
+
+    const auto& index = db.get_index< book_index >();
+    auto check_consistency = [&]( uint32_t next_id )
+    {
+      const auto& by_id_idx = index.indices().get< by_id >();
+      for( uint32_t id = 0; id <= next_id; ++id )
+      {
+        auto itr = by_id_idx.find( book::id_type( id ) );
+        const book* expected = itr == by_id_idx.end() ? nullptr : &*itr;
+        BOOST_REQUIRE( db.find< book >( book::id_type( id ) ) == expected );
+        BOOST_REQUIRE( index.find( book::id_type( id ) ) == expected );
+      }
+    };
+
+    const uint32_t count = 3000;
+    for( uint32_t i = 0; i < count; ++i )
+      db.create<book>( [&]( book& b ) { b.a = i; } );
+    check_consistency( count );
+    BOOST_REQUIRE_EQUAL( db.get< book >( book::id_type( 1234 ) ).a, 1234 );
+
+    {
+      auto session = db.start_undo_session();
+      /// removal in order of creation releases leading part of the table
+      for( uint32_t i = 0; i < 2000; ++i )
+        db.remove( db.get< book >( book::id_type( i ) ) );
+      const auto& added = db.create<book>( []( book& b ) { b.a = -1; } );
+      BOOST_REQUIRE( db.find< book >( book::id_type( count ) ) == &added );
+      check_consistency( count + 1 );
+    }
+    /// undo restores removed objects in front of the table and drops created one
+    check_consistency( count + 1 );
+    BOOST_REQUIRE( db.find< book >( book::id_type( count ) ) == nullptr );
+    BOOST_REQUIRE_EQUAL( db.get< book >( book::id_type( 0 ) ).a, 0 );
+
+    for( uint32_t i = 0; i < 2000; ++i )
+      db.remove( db.get< book >( book::id_type( i ) ) );
+    const auto& added = db.create<book>( []( book& b ) { b.a = -1; } );
+    BOOST_REQUIRE_EQUAL( added.get_id().get_value(), count );
+    check_consistency( count + 1 );
+
+    db.get_mutable_index< book_index >().clear();
+    BOOST_REQUIRE( db.find< book >( book::id_type( count ) ) == nullptr );
+
+    /// objects with borrowed ids live past _next_id of their own index, undo must not drop their slots
+    db.add_index< bookmark_index >();
+    const auto& marked = db.create<book>( []( book& b ) { b.a = 7; } );
+    const auto& mark = db.create<bookmark>( marked );
+    BOOST_REQUIRE_GT( mark.get_id().get_value(), 0u );
+    {
+      auto session = db.start_undo_session();
+      db.create<bookmark>( db.create<book>( []( book& b ) { b.a = 8; } ) );
+    }
+    BOOST_REQUIRE( db.find< bookmark >( mark.get_id() ) == &mark );
+    BOOST_REQUIRE_EQUAL( db.get< bookmark >( bookmark::id_type( marked.get_id().get_value() ) ).page, 7 );
+    BOOST_REQUIRE( db.find< bookmark >( bookmark::id_type( mark.get_id().get_value() + 1 ) ) == nullptr );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( hashed_index ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< magazine_index >();
+
+    const auto& by_issn_idx = db.get_index< magazine_index, by_issn >();
+    const uint64_t count = 1000;
+    for( uint64_t i = 0; i < count; ++i )
+      db.create<magazine>( [&]( magazine& m ) { m.issn = i * 7; } );
+    BOOST_REQUIRE( ( db.find< magazine, by_issn >( 7 * 123 ) == db.find< magazine >( magazine::id_type( 123 ) ) ) );
+    BOOST_REQUIRE( ( db.find< magazine, by_issn >( 5 ) == nullptr ) );
+    auto buckets_before = by_issn_idx.bucket_count();
+
+    {
+      auto session = db.start_undo_session();
+      /// enough new entries to force rehash of the buckets, then change keys and remove some of old entries
+      for( uint64_t i = count; i < 10 * count; ++i )
+        db.create<magazine>( [&]( magazine& m ) { m.issn = i * 7; } );
+      BOOST_REQUIRE( by_issn_idx.bucket_count() > buckets_before );
+      db.modify( db.get< magazine >( magazine::id_type( 5 ) ), []( magazine& m ) { m.issn = 5; } );
+      for( uint64_t i = 100; i < 200; ++i )
+        db.remove( db.get< magazine, by_issn >( i * 7 ) );
+      BOOST_CHECK_THROW( db.modify( db.get< magazine >( magazine::id_type( 6 ) ), []( magazine& m ) { m.issn = 5; } ), std::logic_error );
+    }
+
+    /// undo restores state from before the session, including object dropped by failed modify
+    BOOST_REQUIRE_EQUAL( by_issn_idx.size(), count );
+    BOOST_REQUIRE( ( db.find< magazine, by_issn >( 5 ) == nullptr ) );
+    BOOST_REQUIRE( ( db.find< magazine, by_issn >( 7 * count ) == nullptr ) );
+    for( uint64_t i = 0; i < count; ++i )
+    {
+      const magazine* m = db.find< magazine, by_issn >( i * 7 );
+      BOOST_REQUIRE( m != nullptr );
+      BOOST_REQUIRE( m == db.find< magazine >( magazine::id_type( i ) ) );
+    }
+
+    auto info = db.get_abstract_index_cntr().front()->get_statistics( true );
+    BOOST_REQUIRE_EQUAL( info._item_count, count );
+    BOOST_REQUIRE( info._additional_container_allocation >= by_issn_idx.bucket_count() * sizeof( void* ) );
+
+    /// growth within reservation does not rehash
+    db.get_mutable_index< magazine_index >().reserve_buckets( 20 * count );
+    const auto reserved_buckets = by_issn_idx.bucket_count();
+    BOOST_REQUIRE( reserved_buckets >= 20 * count );
+    for( uint64_t i = count; i < 20 * count; ++i )
+      db.create<magazine>( [&]( magazine& m ) { m.issn = i * 7; } );
+    BOOST_REQUIRE_EQUAL( by_issn_idx.bucket_count(), reserved_buckets );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+// BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE( journaled_undo ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< ledger_index >();
+
+    const auto& index = db.get_index< ledger_index >();
+    const auto& l1 = db.create<ledger>( []( ledger& l ) { l.a = 1; l.balance = 10; } );
+    const auto& l2 = db.create<ledger>( []( ledger& l ) { l.a = 2; l.balance = 20; } );
+    const auto& l3 = db.create<ledger>( []( ledger& l ) { l.a = 3; l.balance = 30; } );
+    const ledger::id_type id2 = l2.get_id();
+
+    {
+      auto session = db.start_undo_session();
+      db.modify( l1, []( ledger& l ) { l.balance = 11; } );
+      db.modify( l1, []( ledger& l ) { l.balance = 12; ++l.counter; l.history.push_back( 11 ); } );
+      db.modify( l2, []( ledger& l ) { l.a = 5; } );
+      db.remove( db.get< ledger >( id2 ) );
+      const auto& l4 = db.create<ledger>( []( ledger& l ) { l.a = 4; } );
+      db.modify( l4, []( ledger& l ) { l.balance = 40; } );
+      /// reindex failure drops the object, undo has to bring it back
+      BOOST_REQUIRE_THROW( db.modify( l3, []( ledger& l ) { l.a = 1; l.balance = 31; } ), std::logic_error );
+      BOOST_REQUIRE( db.find< ledger >( ledger::id_type( 2 ) ) == nullptr );
+
+      int modified = 0, created = 0, removed = 0;
+      BOOST_REQUIRE( index.visit_undo_state_changes( [&]( const ledger* old_value, const ledger* new_value )
+      {
+        if( old_value && new_value )
+        {
+          ++modified;
+          BOOST_REQUIRE( new_value == &l1 );
+          BOOST_REQUIRE_EQUAL( old_value->balance, 10 );
+          BOOST_REQUIRE_EQUAL( old_value->counter, 0 );
+          BOOST_REQUIRE( old_value->history.empty() );
+          BOOST_REQUIRE_EQUAL( new_value->balance, 12 );
+          BOOST_REQUIRE_EQUAL( new_value->history.size(), 1 );
+        }
+        else if( new_value )
+        {
+          ++created;
+          BOOST_REQUIRE_EQUAL( new_value->a, 4 );
+        }
+        else
+        {
+          ++removed;
+          /// removed objects are reported with values from before the session
+          BOOST_REQUIRE( old_value->a == 2 || old_value->a == 3 );
+          BOOST_REQUIRE_EQUAL( old_value->balance, uint64_t( old_value->a * 10 ) );
+        }
+      } ) );
+      BOOST_REQUIRE_EQUAL( modified, 1 );
+      BOOST_REQUIRE_EQUAL( created, 1 );
+      BOOST_REQUIRE_EQUAL( removed, 2 );
+    }
+
+    BOOST_REQUIRE_EQUAL( index.indices().size(), 3 );
+    for( int i = 0; i < 3; ++i )
+    {
+      const auto& l = db.get< ledger >( ledger::id_type( i ) );
+      BOOST_REQUIRE_EQUAL( l.a, i + 1 );
+      BOOST_REQUIRE_EQUAL( l.balance, uint64_t( ( i + 1 ) * 10 ) );
+      BOOST_REQUIRE_EQUAL( l.counter, 0 );
+    }
+
+    auto require_initial_state = [&]()
+    {
+      BOOST_REQUIRE_EQUAL( index.indices().size(), 3 );
+      for( int i = 0; i < 3; ++i )
+      {
+        const auto& l = db.get< ledger >( ledger::id_type( i ) );
+        BOOST_REQUIRE_EQUAL( l.a, i + 1 );
+        BOOST_REQUIRE_EQUAL( l.balance, uint64_t( ( i + 1 ) * 10 ) );
+        BOOST_REQUIRE_EQUAL( l.counter, 0 );
+        BOOST_REQUIRE( l.history.empty() );
+      }
+    };
+
+    /// squashed sessions undo changes of both
+    {
+      auto outer = db.start_undo_session();
+      db.modify( l1, []( ledger& l ) { l.balance = 100; } );
+      db.modify( db.get< ledger >( ledger::id_type( 2 ) ), []( ledger& l ) { l.a = 30; l.counter = 3; } );
+      const auto& l5 = db.create<ledger>( []( ledger& l ) { l.a = 5; } );
+      {
+        auto inner = db.start_undo_session();
+        db.modify( l1, []( ledger& l ) { l.balance = 200; l.counter = 2; l.history.push_back( 100 ); } );
+        db.modify( l1, []( ledger& l ) { l.balance = 300; } );
+        db.modify( l5, []( ledger& l ) { l.balance = 50; } );
+        db.remove( db.get< ledger >( ledger::id_type( 2 ) ) );
+        inner.squash();
+      }
+      BOOST_REQUIRE_EQUAL( l1.balance, 300 );
+      BOOST_REQUIRE( db.find< ledger >( ledger::id_type( 2 ) ) == nullptr );
+
+      int modified = 0, removed = 0;
+      BOOST_REQUIRE( index.visit_undo_state_changes( [&]( const ledger* old_value, const ledger* new_value )
+      {
+        if( old_value && new_value )
+        {
+          ++modified;
+          BOOST_REQUIRE_EQUAL( old_value->balance, 10 );
+          BOOST_REQUIRE_EQUAL( old_value->counter, 0 );
+        }
+        else if( old_value )
+        {
+          ++removed;
+          BOOST_REQUIRE_EQUAL( old_value->a, 3 );
+          BOOST_REQUIRE_EQUAL( old_value->counter, 0 );
+        }
+      } ) );
+      BOOST_REQUIRE_EQUAL( modified, 1 );
+      BOOST_REQUIRE_EQUAL( removed, 1 );
+    }
+    require_initial_state();
+
+    /// object removed after change of its unique key comes back with key from before the session, even when
+    /// other objects took both its original key and the one it had when removed
+    {
+      auto session = db.start_undo_session();
+      db.modify( db.get< ledger >( ledger::id_type( 1 ) ), []( ledger& l ) { l.a = 20; l.balance = 21; } );
+      db.remove( db.get< ledger >( ledger::id_type( 1 ) ) );
+      db.modify( db.get< ledger >( ledger::id_type( 2 ) ), []( ledger& l ) { l.a = 20; } );
+      db.create<ledger>( []( ledger& l ) { l.a = 2; } );
+
+      int removed = 0;
+      BOOST_REQUIRE( index.visit_undo_state_changes( [&]( const ledger* old_value, const ledger* new_value )
+      {
+        if( !new_value )
+        {
+          ++removed;
+          BOOST_REQUIRE_EQUAL( old_value->a, 2 );
+          BOOST_REQUIRE_EQUAL( old_value->balance, 20 );
+        }
+      } ) );
+      BOOST_REQUIRE_EQUAL( removed, 1 );
+    }
+    require_initial_state();
+
+    /// the same when key change and removal happen in different squashed sessions
+    {
+      auto outer = db.start_undo_session();
+      db.modify( db.get< ledger >( ledger::id_type( 1 ) ), []( ledger& l ) { l.a = 20; } );
+      {
+        auto inner = db.start_undo_session();
+        db.remove( db.get< ledger >( ledger::id_type( 1 ) ) );
+        db.modify( db.get< ledger >( ledger::id_type( 2 ) ), []( ledger& l ) { l.a = 20; } );
+        inner.squash();
+      }
+    }
+    require_initial_state();
+
+    /// unique keys exchanged through several modifications within squashed sessions are restored in reverse order
+    {
+      auto outer = db.start_undo_session();
+      db.modify( l1, []( ledger& l ) { l.a = 10; ++l.counter; } );
+      db.modify( db.get< ledger >( ledger::id_type( 1 ) ), []( ledger& l ) { l.a = 1; } );
+      {
+        auto inner = db.start_undo_session();
+        db.modify( l1, []( ledger& l ) { l.a = 2; ++l.counter; } );
+        db.modify( db.get< ledger >( ledger::id_type( 1 ) ), []( ledger& l ) { l.balance = 25; } );
+        inner.squash();
+      }
+      BOOST_REQUIRE_EQUAL( l1.counter, 2 );
+
+      int modified = 0;
+      BOOST_REQUIRE( index.visit_undo_state_changes( [&]( const ledger* old_value, const ledger* new_value )
+      {
+        ++modified;
+        BOOST_REQUIRE( old_value && new_value );
+        BOOST_REQUIRE_EQUAL( old_value->a, int( old_value->get_id().get_value() ) + 1 );
+        BOOST_REQUIRE_EQUAL( old_value->counter, 0 );
+      } ) );
+      BOOST_REQUIRE_EQUAL( modified, 2 );
+    }
+    require_initial_state();
+
+    /// committed changes stay
+    {
+      auto session = db.start_undo_session();
+      db.modify( l1, []( ledger& l ) { l.balance = 15; } );
+      session.push();
+    }
+    db.commit( db.revision() );
+    BOOST_REQUIRE_EQUAL( l1.balance, 15 );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( node_pool_reuse ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< book_index >();
+
+    auto get_info = [&]() { return db.get_abstract_index_cntr().front()->get_statistics( true ); };
+
+    const uint32_t count = 1000;
+    for( uint32_t i = 0; i < count; ++i )
+      db.create<book>( [&]( book& b ) { b.a = i; } );
+
+    auto info = get_info();
+    BOOST_REQUIRE_GT( info._node_pool_reserved, 0 );
+    /// pool holds all nodes (plus header node of the container)
+    BOOST_REQUIRE_GE( info._node_pool_reserved - info._node_pool_free, count * ( info._item_sizeof ) );
+    const size_t reserved = info._node_pool_reserved;
+    const size_t free = info._node_pool_free;
+
+    for( uint32_t i = 0; i < count; i += 2 )
+      db.remove( db.get< book >( book::id_type( i ) ) );
+    info = get_info();
+    BOOST_REQUIRE_EQUAL( info._node_pool_reserved, reserved );
+    BOOST_REQUIRE_GT( info._node_pool_free, free );
+
+    /// released nodes are reused before pool asks segment manager for more memory
+    for( uint32_t i = 0; i < count / 2; ++i )
+      db.create<book>( [&]( book& b ) { b.a = i; } );
+    info = get_info();
+    BOOST_REQUIRE_EQUAL( info._node_pool_reserved, reserved );
+    BOOST_REQUIRE_EQUAL( info._node_pool_free, free );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( compaction ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< ledger_index >();
+
+    const int count = 5000;
+    for( int i = 0; i < count; ++i )
+      db.create<ledger>( [&]( ledger& l ) { l.a = i; l.balance = i * 3; l.counter = i % 7; } );
+    for( int i = 0; i < count; ++i )
+    {
+      if( i % 4 != 0 )
+        db.remove( db.get< ledger >( ledger::id_type( i ) ) );
+    }
+    db.set_revision( 42 );
+    const size_t free_before = db.get_free_memory();
+
+    BOOST_REQUIRE_THROW( [&]() { auto session = db.start_undo_session(); db.compact(); }(), std::runtime_error );
+
+    auto stats = db.compact();
+    BOOST_REQUIRE_GT( stats.get_reclaimed(), 0 );
+    BOOST_REQUIRE_GT( db.get_free_memory(), free_before );
+    BOOST_REQUIRE( !bfs::exists( temp / "shared_memory.bin.compact" ) );
+
+    /// replaced file is still guarded from other writers
+    const pid_t child = fork();
+    BOOST_REQUIRE( child >= 0 );
+    if( child == 0 )
+    {
+      try
+      {
+        chainbase::database other;
+        other.open( temp, 0, 1024*1024*8 );
+      }
+      catch( const std::runtime_error& )
+      {
+        _exit( 0 );
+      }
+      _exit( 1 );
+    }
+    int status = 0;
+    BOOST_REQUIRE_EQUAL( waitpid( child, &status, 0 ), child );
+    BOOST_REQUIRE( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+
+    const auto& index = db.get_index< ledger_index >();
+    BOOST_REQUIRE_EQUAL( index.indices().size(), count / 4 );
+    BOOST_REQUIRE_EQUAL( index.get_next_id().get_value(), count );
+    BOOST_REQUIRE_EQUAL( db.revision(), 42 );
+    for( int i = 0; i < count; i += 4 )
+    {
+      const auto& l = db.get< ledger >( ledger::id_type( i ) );
+      BOOST_REQUIRE_EQUAL( l.a, i );
+      BOOST_REQUIRE_EQUAL( l.balance, uint64_t( i * 3 ) );
+      BOOST_REQUIRE_EQUAL( l.counter, uint32_t( i % 7 ) );
+    }
+    const auto& created = db.create<ledger>( []( ledger& l ) { l.a = -1; } );
+    BOOST_REQUIRE_EQUAL( created.get_id().get_value(), count );
+
+    /// compacted file is used after reopen
+    db.close();
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< ledger_index >();
+    BOOST_REQUIRE_EQUAL( db.get_index< ledger_index >().indices().size(), count / 4 + 1 );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( read_replica ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database replica;
+    BOOST_CHECK_THROW( replica.open( temp, chainbase::database::read_only ), std::runtime_error ); /// no shared memory file yet
+
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< ledger_index >();
+    BOOST_CHECK_THROW( replica.open( temp, chainbase::database::read_only ), std::runtime_error ); /// writer does not allow replicas
+    db.close();
+
+    db.open( temp, chainbase::database::allow_replicas, 1024*1024*8 );
+    db.add_index< ledger_index >();
+    db.with_write_lock( [&]()
+    {
+      for( int i = 0; i < 10; ++i )
+        db.create<ledger>( [&]( ledger& l ) { l.a = i; } );
+      db.set_revision( 7 );
+    } );
+
+    replica.open( temp, chainbase::database::read_only );
+    replica.add_index< ledger_index >();
+    BOOST_REQUIRE( replica.is_read_only() );
+    BOOST_REQUIRE_EQUAL( replica.get_replica_revision(), 7 );
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get_index< ledger_index >().indices().size(), 10 );
+      BOOST_REQUIRE_EQUAL( replica.get< ledger >( ledger::id_type( 3 ) ).a, 3 );
+    } );
+    BOOST_CHECK_THROW( replica.with_write_lock( []() {} ), std::logic_error );
+    BOOST_CHECK_THROW( replica.resize( 1024*1024*16 ), std::runtime_error );
+
+    BOOST_TEST_MESSAGE( "Replica follows changes of writer" );
+    db.with_write_lock( [&]()
+    {
+      db.modify( db.get< ledger >( ledger::id_type( 3 ) ), []( ledger& l ) { l.a = 33; } );
+      db.set_revision( 8 );
+    } );
+    BOOST_REQUIRE_EQUAL( replica.get_replica_revision(), 8 );
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get< ledger >( ledger::id_type( 3 ) ).a, 33 );
+    } );
+
+    BOOST_TEST_MESSAGE( "Replica remaps file resized by writer" );
+    db.with_write_lock( [&]()
+    {
+      db.resize( 1024*1024*16 );
+      db.create<ledger>( []( ledger& l ) { l.a = 10; } );
+    } );
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get_max_memory(), 1024*1024*16 );
+      BOOST_REQUIRE_EQUAL( replica.get_index< ledger_index >().indices().size(), 11 );
+    } );
+
+    BOOST_TEST_MESSAGE( "Replica remaps file replaced by compaction" );
+    db.with_write_lock( [&]()
+    {
+      db.remove( db.get< ledger >( ledger::id_type( 0 ) ) );
+      db.compact();
+    } );
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get_index< ledger_index >().indices().size(), 10 );
+      BOOST_REQUIRE_EQUAL( replica.get< ledger >( ledger::id_type( 10 ) ).a, 10 );
+    } );
+
+    replica.close();
+    db.close();
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( read_replica_failures ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    db.open( temp, chainbase::database::allow_replicas, 1024*1024*8 );
+    db.add_index< ledger_index >();
+    db.with_write_lock( [&]() { db.create<ledger>( []( ledger& l ) { l.a = 1; } ); } );
+
+    /// writer must not wait for lock forever - run it on separate thread and give up after a while
+    int next_value = 2; // ledger::a is unique
+    auto write_completes = [&]( std::chrono::seconds limit )
+    {
+      auto done = std::async( std::launch::async, [&]()
+      {
+        db.with_write_lock( [&]() { db.create<ledger>( [&]( ledger& l ) { l.a = next_value++; } ); } );
+      } );
+      if( done.wait_for( limit ) != std::future_status::ready )
+        return false;
+      done.get(); // rethrows failure of the write
+      return true;
+    };
+
+    /// runs replica in child process that holds read lock until it is killed
+    auto fork_stuck_reader = [&]()
+    {
+      int ready_pipe[2];
+      BOOST_REQUIRE_EQUAL( pipe( ready_pipe ), 0 );
+      const pid_t child = fork();
+      BOOST_REQUIRE_GE( child, 0 );
+      if( child == 0 )
+      {
+        chainbase::database replica;
+        replica.open( temp, chainbase::database::read_only );
+        replica.add_index< ledger_index >();
+        replica.with_read_lock( [&]()
+        {
+          char ready = 1;
+          if( write( ready_pipe[1], &ready, 1 ) != 1 )
+            _exit( 1 );
+          while( true )
+            pause();
+        } );
+        _exit( 0 );
+      }
+      char ready = 0;
+      BOOST_REQUIRE_EQUAL( read( ready_pipe[0], &ready, 1 ), 1 );
+      close( ready_pipe[0] );
+      close( ready_pipe[1] );
+      return child;
+    };
+
+    BOOST_TEST_MESSAGE( "Replica killed while holding read lock does not block writer" );
+    pid_t child = fork_stuck_reader();
+    kill( child, SIGKILL );
+    int status = 0;
+    BOOST_REQUIRE_EQUAL( waitpid( child, &status, 0 ), child );
+    BOOST_REQUIRE( write_completes( std::chrono::seconds( 10 ) ) );
+
+    BOOST_TEST_MESSAGE( "Live replica can still read after writer reclaimed slot of dead one" );
+    chainbase::database replica;
+    replica.open( temp, chainbase::database::read_only );
+    replica.add_index< ledger_index >();
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get_index< ledger_index >().indices().size(), 2 );
+    } );
+
+    BOOST_TEST_MESSAGE( "Replica holding read lock for too long is terminated by writer" );
+    db.set_max_replica_reader_wait( std::chrono::milliseconds( 10 ) );
+    child = fork_stuck_reader();
+    BOOST_REQUIRE( write_completes( std::chrono::seconds( 10 ) ) );
+    BOOST_REQUIRE_EQUAL( waitpid( child, &status, 0 ), child );
+    BOOST_REQUIRE( WIFSIGNALED( status ) );
+    BOOST_REQUIRE_EQUAL( WTERMSIG( status ), SIGKILL );
+
+    /// other replicas are not affected
+    replica.with_read_lock( [&]()
+    {
+      BOOST_REQUIRE_EQUAL( replica.get_index< ledger_index >().indices().size(), 3 );
+    } );
+
+    replica.close();
+    db.close();
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( lock_times ) {
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    struct counting_observer : public chainbase::lock_observer
+    {
+      virtual void on_read_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) override
+      {
+        ++reads;
+        read_hold += hold_time;
+      }
+      virtual void on_write_lock_released( std::chrono::nanoseconds wait_time, std::chrono::nanoseconds hold_time ) override
+      {
+        ++writes;
+      }
+
+      uint32_t reads = 0;
+      uint32_t writes = 0;
+      std::chrono::nanoseconds read_hold = std::chrono::nanoseconds( 0 );
+    } observer;
+
+    chainbase::database db;
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< book_index >();
+    db.set_lock_observer( &observer );
+
+    db.with_write_lock( [&]() { db.create<book>( []( book& b ) { b.a = 1; } ); } );
+    db.with_read_lock( [&]() { std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) ); } );
+    BOOST_REQUIRE_EQUAL( observer.writes, 1 );
+    BOOST_REQUIRE_EQUAL( observer.reads, 1 );
+    BOOST_REQUIRE( observer.read_hold >= std::chrono::milliseconds( 2 ) );
+
+    /// callback that throws still releases (and reports) the lock
+    BOOST_CHECK_THROW( db.with_read_lock( []() { throw std::runtime_error( "test" ); } ), std::runtime_error );
+    BOOST_REQUIRE_EQUAL( observer.reads, 2 );
+
+    db.set_lock_observer( nullptr );
+    db.with_read_lock( []() {} );
+    BOOST_REQUIRE_EQUAL( observer.reads, 2 );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
+
+BOOST_AUTO_TEST_CASE( memory_mapping_options ) {
+  using chainbase::memory_mapping::parse_node_list;
+  using node_list = std::vector< uint32_t >;
+  BOOST_REQUIRE( parse_node_list( "0-3,6" ) == node_list( { 0, 1, 2, 3, 6 } ) );
+  BOOST_REQUIRE( parse_node_list( " 5, 1 ,1-2,5 " ) == node_list( { 1, 2, 5 } ) );
+  BOOST_REQUIRE( parse_node_list( "" ).empty() );
+  BOOST_CHECK_THROW( parse_node_list( "3-1" ), std::runtime_error );
+  BOOST_CHECK_THROW( parse_node_list( "a" ), std::runtime_error );
+  BOOST_CHECK_THROW( parse_node_list( "1-" ), std::runtime_error );
+
+  boost::filesystem::path temp = boost::filesystem::unique_path();
+  try {
+    chainbase::database db;
+    BOOST_REQUIRE_EQUAL( db.get_mapping_statistics().mapped_size, 0 );
+
+    /// bind policy without nodes is reported, not thrown; prefault makes whole file resident
+    chainbase::mapping_options options;
+    options.prefault_threads = 2;
+    options.numa_policy = chainbase::mapping_options::numa_policy_type::bind;
+    db.set_mapping_options( options );
+    db.open( temp, 0, 1024*1024*8 );
+    db.add_index< book_index >();
+
+    auto stats = db.get_mapping_statistics();
+    BOOST_REQUIRE_EQUAL( stats.mapped_size, 1024*1024*8 );
+    BOOST_REQUIRE_GT( stats.resident_size, 0 );
+    BOOST_REQUIRE_LE( stats.resident_size, stats.mapped_size );
+
+    db.with_read_lock( [&]() { db.refresh_mapping_statistics(); } );
+    BOOST_REQUIRE_EQUAL( db.get_mapping_statistics().mapped_size, 1024*1024*8 );
+
+    db.close();
+    BOOST_REQUIRE_EQUAL( db.get_mapping_statistics().mapped_size, 0 );
+  } catch ( ... ) {
+    bfs::remove_all( temp );
+    throw;
+  }
+  bfs::remove_all( temp );
+}
@@ -12,6 +12,7 @@
 #pragma once
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 #include <typeinfo>
 #include <fc/exception/exception.hpp>
 #include <fc/uint128.hpp>
@@ -41,7 +42,7 @@ struct variant_creator_functor
 // Implementation details, the user should not import this:
 namespace impl {
 
-template<int64_t N, typename... Ts>
+template<typename... Ts>
 struct storage_ops;
 
 template<typename X, typename... Ts>
@@ -76,91 +77,75 @@ struct move_construct
    }
 };
 
-template<int64_t N, typename T, typename... Ts>
-struct storage_ops<N, T&, Ts...> {
-    static void del(int64_t n, void *data) {}
-    static void con(int64_t n, void *data) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {}
-
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {}
-};
-
-template<int64_t N, typename T, typename... Ts>
-struct storage_ops<N, T, Ts...> {
+/**
+ * Operations on storage of static_variant dispatched on stored type tag.
+ * Each operation uses a table of function pointers (one entry per type, generated at compile time),
+ * so dispatch costs one indexed indirect call regardless of number of types, instead of a chain of
+ * tag comparisons that grows with position of the type.
+ */
+template<typename... Ts>
+struct storage_ops {
     static void del(int64_t n, void *data) {
-        if(n == N) 
-        {
-            auto ptr = std::launder(reinterpret_cast<T*>(data));
-            std::destroy_at(ptr);
-        }
-        else
-        {
-            storage_ops<N + 1, Ts...>::del(n, data);
-        }
+        static constexpr void (*table[])(void*) = { &del_impl<Ts>... };
+        check_tag(n);
+        table[n](data);
     }
     static void con(int64_t n, void *data) {
-        if(n == N) new(data) T();
-        else storage_ops<N + 1, Ts...>::con(n, data);
+        static constexpr void (*table[])(void*) = { &con_impl<Ts>... };
+        check_tag(n);
+        table[n](data);
     }
 
     template<typename visitor>
     static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {
-        if(n == N) return v(*reinterpret_cast<T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
+        return dispatch<void*, visitor&>(n, data, v);
     }
 
     template<typename visitor>
     static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {
-        if(n == N) return v(*reinterpret_cast<T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
+        return dispatch<void*, const visitor&>(n, data, v);
     }
 
     template<typename visitor>
     static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {
-        if(n == N) return v(*reinterpret_cast<const T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
+        return dispatch<const void*, visitor&>(n, data, v);
     }
 
     template<typename visitor>
     static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {
-        if(n == N) return v(*reinterpret_cast<const T*>(data));
-        else return storage_ops<N + 1, Ts...>::apply(n, data, v);
+        return dispatch<const void*, const visitor&>(n, data, v);
     }
-};
 
-template<int64_t N>
-struct storage_ops<N> {
-    static void del(int64_t n, void *data) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid.");
-    }
-    static void con(int64_t n, void *data) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+private:
+    static void check_tag(int64_t n) {
+        if(static_cast<uint64_t>(n) >= sizeof...(Ts))
+            FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
     }
 
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+    template<typename T>
+    static void del_impl(void *data) {
+        auto ptr = std::launder(reinterpret_cast<T*>(data));
+        std::destroy_at(ptr);
     }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, void *data, const visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+    template<typename T>
+    static void con_impl(void *data) {
+        new(data) T();
     }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+
+    template<typename T, typename Data, typename Visitor>
+    static typename std::decay_t<Visitor>::result_type apply_impl(Data data, Visitor v) {
+        if constexpr(std::is_const_v<std::remove_pointer_t<Data>>)
+            return v(*reinterpret_cast<const T*>(data));
+        else
+            return v(*reinterpret_cast<T*>(data));
     }
-    template<typename visitor>
-    static typename visitor::result_type apply(int64_t n, const void *data, const visitor& v) {
-       FC_THROW_EXCEPTION( fc::assert_exception, "Internal error: static_variant tag is invalid." );
+
+    template<typename Data, typename Visitor>
+    static typename std::decay_t<Visitor>::result_type dispatch(int64_t n, Data data, Visitor v) {
+        typedef typename std::decay_t<Visitor>::result_type (*function_type)(Data, Visitor);
+        static constexpr function_type table[] = { &apply_impl<Ts, Data, Visitor>... };
+        check_tag(n);
+        return table[n](data, v);
     }
 };
 
@@ -274,14 +259,14 @@ public:
     static_variant(int64_t t = 0)
       : _tag( t )
     {
-       impl::storage_ops<0, Types...>::con(_tag, storage);
+       impl::storage_ops<Types...>::con(_tag, storage);
     }
 
     template<typename visitor>
     static_variant(int64_t t, visitor& v)
       : _tag(t)
     {
-      impl::storage_ops<0, Types...>::con(_tag, storage);
+      impl::storage_ops<Types...>::con(_tag, storage);
       visit(v);
     }
 
@@ -380,22 +365,22 @@ public:
     }
     template<typename visitor>
     typename visitor::result_type visit(visitor& v) {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v) {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(visitor& v)const {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     template<typename visitor>
     typename visitor::result_type visit(const visitor& v)const {
-        return impl::storage_ops<0, Types...>::apply(_tag, storage, v);
+        return impl::storage_ops<Types...>::apply(_tag, storage, v);
     }
 
     static int64_t count() { return static_cast< int64_t >( impl::type_info<Types...>::count ); }
@@ -403,7 +388,7 @@ public:
     int64_t which() const {return _tag;}
 private:
     void clear_storage() {
-      impl::storage_ops<0, Types...>::del(_tag, storage);
+      impl::storage_ops<Types...>::del(_tag, storage);
     }
 };
 
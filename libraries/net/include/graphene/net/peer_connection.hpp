@@ -304,6 +304,8 @@ namespace graphene { namespace net
 
       uint64_t get_total_bytes_sent() const;
       uint64_t get_total_bytes_received() const;
+      uint64_t get_total_messages_sent() const;
+      uint64_t get_total_messages_received() const;
 
       fc::time_point get_last_message_sent_time() const;
       fc::time_point get_last_message_received_time() const;
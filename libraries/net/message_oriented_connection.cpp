@@ -58,6 +58,8 @@ namespace graphene { namespace net {
       fc::future<void> _read_loop_done;
       uint64_t _bytes_received;
       uint64_t _bytes_sent;
+      uint64_t _messages_received;
+      uint64_t _messages_sent;
 
       fc::time_point _connected_time;
       fc::time_point _last_message_received_time;
@@ -86,6 +88,8 @@ namespace graphene { namespace net {
 
       uint64_t get_total_bytes_sent() const;
       uint64_t get_total_bytes_received() const;
+      uint64_t get_total_messages_sent() const;
+      uint64_t get_total_messages_received() const;
 
       fc::time_point get_last_message_sent_time() const;
       fc::time_point get_last_message_received_time() const;
@@ -99,6 +103,8 @@ namespace graphene { namespace net {
       _delegate(delegate),
       _bytes_received(0),
       _bytes_sent(0),
+      _messages_received(0),
+      _messages_sent(0),
       _send_message_in_progress(false)
 #ifndef NDEBUG
       ,_thread(&fc::thread::current())
@@ -182,6 +188,7 @@ namespace graphene { namespace net {
           m.data.resize(m.size); // truncate off the padding bytes
 
           _last_message_received_time = fc::time_point::now();
+          ++_messages_received;
 
           try
           {
@@ -281,6 +288,7 @@ namespace graphene { namespace net {
         _sock.write(padded_message.get(), size_with_padding);
         _sock.flush();
         _bytes_sent += size_with_padding;
+        ++_messages_sent;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
@@ -331,6 +339,18 @@ namespace graphene { namespace net {
       return _bytes_received;
     }
 
+    uint64_t message_oriented_connection_impl::get_total_messages_sent() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _messages_sent;
+    }
+
+    uint64_t message_oriented_connection_impl::get_total_messages_received() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _messages_received;
+    }
+
     fc::time_point message_oriented_connection_impl::get_last_message_sent_time() const
     {
       VERIFY_CORRECT_THREAD();
@@ -406,6 +426,16 @@ namespace graphene { namespace net {
     return my->get_total_bytes_received();
   }
 
+  uint64_t message_oriented_connection::get_total_messages_sent() const
+  {
+    return my->get_total_messages_sent();
+  }
+
+  uint64_t message_oriented_connection::get_total_messages_received() const
+  {
+    return my->get_total_messages_received();
+  }
+
   fc::time_point message_oriented_connection::get_last_message_sent_time() const
   {
     return my->get_last_message_sent_time();
@@ -5512,6 +5512,8 @@ namespace graphene { namespace net {
         peer_details["lastrecv"] = peer->get_last_message_received_time().sec_since_epoch();
         peer_details["bytessent"] = peer->get_total_bytes_sent();
         peer_details["bytesrecv"] = peer->get_total_bytes_received();
+        peer_details["msgsent"] = peer->get_total_messages_sent();
+        peer_details["msgrecv"] = peer->get_total_messages_received();
         peer_details["conntime"] = peer->get_connection_time();
         peer_details["pingtime"] = "";
         peer_details["pingwait"] = "";
@@ -420,6 +420,18 @@ namespace graphene { namespace net
       return _message_connection.get_total_bytes_received();
     }
 
+    uint64_t peer_connection::get_total_messages_sent() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _message_connection.get_total_messages_sent();
+    }
+
+    uint64_t peer_connection::get_total_messages_received() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _message_connection.get_total_messages_received();
+    }
+
     fc::time_point peer_connection::get_last_message_sent_time() const
     {
       VERIFY_CORRECT_THREAD();
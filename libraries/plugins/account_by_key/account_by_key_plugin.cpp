@@ -289,8 +289,15 @@ void account_by_key_plugin::plugin_initialize( const boost::program_options::var
     ilog( "Initializing account_by_key plugin" );
     chain::database& db = get_app().get_plugin< hive::plugins::chain::chain_plugin >().db();
 
-    my->_pre_apply_operation_conn = db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->on_pre_apply_operation( note ); }, *this, 0 );
-    my->_post_apply_operation_conn = db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->on_post_apply_operation( note ); }, *this, 0 );
+    // only operations handled by pre_operation_visitor/post_operation_visitor
+    const auto key_operations = chain::database::make_operation_type_set< account_create_operation, account_create_with_delegation_operation,
+      account_update_operation, account_update2_operation, create_claimed_account_operation, recover_account_operation,
+      pow_operation, pow2_operation >();
+    auto post_operations = key_operations;
+    post_operations.push_back( operation::tag< hardfork_operation >::value );
+
+    my->_pre_apply_operation_conn = db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->on_pre_apply_operation( note ); }, key_operations, *this, 0 );
+    my->_post_apply_operation_conn = db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->on_post_apply_operation( note ); }, post_operations, *this, 0 );
 
     HIVE_ADD_PLUGIN_INDEX(db, key_lookup_index);
 
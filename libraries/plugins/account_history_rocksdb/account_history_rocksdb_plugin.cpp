@@ -15,6 +15,7 @@
 #include <hive/plugins/chain/state_snapshot_provider.hpp>
 
 #include <hive/utilities/benchmark_dumper.hpp>
+#include <hive/utilities/performance_metrics.hpp>
 
 #include <appbase/application.hpp>
 
@@ -52,7 +53,8 @@ enum Columns
   OPERATION_BY_BLOCK,
   AH_INFO_BY_NAME,
   AH_OPERATION_BY_ID,
-  BY_TRANSACTION_ID
+  BY_TRANSACTION_ID,
+  AH_OPERATION_BY_TYPE
 };
 
 #define WRITE_BUFFER_FLUSH_LIMIT     10
@@ -65,7 +67,13 @@ enum Columns
 #define MAX_OPERATION_ID             std::numeric_limits<int64_t>::max()
 
 #define STORE_MAJOR_VERSION          1
-#define STORE_MINOR_VERSION          1
+#define STORE_MINOR_VERSION          2
+
+/** Max number of account history entries visited by single call of find_account_history_data with operation type filter.
+  *  Entries rejected by the filter are cheap (no operation is loaded), but searching for rare operation in long history
+  *  still has to end somewhere.
+  */
+#define MAX_FILTERED_ENTRIES_SCANNED 1000000
 
 namespace hive { namespace plugins { namespace account_history_rocksdb {
 
@@ -315,6 +323,59 @@ typedef PrimitiveTypeSlice< uint32_t > by_block_slice_t;
 typedef PrimitiveTypeSlice< account_name_type::Storage > ah_info_by_name_slice_t;
 typedef PrimitiveTypeSlice< ah_op_id_pair > ah_op_by_id_slice_t;
 
+/** Value of AH_OPERATION_BY_ID column: id of pointed operation and (since store version 1.2) its type, so account history
+  *  can be filtered by operation type without loading operations. Type is packed into the same 8 bytes as the id:
+  *  top bit marks presence of type, next 7 bits hold the type and remaining 56 bits - operation id. Entries written by
+  *  older versions (top bit clear) hold just the id and are treated as of unknown type.
+  */
+class ah_operation_entry final
+{
+public:
+  ah_operation_entry(int64_t op_id, uint32_t op_type)
+  {
+    if(op_type <= MAX_OP_TYPE && (static_cast<uint64_t>(op_id) & ~OP_ID_MASK) == 0)
+      _value = HAS_TYPE_FLAG | (static_cast<uint64_t>(op_type) << OP_TYPE_SHIFT) | static_cast<uint64_t>(op_id);
+    else
+      _value = static_cast<uint64_t>(op_id);
+  }
+
+  int64_t get_op_id() const
+  {
+    return has_op_type() ? static_cast<int64_t>(_value & OP_ID_MASK) : static_cast<int64_t>(_value);
+  }
+
+  bool has_op_type() const { return (_value & HAS_TYPE_FLAG) != 0; }
+  uint32_t get_op_type() const { return static_cast<uint32_t>((_value & ~HAS_TYPE_FLAG) >> OP_TYPE_SHIFT); }
+
+private:
+  static constexpr uint32_t OP_TYPE_SHIFT = 56;
+  static constexpr uint32_t MAX_OP_TYPE = 0x7F;
+  static constexpr uint64_t HAS_TYPE_FLAG = 1ull << 63;
+  static constexpr uint64_t OP_ID_MASK = (1ull << OP_TYPE_SHIFT) - 1;
+
+  uint64_t _value = 0;
+};
+
+static_assert(sizeof(ah_operation_entry) == sizeof(int64_t), "AH entry must keep size of operation id");
+
+typedef PrimitiveTypeSlice< ah_operation_entry > ah_operation_entry_slice_t;
+
+/** Key of optional AH_OPERATION_BY_TYPE index: account_history_info::id, operation type and sequence number of the entry
+  *  in account history (the same as in AH_OPERATION_BY_ID). Value is operation id.
+  */
+typedef std::pair< int64_t, std::pair< uint32_t, uint32_t > > ah_op_type_seq_key;
+typedef PrimitiveTypeComparatorImpl< ah_op_type_seq_key > ah_op_by_type_ComparatorImpl;
+typedef PrimitiveTypeSlice< ah_op_type_seq_key > ah_op_by_type_slice_t;
+
+/// Extracts operation type (static_variant tag) from serialized operation without unpacking whole operation.
+uint32_t get_serialized_op_type(const serialize_buffer_t& serialized_op)
+{
+  fc::unsigned_int which;
+  fc::datastream<const char*> ds(serialized_op.data(), serialized_op.size());
+  fc::raw::unpack(ds, which);
+  return which.value;
+}
+
 
 class TransactionIdComparator final : public AComparator
   {
@@ -358,6 +419,12 @@ const Comparator* ah_op_by_id_Comparator()
   return &c;
 }
 
+const Comparator* ah_op_by_type_Comparator()
+{
+  static ah_op_by_type_ComparatorImpl c;
+  return &c;
+}
+
 const Comparator* by_txId_Comparator()
   {
   static TransactionIdComparator c;
@@ -513,10 +580,23 @@ public:
     _cached_reindex_point = 0;
 
     HIVE_ADD_PLUGIN_INDEX(_mainDb, volatile_operation_index);
+    HIVE_ADD_PLUGIN_INDEX(_mainDb, volatile_account_operation_index);
+
+    auto& metrics = hive::utilities::performance_metrics::instance();
+    metrics.describe_family( "rocksdb_estimated_keys", "Estimated number of keys in account history storage, by column" );
+    metrics.describe_family( "rocksdb_sst_files_bytes", "Size of SST files of account history storage, by column" );
+    metrics.describe_family( "rocksdb_memtable_bytes", "Size of memtables of account history storage, by column" );
+    metrics.describe_family( "rocksdb_pending_compaction_bytes", "Estimated bytes to be rewritten by compaction of account history storage, by column" );
+    _storageMetricsCollector = metrics.add_collector(
+      [this]( std::vector< hive::utilities::performance_metrics::collected_value >& values )
+      {
+        collectStorageMetrics( values );
+      } );
     }
 
   ~impl()
   {
+    hive::utilities::performance_metrics::instance().remove_collector( _storageMetricsCollector );
 
     chain::util::disconnect_signal(_on_pre_apply_operation_con);
     chain::util::disconnect_signal(_on_irreversible_block_conn);
@@ -548,6 +628,8 @@ public:
     options.max_open_files = OPEN_FILE_LIMIT;
 
     DBOptions dbOptions(options);
+    /// Columns added by newer versions of the plugin (AH_OPERATION_BY_TYPE) are created in existing stores.
+    dbOptions.create_missing_column_families = true;
 
     auto status = DB::Open(dbOptions, strPath, columnDefs, &_columnHandles, &storageDb);
 
@@ -555,8 +637,12 @@ public:
     {
       ilog("RocksDB opened successfully storage at location: `${p}'.", ("p", strPath));
       verifyStoreVersion(storageDb);
+      verifyOpTypeIndex(storageDb);
       loadSeqIdentifiers(storageDb);
-      _storage.reset(storageDb);
+      {
+        std::lock_guard<std::mutex> guard(_storageMetricsMutex);
+        _storage.reset(storageDb);
+      }
 
       // I do not like using exceptions for control paths, but column definitions are set multiple times
       // opening the db, so that is not a good place to write the initial lib.
@@ -590,9 +676,14 @@ public:
   void on_post_reindex( const hive::chain::reindex_notification& note );
 
   void find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit, bool include_reversible,
-    std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const;
+    std::function<bool(unsigned int, const rocksdb_operation_object&)> processor, std::function<bool(uint32_t)> op_type_filter) const;
+  void find_account_history_data_of_type(const account_name_type& name, uint32_t op_type, uint64_t start, uint32_t limit,
+    bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const;
   uint32_t find_reversible_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit, uint32_t number_of_irreversible_ops,
     std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const;
+  /// Loads given operations with single MultiGet and passes them to `processor` until it accepts `limit` of them (returns number accepted).
+  uint32_t process_operation_batch(const std::vector<unsigned int>& sequences, const std::vector<int64_t>& opIds, uint32_t limit,
+    const std::function<bool(unsigned int, const rocksdb_operation_object&)>& processor) const;
   bool find_operation_object(size_t opId, rocksdb_operation_object* op) const;
   /// Allows to look for all operations present in given block and call `processor` for them.
   void find_operations_by_block(size_t blockNum, bool include_reversible,
@@ -606,14 +697,57 @@ public:
   bool find_transaction_info(const protocol::transaction_id_type& trxId, bool include_reversible, uint32_t* blockNo,
     uint32_t* txInBlock) const;
 
+  void setPrune(bool prune) { _prune = prune; }
+  void setMaxFilteredEntriesScanned(uint32_t limit) { _maxFilteredEntriesScanned = limit; }
+
+  /// Rewrites store into format of version 1.1 (entries without operation type, no index by operation type) and reopens it.
+  void downgradeStoreAndReopen()
+  {
+    FC_ASSERT(_storage, "Account history store is not open");
+    FC_ASSERT(_columnHandles.size() == Columns::AH_OPERATION_BY_TYPE + 1);
+    flushStorage();
+
+    WriteBatch batch;
+    std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(ReadOptions(), _columnHandles[Columns::AH_OPERATION_BY_ID]));
+    for(it->SeekToFirst(); it->Valid(); it->Next())
+    {
+      id_slice_t valueSlice(ah_operation_entry_slice_t::unpackSlice(it->value()).get_op_id());
+      auto s = batch.Put(_columnHandles[Columns::AH_OPERATION_BY_ID], it->key(), valueSlice);
+      checkStatus(s);
+    }
+    checkStatus(it->status());
+    it.reset();
+
+    PrimitiveTypeSlice<uint32_t> minorVSlice(1);
+    auto s = batch.Put(Slice("STORE_MINOR_VERSION"), minorVSlice);
+    checkStatus(s);
+    s = batch.Delete(Slice("OP_TYPE_INDEX"));
+    checkStatus(s);
+    s = _storage->Write(::rocksdb::WriteOptions(), &batch);
+    checkStatus(s);
+
+    /// AH_OPERATION_BY_TYPE is the last column - stores of version 1.1 don't have it
+    s = _storage->DropColumnFamily(_columnHandles.back());
+    checkStatus(s);
+    s = _storage->DestroyColumnFamilyHandle(_columnHandles.back());
+    checkStatus(s);
+    _columnHandles.pop_back();
+
+    shutdownDb();
+    openDb(false);
+  }
+
   void shutdownDb( bool removeDB = false )
   {
     if(_storage)
     {
       flushStorage();
-      cleanupColumnHandles();
-      _storage->Close();
-      _storage.reset();
+      {
+        std::lock_guard<std::mutex> guard(_storageMetricsMutex);
+        cleanupColumnHandles();
+        _storage->Close();
+        _storage.reset();
+      }
 
       if( removeDB )
       {
@@ -625,6 +759,32 @@ public:
   }
 
 private:
+  /// performance_metrics collector: RocksDB properties of each column (called from thread that exports metrics)
+  void collectStorageMetrics( std::vector< hive::utilities::performance_metrics::collected_value >& values ) const
+  {
+    static const std::pair< const char*, const char* > properties[] =
+    {
+      { "rocksdb_estimated_keys", "rocksdb.estimate-num-keys" },
+      { "rocksdb_sst_files_bytes", "rocksdb.total-sst-files-size" },
+      { "rocksdb_memtable_bytes", "rocksdb.cur-size-all-mem-tables" },
+      { "rocksdb_pending_compaction_bytes", "rocksdb.estimate-pending-compaction-bytes" }
+    };
+
+    std::lock_guard<std::mutex> guard(_storageMetricsMutex);
+    if(!_storage)
+      return;
+
+    for(auto* h : _columnHandles)
+    {
+      for(const auto& property : properties)
+      {
+        uint64_t value = 0;
+        if(_storage->GetIntProperty(h, property.second, &value))
+          values.push_back( { { property.first, h->GetName() }, false, static_cast<int64_t>(value) } );
+      }
+    }
+  }
+
   void supplement_snapshot(const hive::chain::prepare_snapshot_supplement_notification& note);
   void load_additional_data_from_snapshot(const hive::chain::load_snapshot_supplement_notification& note);
 
@@ -753,7 +913,53 @@ private:
     checkStatus(s);
     const auto minor = PrimitiveTypeSlice<uint32_t>::unpackSlice(buffer);
 
-    FC_ASSERT(minor == STORE_MINOR_VERSION, "Store minor version mismatch");
+    FC_ASSERT(minor <= STORE_MINOR_VERSION, "Store minor version mismatch");
+
+    if(minor < STORE_MINOR_VERSION)
+    {
+      /** Older store can be extended in place (AH entries written so far just don't carry operation type).
+        *  Version is updated right away, so previous versions of plugin won't open the store containing new entries.
+        */
+      ilog("Upgrading account history store version from ${ma}.${mi} to ${ma}.${n}",
+        ("ma", major)("mi", minor)("n", STORE_MINOR_VERSION));
+      PrimitiveTypeSlice<uint32_t> minorVSlice(STORE_MINOR_VERSION);
+      s = storageDb->Put(::rocksdb::WriteOptions(), Slice("STORE_MINOR_VERSION"), minorVSlice);
+      checkStatus(s);
+    }
+  }
+
+  /** Index by operation type is usable only when it has been maintained since the store was created, which is marked
+    *  in the store at creation time. Otherwise it can't be used until the store is rebuilt (replay).
+    */
+  void verifyOpTypeIndex(DB* storageDb)
+  {
+    std::string buffer;
+    auto s = storageDb->Get(ReadOptions(), "OP_TYPE_INDEX", &buffer);
+    const bool present = s.IsNotFound() == false;
+    if(present)
+      checkStatus(s);
+
+    _opTypeIndex = present && _opTypeIndexRequested;
+
+    if(_opTypeIndexRequested && !present)
+    {
+      wlog("Account history store was created without index by operation type - index will be built after replay with --force-replay");
+    }
+    else if(present && !_opTypeIndexRequested)
+    {
+      /// Index would become stale - drop it, so it is not used if the option is turned on again.
+      ilog("Index by operation type is no longer maintained - removing it from account history store");
+      s = storageDb->Delete(::rocksdb::WriteOptions(), Slice("OP_TYPE_INDEX"));
+      checkStatus(s);
+      ah_op_by_type_slice_t beginSlice(ah_op_type_seq_key(0, {0, 0}));
+      ah_op_by_type_slice_t endSlice(ah_op_type_seq_key(std::numeric_limits<int64_t>::max(), {0, 0}));
+      s = storageDb->DeleteRange(::rocksdb::WriteOptions(), _columnHandles[Columns::AH_OPERATION_BY_TYPE], beginSlice, endSlice);
+      checkStatus(s);
+    }
+    else if(_opTypeIndex)
+    {
+      ilog("Account history index by operation type is enabled");
+    }
   }
 
   void storeSequenceIds()
@@ -845,6 +1051,9 @@ private:
   std::vector<rocksdb_operation_object> collectReversibleOps(uint32_t* blockRangeBegin, uint32_t* blockRangeEnd,
     uint32_t* collectedIrreversibleBlock) const;
 
+  /// Returns reversible operations impacting given account (in order of blocks), using volatile_account_operation_index.
+  std::vector<rocksdb_operation_object> collectReversibleAccountOps(const account_name_type& name) const;
+
 /// Class attributes:
 private:
   account_history_rocksdb_plugin&  _self;
@@ -854,6 +1063,9 @@ private:
   std::unique_ptr<DB>              _storage;
   std::vector<ColumnFamilyHandle*> _columnHandles;
   CachableWriteBatch               _writeBuffer;
+  /// guards replacing of _storage against collectStorageMetrics (other readers run only while storage is open)
+  mutable std::mutex               _storageMetricsMutex;
+  hive::utilities::performance_metrics::collector_id _storageMetricsCollector = 0;
 
   boost::signals2::connection      _on_pre_apply_operation_con;
   boost::signals2::connection      _on_irreversible_block_conn;
@@ -902,6 +1114,12 @@ private:
   bool                             _reindexing = false;
 
   bool                             _prune = false;
+  uint32_t                         _maxFilteredEntriesScanned = MAX_FILTERED_ENTRIES_SCANNED;
+
+  /// `account-history-rocksdb-index-by-operation-type` was set
+  bool                             _opTypeIndexRequested = false;
+  /// AH_OPERATION_BY_TYPE is complete and maintained
+  bool                             _opTypeIndex = false;
 
   struct saved_balances
   {
@@ -963,6 +1181,9 @@ void account_history_rocksdb_plugin::impl::collectOptions(const boost::program_o
   if(_blacklisted_op_list.empty() == false)
     ilog( "Account History: blacklisting ops ${o}", ("o", _blacklisted_op_list) );
 
+  if(options.count("account-history-rocksdb-index-by-operation-type"))
+    _opTypeIndexRequested = options.at("account-history-rocksdb-index-by-operation-type").as<bool>();
+
   if (options.count("account-history-rocksdb-dump-balance-history"))
   {
     _balance_csv_filename = options.at("account-history-rocksdb-dump-balance-history").as<std::string>();
@@ -1097,8 +1318,39 @@ account_history_rocksdb_plugin::impl::collectReversibleOps(uint32_t* blockRangeB
   });
 }
 
+std::vector<rocksdb_operation_object>
+account_history_rocksdb_plugin::impl::collectReversibleAccountOps(const account_name_type& name) const
+{
+  return _mainDb.with_read_lock([this, &name]() -> std::vector<rocksdb_operation_object>
+  {
+    uint32_t rangeBegin = _cached_irreversible_block;
+    if( BOOST_UNLIKELY( rangeBegin == 0) )
+      rangeBegin = 1;
+    const uint32_t rangeEnd = _mainDb.head_block_num() + 1;
+
+    std::vector<rocksdb_operation_object> retVal;
+
+    const auto& accountIdx = _mainDb.get_index< volatile_account_operation_index, by_account_block >();
+    auto itr = accountIdx.lower_bound(boost::make_tuple(name, rangeBegin));
+    for(; itr != accountIdx.end() && itr->account == name && itr->block < rangeEnd; ++itr)
+    {
+      const auto& operation = _mainDb.get< volatile_operation_object >(itr->operation);
+
+      uint64_t opId = operation.op_in_trx;
+      opId |= static_cast<uint64_t>(operation.trx_in_block) << 32;
+
+      rocksdb_operation_object persistentOp(operation);
+      persistentOp.id = opId;
+      retVal.emplace_back(std::move(persistentOp));
+    }
+
+    return retVal;
+  });
+}
+
 void account_history_rocksdb_plugin::impl::find_account_history_data(const account_name_type& name, uint64_t start,
-  uint32_t limit, bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const
+  uint32_t limit, bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor,
+  std::function<bool(uint32_t)> op_type_filter) const
 {
   if(limit == 0)
     return;
@@ -1151,6 +1403,20 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
   if(include_reversible)
     count += find_reversible_account_history_data(name, start, limit, number_of_irreversible_ops, processor);
 
+  /** Entries are collected first and pointed operations are loaded in batches with single MultiGet call. Batch never
+    *  exceeds number of operations still missing, so when processor accepts everything, no operation is loaded in vain.
+    *  Entries of types rejected by `op_type_filter` are skipped without loading operation at all.
+    */
+  std::vector<unsigned int> pendingSequences;
+  std::vector<int64_t> pendingOpIds;
+  auto processPending = [&]()
+  {
+    count += process_operation_batch(pendingSequences, pendingOpIds, limit - count, processor);
+    pendingSequences.clear();
+    pendingOpIds.clear();
+  };
+
+  uint32_t scannedEntries = 0;
   for(; it->Valid() && count<limit; it->Prev())
   {
     auto keySlice = it->key();
@@ -1160,18 +1426,127 @@ void account_history_rocksdb_plugin::impl::find_account_history_data(const accou
     keyValue = ah_op_by_id_slice_t::unpackSlice(keySlice);
 
     auto valueSlice = it->value();
-    const auto& opId = id_slice_t::unpackSlice(valueSlice);
-    rocksdb_operation_object oObj;
-    bool found = find_operation_object(opId, &oObj);
-    FC_ASSERT(found, "Missing operation?");
+    const auto& entry = ah_operation_entry_slice_t::unpackSlice(valueSlice);
 
-    if(processor(keyValue.second, oObj))
+    if(op_type_filter)
     {
-      ++count;
-      if(count >= limit)
+      if(++scannedEntries > _maxFilteredEntriesScanned)
+      {
+        processPending();
+        FC_ASSERT(count >= limit, "Could not find filtered operation in ${n} account history entries, to continue searching, set start=${sequence}.",
+          ("n", _maxFilteredEntriesScanned)("sequence", keyValue.second));
         break;
+      }
+      if(entry.has_op_type() && op_type_filter(entry.get_op_type()) == false)
+        continue;
+    }
+
+    pendingSequences.push_back(keyValue.second);
+    pendingOpIds.push_back(entry.get_op_id());
+    if(pendingOpIds.size() >= limit - count)
+      processPending();
+  }
+
+  processPending();
+}
+
+void account_history_rocksdb_plugin::impl::find_account_history_data_of_type(const account_name_type& name, uint32_t op_type,
+  uint64_t start, uint32_t limit, bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const
+{
+  if(_opTypeIndex == false)
+  {
+    find_account_history_data(name, start, limit, include_reversible, processor,
+      [op_type](uint32_t type) -> bool { return type == op_type; });
+    return;
+  }
+
+  if(limit == 0)
+    return;
+
+  unsigned int count = 0;
+
+  ReadOptions rOptions;
+
+  ah_info_by_name_slice_t nameSlice(name.data);
+  PinnableSlice buffer;
+  auto s = _storage->Get(rOptions, _columnHandles[Columns::AH_INFO_BY_NAME], nameSlice, &buffer);
+
+  if(s.IsNotFound())
+  {
+    if(include_reversible)
+      find_reversible_account_history_data(name, start, limit, 0, processor);
+    return;
+  }
+
+  checkStatus(s);
+
+  account_history_info ahInfo;
+  load(ahInfo, buffer.data(), buffer.size());
+
+  /// Numbering of reversible operations continues after last irreversible entry not newer than `start`, same as in find_account_history_data.
+  const bool hasIrreversibleEntries = start >= ahInfo.oldestEntryId;
+  const uint32_t lastEntryId = hasIrreversibleEntries ? std::min<uint64_t>(start, ahInfo.newestEntryId) : 0;
+  if(include_reversible)
+    count += find_reversible_account_history_data(name, start, limit, hasIrreversibleEntries ? lastEntryId + 1 : 0, processor);
+
+  if(hasIrreversibleEntries == false || count >= limit)
+    return;
+
+  ah_op_by_type_slice_t lowerBoundSlice(ah_op_type_seq_key(ahInfo.id, {op_type, ahInfo.oldestEntryId}));
+  ah_op_by_type_slice_t upperBoundSlice(ah_op_type_seq_key(ahInfo.id, {op_type, lastEntryId + 1}));
+
+  rOptions.iterate_lower_bound = &lowerBoundSlice;
+  rOptions.iterate_upper_bound = &upperBoundSlice;
+
+  std::unique_ptr<::rocksdb::Iterator> it(_storage->NewIterator(rOptions, _columnHandles[Columns::AH_OPERATION_BY_TYPE]));
+
+  /// Every entry in range has requested type, so operations are loaded in batches of exactly as many as still needed.
+  std::vector<unsigned int> sequences;
+  std::vector<int64_t> opIds;
+  for(it->SeekToLast(); it->Valid() && count < limit; it->Prev())
+  {
+    const auto& key = ah_op_by_type_slice_t::unpackSlice(it->key());
+    sequences.push_back(key.second.second);
+    opIds.push_back(id_slice_t::unpackSlice(it->value()));
+
+    if(opIds.size() >= limit - count)
+    {
+      count += process_operation_batch(sequences, opIds, limit - count, processor);
+      sequences.clear();
+      opIds.clear();
     }
   }
+
+  process_operation_batch(sequences, opIds, limit - count, processor);
+}
+
+uint32_t account_history_rocksdb_plugin::impl::process_operation_batch(const std::vector<unsigned int>& sequences,
+  const std::vector<int64_t>& opIds, uint32_t limit,
+  const std::function<bool(unsigned int, const rocksdb_operation_object&)>& processor) const
+{
+  if(opIds.empty() || limit == 0)
+    return 0;
+
+  std::vector<Slice> keys;
+  keys.reserve(opIds.size());
+  for(const auto& opId : opIds)
+    keys.emplace_back(reinterpret_cast<const char*>(&opId), sizeof(opId));
+  std::vector<ColumnFamilyHandle*> columns(keys.size(), _columnHandles[Columns::OPERATION_BY_ID]);
+  std::vector<std::string> values;
+  const auto statuses = _storage->MultiGet(ReadOptions(), columns, keys, &values);
+
+  uint32_t count = 0;
+  for(size_t i = 0; i < opIds.size() && count < limit; ++i)
+  {
+    FC_ASSERT(statuses[i].IsNotFound() == false, "Missing operation?");
+    checkStatus(statuses[i]);
+
+    rocksdb_operation_object oObj;
+    load(oObj, values[i].data(), values[i].size());
+    if(processor(sequences[i], oObj))
+      ++count;
+  }
+  return count;
 }
 
 uint32_t account_history_rocksdb_plugin::impl::find_reversible_account_history_data(const account_name_type& name, uint64_t start,
@@ -1183,23 +1558,7 @@ uint32_t account_history_rocksdb_plugin::impl::find_reversible_account_history_d
   // this is legit call
   if(number_of_irreversible_ops <= start)
   {
-    uint32_t collectedIrreversibleBlock = 0;
-    uint32_t rangeBegin = _cached_irreversible_block;
-    if( BOOST_UNLIKELY( rangeBegin == 0) )
-      rangeBegin = 1;
-    uint32_t rangeEnd = _mainDb.head_block_num() + 1;
-
-    const auto reversibleOps = collectReversibleOps(&rangeBegin, &rangeEnd, &collectedIrreversibleBlock);
-
-    std::vector<rocksdb_operation_object> ops_for_this_account;
-    ops_for_this_account.reserve(reversibleOps.size());
-    for(const auto& obj : reversibleOps)
-    {
-      hive::protocol::operation op = fc::raw::unpack_from_buffer< hive::protocol::operation >( obj.serialized_op );
-      auto impacted = getImpactedAccounts( op );
-      if( std::find( impacted.begin(), impacted.end(), name) != impacted.end() )
-        ops_for_this_account.push_back(obj);
-    };
+    const auto ops_for_this_account = collectReversibleAccountOps(name);
 
     // There's always at least one operation for each account: account_create_operation
     FC_ASSERT(number_of_irreversible_ops + ops_for_this_account.size() > 0);
@@ -1639,6 +1998,11 @@ account_history_rocksdb_plugin::impl::ColumnDefinitions account_history_rocksdb_
   auto& byTxIdColumn = columnDefs.back();
   byTxIdColumn.options.comparator = by_txId_Comparator();
 
+  /// Always defined, but filled only when `account-history-rocksdb-index-by-operation-type` is set (see verifyOpTypeIndex).
+  columnDefs.emplace_back("ah_operation_by_type", ColumnFamilyOptions());
+  auto& byAHTypeColumn = columnDefs.back();
+  byAHTypeColumn.options.comparator = ah_op_by_type_Comparator();
+
   return columnDefs;
 }
 
@@ -1647,6 +2011,9 @@ std::tuple<bool, bool> account_history_rocksdb_plugin::impl::createDbSchema(cons
   DB* db = nullptr;
 
   auto columnDefs = prepareColumnDefinitions(true);
+  /// Stores created before AH_OPERATION_BY_TYPE was introduced don't have that column yet - read-only open accepts
+  /// subset of columns and the missing one is created by openDb.
+  columnDefs.pop_back();
   auto strPath = path.string();
   Options options;
   /// Optimize RocksDB. This is the easiest way to get RocksDB to perform well
@@ -1674,6 +2041,12 @@ std::tuple<bool, bool> account_history_rocksdb_plugin::impl::createDbSchema(cons
     {
       ilog("RocksDB column definitions created successfully.");
       saveStoreVersion();
+      if(_opTypeIndexRequested)
+      {
+        PrimitiveTypeSlice<uint32_t> markerSlice(1);
+        auto ms = _writeBuffer.Put(Slice("OP_TYPE_INDEX"), markerSlice);
+        checkStatus(ms);
+      }
       /// Store initial values of Seq-IDs for held objects.
       flushWriteBuffer(db);
       cleanupColumnHandles(db);
@@ -1702,6 +2075,8 @@ std::tuple<bool, bool> account_history_rocksdb_plugin::impl::createDbSchema(cons
 void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const account_name_type& name, const rocksdb_operation_object& obj )
 {
   std::string strName = name;
+  const uint32_t opType = get_serialized_op_type(obj.serialized_op);
+  uint32_t entryId = 0;
 
   ReadOptions rOptions;
   //rOptions.tailing = true;
@@ -1724,8 +2099,9 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
     auto nextEntryId = ++ahInfo.newestEntryId;
     _writeBuffer.putAHInfo(name, ahInfo);
 
+    entryId = nextEntryId;
     ah_op_by_id_slice_t ahInfoOpSlice(std::make_pair(ahInfo.id, nextEntryId));
-    id_slice_t valueSlice(obj.id);
+    ah_operation_entry_slice_t valueSlice(ah_operation_entry(obj.id, opType));
     auto s = _writeBuffer.Put(_columnHandles[Columns::AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
     checkStatus(s);
   }
@@ -1739,10 +2115,18 @@ void account_history_rocksdb_plugin::impl::buildAccountHistoryRecord( const acco
     _writeBuffer.putAHInfo(name, ahInfo);
 
     ah_op_by_id_slice_t ahInfoOpSlice(std::make_pair(ahInfo.id, 0));
-    id_slice_t valueSlice(obj.id);
+    ah_operation_entry_slice_t valueSlice(ah_operation_entry(obj.id, opType));
     auto s = _writeBuffer.Put(_columnHandles[Columns::AH_OPERATION_BY_ID], ahInfoOpSlice, valueSlice);
     checkStatus(s);
   }
+
+  if(_opTypeIndex)
+  {
+    ah_op_by_type_slice_t typeKeySlice(ah_op_type_seq_key(ahInfo.id, {opType, entryId}));
+    id_slice_t valueSlice(obj.id);
+    auto s = _writeBuffer.Put(_columnHandles[Columns::AH_OPERATION_BY_TYPE], typeKeySlice, valueSlice);
+    checkStatus(s);
+  }
 }
 
 void account_history_rocksdb_plugin::impl::storeTransactionInfo(const chain::transaction_id_type& trx_id, uint32_t blockNo, uint32_t trx_in_block)
@@ -1800,7 +2184,7 @@ void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_h
 
     auto value = dataItr->value();
 
-    auto pointedOpId = id_slice_t::unpackSlice(value);
+    auto pointedOpId = ah_operation_entry_slice_t::unpackSlice(value).get_op_id();
     rocksdb_operation_object op;
     find_operation_object(pointedOpId, &op);
 
@@ -1813,6 +2197,13 @@ void account_history_rocksdb_plugin::impl::prunePotentiallyTooOldItems(account_h
         std::make_pair(ahInfo->id, rightBoundary));
       s = _writeBuffer.SingleDelete(_columnHandles[4], rightBoundarySlice);
       checkStatus(s);
+
+      if(_opTypeIndex)
+      {
+        ah_op_by_type_slice_t typeKeySlice(ah_op_type_seq_key(ahInfo->id, {get_serialized_op_type(op.serialized_op), rightBoundary}));
+        s = _writeBuffer.SingleDelete(_columnHandles[Columns::AH_OPERATION_BY_TYPE], typeKeySlice);
+        checkStatus(s);
+      }
     }
     else
     {
@@ -1962,7 +2353,7 @@ void account_history_rocksdb_plugin::impl::on_pre_apply_operation(const operatio
   else
   {
     auto txs = _mainDb.get_tx_status();
-    _mainDb.create< volatile_operation_object >( [&]( volatile_operation_object& o )
+    const auto& volatileOp = _mainDb.create< volatile_operation_object >( [&]( volatile_operation_object& o )
     {
       o.trx_id = n.trx_id;
       o.block = n.block;
@@ -1981,6 +2372,16 @@ void account_history_rocksdb_plugin::impl::on_pre_apply_operation(const operatio
         o.transaction_status = txs;
     });
 
+    for( const auto& name : impacted )
+    {
+      _mainDb.create< volatile_account_operation_object >( [&]( volatile_account_operation_object& o )
+      {
+        o.account = name;
+        o.block = volatileOp.block;
+        o.operation = volatileOp.get_id();
+      });
+    }
+
     //dlog("Adding operation: id ${id}, block: ${b}, tx_status: ${txs}, body: ${body}", ("id", newOp.get_id())("b", n.block)
     //  ("txs", to_string(txs))("body", fc::json::to_string(n.op)));
   }
@@ -2043,6 +2444,16 @@ void account_history_rocksdb_plugin::impl::on_irreversible_block( uint32_t block
     }
   );
 
+  /// Links to operations moved above are removed as well (the ones skipped above stay with their operations).
+  auto& volatileAccountOpsGenericIndex = _mainDb.get_mutable_index<volatile_account_operation_index>();
+  const auto& volatile_account_idx = _mainDb.get_index< volatile_account_operation_index, by_block >();
+  volatileAccountOpsGenericIndex.move_to_external_storage<by_block>(volatile_account_idx.begin(), volatile_account_idx.upper_bound(block_num),
+    [this](const volatile_account_operation_object& link) -> bool
+    {
+      return _mainDb.find< volatile_operation_object >(link.operation) == nullptr;
+    }
+  );
+
   update_lib(block_num);
   //flushStorage(); it is apparently needed to properly write LIB so it can be read later, however it kills performance - alternative solution used currently just masks problem
 }
@@ -2177,6 +2588,8 @@ void account_history_rocksdb_plugin::set_program_options(
     ("account-history-rocksdb-track-account-range", boost::program_options::value< std::vector<std::string> >()->composing()->multitoken(), "Defines a range of accounts to track as a json pair [\"from\",\"to\"] [from,to] Can be specified multiple times.")
     ("account-history-rocksdb-whitelist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly logged.")
     ("account-history-rocksdb-blacklist-ops", boost::program_options::value< std::vector<std::string> >()->composing(), "Defines a list of operations which will be explicitly ignored.")
+    ("account-history-rocksdb-index-by-operation-type", bpo::value<bool>()->default_value(false),
+      "Maintains additional index of account history by operation type, so queries for single type of operations don't scan whole history of the account. Built during replay.")
 
   ;
   command_line_options.add_options()
@@ -2219,10 +2632,32 @@ void account_history_rocksdb_plugin::plugin_shutdown()
   _my->shutdownDb(_destroyOnShutdown);
 }
 
+void account_history_rocksdb_plugin::set_prune_old_entries(bool set)
+{
+  _my->setPrune(set);
+}
+
+void account_history_rocksdb_plugin::set_max_filtered_entries_scanned(uint32_t limit)
+{
+  _my->setMaxFilteredEntriesScanned(limit);
+}
+
+void account_history_rocksdb_plugin::downgrade_store_and_reopen()
+{
+  _my->downgradeStoreAndReopen();
+}
+
 void account_history_rocksdb_plugin::find_account_history_data(const account_name_type& name, uint64_t start, uint32_t limit,
-  bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const
+  bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor,
+  std::function<bool(uint32_t)> op_type_filter) const
+{
+  _my->find_account_history_data(name, start, limit, include_reversible, processor, op_type_filter);
+}
+
+void account_history_rocksdb_plugin::find_account_history_data_of_type(const account_name_type& name, uint32_t op_type, uint64_t start,
+  uint32_t limit, bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const
 {
-  _my->find_account_history_data(name, start, limit, include_reversible, processor);
+  _my->find_account_history_data_of_type(name, op_type, start, limit, include_reversible, processor);
 }
 
 bool account_history_rocksdb_plugin::find_operation_object(size_t opId, rocksdb_operation_object* op) const
@@ -2255,3 +2690,4 @@ FC_REFLECT( hive::plugins::account_history_rocksdb::account_history_info,
   (id)(oldestEntryId)(newestEntryId)(oldestEntryTimestamp) )
 
 HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::plugins::account_history_rocksdb::volatile_operation_index)
+HIVE_DEFINE_TYPE_REGISTRAR_REGISTER_TYPE(hive::plugins::account_history_rocksdb::volatile_account_operation_index)
@@ -19,7 +19,8 @@ typedef std::vector<char> serialize_buffer_t;
 
 enum account_history_rocksdb_object_types
 {
-  volatile_operation_object_type = ( HIVE_ACCOUNT_HISTORY_ROCKSDB_SPACE_ID << 8 )
+  volatile_operation_object_type = ( HIVE_ACCOUNT_HISTORY_ROCKSDB_SPACE_ID << 8 ),
+  volatile_account_operation_object_type
 };
 
 class volatile_operation_object : public object< volatile_operation_object_type, volatile_operation_object >
@@ -42,6 +43,23 @@ class volatile_operation_object : public object< volatile_operation_object_type,
 
 typedef oid_ref< volatile_operation_object > volatile_operation_id_type;
 
+/** Links reversible (volatile) operation with each account impacted by it, so account history queries that include
+  *  reversible data find operations of given account directly, without deserializing all reversible operations.
+  *  Created together with volatile_operation_object, so it is undone with it on fork switch, and removed when pointed
+  *  operation is moved to persistent storage.
+  */
+class volatile_account_operation_object : public object< volatile_account_operation_object_type, volatile_account_operation_object >
+{
+  CHAINBASE_OBJECT( volatile_account_operation_object );
+
+  public:
+    CHAINBASE_DEFAULT_CONSTRUCTOR( volatile_account_operation_object )
+
+    account_name_type                        account;
+    uint32_t                                 block = 0;
+    volatile_operation_id_type               operation;
+};
+
 /** Dedicated definition is needed because of conflict of BIP allocator
   *  against usage of this class as temporary object.
   *  The conflict appears in original serialized_op container type definition,
@@ -74,6 +92,7 @@ class rocksdb_operation_object
 };
 
 struct by_block;
+struct by_account_block;
 
 typedef multi_index_container<
     volatile_operation_object,
@@ -90,9 +109,34 @@ typedef multi_index_container<
     allocator< volatile_operation_object >
   > volatile_operation_index;
 
+typedef multi_index_container<
+    volatile_account_operation_object,
+    indexed_by<
+      ordered_unique< tag< by_id >,
+        const_mem_fun< volatile_account_operation_object, volatile_account_operation_object::id_type, &volatile_account_operation_object::get_id > >,
+      ordered_unique< tag< by_account_block >,
+        composite_key< volatile_account_operation_object,
+          member< volatile_account_operation_object, account_name_type, &volatile_account_operation_object::account >,
+          member< volatile_account_operation_object, uint32_t, &volatile_account_operation_object::block >,
+          member< volatile_account_operation_object, volatile_operation_id_type, &volatile_account_operation_object::operation >
+        >
+      >,
+      ordered_unique< tag< by_block >,
+        composite_key< volatile_account_operation_object,
+          member< volatile_account_operation_object, uint32_t, &volatile_account_operation_object::block >,
+          const_mem_fun< volatile_account_operation_object, volatile_account_operation_object::id_type, &volatile_account_operation_object::get_id >
+        >
+      >
+    >,
+    allocator< volatile_account_operation_object >
+  > volatile_account_operation_index;
+
 } } } // hive::plugins::account_history_rocksdb
 
 FC_REFLECT( hive::plugins::account_history_rocksdb::volatile_operation_object, (id)(trx_id)(block)(trx_in_block)(op_in_trx)(is_virtual)(timestamp)(serialized_op)(impacted)(transaction_status) )
 CHAINBASE_SET_INDEX_TYPE( hive::plugins::account_history_rocksdb::volatile_operation_object, hive::plugins::account_history_rocksdb::volatile_operation_index )
 
+FC_REFLECT( hive::plugins::account_history_rocksdb::volatile_account_operation_object, (id)(account)(block)(operation) )
+CHAINBASE_SET_INDEX_TYPE( hive::plugins::account_history_rocksdb::volatile_account_operation_object, hive::plugins::account_history_rocksdb::volatile_account_operation_index )
+
 FC_REFLECT( hive::plugins::account_history_rocksdb::rocksdb_operation_object, (id)(trx_id)(block)(trx_in_block)(op_in_trx)(is_virtual)(timestamp)(serialized_op) )
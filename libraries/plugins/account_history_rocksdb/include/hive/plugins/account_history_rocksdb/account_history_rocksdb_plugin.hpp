@@ -38,8 +38,19 @@ public:
   virtual void plugin_startup() override;
   virtual void plugin_shutdown() override;
 
+  /** Calls `processor` for operations of given account, starting from sequence `start` backwards, until it accepts `limit` of them.
+    *  Optional `op_type_filter` is checked against type of operation (its `which()`) before the operation is loaded - rejected ones
+    *  are not passed to `processor` (entries written by older versions of the plugin and reversible operations are always passed).
+    */
   void find_account_history_data(const protocol::account_name_type& name, uint64_t start, uint32_t limit, bool include_reversible,
-    std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const;
+    std::function<bool(unsigned int, const rocksdb_operation_object&)> processor,
+    std::function<bool(uint32_t)> op_type_filter = std::function<bool(uint32_t)>()) const;
+  /** Like find_account_history_data, but passes only operations of given type. Uses index by operation type when it is
+    *  maintained (`account-history-rocksdb-index-by-operation-type`), so the cost depends on size of the result, not on
+    *  length of account history. Otherwise falls back to filtering during iteration.
+    */
+  void find_account_history_data_of_type(const protocol::account_name_type& name, uint32_t op_type, uint64_t start, uint32_t limit,
+    bool include_reversible, std::function<bool(unsigned int, const rocksdb_operation_object&)> processor) const;
   bool find_operation_object(size_t opId, rocksdb_operation_object* data) const;
   void find_operations_by_block(size_t blockNum, bool include_reversible,
     std::function<void(const rocksdb_operation_object&)> processor) const;
@@ -53,6 +64,14 @@ public:
   void set_destroy_database_on_startup( bool set = true ) { _destroyOnStartup = set; }
   // makes plugin remove database on shutdown - useful for tests where each test needs fresh database
   void set_destroy_database_on_shutdown( bool set = true ) { _destroyOnShutdown = set; }
+  // makes plugin prune entries older than 30 days from account history (leaving at least 30 newest ones) - there is no
+  // option for that, it is used in tests only
+  void set_prune_old_entries( bool set = true );
+  // changes limit of entries visited by filtered search of account history (1M by default) - useful for tests
+  void set_max_filtered_entries_scanned( uint32_t limit );
+  // rewrites store to format of version 1.1 (entries without operation type, no index by operation type) and reopens it,
+  // so tests can check how stores created by older versions are upgraded
+  void downgrade_store_and_reopen();
 
 private:
   class impl;
@@ -147,11 +147,30 @@ DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_account_history )
     uint64_t filter_low = args.operation_filter_low ? *args.operation_filter_low : 0;
     uint64_t filter_high = args.operation_filter_high ? *args.operation_filter_high : 0;
 
+    /// Operation types accepted by the filter - lets storage skip other operations without loading them.
+    std::vector<bool> accepted_types(hive::protocol::operation::count());
+    uint32_t accepted_type_count = 0;
+    uint32_t single_accepted_type = 0;
+    for(uint32_t type = 0; type < accepted_types.size(); ++type)
+    {
+      hive::protocol::operation op(static_cast<int64_t>(type));
+      operation_filtering_visitor accepting_visitor;
+      accepted_types[type] = accepting_visitor.check( filter_low, filter_high, op );
+      if( accepted_types[type] )
+      {
+        ++accepted_type_count;
+        single_accepted_type = type;
+      }
+    }
+    auto op_type_filter = [&accepted_types](uint32_t type) -> bool
+    {
+      return type >= accepted_types.size() || accepted_types[type];
+    };
+
     try
     {
 
-    _dataSource.find_account_history_data(args.account, args.start, args.limit, include_reversible,
-      [&result, filter_low, filter_high, &total_processed_items](unsigned int sequence, const account_history_rocksdb::rocksdb_operation_object& op) -> bool
+    auto processor = [&result, filter_low, filter_high, &total_processed_items](unsigned int sequence, const account_history_rocksdb::rocksdb_operation_object& op) -> bool
       {
         FC_ASSERT(total_processed_items < 2000, "Could not find filtered operation in ${total_processed_items} operations, to continue searching, set start=${sequence}.",("total_processed_items",total_processed_items)("sequence",sequence));
 
@@ -170,7 +189,12 @@ DEFINE_API_IMPL( account_history_api_rocksdb_impl, get_account_history )
         {
           return false;
         }
-      });
+      };
+
+    if( accepted_type_count == 1 )
+      _dataSource.find_account_history_data_of_type(args.account, single_accepted_type, args.start, args.limit, include_reversible, processor);
+    else
+      _dataSource.find_account_history_data(args.account, args.start, args.limit, include_reversible, processor, op_type_filter);
     }
     catch(const fc::exception& e)
     { //if we have some results but not all requested, return what we have
@@ -8,10 +8,17 @@
 
 namespace hive { namespace plugins { namespace block_api {
 
+namespace
+{
+  /// cached JSON of block is JSON of get_block result - block object within it is what get_block_range needs
+  const std::string get_block_json_prefix = "{\"block\":";
+  const std::string get_block_json_suffix = "}";
+}
+
 class block_api_impl
 {
   public:
-    block_api_impl( appbase::application& app );
+    block_api_impl( appbase::application& app, const std::shared_ptr< block_json_cache >& json_cache );
     ~block_api_impl();
 
     DECLARE_API_IMPL(
@@ -20,7 +27,13 @@ class block_api_impl
       (get_block_range)
     )
 
-    const hive::chain::block_read_i& _block_reader;
+    /// JSON of get_block/get_block_range results built from cache, empty when request has to be executed regularly
+    block_json_cache::json_t get_cached_block( const fc::variant& args ) const;
+    block_json_cache::json_t get_cached_block_range( const fc::variant& args ) const;
+
+    const hive::chain::block_read_i&      _block_reader;
+    std::shared_ptr< block_json_cache >   _json_cache;
+    block_json_cache::format_id           _json_format = 0;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -29,16 +42,37 @@ class block_api_impl
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-block_api::block_api( appbase::application& app )
-  : my( new block_api_impl( app ) )
+block_api::block_api( appbase::application& app, const std::shared_ptr< block_json_cache >& json_cache )
+  : my( new block_api_impl( app, json_cache ) )
 {
   JSON_RPC_REGISTER_API( HIVE_BLOCK_API_PLUGIN_NAME );
+
+  if( json_cache )
+  {
+    auto& json_rpc = app.get_plugin< hive::plugins::json_rpc::json_rpc_plugin >();
+    json_rpc.add_serialized_result_source( HIVE_BLOCK_API_PLUGIN_NAME, "get_block",
+      [this]( const fc::variant& args ) { return my->get_cached_block( args ); } );
+    json_rpc.add_serialized_result_source( HIVE_BLOCK_API_PLUGIN_NAME, "get_block_range",
+      [this]( const fc::variant& args ) { return my->get_cached_block_range( args ); } );
+  }
 }
 
 block_api::~block_api() {}
 
-block_api_impl::block_api_impl( appbase::application& app )
-  : _block_reader( app.get_plugin< hive::plugins::chain::chain_plugin >().block_reader() ) {}
+block_api_impl::block_api_impl( appbase::application& app, const std::shared_ptr< block_json_cache >& json_cache )
+  : _block_reader( app.get_plugin< hive::plugins::chain::chain_plugin >().block_reader() ),
+    _json_cache( json_cache )
+{
+  if( _json_cache )
+  {
+    _json_format = _json_cache->add_format( HIVE_BLOCK_API_PLUGIN_NAME, []( const std::shared_ptr< full_block_type >& full_block )
+    {
+      get_block_return result;
+      result.block = full_block;
+      return fc::json::to_string( fc::variant( result ) );
+    } );
+  }
+}
 
 block_api_impl::~block_api_impl() {}
 
@@ -88,6 +122,57 @@ DEFINE_API_IMPL( block_api_impl, get_block_range )
   return result;
 }
 
+//////////////////////////////////////////////////////////////////////
+//                                                                  //
+// Cached results                                                   //
+//                                                                  //
+//////////////////////////////////////////////////////////////////////
+block_json_cache::json_t block_api_impl::get_cached_block( const fc::variant& args ) const
+{
+  if( !args.is_object() || !args.get_object().contains( "block_num" ) )
+    return block_json_cache::json_t();
+  return _json_cache->get( _json_format, args[ "block_num" ].as< uint32_t >() );
+}
+
+block_json_cache::json_t block_api_impl::get_cached_block_range( const fc::variant& args ) const
+{
+  if( !args.is_object() || !args.get_object().contains( "starting_block_num" ) || !args.get_object().contains( "count" ) )
+    return block_json_cache::json_t();
+  const uint32_t starting_block_num = args[ "starting_block_num" ].as< uint32_t >();
+  uint32_t count = args[ "count" ].as< uint32_t >();
+
+  // empty results and errors are left for regular call
+  const uint32_t head = _block_reader.head_block_num();
+  if( starting_block_num == 0 || starting_block_num > head || count == 0 || count > BLOCK_API_SINGLE_QUERY_LIMIT )
+    return block_json_cache::json_t();
+  count = std::min( count, head - starting_block_num + 1 );
+
+  std::vector< block_json_cache::json_t > blocks;
+  blocks.reserve( count );
+  size_t size = 0;
+  for( uint32_t block_num = starting_block_num; block_num < starting_block_num + count; ++block_num )
+  {
+    auto block = _json_cache->get( _json_format, block_num );
+    if( !block )
+      return block_json_cache::json_t();
+    size += block->size();
+    blocks.emplace_back( std::move( block ) );
+  }
+
+  const size_t trimmed = get_block_json_prefix.size() + get_block_json_suffix.size();
+  auto result = std::make_shared< std::string >();
+  result->reserve( size + 16 );
+  *result += "{\"blocks\":[";
+  for( const auto& block : blocks )
+  {
+    if( &block != &blocks.front() )
+      *result += ',';
+    result->append( *block, get_block_json_prefix.size(), block->size() - trimmed );
+  }
+  *result += "]}";
+  return result;
+}
+
 DEFINE_LOCKLESS_APIS( block_api,
   (get_block_header)
   (get_block)
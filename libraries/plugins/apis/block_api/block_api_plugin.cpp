@@ -1,6 +1,8 @@
 #include <hive/plugins/block_api/block_api.hpp>
 #include <hive/plugins/block_api/block_api_plugin.hpp>
 
+#include <hive/chain/util/signal.hpp>
+
 namespace hive { namespace plugins { namespace block_api {
 
 block_api_plugin::block_api_plugin() {}
@@ -8,15 +10,49 @@ block_api_plugin::~block_api_plugin() {}
 
 void block_api_plugin::set_program_options(
   options_description& cli,
-  options_description& cfg ) {}
+  options_description& cfg )
+{
+  cfg.add_options()
+    ("block-api-json-cache-size", bpo::value<uint32_t>()->default_value(0)->value_name("blocks"),
+      "Number of most recent blocks kept as final JSON to serve block_api.get_block, block_api.get_block_range and condenser_api.get_block without serialization. 0 means no cache")
+    ("block-api-json-cache-threads", bpo::value<uint32_t>()->default_value(2)->value_name("threads"),
+      "Number of threads serializing new blocks for JSON cache")
+    ;
+}
 
 void block_api_plugin::plugin_initialize( const variables_map& options )
 {
-  api = std::make_shared< block_api >( get_app() );
+  const uint32_t cache_size = options.at( "block-api-json-cache-size" ).as< uint32_t >();
+  if( cache_size > 0 )
+  {
+    auto& chain = get_app().get_plugin< hive::plugins::chain::chain_plugin >();
+    json_cache = std::make_shared< block_json_cache >( chain.block_reader(), cache_size,
+      options.at( "block-api-json-cache-threads" ).as< uint32_t >() );
+  }
+
+  api = std::make_shared< block_api >( get_app(), json_cache );
 }
 
-void block_api_plugin::plugin_startup() {}
+void block_api_plugin::plugin_startup()
+{
+  if( json_cache )
+  {
+    json_cache->start();
+    auto& db = get_app().get_plugin< hive::plugins::chain::chain_plugin >().db();
+    _post_apply_block_conn = db.add_post_apply_block_handler( [&]( const hive::chain::block_notification& note )
+    {
+      // no point in serializing blocks during replay - they'd be evicted before anyone asks for them
+      if( !db.is_replaying_block() )
+        json_cache->add_block( note.full_block );
+    }, *this, 0 );
+  }
+}
 
-void block_api_plugin::plugin_shutdown() {}
+void block_api_plugin::plugin_shutdown()
+{
+  hive::chain::util::disconnect_signal( _post_apply_block_conn );
+  if( json_cache )
+    json_cache->stop();
+}
 
 } } } // hive::plugins::block_api
@@ -0,0 +1,129 @@
+#include <hive/plugins/block_api/block_json_cache.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
+
+namespace hive { namespace plugins { namespace block_api {
+
+using hive::utilities::performance_metrics;
+
+block_json_cache::block_json_cache( const hive::chain::block_read_i& block_reader, uint32_t max_blocks, uint32_t threads )
+  : _block_reader( block_reader ), _max_blocks( max_blocks ), _threads( threads )
+{
+  FC_ASSERT( _max_blocks > 0 && _threads > 0 );
+  performance_metrics::instance().describe_family( "block_json_cache", "Time of serialization of new block into cached JSON, by format" );
+}
+
+block_json_cache::~block_json_cache()
+{
+  stop();
+}
+
+block_json_cache::format_id block_json_cache::add_format( const std::string& name, serializer_t serializer )
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  format f;
+  f.serializer = std::move( serializer );
+  f.histogram = performance_metrics::instance().get_histogram_id( "block_json_cache", name );
+  _formats.emplace_back( std::move( f ) );
+  return _formats.size() - 1;
+}
+
+void block_json_cache::start()
+{
+  _work.reset( new boost::asio::io_service::work( _ios ) );
+  for( uint32_t i = 0; i < _threads; ++i )
+    _workers.create_thread( [this]() { fc::set_thread_name( "block_json" ); _ios.run(); } );
+  ilog( "Caching JSON of ${n} most recent blocks using ${t} thread(s)", ( "n", _max_blocks )( "t", _threads ) );
+}
+
+void block_json_cache::stop()
+{
+  _work.reset();
+  _ios.stop();
+  _workers.join_all();
+}
+
+void block_json_cache::add_block( const std::shared_ptr< full_block_type >& full_block )
+{
+  const uint32_t block_num = full_block->get_block_num();
+  std::vector< format > formats;
+  {
+    std::lock_guard< std::mutex > guard( _mutex );
+    formats = _formats;
+    // new block replaces blocks of the same or higher number that were popped
+    _entries.erase( _entries.lower_bound( block_num ), _entries.end() );
+    entry& e = _entries[ block_num ];
+    e.block_id = full_block->get_block_id();
+    e.json.resize( _formats.size() );
+    while( _entries.size() > _max_blocks )
+      _entries.erase( _entries.begin() );
+  }
+
+  for( format_id id = 0; id < formats.size(); ++id )
+    _ios.post( [this, id, f = formats[id], full_block]() { serialize( id, f, full_block ); } );
+}
+
+void block_json_cache::serialize( format_id id, const format& f, const std::shared_ptr< full_block_type >& full_block )
+{
+  const uint32_t block_num = full_block->get_block_num();
+  const block_id_type& block_id = full_block->get_block_id();
+  auto is_still_cached = [&]()
+  {
+    auto itr = _entries.find( block_num );
+    return itr != _entries.end() && itr->second.block_id == block_id;
+  };
+
+  {
+    // during sync blocks come faster than they can be serialized - skip the ones that were already evicted
+    std::lock_guard< std::mutex > guard( _mutex );
+    if( !is_still_cached() )
+      return;
+  }
+
+  json_t json;
+  try
+  {
+    performance_metrics::scoped_timer timer( f.histogram );
+    json = std::make_shared< const std::string >( f.serializer( full_block ) );
+  }
+  catch( const fc::exception& e )
+  {
+    elog( "Unable to serialize block ${b} for JSON cache: ${e}", ( "b", block_num )( "e", e.to_detail_string() ) );
+    return;
+  }
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  if( is_still_cached() )
+    _entries[ block_num ].json[ id ] = std::move( json );
+}
+
+block_json_cache::json_t block_json_cache::get( format_id format, uint32_t block_num ) const
+{
+  json_t json;
+  block_id_type block_id;
+  {
+    std::lock_guard< std::mutex > guard( _mutex );
+    auto itr = _entries.find( block_num );
+    if( itr == _entries.end() || format >= itr->second.json.size() )
+      return json_t();
+    json = itr->second.json[ format ];
+    block_id = itr->second.block_id;
+  }
+  if( !json )
+    return json;
+
+  // block might have been popped without being replaced yet
+  try
+  {
+    if( _block_reader.find_block_id_for_num( block_num ) == block_id )
+      return json;
+  }
+  catch( const fc::exception& )
+  {
+  }
+  return json_t();
+}
+
+} } } // hive::plugins::block_api
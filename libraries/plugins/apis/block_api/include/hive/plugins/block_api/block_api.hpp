@@ -3,6 +3,7 @@
 #include <hive/plugins/json_rpc/utility.hpp>
 
 #include <hive/plugins/block_api/block_api_args.hpp>
+#include <hive/plugins/block_api/block_json_cache.hpp>
 
 #define BLOCK_API_SINGLE_QUERY_LIMIT 1000
 
@@ -13,7 +14,8 @@ class block_api_impl;
 class block_api
 {
   public:
-    block_api( appbase::application& app );
+    /// when `json_cache` is given, get_block and get_block_range calls are served from it whenever possible
+    block_api( appbase::application& app, const std::shared_ptr< block_json_cache >& json_cache = nullptr );
     ~block_api();
 
     DECLARE_API(
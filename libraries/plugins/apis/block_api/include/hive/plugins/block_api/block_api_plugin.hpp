@@ -3,6 +3,8 @@
 #include <hive/plugins/chain/chain_plugin.hpp>
 #include <hive/plugins/json_rpc/json_rpc_plugin.hpp>
 
+#include <hive/plugins/block_api/block_json_cache.hpp>
+
 #include <appbase/application.hpp>
 
 namespace hive { namespace plugins { namespace block_api {
@@ -32,6 +34,11 @@ class block_api_plugin : public plugin< block_api_plugin >
     void plugin_shutdown() override;
 
     std::shared_ptr< class block_api > api;
+    /// JSON of recent blocks (null when disabled); other APIs can register their formats in it
+    std::shared_ptr< block_json_cache > json_cache;
+
+  private:
+    boost::signals2::connection _post_apply_block_conn;
 };
 
 } } } // hive::plugins::block_api
@@ -0,0 +1,84 @@
+#pragma once
+#include <hive/chain/full_block.hpp>
+#include <hive/chain/block_read_interface.hpp>
+
+#include <hive/utilities/performance_metrics.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hive { namespace plugins { namespace block_api {
+
+using hive::chain::full_block_type;
+using hive::protocol::block_id_type;
+
+/**
+  * Final JSON of most recent blocks, so API calls that ask for the same recent blocks over and over
+  * (most of block API traffic) don't convert them through fc::variant on every request.
+  *
+  * Block can be cached in many formats (f.e. block_api and legacy condenser_api results), each with its
+  * own serializer. Serialization is done by worker threads of the cache after block is applied, so
+  * block processing does not wait for it; until it is done, calls are served the regular way.
+  *
+  * Cache is keyed by block number - entry is valid only as long as block reader still has block with
+  * cached id under that number, which covers blocks popped during fork switch.
+  */
+class block_json_cache
+{
+  public:
+    typedef std::shared_ptr< const std::string > json_t;
+    typedef std::function< std::string( const std::shared_ptr< full_block_type >& ) > serializer_t;
+    typedef uint32_t format_id;
+
+    block_json_cache( const hive::chain::block_read_i& block_reader, uint32_t max_blocks, uint32_t threads );
+    ~block_json_cache();
+
+    /// registers format of cached JSON (blocks added earlier are not cached in it)
+    format_id add_format( const std::string& name, serializer_t serializer );
+
+    void start();
+    void stop();
+
+    /// schedules serialization of new block in all formats (drops entries of blocks it replaces)
+    void add_block( const std::shared_ptr< full_block_type >& full_block );
+
+    /// JSON of given block in given format, empty when not (yet) cached
+    json_t get( format_id format, uint32_t block_num ) const;
+
+  private:
+    struct format
+    {
+      serializer_t                                            serializer;
+      hive::utilities::performance_metrics::histogram_id      histogram = 0;
+    };
+
+    struct entry
+    {
+      block_id_type           block_id;
+      std::vector< json_t >   json; // by format
+    };
+
+    void serialize( format_id id, const format& f, const std::shared_ptr< full_block_type >& full_block );
+
+    const hive::chain::block_read_i&                          _block_reader;
+    const uint32_t                                            _max_blocks;
+    const uint32_t                                            _threads;
+
+    std::vector< format >                                     _formats;
+
+    mutable std::mutex                                        _mutex;
+    std::map< uint32_t, entry >                               _entries;
+
+    boost::asio::io_service                                   _ios;
+    std::unique_ptr< boost::asio::io_service::work >          _work;
+    boost::thread_group                                       _workers;
+};
+
+} } } // hive::plugins::block_api
@@ -169,6 +169,8 @@ namespace detail
 
       std::shared_ptr< database_api::database_api >                     _database_api;
       std::shared_ptr< block_api::block_api >                           _block_api;
+      std::shared_ptr< block_api::block_json_cache >                    _block_json_cache;
+      block_api::block_json_cache::format_id                            _legacy_block_json_format = 0;
       std::shared_ptr< account_history::account_history_api >           _account_history_api;
       std::shared_ptr< account_by_key::account_by_key_api >             _account_by_key_api;
       std::shared_ptr< network_broadcast_api::network_broadcast_api >   _network_broadcast_api;
@@ -1369,6 +1371,25 @@ void condenser_api::api_startup()
   if( block != nullptr )
   {
     my->_block_api = block->api;
+
+    if( block->json_cache )
+    {
+      my->_block_json_cache = block->json_cache;
+      my->_legacy_block_json_format = block->json_cache->add_format( HIVE_CONDENSER_API_PLUGIN_NAME,
+        []( const std::shared_ptr< full_block_type >& full_block )
+        {
+          get_block_return result = hive::protocol::serializer_wrapper<legacy_signed_block>{
+            legacy_signed_block( block_api::api_signed_block_object( full_block ) ), transaction_serialization_type::legacy };
+          return fc::json::to_string( fc::variant( result ) );
+        } );
+      theApp.get_plugin< json_rpc::json_rpc_plugin >().add_serialized_result_source( HIVE_CONDENSER_API_PLUGIN_NAME, "get_block",
+        [this]( const fc::variant& args )
+        {
+          if( !args.is_array() || args.get_array().size() != 1 )
+            return block_api::block_json_cache::json_t();
+          return my->_block_json_cache->get( my->_legacy_block_json_format, args.get_array()[0].as< uint32_t >() );
+        } );
+    }
   }
 
   auto account_by_key = theApp.find_plugin< account_by_key::account_by_key_api_plugin >();
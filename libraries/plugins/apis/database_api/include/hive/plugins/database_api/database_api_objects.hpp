@@ -484,11 +484,7 @@ struct api_account_object
     name( a.get_name() ),
     memo_key( a.memo_key ),
     proxy( HIVE_PROXY_TO_SELF_ACCOUNT ),
-    last_account_update( a.last_account_update ),
-    created( a.get_creation_time() ),
-    mined( a.was_mined() ),
     reset_account( HIVE_NULL_ACCOUNT ),
-    last_account_recovery( a.get_last_account_recovery_time() ),
     post_count( a.post_count ),
     can_vote( a.can_vote ),
     voting_manabar( a.voting_manabar ),
@@ -531,8 +527,14 @@ struct api_account_object
   {
     if( a.has_proxy() )
       proxy = db.get_account( a.get_proxy() ).get_name();
-    if( a.has_recovery_account() )
-      recovery_account = db.get_account( a.get_recovery_account() ).get_name();
+
+    const auto& cold = db.get_account_cold( a );
+    last_account_update = cold.last_account_update;
+    created = cold.get_creation_time();
+    mined = cold.was_mined();
+    last_account_recovery = cold.get_last_account_recovery_time();
+    if( cold.has_recovery_account() )
+      recovery_account = db.get_account( cold.get_recovery_account() ).get_name();
 
     size_t n = a.proxied_vsf_votes.size();
     proxied_vsf_votes.reserve( n );
@@ -21,10 +21,24 @@ using hive::plugins::json_rpc::void_type;
 
 /* get_node_status */
 typedef void_type get_node_status_args;
+struct memory_status
+{
+  /// size of shared memory file mapping and part of it present in physical memory
+  uint64_t shared_memory_size = 0;
+  uint64_t shared_memory_resident = 0;
+  /// resident set of whole process [kB]
+  uint64_t resident_set_kb = 0;
+  uint64_t peak_resident_set_kb = 0;
+  /// page faults since process start (sample twice to get the rate)
+  uint64_t minor_page_faults = 0;
+  uint64_t major_page_faults = 0;
+};
+
 struct get_node_status_return
 {
   uint32_t last_processed_block_num;
   fc::time_point_sec last_processed_block_time;
+  memory_status memory;
 };
 
 namespace detail{ class node_status_api_impl; }
@@ -43,4 +57,6 @@ class node_status_api
 
 } } } // hive::plugins::node_status_api
 
-FC_REFLECT(hive::plugins::node_status_api::get_node_status_return, (last_processed_block_num)(last_processed_block_time))
+FC_REFLECT(hive::plugins::node_status_api::memory_status,
+  (shared_memory_size)(shared_memory_resident)(resident_set_kb)(peak_resident_set_kb)(minor_page_faults)(major_page_faults))
+FC_REFLECT(hive::plugins::node_status_api::get_node_status_return, (last_processed_block_num)(last_processed_block_time)(memory))
@@ -2,9 +2,12 @@
 #include <hive/plugins/node_status_api/node_status_api_plugin.hpp>
 
 #include <hive/chain/database.hpp>
+#include <hive/utilities/benchmark_dumper.hpp>
 
 #include <appbase/application.hpp>
 
+#include <sys/resource.h>
+
 namespace hive { namespace plugins { namespace node_status_api {
 
 namespace detail
@@ -27,6 +30,16 @@ namespace detail
     get_node_status_return result;
     result.last_processed_block_num = node_status.last_processed_block_num;
     result.last_processed_block_time = node_status.last_processed_block_time;
+
+    result.memory.shared_memory_size = node_status.shared_memory.mapped_size;
+    result.memory.shared_memory_resident = node_status.shared_memory.resident_size;
+    hive::utilities::benchmark_dumper::read_resident_mem( &result.memory.resident_set_kb, &result.memory.peak_resident_set_kb );
+    struct rusage usage;
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+    {
+      result.memory.minor_page_faults = usage.ru_minflt;
+      result.memory.major_page_faults = usage.ru_majflt;
+    }
     return result;
   }
 } // detail
@@ -7,6 +7,7 @@
 
 #include <hive/plugins/block_data_export/block_data_export_plugin.hpp>
 #include <hive/plugins/block_data_export/exportable_block_data.hpp>
+#include <hive/plugins/block_data_export/export_records.hpp>
 
 #include <appbase/application.hpp>
 
@@ -15,17 +16,27 @@
 #include <hive/chain/global_property_object.hpp>
 #include <hive/chain/index.hpp>
 
+#include <fc/io/raw.hpp>
+#include <fc/io/raw_variant.hpp>
+
 #include <boost/thread/future.hpp>
 #include <boost/thread/sync_bounded_queue.hpp>
 
-#include <fstream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <queue>
 #include <sstream>
 
+#include <unistd.h>
+
 namespace hive { namespace plugins { namespace block_data_export {
 
 using hive::chain::block_notification;
+using hive::chain::async_block_notification;
 using hive::chain::database;
 
 using hive::protocol::block_id_type;
@@ -53,11 +64,21 @@ FC_REFLECT( hive::plugins::block_data_export::detail::api_export_data_object, (b
 
 namespace hive { namespace plugins { namespace block_data_export { namespace detail {
 
+enum class export_format
+{
+  json,     ///< one JSON line per block
+  binary,   ///< length-prefixed fc::raw record per block
+  per_type  ///< separate file per export data type, each with length-prefixed fc::raw record per block
+};
+
+/// serialized block data ready to be written: pairs of (output stream suffix, bytes)
+typedef std::vector< std::pair< std::string, std::string > > export_output;
+
 struct work_item
 {
-  std::shared_ptr< api_export_data_object >          edo;
-  boost::promise< std::shared_ptr< std::string > >   edo_json_promise;
-  boost::future< std::shared_ptr< std::string > >    edo_json_future = edo_json_promise.get_future();
+  std::shared_ptr< api_export_data_object >           edo;
+  boost::promise< std::shared_ptr< export_output > >  edo_output_promise;
+  boost::future< std::shared_ptr< export_output > >   edo_output_future = edo_output_promise.get_future();
 };
 
 class block_data_export_plugin_impl
@@ -72,22 +93,25 @@ class block_data_export_plugin_impl
 
     void on_pre_apply_block( const block_notification& note );
     void on_post_apply_block( const block_notification& note );
+    void on_async_post_apply_block( const async_block_notification& note );
 
     void register_export_data_factory( const std::string& name, std::function< std::shared_ptr< exportable_block_data >() >& factory );
     void unregister_export_data( const std::string& name );
     void create_export_data( const block_notification& note );
-    void send_export_data();
+    void send_export_data( std::shared_ptr< api_export_data_object > edo );
     std::shared_ptr< exportable_block_data > find_abstract_export_data( const std::string& name );
 
     void start_threads();
     void stop_threads();
     void convert_to_json_thread_main();
     void output_thread_main();
+    std::shared_ptr< export_output > serialize( const api_export_data_object& edo )const;
 
     database&                     _db;
     block_data_export_plugin&     _self;
     boost::signals2::connection   _pre_apply_block_conn;
     boost::signals2::connection   _post_apply_block_conn;
+    boost::signals2::connection   _async_post_apply_block_conn;
     std::shared_ptr< api_export_data_object >
                         _edo;
     std::vector< std::pair<
@@ -97,6 +121,15 @@ class block_data_export_plugin_impl
     std::string                   _output_name;
     bool                          _enabled = false;
     bool                          _skip_empty = false;
+    bool                          _async = false;
+    export_format                 _format = export_format::json;
+    uint32_t                      _flush_interval = 1; // in blocks
+    bool                          _fsync = false;
+
+    // in async mode complete export data waits here (by block number) for async notification of its block
+    std::mutex                    _pending_edo_mutex;
+    std::map< uint32_t, std::shared_ptr< api_export_data_object > >
+                        _pending_edo;
 
     size_t                        _max_queue_size = 100;
     boost::concurrent::sync_bounded_queue< std::shared_ptr< work_item > >    _data_queue;
@@ -162,14 +195,99 @@ void block_data_export_plugin_impl::convert_to_json_thread_main()
     }
 
     // TODO exception handling
-    std::shared_ptr< std::string > edo_json = std::make_shared< std::string >( fc::json::to_string( work->edo ) );
-    work->edo_json_promise.set_value( edo_json );
+    work->edo_output_promise.set_value( serialize( *work->edo ) );
   }
 }
 
+std::shared_ptr< export_output > block_data_export_plugin_impl::serialize( const api_export_data_object& edo )const
+{
+  std::shared_ptr< export_output > output = std::make_shared< export_output >();
+  switch( _format )
+  {
+    case export_format::json:
+    {
+      output->emplace_back( std::string(), fc::json::to_string( edo ) );
+      output->back().second.push_back( '\n' );
+      break;
+    }
+    case export_format::binary:
+    {
+      binary_export_record record;
+      record.block_id = edo.block_id;
+      record.previous = edo.previous;
+      record.export_data.reserve( edo.export_data.size() );
+      for( const auto& entry : edo.export_data )
+      {
+        record.export_data.emplace_back();
+        record.export_data.back().name = entry.first;
+        entry.second->to_binary( record.export_data.back().data );
+      }
+      output->emplace_back( std::string(), std::string() );
+      append_length_prefixed( output->back().second, fc::raw::pack_to_vector( record ) );
+      break;
+    }
+    case export_format::per_type:
+    {
+      for( const auto& entry : edo.export_data )
+      {
+        per_type_export_record record;
+        record.block_id = edo.block_id;
+        record.previous = edo.previous;
+        entry.second->to_binary( record.data );
+        output->emplace_back( entry.first, std::string() );
+        append_length_prefixed( output->back().second, fc::raw::pack_to_vector( record ) );
+      }
+      break;
+    }
+  }
+  return output;
+}
+
 void block_data_export_plugin_impl::output_thread_main()
 {
-  std::ofstream output_file( _output_name, std::ios::binary );
+  // output streams by suffix (empty for main output file); binary-per-type format opens new file for every export data type
+  std::map< std::string, FILE* > output_files;
+  // export with missing blocks is useless to its consumers - after first failure nothing more is written and node is stopped
+  bool failed = false;
+  auto fail = [&]( const char* action, const std::string& suffix )
+  {
+    const std::string file_name = suffix.empty() ? _output_name : _output_name + "." + suffix;
+    const std::string error = strerror( errno );
+    elog( "Cannot ${action} block data export file ${file_name}: ${error} - export stopped, shutting down",
+      ( action )( file_name )( error ) );
+    failed = true;
+    theApp.generate_interrupt_request();
+  };
+  auto get_output_file = [&]( const std::string& suffix ) -> FILE*
+  {
+    auto it = output_files.find( suffix );
+    if( it != output_files.end() )
+      return it->second;
+    const std::string file_name = suffix.empty() ? _output_name : _output_name + "." + suffix;
+    FILE* file = fopen( file_name.c_str(), "wb" );
+    if( file == nullptr )
+      fail( "open", suffix );
+    else
+      output_files.emplace( suffix, file );
+    return file;
+  };
+  auto flush_all = [&]()
+  {
+    for( const auto& output : output_files )
+    {
+      if( fflush( output.second ) != 0 )
+        fail( "flush", output.first );
+      else if( _fsync && fsync( fileno( output.second ) ) != 0 )
+        fail( "sync", output.first );
+      if( failed )
+        return;
+    }
+  };
+
+  if( _format != export_format::per_type )
+    get_output_file( std::string() );
+
+  uint32_t blocks_since_flush = 0;
   while( true )
   {
     if (theApp.is_interrupt_request() )
@@ -185,12 +303,33 @@ void block_data_export_plugin_impl::output_thread_main()
       break;
     }
 
-    std::shared_ptr< std::string > edo_json = work->edo_json_future.get();
+    std::shared_ptr< export_output > edo_output = work->edo_output_future.get();
+
+    for( const auto& chunk : *edo_output )
+    {
+      FILE* file = get_output_file( chunk.first );
+      if( file == nullptr )
+        break;
+      if( fwrite( chunk.second.data(), 1, chunk.second.size(), file ) != chunk.second.size() )
+      {
+        fail( "write", chunk.first );
+        break;
+      }
+    }
 
-    output_file.write( edo_json->c_str(), edo_json->length() );
-    output_file.put( '\n' );
-    output_file.flush();
+    if( !failed && ++blocks_since_flush >= _flush_interval )
+    {
+      flush_all();
+      blocks_since_flush = 0;
+    }
+    if( failed )
+      break;
   }
+
+  if( !failed )
+    flush_all();
+  for( const auto& output : output_files )
+    fclose( output.second );
 }
 
 void block_data_export_plugin_impl::register_export_data_factory(
@@ -231,14 +370,13 @@ void block_data_export_plugin_impl::create_export_data( const block_notification
   }
 }
 
-void block_data_export_plugin_impl::send_export_data()
+void block_data_export_plugin_impl::send_export_data( std::shared_ptr< api_export_data_object > edo )
 {
-  if( _skip_empty && _edo->export_data.empty() )
+  if( _skip_empty && edo->export_data.empty() )
     return;
 
   std::shared_ptr< work_item > work = std::make_shared< work_item >();
-  work->edo = _edo;
-  _edo.reset();
+  work->edo = std::move( edo );
 
   try
   {
@@ -272,7 +410,34 @@ void block_data_export_plugin_impl::on_pre_apply_block( const block_notification
 
 void block_data_export_plugin_impl::on_post_apply_block( const block_notification& note )
 {
-  send_export_data();
+  if( _async )
+  {
+    std::lock_guard< std::mutex > guard( _pending_edo_mutex );
+    _pending_edo[ note.block_num ] = std::move( _edo );
+  }
+  else
+  {
+    send_export_data( std::move( _edo ) );
+  }
+  _edo.reset();
+}
+
+void block_data_export_plugin_impl::on_async_post_apply_block( const async_block_notification& note )
+{
+  std::shared_ptr< api_export_data_object > edo;
+  {
+    std::lock_guard< std::mutex > guard( _pending_edo_mutex );
+    // leftovers of blocks that failed after post_apply_block notification are dropped here
+    _pending_edo.erase( _pending_edo.begin(), _pending_edo.lower_bound( note.block_num ) );
+    auto it = _pending_edo.find( note.block_num );
+    if( it != _pending_edo.end() && it->second->block_id == note.block_id )
+    {
+      edo = std::move( it->second );
+      _pending_edo.erase( it );
+    }
+  }
+  if( edo )
+    send_export_data( std::move( edo ) );
 }
 
 } // detail
@@ -302,6 +467,10 @@ void block_data_export_plugin::set_program_options( options_description& cli, op
   cfg.add_options()
       ("block-data-export-file", boost::program_options::value< string >()->default_value("NONE"), "Where to export data (NONE to discard)")
       ("block-data-skip-empty", boost::program_options::value< bool >()->default_value( false ), "Skip producing when no factory is registered" )
+      ("block-data-export-format", boost::program_options::value< string >()->default_value( "json" ), "Format of exported data: json (JSON line per block), binary (length-prefixed fc::raw record per block) or binary-per-type (separate length-prefixed fc::raw file per export data type)" )
+      ("block-data-export-flush-interval", boost::program_options::value< uint32_t >()->default_value( 1 ), "Number of blocks written between flushes of export file(s)" )
+      ("block-data-export-fsync", boost::program_options::value< bool >()->default_value( false ), "Call fsync on export file(s) with every flush" )
+      ("block-data-export-async", boost::program_options::value< bool >()->default_value( false ), "Hand export data over to output threads asynchronously after block is applied, so slow output does not delay block processing" )
       ;
 }
 
@@ -317,11 +486,31 @@ void block_data_export_plugin::plugin_initialize( const boost::program_options::
     if( !my->_enabled )
       return;
     my->_skip_empty = options.at( "block-data-skip-empty" ).as< bool >();
+    my->_async = options.at( "block-data-export-async" ).as< bool >();
+
+    const std::string format = options.at( "block-data-export-format" ).as< string >();
+    if( format == "json" )
+      my->_format = detail::export_format::json;
+    else if( format == "binary" )
+      my->_format = detail::export_format::binary;
+    else if( format == "binary-per-type" )
+      my->_format = detail::export_format::per_type;
+    else
+      FC_ASSERT( false, "Unknown block-data-export-format ${format}", ( format ) );
+
+    my->_flush_interval = options.at( "block-data-export-flush-interval" ).as< uint32_t >();
+    FC_ASSERT( my->_flush_interval > 0, "block-data-export-flush-interval must be greater than 0" );
+    my->_fsync = options.at( "block-data-export-fsync" ).as< bool >();
 
     my->_pre_apply_block_conn = my->_db.add_pre_apply_block_handler(
       [&]( const block_notification& note ){ my->on_pre_apply_block( note ); }, *this, -9300 );
     my->_post_apply_block_conn = my->_db.add_post_apply_block_handler(
       [&]( const block_notification& note ){ my->on_post_apply_block( note ); }, *this, 9300 );
+    if( my->_async )
+    {
+      my->_async_post_apply_block_conn = my->_db.add_async_post_apply_block_handler(
+        [&]( const async_block_notification& note ){ my->on_async_post_apply_block( note ); }, *this );
+    }
 
     my->start_threads();
   }
@@ -335,6 +524,8 @@ void block_data_export_plugin::plugin_shutdown()
   if( !my->_enabled )
     return;
 
+  my->_db.flush_async_notifications();
+  chain::util::disconnect_signal( my->_async_post_apply_block_conn );
   chain::util::disconnect_signal( my->_pre_apply_block_conn );
   chain::util::disconnect_signal( my->_post_apply_block_conn );
 
@@ -344,4 +535,11 @@ void block_data_export_plugin::plugin_shutdown()
 exportable_block_data::exportable_block_data() {}
 exportable_block_data::~exportable_block_data() {}
 
+void exportable_block_data::to_binary( std::vector< char >& data )const
+{
+  fc::variant v;
+  to_variant( v );
+  data = fc::raw::pack_to_vector( v );
+}
+
 } } } // hive::plugins::block_data_export
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <hive/protocol/types.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace hive { namespace plugins { namespace block_data_export {
+
+/**
+  * Records of binary export formats. Every record in export file is preceded by its size
+  * (32bit little endian) and serialized with fc::raw.
+  * - binary format: single file with binary_export_record per block,
+  * - binary-per-type format: separate file per export data type (name of export data appended to the
+  *   name of export file after a dot), each with per_type_export_record per block.
+  */
+struct binary_export_entry
+{
+  std::string                      name;
+  std::vector< char >              data; ///< result of exportable_block_data::to_binary
+};
+
+struct binary_export_record
+{
+  hive::protocol::block_id_type    block_id;
+  hive::protocol::block_id_type    previous;
+  std::vector< binary_export_entry > export_data;
+};
+
+struct per_type_export_record
+{
+  hive::protocol::block_id_type    block_id;
+  hive::protocol::block_id_type    previous;
+  std::vector< char >              data; ///< result of exportable_block_data::to_binary
+};
+
+/// appends 32bit little endian length followed by the data
+inline void append_length_prefixed( std::string& out, const std::vector< char >& data )
+{
+  const uint32_t size = static_cast< uint32_t >( data.size() );
+  for( int i = 0; i < 4; ++i )
+    out.push_back( static_cast< char >( ( size >> ( 8 * i ) ) & 0xFF ) );
+  out.append( data.data(), data.size() );
+}
+
+/// reads next record of binary export file; false at the end of file, throws on truncated record
+template< typename Record >
+bool read_export_record( std::istream& in, Record& record )
+{
+  unsigned char prefix[4];
+  if( !in.read( reinterpret_cast< char* >( prefix ), sizeof( prefix ) ) )
+  {
+    FC_ASSERT( in.gcount() == 0, "Truncated length of block data export record" );
+    return false;
+  }
+  const uint32_t size = uint32_t( prefix[0] ) | ( uint32_t( prefix[1] ) << 8 ) |
+    ( uint32_t( prefix[2] ) << 16 ) | ( uint32_t( prefix[3] ) << 24 );
+  std::vector< char > data( size );
+  FC_ASSERT( size == 0 || in.read( data.data(), size ), "Truncated block data export record" );
+  fc::raw::unpack_from_vector( data, record );
+  return true;
+}
+
+} } } // hive::plugins::block_data_export
+
+FC_REFLECT( hive::plugins::block_data_export::binary_export_entry, (name)(data) )
+FC_REFLECT( hive::plugins::block_data_export::binary_export_record, (block_id)(previous)(export_data) )
+FC_REFLECT( hive::plugins::block_data_export::per_type_export_record, (block_id)(previous)(data) )
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace fc {
 class variant;
@@ -15,6 +16,12 @@ class exportable_block_data
     virtual ~exportable_block_data();
 
     virtual void to_variant( fc::variant& v )const = 0;
+
+    /**
+      * Serialization used by binary export formats. Default implementation packs result of to_variant
+      * with fc::raw; override with direct fc::raw::pack of the data to avoid building the variant.
+      */
+    virtual void to_binary( std::vector< char >& data )const;
 };
 
 } } }
@@ -7,14 +7,17 @@
 #include <hive/chain/database_exceptions.hpp>
 #include <hive/chain/db_with.hpp>
 #include <hive/chain/irreversible_block_writer.hpp>
+#include <hive/chain/replica_block_writer.hpp>
 #include <hive/chain/sync_block_writer.hpp>
 
 #include <hive/plugins/chain/abstract_block_producer.hpp>
+#include <hive/plugins/chain/replay_benchmark.hpp>
 #include <hive/plugins/chain/state_snapshot_provider.hpp>
 #include <hive/plugins/statsd/utility.hpp>
 
 #include <hive/utilities/notifications.hpp>
 #include <hive/utilities/benchmark_dumper.hpp>
+#include <hive/utilities/performance_metrics.hpp>
 #include <hive/utilities/database_configuration.hpp>
 
 #include <fc/string.hpp>
@@ -47,6 +50,7 @@ using fc::flat_map;
 using hive::chain::block_id_type;
 
 using hive::plugins::chain::synchronization_type;
+using hive::utilities::performance_metrics;
 using index_memory_details_cntr_t = hive::utilities::benchmark_dumper::index_memory_details_cntr_t;
 using get_indexes_memory_details_type = std::function< void( index_memory_details_cntr_t&, bool ) >;
 
@@ -113,6 +117,7 @@ typedef fc::static_variant<
 struct write_context
 {
   write_request_ptr             req_ptr;
+  fc::time_point                enqueued_time; // set by chain_plugin_impl::enqueue_write_request
 };
 
 namespace detail {
@@ -124,12 +129,17 @@ class chain_plugin_impl
       thread_pool( app ),
       db( app ),
       default_block_writer( db, app ),
+      replica_writer( app ),
       webserver( app.get_plugin<hive::plugins::webserver::webserver_plugin>() ),
-      theApp( app )
+      theApp( app ),
+      write_queue_depth_metric( performance_metrics::instance().get_gauge( "write_queue", "depth" ) ),
+      free_memory_metric( performance_metrics::instance().get_gauge( "chainbase", "free_memory_bytes" ) ),
+      write_queue_wait_metric_id( performance_metrics::instance().get_histogram_id( "write_queue", "wait" ) )
     {}
 
     ~chain_plugin_impl()
     {
+      stop_replica_processing();
       stop_write_processing();
 
       if( chain_sync_con.connected() )
@@ -158,6 +168,10 @@ class chain_plugin_impl
     void prepare_work( bool started, synchronization_type& on_sync );
     void work( synchronization_type& on_sync );
 
+    /// read replica: follows block log of writer instead of processing writes
+    void start_replica_processing( synchronization_type& on_sync );
+    void stop_replica_processing();
+
     void write_default_database_config( bfs::path& p );
     void setup_benchmark_dumper();
 
@@ -173,13 +187,18 @@ class chain_plugin_impl
     uint64_t                         shared_memory_size = 0;
     uint16_t                         shared_file_full_threshold = 0;
     uint16_t                         shared_file_scale_rate = 0;
+    chainbase::mapping_options       shared_file_mapping;
     uint32_t                         chainbase_flags = 0;
+    uint32_t                         max_replica_reader_wait = 100; // milliseconds
     bfs::path                        shared_memory_dir;
     bool                             replay = false;
     bool                             resync   = false;
-    bool                             readonly = false;
+    bool                             readonly = false; // read replica of other node's shared memory file
+    uint32_t                         replica_refresh_interval = 500; // milliseconds
     bool                             check_locks = false;
     bool                             validate_invariants = false;
+    bool                             validate_invariants_per_block = false;
+    uint32_t                         full_invariants_validation_interval = 0;
     bool                             dump_memory_details = false;
     bool                             benchmark_is_enabled = false;
     bool                             statsd_on_replay = false;
@@ -190,6 +209,7 @@ class chain_plugin_impl
     bool                             exit_before_sync = false;
     bool                             force_replay = false;
     bool                             validate_during_replay = false;
+    bool                             compact_shared_file = false;
     uint32_t                         benchmark_interval = 0;
     uint32_t                         flush_interval = 0;
     bool                             replay_in_memory = false;
@@ -198,6 +218,7 @@ class chain_plugin_impl
     bool                             enable_block_log_auto_fixing = true;
     bool                             load_snapshot = false;
     int                              block_log_compression_level = 15;
+    uint32_t                         comment_cashout_threads = 0;
     flat_map<uint32_t,block_id_type> checkpoints;
     flat_map<uint32_t,block_id_type> loaded_checkpoints;
     bool                             last_pushed_block_was_before_checkpoint = false; // just used for logging
@@ -214,6 +235,11 @@ class chain_plugin_impl
     std::queue<write_context*>       write_queue;
     bool                             running = true;
 
+    /// adds request to write_queue and wakes up write processing thread
+    void enqueue_write_request( write_context* cxt );
+    /// takes next request from write_queue (queue_mutex has to be held by caller)
+    write_context* dequeue_write_request();
+
     int16_t                          write_lock_hold_time = HIVE_BLOCK_INTERVAL * 1000 / 6; // 1/6 of block time (millseconds)
 
     vector< string >                 loaded_plugins;
@@ -224,6 +250,8 @@ class chain_plugin_impl
 
     database                         db;
     sync_block_writer                default_block_writer;
+    replica_block_writer             replica_writer;
+    std::thread                      replica_refresh_thread;
 
     std::string block_generator_registrant;
     std::shared_ptr< abstract_block_producer > block_generator;
@@ -234,6 +262,7 @@ class chain_plugin_impl
     boost::signals2::connection         dumper_post_apply_block;
 
     state_snapshot_provider*            snapshot_provider = nullptr;
+    std::unique_ptr< replay_benchmark > replay_benchmark_collector; // only with --replay-benchmark
     bool                                is_p2p_enabled = true;
     std::atomic<uint32_t>               peer_count = {0};
 
@@ -266,6 +295,11 @@ class chain_plugin_impl
 
     appbase::application& theApp;
 
+    // exported with performance_metrics; updated by writer, so reading them never waits for chainbase lock
+    performance_metrics::gauge&         write_queue_depth_metric;
+    performance_metrics::gauge&         free_memory_metric;
+    performance_metrics::histogram_id   write_queue_wait_metric_id;
+
   private:
     bool _push_block( const block_flow_control& block_ctrl );
 
@@ -471,6 +505,7 @@ void chain_plugin_impl::start_write_processing()
       fc::time_point last_popped_item_time = fc::time_point::now();
       fc::time_point last_msg_time = last_popped_item_time;
       fc::time_point wait_start_time = last_popped_item_time;
+      fc::time_point last_mapping_statistics_time = last_popped_item_time;
 
       theApp.notify_status("syncing");
       while (true)
@@ -516,8 +551,7 @@ void chain_plugin_impl::start_write_processing()
           if (wait_timed_out) // we timed out, restart the while loop to print a "No P2P data" message
             continue;
           // otherwise, we woke because the write_queue is non-empty
-          cxt = write_queue.front();
-          write_queue.pop();
+          cxt = dequeue_write_request();
         }
 
         cumulative_time_waiting_for_work += fc::time_point::now() - wait_start_time;
@@ -590,18 +624,26 @@ void chain_plugin_impl::start_write_processing()
                           ("per_block", write_queue_processed_duration.count() / write_queue_items_processed));
                 break;
               }
-              cxt = write_queue.front();
-              write_queue.pop();
+              cxt = dequeue_write_request();
             }
 
             last_popped_item_time = fc::time_point::now();
           } // while items in write_queue and time limit not exceeded for live sync
           head_block_time = db.head_block_time();
+          free_memory_metric.set( db.get_free_memory() );
+          // residency of shared memory file (reported by lockless node status API) is sampled only from time to time
+          if( last_popped_item_time - last_mapping_statistics_time > fc::seconds( 10 ) )
+          {
+            db.refresh_mapping_statistics();
+            last_mapping_statistics_time = last_popped_item_time;
+          }
         }); // with_write_lock
 
         if (is_syncing && fc::time_point::now() - head_block_time < fc::minutes(1)) //we're syncing, see if we are close enough to move to live sync
         {
           is_syncing = false;
+          // comments created during sync (replay) filled reservation made when state was loaded
+          db.with_write_lock( [&]() { db.reserve_hashed_index_buckets(); } );
           db.notify_end_of_syncing();
           default_block_writer.set_is_at_live_sync();
           theApp.notify_status("entering live mode");
@@ -657,6 +699,27 @@ void chain_plugin_impl::start_write_processing()
   });
 }
 
+void chain_plugin_impl::enqueue_write_request( write_context* cxt )
+{
+  cxt->enqueued_time = fc::time_point::now();
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    write_queue.push(cxt);
+    write_queue_depth_metric.set( write_queue.size() );
+  }
+  queue_condition_variable.notify_one();
+}
+
+write_context* chain_plugin_impl::dequeue_write_request()
+{
+  write_context* cxt = write_queue.front();
+  write_queue.pop();
+  write_queue_depth_metric.set( write_queue.size() );
+  if( performance_metrics::instance().is_enabled() )
+    performance_metrics::instance().record( write_queue_wait_metric_id, ( fc::time_point::now() - cxt->enqueued_time ).count() * 1000 );
+  return cxt;
+}
+
 void chain_plugin_impl::stop_write_processing()
 {
   theApp.notify_status("finished syncing");
@@ -715,7 +778,10 @@ bool chain_plugin_impl::start_replay_processing( hive::chain::blockchain_worker_
 
 void chain_plugin_impl::initial_settings()
 {
-  db.set_block_writer( &( default_block_writer ) );
+  if( readonly )
+    db.set_block_writer( &replica_writer );
+  else
+    db.set_block_writer( &( default_block_writer ) );
 
   if( statsd_on_replay )
   {
@@ -748,7 +814,8 @@ void chain_plugin_impl::initial_settings()
     {
       auto info = idx->get_statistics(onlyStaticInfo);
       index_memory_details_cntr.emplace_back(std::move(info._value_type_name), info._item_count,
-        info._item_sizeof, info._item_additional_allocation, info._additional_container_allocation);
+        info._item_sizeof, info._item_additional_allocation, info._additional_container_allocation,
+        info._node_pool_reserved, info._node_pool_free);
     }
   };
 
@@ -759,12 +826,17 @@ void chain_plugin_impl::initial_settings()
   db_open_args.shared_file_size = shared_memory_size;
   db_open_args.shared_file_full_threshold = shared_file_full_threshold;
   db_open_args.shared_file_scale_rate = shared_file_scale_rate;
+  db_open_args.shared_file_mapping = shared_file_mapping;
   db_open_args.chainbase_flags = chainbase_flags;
+  db_open_args.max_replica_reader_wait = max_replica_reader_wait;
   db_open_args.do_validate_invariants = validate_invariants;
+  db_open_args.validate_invariants_per_block = validate_invariants_per_block;
+  db_open_args.full_invariants_validation_interval = full_invariants_validation_interval;
   db_open_args.stop_replay_at = stop_replay_at;
   db_open_args.exit_after_replay = exit_after_replay;
   db_open_args.force_replay = force_replay;
   db_open_args.validate_during_replay = validate_during_replay;
+  db_open_args.compact_shared_file = compact_shared_file;
   db_open_args.benchmark_is_enabled = benchmark_is_enabled;
   db_open_args.database_cfg = database_config;
   db_open_args.replay_in_memory = replay_in_memory;
@@ -772,6 +844,8 @@ void chain_plugin_impl::initial_settings()
   db_open_args.enable_block_log_compression = enable_block_log_compression;
   db_open_args.enable_block_log_auto_fixing = enable_block_log_auto_fixing;
   db_open_args.block_log_compression_level = block_log_compression_level;
+  db_open_args.comment_cashout_threads = comment_cashout_threads;
+  db_open_args.worker_thread_pool = &thread_pool;
   db_open_args.load_snapshot = load_snapshot;
 }
 
@@ -811,6 +885,13 @@ void chain_plugin_impl::open()
   {
     ilog("Opening shared memory from ${path}", ("path",shared_memory_dir.generic_string()));
 
+    if( readonly )
+    {
+      db.open( db_open_args );
+      replica_writer.open( db_open_args.data_dir / "block_log", thread_pool );
+      return;
+    }
+
     default_block_writer.open(  db_open_args.data_dir / "block_log",
                                 db_open_args.enable_block_log_compression,
                                 db_open_args.block_log_compression_level,
@@ -1139,12 +1220,21 @@ uint32_t chain_plugin_impl::reindex_internal( const open_args& args,
            ("free_memory_megabytes", db.get_free_memory() >> 20));
     }
 
+    if( replay_benchmark_collector )
+      replay_benchmark_collector->on_block_start();
+
     db.apply_block(full_block, skip_flags);
     last_applied_block = full_block;
 
+    if( replay_benchmark_collector )
+      replay_benchmark_collector->on_block_end( *full_block );
+
     return !theApp.is_interrupt_request();
   };
 
+  if( replay_benchmark_collector )
+    replay_benchmark_collector->start();
+
   const uint32_t start_block_number = start_block->get_block_num();
   process_block(start_block);
 
@@ -1158,6 +1248,9 @@ uint32_t chain_plugin_impl::reindex_internal( const open_args& args,
   fc::enable_record_assert_trip = rat; //restore flag
   fc::enable_assert_stacktrace = as;
 
+  if( replay_benchmark_collector )
+    replay_benchmark_collector->finish( db );
+
   return last_applied_block->get_block_num();
 }
 
@@ -1253,6 +1346,49 @@ void chain_plugin_impl::work( synchronization_type& on_sync )
   start_write_processing();
 }
 
+void chain_plugin_impl::start_replica_processing( synchronization_type& on_sync )
+{
+  ilog( "Read replica started on blockchain with ${n} blocks, LIB: ${lb}, blocks in block log: ${b}",
+    ( "n", db.head_block_num() )( "lb", db.get_last_irreversible_block_num() )( "b", replica_writer.get_block_reader().head_block_num() ) );
+
+  on_sync();
+
+  replica_refresh_thread = std::thread( [this]()
+  {
+    fc::set_thread_name( "replica" );
+    std::unique_lock<std::mutex> lock( queue_mutex );
+    while( running )
+    {
+      queue_condition_variable.wait_for( lock, std::chrono::milliseconds( replica_refresh_interval ) );
+      if( !running )
+        break;
+      lock.unlock();
+      try
+      {
+        const uint32_t last_irreversible_block = db.with_read_lock( [&]() { return db.get_last_irreversible_block_num(); } );
+        replica_writer.refresh( last_irreversible_block, thread_pool );
+      }
+      catch( const fc::exception& e )
+      {
+        elog( "Error while following writer of read replica: ${e}", ( "e", e.to_detail_string() ) );
+      }
+      lock.lock();
+    }
+  } );
+}
+
+void chain_plugin_impl::stop_replica_processing()
+{
+  if( !replica_refresh_thread.joinable() )
+    return;
+  {
+    std::unique_lock<std::mutex> lock( queue_mutex );
+    running = false;
+  }
+  queue_condition_variable.notify_all();
+  replica_refresh_thread.join();
+}
+
 void chain_plugin_impl::write_default_database_config( bfs::path &p )
 {
   ilog( "writing database configuration: ${p}", ("p", p.string()) );
@@ -1297,6 +1433,8 @@ const block_read_i& chain_plugin::block_reader() const
 {
   // When other plugins are able to call this method, replay is complete (if required)
   // and default syncing block writer is being used.
+  if( my->readonly )
+    return my->replica_writer.get_block_reader();
   return my->default_block_writer.get_block_reader();
 }
 
@@ -1326,6 +1464,20 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
         "A 2 precision percentage (0-10000) that defines the threshold for when to autoscale the shared memory file. Setting this to 0 disables autoscaling. Recommended value for consensus node is 9500 (95%)." )
       ("shared-file-scale-rate", bpo::value<uint16_t>()->default_value(0),
         "A 2 precision percentage (0-10000) that defines how quickly to scale the shared memory file. When autoscaling occurs the file's size will be increased by this percent. Setting this to 0 disables autoscaling. Recommended value is between 1000-2000 (10-20%)" )
+      ("shared-file-huge-pages", bpo::bool_switch()->default_value(false),
+        "Advise kernel to back shared memory file with transparent huge pages (works when shared-file-dir is on tmpfs mounted with huge=advise; on hugetlbfs mount file always uses huge pages)" )
+      ("shared-file-prefault-threads", bpo::value<uint32_t>()->default_value(0)->value_name("threads"),
+        "Number of threads reading all pages of shared memory file at startup to prefault it. 0 disables prefault" )
+      ("shared-file-numa-policy", bpo::value<string>()->default_value("default"),
+        "NUMA placement of shared memory file pages: default, interleave or bind (to nodes given in shared-file-numa-nodes)" )
+      ("shared-file-numa-nodes", bpo::value<string>()->default_value(""),
+        "List of NUMA nodes for shared-file-numa-policy, f.e. 0-1 or 0,2. Empty list with interleave policy means all nodes" )
+      ("allow-read-replicas", bpo::value<bool>()->default_value(false),
+        "Let other hived processes started with --read-replica serve API calls from shared memory file of this node (they share its lock, but not the one of local API threads)" )
+      ("max-read-replica-wait", bpo::value<uint32_t>()->default_value(100)->value_name("ms"),
+        "How long node allowing read replicas waits for their API calls to finish before it changes state. Replica still reading after that time is terminated" )
+      ("read-replica-refresh-interval", bpo::value<uint32_t>()->default_value(500)->value_name("ms"),
+        "How often read replica checks for new irreversible blocks in block log of its writer" )
       ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
       ("flush-state-interval", bpo::value<uint32_t>(),
         "flush shared memory changes to disk every N blocks")
@@ -1333,6 +1485,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
       ("enable-block-log-auto-fixing", boost::program_options::value<bool>()->default_value(true), "If enabled, corrupted block_log will try to fix itself automatically." )
       ("block-log-compression-level", bpo::value<int>()->default_value(15), "Block log zstd compression level 0 (fast, low compression) - 22 (slow, high compression)" )
       ("blockchain-thread-pool-size", bpo::value<uint32_t>()->default_value(8)->value_name("size"), "Number of worker threads used to pre-validate transactions and blocks")
+      ("comment-cashout-threads", bpo::value<uint32_t>()->default_value(0)->value_name("threads"), "Number of threads (including workers of blockchain thread pool) used to compute comment payouts in blocks with many payouts. 0 or 1 means serial processing")
+      ("enable-performance-metrics", bpo::value<bool>()->default_value(true), "Collect latency histograms of evaluators, block processing phases and plugin handlers (exported by statsd and webserver /metrics)" )
       ("block-stats-report-type", bpo::value<string>()->default_value("FULL"), "Level of detail of block stat reports: NONE, MINIMAL, REGULAR, FULL. Default FULL (recommended for API nodes)." )
       ("block-stats-report-output", bpo::value<string>()->default_value("ILOG"), "Where to put block stat reports: DLOG, ILOG, NOTIFY, LOG_NOTIFY. Default ILOG." )
 #ifdef USE_ALTERNATE_CHAIN_ID
@@ -1351,11 +1505,17 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
       ("exit-before-sync", bpo::bool_switch()->default_value(false), "Exits before starting sync, handy for dumping snapshot without starting replay")
       ("force-replay", bpo::bool_switch()->default_value(false), "Before replaying clean all old files. If specifed, `--replay-blockchain` flag is implied")
       ("validate-during-replay", bpo::bool_switch()->default_value(false), "Runs all validations that are normally turned off during replay")
+      ("compact-shared-file", bpo::bool_switch()->default_value(false), "Rebuild shared memory file at startup (objects in id order) to reclaim space lost to fragmentation. Copies whole state, so it takes a while and needs free disk space for used part of the file")
+      ("read-replica", bpo::bool_switch()->default_value(false), "Open shared memory file and block log of node running with allow-read-replicas in the same shared-file-dir and data dir read-only, and serve API calls from its state without processing blocks or transactions")
       ("advanced-benchmark", "Make profiling for every plugin.")
       ("set-benchmark-interval", bpo::value<uint32_t>(), "Print time and memory usage every given number of blocks")
       ("dump-memory-details", bpo::bool_switch()->default_value(false), "Dump database objects memory usage info. Use set-benchmark-interval to set dump interval.")
+      ("replay-benchmark", bpo::value<bfs::path>()->value_name("file"), "Replay blocks (from loaded snapshot, if any, up to --stop-at-block) and write throughput and phase timing report in JSON form to given file, then exit. Implies --replay-blockchain")
+      ("replay-benchmark-window", bpo::value<uint32_t>()->default_value(1000000)->value_name("blocks"), "Number of blocks in single window of --replay-benchmark report")
       ("check-locks", bpo::bool_switch()->default_value(false), "Check correctness of chainbase locking" )
       ("validate-database-invariants", bpo::bool_switch()->default_value(false), "Validate all supply invariants check out" )
+      ("validate-database-invariants-per-block", bpo::bool_switch()->default_value(false), "Validate supply invariants after each applied block, looking only at objects changed by that block (not possible during replay)" )
+      ("validate-database-invariants-interval", bpo::value<uint32_t>()->default_value(0), "With --validate-database-invariants-per-block, every given number of blocks scan all objects instead. 0 means never" )
 #ifdef USE_ALTERNATE_CHAIN_ID
       ("chain-id", bpo::value< std::string >()->default_value( HIVE_CHAIN_ID ), "chain ID to connect to")
       ("skeleton-key", bpo::value< std::string >()->default_value(default_skeleton_privkey), "WIF PRIVATE key to be used as skeleton key for all accounts")
@@ -1388,9 +1548,27 @@ void chain_plugin::plugin_initialize(const variables_map& options)
   if( options.count( "shared-file-scale-rate" ) )
     my->shared_file_scale_rate = options.at( "shared-file-scale-rate" ).as< uint16_t >();
 
+  my->shared_file_mapping.huge_pages = options.at( "shared-file-huge-pages" ).as< bool >();
+  my->shared_file_mapping.prefault_threads = options.at( "shared-file-prefault-threads" ).as< uint32_t >();
+  {
+    const std::string numa_policy = options.at( "shared-file-numa-policy" ).as< string >();
+    if( numa_policy == "interleave" )
+      my->shared_file_mapping.numa_policy = chainbase::mapping_options::numa_policy_type::interleave;
+    else if( numa_policy == "bind" )
+      my->shared_file_mapping.numa_policy = chainbase::mapping_options::numa_policy_type::bind;
+    else
+      FC_ASSERT( numa_policy == "default", "Unknown shared-file-numa-policy: ${p}", ( "p", numa_policy ) );
+    my->shared_file_mapping.numa_nodes =
+      chainbase::memory_mapping::parse_node_list( options.at( "shared-file-numa-nodes" ).as< string >() );
+    FC_ASSERT( numa_policy != "bind" || !my->shared_file_mapping.numa_nodes.empty(),
+      "shared-file-numa-policy = bind requires shared-file-numa-nodes" );
+  }
+
   my->force_replay        = options.count( "force-replay" ) ? options.at( "force-replay" ).as<bool>() : false;
   my->validate_during_replay =
     options.count( "validate-during-replay" ) ? options.at( "validate-during-replay" ).as<bool>() : false;
+  my->compact_shared_file =
+    options.count( "compact-shared-file" ) ? options.at( "compact-shared-file" ).as<bool>() : false;
   my->replay              = options.at( "replay-blockchain").as<bool>() || my->force_replay;
   my->resync              = options.at( "resync-blockchain").as<bool>();
   my->stop_replay_at      = options.count( "stop-replay-at-block" ) ? options.at( "stop-replay-at-block" ).as<uint32_t>() : 0;
@@ -1401,10 +1579,16 @@ void chain_plugin::plugin_initialize(const variables_map& options)
     options.count( "set-benchmark-interval" ) ? options.at( "set-benchmark-interval" ).as<uint32_t>() : 0;
   my->check_locks         = options.at( "check-locks" ).as< bool >();
   my->validate_invariants = options.at( "validate-database-invariants" ).as<bool>();
+  my->validate_invariants_per_block = options.at( "validate-database-invariants-per-block" ).as<bool>();
+  my->full_invariants_validation_interval = options.at( "validate-database-invariants-interval" ).as<uint32_t>();
   my->dump_memory_details = options.at( "dump-memory-details" ).as<bool>();
   my->enable_block_log_compression = options.at( "enable-block-log-compression" ).as<bool>();
   my->enable_block_log_auto_fixing = options.at( "enable-block-log-auto-fixing" ).as<bool>();
   my->block_log_compression_level = options.at( "block-log-compression-level" ).as<int>();
+  my->comment_cashout_threads = options.at( "comment-cashout-threads" ).as<uint32_t>();
+  hive::utilities::performance_metrics::instance().set_enabled( options.at( "enable-performance-metrics" ).as<bool>() );
+  performance_metrics::instance().describe_family( "write_queue", "Requests (blocks and transactions) waiting for write processing thread" );
+  performance_metrics::instance().describe_family( "chainbase", "State of shared memory file" );
 
   FC_ASSERT(!(my->stop_replay_at && my->stop_at_block), "--stop-replay-at and --stop-at-block cannot be used together" );
   FC_ASSERT(!(my->stop_replay_at && my->exit_at_block), "--stop-replay-at and --exit-at-block cannot be used together" );
@@ -1450,6 +1634,34 @@ void chain_plugin::plugin_initialize(const variables_map& options)
   this->my->setup_benchmark_dumper();
   my->benchmark_is_enabled = (options.count( "advanced-benchmark" ) != 0);
 
+  if( options.count( "replay-benchmark" ) )
+  {
+    bfs::path report_file = options.at( "replay-benchmark" ).as< bfs::path >();
+    if( report_file.is_relative() )
+      report_file = get_app().data_dir() / report_file;
+    const std::string snapshot = options.count( "load-snapshot" ) ? options.at( "load-snapshot" ).as< std::string >() : std::string();
+    my->replay_benchmark_collector = std::make_unique< replay_benchmark >( report_file.string(),
+      options.at( "replay-benchmark-window" ).as< uint32_t >(), snapshot, my->validate_during_replay );
+    // benchmark covers replay only, node must not continue with regular work
+    my->replay = true;
+    my->exit_after_replay = true;
+  }
+
+  my->readonly = options.at( "read-replica" ).as< bool >();
+  if( my->readonly )
+  {
+    FC_ASSERT( !my->replay && !my->resync && !my->load_snapshot && !my->compact_shared_file,
+      "--read-replica can't be combined with options that modify state or block log" );
+    my->chainbase_flags |= chainbase::database::read_only;
+    my->replica_refresh_interval = options.at( "read-replica-refresh-interval" ).as< uint32_t >();
+    my->is_p2p_enabled = false;
+  }
+  else if( options.at( "allow-read-replicas" ).as< bool >() )
+  {
+    my->chainbase_flags |= chainbase::database::allow_replicas;
+    my->max_replica_reader_wait = options.at( "max-read-replica-wait" ).as< uint32_t >();
+  }
+
   if( options.count( "statsd-record-on-replay" ) )
   {
     my->statsd_on_replay = options.at( "statsd-record-on-replay" ).as< bool >();
@@ -1652,7 +1864,12 @@ void chain_plugin::plugin_startup()
 
   my->prepare_work( get_state() == appbase::abstract_plugin::started, on_sync );
 
-  if( my->replay )
+  if( my->readonly )
+  {
+    ilog("Following writer as read replica...");
+    my->start_replica_processing( on_sync );
+  }
+  else if( my->replay )
   {
     ilog("Replaying...");
     if( !my->start_replay_processing( get_thread_pool() ) )
@@ -1700,9 +1917,11 @@ void chain_plugin::plugin_shutdown()
 {
   ilog("closing chain database");
   get_thread_pool().shutdown();
+  my->stop_replica_processing();
   my->stop_write_processing();
   my->db.close();
   my->default_block_writer.close();
+  my->replica_writer.close();
   ilog("database closed successfully");
   get_app().notify_status("finished syncing");
 }
@@ -1772,11 +1991,7 @@ bool chain_plugin::accept_block( const std::shared_ptr< p2p_block_flow_control >
   fc::promise<void>::ptr accept_block_promise(new fc::promise<void>("accept_block"));
   fc::future<void> accept_block_future(accept_block_promise);
   block_ctrl->attach_promise( accept_block_promise );
-  {
-    std::unique_lock<std::mutex> lock(my->queue_mutex);
-    my->write_queue.push(&cxt);
-  }
-  my->queue_condition_variable.notify_one();
+  my->enqueue_write_request(&cxt);
   accept_block_future.wait();
 
   block_ctrl->rethrow_if_exception();
@@ -1786,6 +2001,7 @@ bool chain_plugin::accept_block( const std::shared_ptr< p2p_block_flow_control >
 
 void chain_plugin::accept_transaction( const std::shared_ptr<full_transaction_type>& full_transaction, const lock_type lock /* = lock_type::boost */  )
 {
+  FC_ASSERT( !my->readonly, "Read replica does not accept transactions - send them to its writer" );
   transaction_flow_control tx_ctrl( full_transaction );
   write_context cxt;
   cxt.req_ptr = &tx_ctrl;
@@ -1802,11 +2018,7 @@ void chain_plugin::accept_transaction( const std::shared_ptr<full_transaction_ty
     std::shared_ptr<boost::promise<void>> accept_transaction_promise = std::make_shared<boost::promise<void>>();
     boost::unique_future<void> accept_transaction_future(accept_transaction_promise->get_future());
     tx_ctrl.attach_promise( accept_transaction_promise );
-    {
-      std::unique_lock<std::mutex> lock(my->queue_mutex);
-      my->write_queue.push(&cxt);
-    }
-    my->queue_condition_variable.notify_one();
+    my->enqueue_write_request(&cxt);
     accept_transaction_future.get();
   }
   else
@@ -1815,11 +2027,7 @@ void chain_plugin::accept_transaction( const std::shared_ptr<full_transaction_ty
     fc::promise<void>::ptr accept_transaction_promise(new fc::promise<void>("accept_transaction"));
     fc::future<void> accept_transaction_future(accept_transaction_promise);
     tx_ctrl.attach_promise( accept_transaction_promise );
-    {
-      std::unique_lock<std::mutex> lock(my->queue_mutex);
-      my->write_queue.push(&cxt);
-    }
-    my->queue_condition_variable.notify_one();
+    my->enqueue_write_request(&cxt);
     accept_transaction_future.wait();
   }
 
@@ -1879,11 +2087,7 @@ void chain_plugin::generate_block( const std::shared_ptr< generate_block_flow_co
   boost::unique_future<void> generate_block_future(generate_block_promise->get_future());
   generate_block_ctrl->attach_promise( generate_block_promise );
 
-  {
-    std::unique_lock<std::mutex> lock(my->queue_mutex);
-    my->write_queue.push(&cxt);
-  }
-  my->queue_condition_variable.notify_one();
+  my->enqueue_write_request(&cxt);
 
   generate_block_future.get();
 
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <hive/chain/database.hpp>
+#include <hive/chain/full_block.hpp>
+
+#include <hive/utilities/performance_metrics.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace hive { namespace plugins { namespace chain {
+
+/**
+  * Time spent in particular parts of block processing [s]. Values come from performance_metrics histograms
+  * and are summed over all threads, so parts performed by worker threads (reading and decoding of blocks,
+  * signature recovery) can exceed real time. Wall clock time of replay loop is split into waiting for
+  * next block and block application.
+  */
+struct replay_benchmark_phases
+{
+  double block_log_read = 0.0;
+  double decompression = 0.0;
+  double unpack = 0.0;
+  double signature_recovery = 0.0;
+  double authority_verification = 0.0;
+  double evaluation = 0.0;
+  double plugin_signals = 0.0;
+  double undo = 0.0;
+  /// block phases other than application of transactions (witness schedule, cashouts, etc.)
+  double block_maintenance = 0.0;
+
+  double waiting_for_blocks = 0.0;
+  double block_application = 0.0;
+};
+
+/// throughput within range of blocks
+struct replay_benchmark_window
+{
+  uint32_t                first_block = 0;
+  uint32_t                last_block = 0;
+  uint32_t                blocks = 0;
+  uint64_t                transactions = 0;
+  uint64_t                operations = 0;
+  double                  real_seconds = 0.0;
+  double                  blocks_per_second = 0.0;
+  double                  transactions_per_second = 0.0;
+  double                  operations_per_second = 0.0;
+  replay_benchmark_phases phases;
+};
+
+struct replay_benchmark_memory
+{
+  uint64_t peak_rss_kb = 0;
+  uint64_t current_rss_kb = 0;
+  uint64_t shared_memory_size = 0;
+  uint64_t shared_memory_used = 0;
+  uint64_t shared_memory_free = 0;
+};
+
+struct replay_benchmark_report
+{
+  std::string                             snapshot;
+  bool                                    validate_during_replay = false;
+  uint32_t                                window_size = 0;
+  std::vector< replay_benchmark_window >  windows;
+  replay_benchmark_window                 total;
+  replay_benchmark_memory                 memory;
+};
+
+/**
+  * Collects data for --replay-benchmark. Windows are aligned to multiples of window size (in block numbers),
+  * so runs of the same range can be compared window by window; first and last window can be partial.
+  * Report is written in JSON form when replay finishes.
+  */
+class replay_benchmark
+{
+  public:
+    replay_benchmark( const std::string& output_file, uint32_t window_size, const std::string& snapshot,
+      bool validate_during_replay );
+
+    /// called before first block of replay is processed
+    void start();
+    /// called right before given block is applied (ends waiting for the block)
+    void on_block_start();
+    /// called after given block was applied
+    void on_block_end( const hive::chain::full_block_type& full_block );
+    /// closes last window and writes report
+    void finish( const hive::chain::database& db );
+
+    const replay_benchmark_report& get_report() const { return _report; }
+
+  private:
+    typedef std::chrono::steady_clock clock_type;
+
+    void close_window();
+
+    std::string                                              _output_file;
+    replay_benchmark_report                                  _report;
+
+    replay_benchmark_window                                  _current;
+    hive::utilities::performance_metrics::snapshot_t         _window_start_metrics;
+    hive::utilities::performance_metrics::snapshot_t         _start_metrics;
+    clock_type::time_point                                   _window_start_time;
+    clock_type::time_point                                   _start_time;
+    clock_type::time_point                                   _last_block_end;
+    clock_type::time_point                                   _block_start;
+    double                                                   _waiting = 0.0;
+    double                                                   _applying = 0.0;
+};
+
+} } } // hive::plugins::chain
+
+FC_REFLECT( hive::plugins::chain::replay_benchmark_phases,
+  (block_log_read)(decompression)(unpack)(signature_recovery)(authority_verification)(evaluation)
+  (plugin_signals)(undo)(block_maintenance)(waiting_for_blocks)(block_application) )
+FC_REFLECT( hive::plugins::chain::replay_benchmark_window,
+  (first_block)(last_block)(blocks)(transactions)(operations)(real_seconds)
+  (blocks_per_second)(transactions_per_second)(operations_per_second)(phases) )
+FC_REFLECT( hive::plugins::chain::replay_benchmark_memory,
+  (peak_rss_kb)(current_rss_kb)(shared_memory_size)(shared_memory_used)(shared_memory_free) )
+FC_REFLECT( hive::plugins::chain::replay_benchmark_report,
+  (snapshot)(validate_during_replay)(window_size)(windows)(total)(memory) )
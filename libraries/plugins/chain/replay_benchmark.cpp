@@ -0,0 +1,192 @@
+#include <hive/plugins/chain/replay_benchmark.hpp>
+
+#include <hive/utilities/benchmark_dumper.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/reflect/variant.hpp>
+
+namespace hive { namespace plugins { namespace chain {
+
+using hive::utilities::performance_metrics;
+using hive::utilities::histogram_snapshot;
+
+namespace
+{
+  double to_seconds( std::chrono::steady_clock::duration d )
+  {
+    return std::chrono::duration< double >( d ).count();
+  }
+
+  /// adds time recorded in performance_metrics between given snapshots to matching phases
+  void add_phases( replay_benchmark_phases& phases, const performance_metrics::snapshot_t& current,
+    const performance_metrics::snapshot_t& start )
+  {
+    for( const auto& entry : current )
+    {
+      histogram_snapshot data = entry.second;
+      auto older = start.find( entry.first );
+      if( older != start.end() )
+        data = data - older->second;
+      const double seconds = double( data.sum_ns ) / 1e9;
+
+      const std::string& family = entry.first.family;
+      const std::string& name = entry.first.name;
+      if( family == "block_decoding" )
+      {
+        if( name == "read_block" )
+          phases.block_log_read += seconds;
+        else if( name == "decompress" )
+          phases.decompression += seconds;
+        else if( name == "unpack" )
+          phases.unpack += seconds;
+        else if( name == "recover_signature_keys" )
+          phases.signature_recovery += seconds;
+      }
+      else if( family == "evaluator" )
+      {
+        phases.evaluation += seconds;
+      }
+      else if( family == "plugin_handler" )
+      {
+        phases.plugin_signals += seconds;
+      }
+      else if( family == "block_phase" )
+      {
+        if( name == "verify_authority" )
+          phases.authority_verification += seconds;
+        else if( name.compare( 0, 5, "undo_" ) == 0 )
+          phases.undo += seconds;
+        else if( name != "apply_transactions" ) // covers evaluators, authority verification and operation handlers
+          phases.block_maintenance += seconds;
+      }
+    }
+  }
+
+  void compute_rates( replay_benchmark_window& window )
+  {
+    if( window.real_seconds <= 0.0 )
+      return;
+    window.blocks_per_second = window.blocks / window.real_seconds;
+    window.transactions_per_second = window.transactions / window.real_seconds;
+    window.operations_per_second = window.operations / window.real_seconds;
+  }
+}
+
+replay_benchmark::replay_benchmark( const std::string& output_file, uint32_t window_size, const std::string& snapshot,
+  bool validate_during_replay )
+  : _output_file( output_file )
+{
+  FC_ASSERT( window_size > 0, "Replay benchmark window has to contain at least one block" );
+  _report.window_size = window_size;
+  _report.snapshot = snapshot;
+  _report.validate_during_replay = validate_during_replay;
+}
+
+void replay_benchmark::start()
+{
+  performance_metrics::instance().set_enabled( true );
+  _start_metrics = _window_start_metrics = performance_metrics::instance().collect();
+  _start_time = _window_start_time = _last_block_end = clock_type::now();
+}
+
+void replay_benchmark::on_block_start()
+{
+  _block_start = clock_type::now();
+  _waiting += to_seconds( _block_start - _last_block_end );
+}
+
+void replay_benchmark::on_block_end( const hive::chain::full_block_type& full_block )
+{
+  _last_block_end = clock_type::now();
+  _applying += to_seconds( _last_block_end - _block_start );
+
+  const uint32_t block_num = full_block.get_block_num();
+  const auto& transactions = full_block.get_block().transactions;
+
+  if( _current.blocks == 0 )
+    _current.first_block = block_num;
+  _current.last_block = block_num;
+  ++_current.blocks;
+  _current.transactions += transactions.size();
+  for( const auto& trx : transactions )
+    _current.operations += trx.operations.size();
+
+  if( block_num % _report.window_size == 0 )
+    close_window();
+}
+
+void replay_benchmark::close_window()
+{
+  if( _current.blocks == 0 )
+    return;
+
+  const auto now = clock_type::now();
+  performance_metrics::snapshot_t metrics = performance_metrics::instance().collect();
+
+  _current.real_seconds = to_seconds( now - _window_start_time );
+  compute_rates( _current );
+  add_phases( _current.phases, metrics, _window_start_metrics );
+  _current.phases.waiting_for_blocks = _waiting;
+  _current.phases.block_application = _applying;
+
+  ilog( "Replay benchmark: blocks ${f}-${l}: ${bps} blocks/s, ${tps} tx/s, ${ops} ops/s",
+    ( "f", _current.first_block )( "l", _current.last_block )
+    ( "bps", uint64_t( _current.blocks_per_second ) )( "tps", uint64_t( _current.transactions_per_second ) )
+    ( "ops", uint64_t( _current.operations_per_second ) ) );
+
+  replay_benchmark_window& total = _report.total;
+  if( total.blocks == 0 )
+    total.first_block = _current.first_block;
+  total.last_block = _current.last_block;
+  total.blocks += _current.blocks;
+  total.transactions += _current.transactions;
+  total.operations += _current.operations;
+  total.phases.waiting_for_blocks += _waiting;
+  total.phases.block_application += _applying;
+
+  _report.windows.emplace_back( std::move( _current ) );
+  _current = replay_benchmark_window();
+  _window_start_metrics = std::move( metrics );
+  _window_start_time = now;
+  _waiting = 0.0;
+  _applying = 0.0;
+}
+
+void replay_benchmark::finish( const hive::chain::database& db )
+{
+  close_window();
+
+  replay_benchmark_window& total = _report.total;
+  total.real_seconds = to_seconds( clock_type::now() - _start_time );
+  compute_rates( total );
+  const double waiting = total.phases.waiting_for_blocks;
+  const double applying = total.phases.block_application;
+  total.phases = replay_benchmark_phases();
+  add_phases( total.phases, performance_metrics::instance().collect(), _start_metrics );
+  total.phases.waiting_for_blocks = waiting;
+  total.phases.block_application = applying;
+
+  replay_benchmark_memory& memory = _report.memory;
+  hive::utilities::benchmark_dumper::read_resident_mem( &memory.current_rss_kb, &memory.peak_rss_kb );
+  memory.shared_memory_size = db.get_max_memory();
+  memory.shared_memory_free = db.get_free_memory();
+  memory.shared_memory_used = memory.shared_memory_size - memory.shared_memory_free;
+
+  ilog( "Replay benchmark: ${b} blocks in ${s} s (${bps} blocks/s, ${tps} tx/s, ${ops} ops/s), peak RSS ${rss} kB",
+    ( "b", total.blocks )( "s", total.real_seconds )( "bps", uint64_t( total.blocks_per_second ) )
+    ( "tps", uint64_t( total.transactions_per_second ) )( "ops", uint64_t( total.operations_per_second ) )
+    ( "rss", memory.peak_rss_kb ) );
+
+  try
+  {
+    fc::json::save_to_file( _report, fc::path( _output_file ) );
+    ilog( "Replay benchmark report written to ${f}", ( "f", _output_file ) );
+  }
+  catch( const fc::exception& e )
+  {
+    elog( "error writing replay benchmark report to file ${f}: ${e}", ( "f", _output_file )( "e", e.to_detail_string() ) );
+  }
+}
+
+} } } // hive::plugins::chain
@@ -14,6 +14,7 @@ using namespace hive::protocol;
 
 using chain::database;
 using chain::operation_notification;
+using chain::async_block_notification;
 
 namespace detail {
 
@@ -36,10 +37,13 @@ class comment_cashout_logging_plugin_impl
       }
 
       void on_pre_apply_operation( const operation_notification& note );
-      std::string make_file_name(bool &changed);
+      void on_async_post_apply_block( const async_block_notification& note );
+      void log_operation( const operation& op, uint64_t block_no );
+      std::string make_file_name(uint64_t block_no, bool &changed);
 
       database&                        _db;
       boost::signals2::connection      _pre_apply_operation_conn;
+      boost::signals2::connection      _async_post_apply_block_conn;
 
       optional<uint64_t> _starting_block;
       optional<uint64_t> _ending_block;
@@ -52,10 +56,9 @@ class comment_cashout_logging_plugin_impl
 
 };
 
-std::string comment_cashout_logging_plugin_impl::make_file_name(bool &changed)
+std::string comment_cashout_logging_plugin_impl::make_file_name(uint64_t block_no, bool &changed)
 {
   changed = false;
-  const uint64_t block_no = _db.head_block_num();
 
   const uint64_t i = block_no / BLOCK_INTERVAL;
   const uint64_t last_starting_block = i * BLOCK_INTERVAL;
@@ -118,11 +121,11 @@ std::string asset_to_string(asset a)
 
 struct operation_visitor
 {
-  operation_visitor( database& db, std::ofstream &log_file) :_db(db), _log_file(log_file) {}
+  operation_visitor( uint64_t block_no, std::ofstream &log_file) :_block_no(block_no), _log_file(log_file) {}
 
   typedef void result_type;
 
-  database& _db;
+  uint64_t _block_no;
   std::ofstream& _log_file;
 
   template<typename T>
@@ -133,7 +136,7 @@ struct operation_visitor
   void operator()(const claim_reward_balance_operation& op) const
   {
     _log_file << "claim_reward_balance_operation" << ";"
-       << _db.head_block_num() << ";" 
+       << _block_no << ";" 
        << static_cast<std::string>(op.account) << ";" 
        << asset_to_string(op.reward_hive) << ";" 
        << asset_to_string(op.reward_hbd) << ";" 
@@ -143,7 +146,7 @@ struct operation_visitor
   void operator()(const author_reward_operation &op) const
   {
     _log_file << "author_reward_operation" << ";" 
-      << _db.head_block_num() << ";" 
+      << _block_no << ";" 
       << static_cast<std::string>(op.author) << ";"
       << op.permlink << ";" 
       << asset_to_string(op.hbd_payout) << ";" 
@@ -155,7 +158,7 @@ struct operation_visitor
   void operator()(const curation_reward_operation& op) const
   {
     _log_file << "curation_reward_operation" << ";" 
-      << _db.head_block_num() << ";"
+      << _block_no << ";"
       << static_cast<std::string>(op.curator) << ";"
       << asset_to_string(op.reward) << ";"
       << static_cast<std::string>(op.author) << ";"
@@ -166,7 +169,7 @@ struct operation_visitor
   void operator()(const comment_reward_operation& op) const
   {
     _log_file << "comment_reward_operation" << ";" 
-      << _db.head_block_num() << ";" 
+      << _block_no << ";" 
       << static_cast<std::string>(op.author) << ";" 
       << op.permlink << ";"
       << asset_to_string(op.payout)
@@ -176,7 +179,7 @@ struct operation_visitor
   void operator()(const comment_benefactor_reward_operation& op) const
   {
     _log_file << "comment_benefactor_reward_operation" << ";" 
-      << _db.head_block_num() << ";" 
+      << _block_no << ";" 
       << static_cast<std::string>(op.benefactor) << ";" 
       << static_cast<std::string>(op.author) << ";" 
       << op.permlink << ";"
@@ -189,19 +192,30 @@ struct operation_visitor
 
 void comment_cashout_logging_plugin_impl::on_pre_apply_operation(const operation_notification& note)
 {
-  
-  const uint64_t block_no = _db.head_block_num();
-  
+  log_operation(note.op, _db.head_block_num());
+}
+
+void comment_cashout_logging_plugin_impl::on_async_post_apply_block(const async_block_notification& note)
+{
+  // head block of the state might be already further, use block number from notification; unlike synchronous
+  // logging (which sees operations as they are applied, including pending transactions) only operations of
+  // blocks that were committed are logged, each once
+  for (const auto& op_note : note.operations)
+    log_operation(op_note.op, note.block_num);
+}
+
+void comment_cashout_logging_plugin_impl::log_operation(const operation& op, uint64_t block_no)
+{
   if (!_log_file.is_open())
   {
     bool changed;
-    const std::string file_name = make_file_name(changed);
+    const std::string file_name = make_file_name(block_no, changed);
     _log_file.open(file_name);
   }
   else
   {
     bool changed;
-    const std::string file_name = make_file_name(changed);
+    const std::string file_name = make_file_name(block_no, changed);
     if (changed)
     {
       _log_file.close();
@@ -213,26 +227,26 @@ void comment_cashout_logging_plugin_impl::on_pre_apply_operation(const operation
   {
     if (block_no >= *_starting_block && block_no <= *_ending_block)
     {
-      note.op.visit(operation_visitor(_db, _log_file));
+      op.visit(operation_visitor(block_no, _log_file));
     }
   }
   else if (_starting_block.valid() && !_ending_block.valid())
   {
     if (block_no >= *_starting_block)
     {
-      note.op.visit(operation_visitor(_db, _log_file));
+      op.visit(operation_visitor(block_no, _log_file));
     }
   }
   else if (!_starting_block.valid() && _ending_block.valid())
   {
     if (block_no <= *_ending_block)
     {
-      note.op.visit(operation_visitor(_db, _log_file));
+      op.visit(operation_visitor(block_no, _log_file));
     }
   }
   else
   {
-    note.op.visit(operation_visitor(_db, _log_file));
+    op.visit(operation_visitor(block_no, _log_file));
   }
 }
 
@@ -247,6 +261,7 @@ void comment_cashout_logging_plugin::set_program_options(options_description& cl
     ("cashout-logging-starting-block", boost::program_options::value<uint64_t>(), "Starting block for comment cashout log")
     ("cashout-logging-ending-block", boost::program_options::value<uint64_t>(), "Ending block for comment cashout log")
     ("cashout-logging-log-path-dir", boost::program_options::value<boost::filesystem::path>(), "Path to log file")
+    ("cashout-logging-async", boost::program_options::value<bool>()->default_value(false), "Write log on separate thread after each block is applied instead of during block processing. Only operations of applied blocks are logged, under number of their block.")
     ;
 }
 
@@ -271,8 +286,16 @@ void comment_cashout_logging_plugin::plugin_initialize( const boost::program_opt
     my = std::make_unique<detail::comment_cashout_logging_plugin_impl>("./", get_app());
   }
 
-  my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler(
-    [&]( const operation_notification& note ){ my->on_pre_apply_operation(note); }, *this, 0 );
+  if (options.at("cashout-logging-async").as<bool>())
+  {
+    my->_async_post_apply_block_conn = my->_db.add_async_post_apply_block_handler(
+      [&]( const async_block_notification& note ){ my->on_async_post_apply_block(note); }, *this );
+  }
+  else
+  {
+    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler(
+      [&]( const operation_notification& note ){ my->on_pre_apply_operation(note); }, *this, 0 );
+  }
 
   if (options.count("cashout-logging-starting-block"))
   {
@@ -289,6 +312,8 @@ void comment_cashout_logging_plugin::plugin_startup() {}
 
 void comment_cashout_logging_plugin::plugin_shutdown()
 {
+   my->_db.flush_async_notifications();
+   chain::util::disconnect_signal( my->_async_post_apply_block_conn );
    chain::util::disconnect_signal( my->_pre_apply_operation_conn );
 }
 
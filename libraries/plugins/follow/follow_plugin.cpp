@@ -357,8 +357,11 @@ void follow_plugin::plugin_initialize( const boost::program_options::variables_m
     // Add the registry to the database so the database can delegate custom ops to the plugin
     my->_db.register_custom_operation_interpreter( _custom_operation_interpreter );
 
-    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->pre_operation( note ); }, *this, 0 );
-    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->post_operation( note ); }, *this, 0 );
+    // only operations handled by pre_operation_visitor/post_operation_visitor
+    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->pre_operation( note ); },
+      chain::database::make_operation_type_set< vote_operation, delete_comment_operation >(), *this, 0 );
+    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->post_operation( note ); },
+      chain::database::make_operation_type_set< custom_json_operation, comment_operation, vote_operation >(), *this, 0 );
     HIVE_ADD_PLUGIN_INDEX(my->_db, follow_index);
     HIVE_ADD_PLUGIN_INDEX(my->_db, feed_index);
     HIVE_ADD_PLUGIN_INDEX(my->_db, blog_index);
@@ -60,6 +60,7 @@
 #define JSON_RPC_NO_PARAMS          (-32001)
 #define JSON_RPC_PARSE_PARAMS_ERROR (-32002)
 #define JSON_RPC_ERROR_DURING_CALL  (-32003)
+#define JSON_RPC_SERVER_BUSY        (-32004)
 
 namespace hive { namespace plugins { namespace json_rpc {
 
@@ -73,6 +74,14 @@ using namespace appbase;
   */
 typedef std::function< fc::variant(const fc::variant&) > api_method;
 
+/**
+  * @brief Shortcut of api method for results that are already serialized (f.e. cached).
+  *
+  * Arguments: same as of api method. Returns JSON of method result, or empty pointer when
+  * method has to be called normally.
+  */
+typedef std::function< std::shared_ptr< const std::string >(const fc::variant&) > api_method_serialized_result;
+
 /**
   * @brief An API, containing APIs and Methods
   *
@@ -93,6 +102,30 @@ namespace detail
   class json_rpc_plugin_impl;
 }
 
+/**
+  * Elements of batch request can be executed concurrently - `post` has to run given task in other thread.
+  * Default value means serial execution in calling thread.
+  */
+struct batch_execution
+{
+  std::function< void( std::function< void() > ) > post;
+  /// max number of threads (including calling one) executing elements of single batch
+  uint32_t max_concurrency = 1;
+};
+
+/**
+  * Called methods and ids of request, found without parsing whole request (see json_rpc_plugin::scan_request).
+  * Has one entry per element of batch; malformed element has empty method and null id.
+  */
+struct request_summary
+{
+  /// full names (api.method) of called methods
+  vector< string >      methods;
+  /// ids of requests (integer or string, null when missing or invalid)
+  vector< fc::variant > ids;
+  bool                  is_batch = false;
+};
+
 class json_rpc_plugin : public appbase::plugin< json_rpc_plugin >
 {
   public:
@@ -112,11 +145,24 @@ class json_rpc_plugin : public appbase::plugin< json_rpc_plugin >
 
     void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
     void add_early_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
-    string call( const string& body );
+    /// registers shortcut consulted before given method is called (has to be done before startup is finished)
+    void add_serialized_result_source( const string& api_name, const string& method_name, const api_method_serialized_result& source );
+    string call( const string& body, const batch_execution& execution = batch_execution() );
+
+    /**
+      * Finds methods and ids of request (single or batch) with light scan of its text - values that are not needed
+      * are skipped without being decoded, so it is cheap enough to be done on I/O thread. Body that is not
+      * well formed gives empty summary (call reports the error).
+      */
+    request_summary scan_request( const string& body )const;
+    /// response with given error for every element of request (used when request is rejected without execution)
+    string make_error_response( const request_summary& request, int32_t code, const string& error_message )const;
 
     void add_serialization_status( const std::function<bool()>& serialization_status );
 
   private:
+    string execute( const fc::variant& message, const batch_execution& execution );
+
     std::unique_ptr< detail::json_rpc_plugin_impl > my;
 };
 
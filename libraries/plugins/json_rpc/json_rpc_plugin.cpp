@@ -5,6 +5,8 @@
 
 #include <hive/protocol/misc_utilities.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/scope_exit.hpp>
 
@@ -15,11 +17,20 @@
 
 #include <chainbase/chainbase.hpp>
 
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
 #define ENABLE_JSON_RPC_LOG
 
 namespace hive { namespace plugins { namespace json_rpc {
 
 using mode_guard = hive::protocol::serialization_mode_controller::mode_guard;
+using hive::utilities::performance_metrics;
 
 namespace detail
 {
@@ -103,8 +114,44 @@ namespace detail
     fc::optional< fc::variant >      result;
     fc::optional< json_rpc_error >   error;
     fc::variant                      id;
+
+    /// JSON of result that came already serialized (used instead of `result`, not reflected)
+    std::shared_ptr< const std::string > serialized_result;
   };
 
+  /// JSON of response - result that came already serialized is inserted as is
+  string to_json( const json_rpc_response& response )
+  {
+    if( !response.serialized_result )
+      return fc::json::to_string( response );
+
+    // same layout as reflected response
+    const string id = fc::json::to_string( response.id );
+    string json;
+    json.reserve( response.jsonrpc.size() + response.serialized_result->size() + id.size() + 32 );
+    json += "{\"jsonrpc\":";
+    json += fc::json::to_string( response.jsonrpc );
+    json += ",\"result\":";
+    json += *response.serialized_result;
+    json += ",\"id\":";
+    json += id;
+    json += '}';
+    return json;
+  }
+
+  string to_json( const vector< json_rpc_response >& responses )
+  {
+    string json( "[" );
+    for( const auto& response : responses )
+    {
+      if( json.size() > 1 )
+        json += ',';
+      json += to_json( response );
+    }
+    json += ']';
+    return json;
+  }
+
   typedef void_type             get_methods_args;
   typedef vector< string >      get_methods_return;
 
@@ -180,6 +227,8 @@ namespace detail
 
       if (error)
         fc::json::save_to_file(response.error, file);
+      else if (response.serialized_result)
+        fc::json::save_to_file(fc::json::from_string(*response.serialized_result, fc::json::format_validation_mode::full), file);
       else
         fc::json::save_to_file(response.result, file);
     }
@@ -210,6 +259,8 @@ namespace detail
       map< string, api_description >                     _registered_apis;
       vector< string >                                   _methods;
       map< string, map< string, api_method_signature > > _method_sigs;
+      map< string, api_method_serialized_result >        _serialized_result_sources; // by api.method
+      map< string, performance_metrics::histogram_id >   _call_metric_ids; // by api.method, only in `data`
     } data, proxy_data;
 
     detail::rpc_obfuscator obfuscator;
@@ -220,14 +271,17 @@ namespace detail
 
       void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
       void add_early_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+      void add_serialized_result_source( const string& api_name, const string& method_name, const api_method_serialized_result& source );
       void plugin_finalize_startup();
       void plugin_pre_shutdown();
 
       api_method* find_api_method( const std::string& api, const std::string& method );
       api_method* process_params( string method, const fc::variant_object& request, fc::variant& func_args, string* method_name );
+      bool find_serialized_result( const string& method_name, const fc::variant& func_args, json_rpc_response& response );
       void rpc_id( const fc::variant_object& request, json_rpc_response& response );
       bool rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response );
       json_rpc_response rpc( const fc::variant& message );
+      vector< json_rpc_response > rpc_batch( vector< fc::variant >&& messages, const batch_execution& execution );
 
       void initialize();
 
@@ -273,6 +327,11 @@ namespace detail
     add_api_method(api_name, method_name, api, sig);
   }
 
+  void json_rpc_plugin_impl::add_serialized_result_source( const string& api_name, const string& method_name, const api_method_serialized_result& source )
+  {
+    proxy_data._serialized_result_sources[ api_name + '.' + method_name ] = source;
+  }
+
   void json_rpc_plugin_impl::plugin_finalize_startup()
   {
     std::sort( proxy_data._methods.begin(), proxy_data._methods.end() );
@@ -280,6 +339,13 @@ namespace detail
     data._registered_apis = std::move( proxy_data._registered_apis );
     data._methods         = std::move( proxy_data._methods );
     data._method_sigs     = std::move( proxy_data._method_sigs );
+    data._serialized_result_sources = std::move( proxy_data._serialized_result_sources );
+
+    // histograms are registered up front, so calls (made from many threads) only read the map
+    auto& metrics = performance_metrics::instance();
+    metrics.describe_family( "api_call", "Time of execution of API calls, by method" );
+    for( const auto& method : data._methods )
+      data._call_metric_ids[ method ] = metrics.get_histogram_id( "api_call", method );
   }
 
   void json_rpc_plugin_impl::plugin_pre_shutdown()
@@ -287,6 +353,8 @@ namespace detail
     data._registered_apis.clear();
     data._methods.clear();
     data._method_sigs.clear();
+    data._serialized_result_sources.clear();
+    data._call_metric_ids.clear();
   }
 
   void json_rpc_plugin_impl::initialize()
@@ -372,6 +440,23 @@ namespace detail
     return ret;
   }
 
+  bool json_rpc_plugin_impl::find_serialized_result( const string& method_name, const fc::variant& func_args, json_rpc_response& response )
+  {
+    auto itr = data._serialized_result_sources.find( method_name );
+    if( itr == data._serialized_result_sources.end() )
+      return false;
+
+    try
+    {
+      response.serialized_result = itr->second( func_args );
+    }
+    catch( fc::exception& )
+    {
+      // f.e. malformed arguments - regular call reports proper error
+    }
+    return response.serialized_result != nullptr;
+  }
+
   void json_rpc_plugin_impl::rpc_id( const fc::variant_object& request, json_rpc_response& response )
   {
     STATSD_START_TIMER( "jsonrpc", "overhead", "rpc_id", 1.0f, theApp );
@@ -428,11 +513,16 @@ namespace detail
               if( call )
               {
                 STATSD_START_TIMER( "jsonrpc", "api", method_name, 1.0f, theApp );
+                auto metric_itr = data._call_metric_ids.find( method_name );
+                std::optional< performance_metrics::scoped_timer > call_timer;
+                if( metric_itr != data._call_metric_ids.end() )
+                  call_timer.emplace( metric_itr->second );
 
                 bool _change_of_serialization_is_allowed = false;
                 try
                 {
-                  response.result = (*call)( func_args );
+                  if( !find_serialized_result( method_name, func_args, response ) )
+                    response.result = (*call)( func_args );
                 }
                 catch( fc::bad_cast_exception& e )
                 {
@@ -565,6 +655,63 @@ namespace detail
 
     return response;
   }
+
+  vector< json_rpc_response > json_rpc_plugin_impl::rpc_batch( vector< fc::variant >&& messages, const batch_execution& execution )
+  {
+    const size_t thread_count = execution.post ? std::min< size_t >( execution.max_concurrency, messages.size() ) : 1;
+    if( thread_count <= 1 )
+    {
+      vector< json_rpc_response > responses;
+      responses.reserve( messages.size() );
+      for( auto& m : messages )
+        responses.push_back( rpc( m ) );
+      return responses;
+    }
+
+    /*
+      Elements are taken one by one by calling thread and helper tasks posted to other threads. Calling thread only
+      waits for elements that are already in progress, so batch completes even if no helper gets to run (f.e. when
+      all threads of the pool are busy); helpers that start after all elements were taken exit immediately.
+    */
+    struct batch_state
+    {
+      vector< fc::variant >        messages;
+      vector< json_rpc_response >  responses;
+      std::atomic< size_t >        next = { 0 };
+      size_t                       completed = 0;
+      std::mutex                   mutex;
+      std::condition_variable      done;
+    };
+
+    auto state = std::make_shared< batch_state >();
+    state->messages = std::move( messages );
+    state->responses.resize( state->messages.size() );
+
+    auto work = [ state, this ]()
+    {
+      size_t processed = 0;
+      for( size_t i = state->next++; i < state->messages.size(); i = state->next++ )
+      {
+        state->responses[i] = rpc( state->messages[i] );
+        ++processed;
+      }
+      if( processed )
+      {
+        std::lock_guard< std::mutex > guard( state->mutex );
+        state->completed += processed;
+        if( state->completed == state->messages.size() )
+          state->done.notify_all();
+      }
+    };
+
+    for( size_t i = 1; i < thread_count; ++i )
+      execution.post( work );
+    work();
+
+    std::unique_lock< std::mutex > lock( state->mutex );
+    state->done.wait( lock, [&]() { return state->completed == state->messages.size(); } );
+    return std::move( state->responses );
+  }
 }
 
 using detail::json_rpc_error;
@@ -624,54 +771,362 @@ void json_rpc_plugin::add_early_api_method( const string& api_name, const string
   my->add_early_api_method( api_name, method_name, api, sig );
 }
 
-string json_rpc_plugin::call( const string& message )
+void json_rpc_plugin::add_serialized_result_source( const string& api_name, const string& method_name, const api_method_serialized_result& source )
 {
-  STATSD_START_TIMER( "jsonrpc", "overhead", "call", 1.0f, get_app() );
-  try
-  {
-    fc::variant v = fc::json::from_string( message, fc::json::format_validation_mode::full );
+  my->add_serialized_result_source( api_name, method_name, source );
+}
 
-    if( v.is_array() )
+namespace
+{
+  template< typename Call >
+  string call_with_error_handling( Call&& call )
+  {
+    try
     {
-      vector< fc::variant > messages = v.as< vector< fc::variant > >();
-      vector< json_rpc_response > responses;
+      return call();
+    }
+    catch( fc::exception& e )
+    {
+      json_rpc_response response;
+      response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
+      return fc::json::to_string( response );
+    }
+    catch( ... )
+    {
+      json_rpc_response response;
+      response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Unknown exception", fc::variant(
+        fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unknown Exception" ), std::current_exception() ).to_detail_string() ) );
+      return fc::json::to_string( response );
+    }
+  }
 
-      if( messages.size() )
+  /**
+    * Reads methods and ids of request from its text following rules of fc legacy JSON parser used by call
+    * (same escapes, first of duplicated keys wins), but skips values it does not need without decoding them.
+    * Nesting of skipped values is only counted, so deeply nested request does not exhaust stack.
+    * Throws when text ends prematurely or value cannot start with encountered character.
+    */
+  class request_scanner
+  {
+    public:
+      explicit request_scanner( const string& text ) : _pos( text.data() ), _end( text.data() + text.size() ) {}
+
+      request_summary scan()
       {
-        responses.reserve( messages.size() );
+        request_summary result;
+        skip_white_space();
+        if( peek() == '[' )
+        {
+          result.is_batch = true;
+          scan_array( [&]( size_t ) { scan_request( result ); } );
+        }
+        else
+        {
+          scan_request( result );
+        }
+        return result;
+      }
 
-        for( auto& m : messages )
-          responses.push_back( my->rpc( m ) );
+    private:
+      char peek()const
+      {
+        FC_ASSERT( _pos != _end, "Unexpected end of request" );
+        return *_pos;
+      }
 
-        return fc::json::to_string( responses );
+      static bool is_white_space( char c )
+      {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
       }
-      else
+
+      void skip_white_space()
+      {
+        while( _pos != _end && is_white_space( *_pos ) )
+          ++_pos;
+      }
+
+      /// whitespace and commas between elements (parser checks placement of commas, scanner does not need to)
+      void skip_separators()
+      {
+        while( _pos != _end && ( *_pos == ',' || is_white_space( *_pos ) ) )
+          ++_pos;
+      }
+
+      string read_string()
       {
-        //For example: message == "[]"
-        json_rpc_response response;
-        response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Array is invalid" );
-        return fc::json::to_string( response );
+        FC_ASSERT( peek() == '"', "Expected string" );
+        ++_pos;
+        string result;
+        for( char c = peek(); c != '"'; c = peek() )
+        {
+          FC_ASSERT( c != 0x04, "Unexpected end of string" );
+          ++_pos;
+          if( c == '\\' )
+          {
+            c = peek();
+            ++_pos;
+            switch( c )
+            {
+              case 't': c = '\t'; break;
+              case 'n': c = '\n'; break;
+              case 'r': c = '\r'; break;
+              default: break; // parser takes any other escaped character as is
+            }
+          }
+          result.push_back( c );
+        }
+        ++_pos;
+        return result;
       }
+
+      void skip_string()
+      {
+        ++_pos;
+        for( char c = peek(); c != '"'; c = peek() )
+        {
+          FC_ASSERT( c != 0x04, "Unexpected end of string" );
+          if( c == '\\' )
+          {
+            ++_pos;
+            peek();
+          }
+          ++_pos;
+        }
+        ++_pos;
+      }
+
+      /// number, true, false or null
+      void skip_token()
+      {
+        while( _pos != _end && !is_white_space( *_pos ) && *_pos != ',' && *_pos != '}' && *_pos != ']' )
+          ++_pos;
+      }
+
+      void skip_value()
+      {
+        uint32_t depth = 0;
+        do
+        {
+          const char c = peek();
+          if( c == '"' )
+          {
+            skip_string();
+          }
+          else if( c == '{' || c == '[' )
+          {
+            ++depth;
+            ++_pos;
+          }
+          else if( c == '}' || c == ']' )
+          {
+            FC_ASSERT( depth > 0, "Expected value" );
+            --depth;
+            ++_pos;
+          }
+          else if( depth == 0 )
+          {
+            FC_ASSERT( c == '-' || c == '.' || std::isdigit( static_cast< unsigned char >( c ) ) || c == 'n' || c == 't' || c == 'f',
+              "Expected value" );
+            skip_token();
+          }
+          else
+          {
+            ++_pos;
+          }
+        }
+        while( depth > 0 );
+      }
+
+      /// integer or string like accepted by json_rpc_plugin_impl::rpc_id, otherwise null
+      fc::variant read_id()
+      {
+        const char c = peek();
+        if( c == '"' )
+          return fc::variant( read_string() );
+        if( c != '-' && !std::isdigit( static_cast< unsigned char >( c ) ) )
+        {
+          skip_value();
+          return fc::variant();
+        }
+
+        const char* start = _pos;
+        skip_token();
+        const string number( start, _pos );
+        if( number.find_first_not_of( "-0123456789" ) != string::npos )
+          return fc::variant(); // floating point
+        errno = 0;
+        char* end = nullptr;
+        fc::variant id;
+        if( number[0] == '-' )
+          id = fc::variant( int64_t( std::strtoll( number.c_str(), &end, 10 ) ) );
+        else
+          id = fc::variant( uint64_t( std::strtoull( number.c_str(), &end, 10 ) ) );
+        if( errno != 0 || end != number.c_str() + number.size() )
+          return fc::variant();
+        return id;
+      }
+
+      template< typename OnElement >
+      void scan_array( OnElement&& on_element )
+      {
+        ++_pos;
+        for( size_t index = 0;; ++index )
+        {
+          skip_separators();
+          if( peek() == ']' )
+            break;
+          on_element( index );
+        }
+        ++_pos;
+      }
+
+      template< typename OnMember >
+      void scan_object( OnMember&& on_member )
+      {
+        ++_pos;
+        for( ;; )
+        {
+          skip_separators();
+          if( peek() == '}' )
+            break;
+          const string key = read_string();
+          skip_white_space();
+          FC_ASSERT( peek() == ':', "Expected ':' after key" );
+          ++_pos;
+          skip_white_space();
+          on_member( key );
+        }
+        ++_pos;
+      }
+
+      void scan_request( request_summary& result )
+      {
+        string method;
+        fc::optional< string > api_name;
+        fc::optional< string > api_method;
+        fc::variant id;
+
+        skip_white_space();
+        if( peek() == '{' )
+        {
+          bool has_method = false;
+          bool has_params = false;
+          bool has_id = false;
+          scan_object( [&]( const string& key )
+          {
+            if( key == "method" && !has_method )
+            {
+              has_method = true;
+              if( peek() == '"' )
+                method = read_string();
+              else
+                skip_value();
+            }
+            else if( key == "params" && !has_params && peek() == '[' )
+            {
+              has_params = true;
+              scan_array( [&]( size_t index )
+              {
+                if( index < 2 && peek() == '"' )
+                  ( index == 0 ? api_name : api_method ) = read_string();
+                else
+                  skip_value();
+              } );
+            }
+            else if( key == "id" && !has_id )
+            {
+              has_id = true;
+              id = read_id();
+            }
+            else
+            {
+              if( key == "params" )
+                has_params = true;
+              skip_value();
+            }
+          } );
+        }
+        else
+        {
+          skip_value();
+        }
+
+        if( method == "call" )
+          method = ( api_name && api_method ) ? *api_name + "." + *api_method : string();
+        result.methods.push_back( std::move( method ) );
+        result.ids.push_back( std::move( id ) );
+      }
+
+      const char* _pos;
+      const char* _end;
+  };
+}
+
+string json_rpc_plugin::call( const string& message, const batch_execution& execution )
+{
+  STATSD_START_TIMER( "jsonrpc", "overhead", "call", 1.0f, get_app() );
+  return call_with_error_handling( [&]()
+  {
+    fc::variant v = fc::json::from_string( message, fc::json::format_validation_mode::full );
+    return execute( v, execution );
+  } );
+}
+
+string json_rpc_plugin::execute( const fc::variant& v, const batch_execution& execution )
+{
+  if( v.is_array() )
+  {
+    vector< fc::variant > messages = v.as< vector< fc::variant > >();
+
+    if( messages.size() )
+    {
+      vector< json_rpc_response > responses = my->rpc_batch( std::move( messages ), execution );
+      return detail::to_json( responses );
     }
     else
     {
-      return fc::json::to_string( my->rpc( v ) );
+      //For example: message == "[]"
+      json_rpc_response response;
+      response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Array is invalid" );
+      return fc::json::to_string( response );
     }
   }
-  catch( fc::exception& e )
+  else
   {
-    json_rpc_response response;
-    response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
-    return fc::json::to_string( response );
+    return detail::to_json( my->rpc( v ) );
   }
-  catch( ... )
+}
+
+request_summary json_rpc_plugin::scan_request( const string& body )const
+{
+  try
   {
-    json_rpc_response response;
-    response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Unknown exception", fc::variant(
-      fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unknown Exception" ), std::current_exception() ).to_detail_string() ) );
-    return fc::json::to_string( response );
+    return request_scanner( body ).scan();
   }
+  catch( const fc::exception& )
+  {
+    return request_summary(); // call will report the error
+  }
+}
 
+string json_rpc_plugin::make_error_response( const request_summary& request, int32_t code, const string& error_message )const
+{
+  auto make_response = [&]( const fc::variant& id )
+  {
+    json_rpc_response response;
+    response.id = id;
+    response.error = json_rpc_error( code, error_message );
+    return response;
+  };
+
+  if( request.is_batch && !request.ids.empty() )
+  {
+    vector< json_rpc_response > responses;
+    for( const auto& id : request.ids )
+      responses.push_back( make_response( id ) );
+    return fc::json::to_string( responses );
+  }
+  return fc::json::to_string( make_response( request.ids.empty() ? fc::variant() : request.ids.front() ) );
 }
 
 } } } // hive::plugins::json_rpc
@@ -175,7 +175,8 @@ void market_history_plugin::plugin_initialize( const boost::program_options::var
     ilog( "market_history: plugin_initialize() begin" );
     my = std::make_unique< detail::market_history_plugin_impl >( get_app() );
 
-    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->on_post_apply_operation( note ); }, *this, 0 );
+    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->on_post_apply_operation( note ); },
+      chain::database::make_operation_type_set< fill_order_operation >(), *this, 0 );
     HIVE_ADD_PLUGIN_INDEX(my->_db, bucket_index);
     HIVE_ADD_PLUGIN_INDEX(my->_db, order_history_index);
 
@@ -8,6 +8,8 @@
 #include <hive/chain/database_exceptions.hpp>
 #include <hive/chain/blockchain_worker_thread_pool.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #include <appbase/shutdown_mgr.hpp>
 
 #include <fc/network/ip.hpp>
@@ -37,6 +39,8 @@ using graphene::net::trx_message;
 using hive::protocol::block_header;
 using hive::protocol::block_id_type;
 
+using hive::utilities::performance_metrics;
+
 namespace detail {
 
 // This exists in p2p_plugin and http_plugin. It should be added to fc.
@@ -121,6 +125,10 @@ public:
 
   void request_precomputing_transaction_signatures_if_useful();
 
+  /// performance_metrics collector: traffic of connected peers (data lives on p2p thread, so it is read from there)
+  void collect_peer_metrics( std::vector< performance_metrics::collected_value >& values ) const;
+  fc::optional< performance_metrics::collector_id > peer_metrics_collector;
+
   fc::optional<fc::ip::endpoint> endpoint;
   vector<fc::ip::endpoint> seeds;
   string user_agent;
@@ -140,6 +148,31 @@ public:
   appbase::application& theApp;
 };
 
+void p2p_plugin_impl::collect_peer_metrics( std::vector< performance_metrics::collected_value >& values ) const
+{
+  try
+  {
+    const std::vector< graphene::net::peer_status > peers = node->get_connected_peers();
+    values.push_back( { { "p2p_connections", "active" }, false, int64_t( peers.size() ) } );
+    for( const graphene::net::peer_status& peer : peers )
+    {
+      const std::string address = peer.info[ "addr" ].as_string();
+      auto add_counter = [&]( const char* family, const char* field )
+      {
+        values.push_back( { { family, address }, true, peer.info[ field ].as_int64() } );
+      };
+      add_counter( "p2p_peer_bytes_sent", "bytessent" );
+      add_counter( "p2p_peer_bytes_received", "bytesrecv" );
+      add_counter( "p2p_peer_messages_sent", "msgsent" );
+      add_counter( "p2p_peer_messages_received", "msgrecv" );
+    }
+  }
+  catch( const fc::exception& e )
+  {
+    dlog( "Unable to collect metrics of P2P peers: ${e}", ( "e", e.to_detail_string() ) );
+  }
+}
+
 ////////////////////////////// Begin node_delegate Implementation //////////////////////////////
 bool p2p_plugin_impl::has_item( const graphene::net::item_id& id )
 {
@@ -549,6 +582,18 @@ void p2p_plugin::plugin_startup()
     // }
     );
   }).wait();
+
+  auto& metrics = performance_metrics::instance();
+  metrics.describe_family( "p2p_connections", "Number of active P2P connections" );
+  metrics.describe_family( "p2p_peer_bytes_sent", "Bytes sent to connected peer, by address" );
+  metrics.describe_family( "p2p_peer_bytes_received", "Bytes received from connected peer, by address" );
+  metrics.describe_family( "p2p_peer_messages_sent", "Messages sent to connected peer, by address" );
+  metrics.describe_family( "p2p_peer_messages_received", "Messages received from connected peer, by address" );
+  my->peer_metrics_collector = metrics.add_collector( [this]( std::vector< performance_metrics::collected_value >& values )
+  {
+    my->collect_peer_metrics( values );
+  } );
+
   ilog( "P2P Plugin started" );
   get_app().notify_status("P2P started");
 }
@@ -578,6 +623,12 @@ void p2p_plugin::plugin_pre_shutdown() {
     elog("P2P shutdown timed out before all blocks/transactions were processed: ${e}", (e));
   }
 
+  if( my->peer_metrics_collector )
+  {
+    performance_metrics::instance().remove_collector( *my->peer_metrics_collector );
+    my->peer_metrics_collector.reset();
+  }
+
   ilog("P2P Plugin: terminating p2p tasks");
   my->node->close();
   fc::promise<void>::ptr quitDone(new fc::promise<void>("P2P thread quit"));
@@ -204,8 +204,9 @@ void reputation_plugin::plugin_initialize( const boost::program_options::variabl
 
     my = std::make_unique< detail::reputation_plugin_impl >( *this, get_app() );
 
-    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->pre_operation( note ); }, *this, 0 );
-    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->post_operation( note ); }, *this, 0 );
+    const auto vote_operations = chain::database::make_operation_type_set< vote_operation >();
+    my->_pre_apply_operation_conn = my->_db.add_pre_apply_operation_handler( [&]( const operation_notification& note ){ my->pre_operation( note ); }, vote_operations, *this, 0 );
+    my->_post_apply_operation_conn = my->_db.add_post_apply_operation_handler( [&]( const operation_notification& note ){ my->post_operation( note ); }, vote_operations, *this, 0 );
     HIVE_ADD_PLUGIN_INDEX(my->_db, reputation_index);
 
     get_app().get_plugin< chain::chain_plugin >().report_state_options( name(), fc::variant_object() );
@@ -10,6 +10,8 @@
 
 #include <hive/plugins/database_api/database_api_objects.hpp>
 
+#include <fc/io/raw.hpp>
+
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -49,6 +51,8 @@ class api_stats_export_data_object
       fc::to_variant( *this, v );
     }
 
+    virtual void to_binary( std::vector< char >& data )const override;
+
     api_dynamic_global_property_object                    global_properties;
     std::vector< api_stats_transaction_data_object >      transaction_stats;
     uint64_t                                              free_memory = 0;
@@ -61,6 +65,11 @@ FC_REFLECT( hive::plugins::stats_export::detail::api_stats_export_data_object, (
 
 namespace hive { namespace plugins { namespace stats_export { namespace detail {
 
+void api_stats_export_data_object::to_binary( std::vector< char >& data )const
+{
+  data = fc::raw::pack_to_vector( *this );
+}
+
 class stats_export_plugin_impl
 {
   public:
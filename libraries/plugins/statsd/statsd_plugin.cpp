@@ -1,17 +1,23 @@
 #include <hive/plugins/statsd/statsd_plugin.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #include <fc/network/resolve.hpp>
 #include <fc/thread/thread.hpp>
 
 #include <boost/algorithm/string.hpp>
 
+#include <condition_variable>
 #include <sstream>
+#include <thread>
 
 #include "StatsdClient.hpp"
 
 namespace hive { namespace plugins { namespace statsd {
 
 using namespace Statsd;
+using hive::utilities::performance_metrics;
+using hive::utilities::histogram_snapshot;
 
 namespace detail
 {
@@ -22,6 +28,17 @@ namespace detail
     return ss.str();
   }
 
+  /// statsd keys can't contain whitespace or some separators - replace anything unusual
+  inline std::string sanitize_key( std::string key )
+  {
+    for( char& c : key )
+    {
+      if( !std::isalnum( static_cast< unsigned char >( c ) ) && c != '_' && c != '-' && c != '.' )
+        c = '_';
+    }
+    return key;
+  }
+
   class statsd_plugin_impl
   {
     public:
@@ -35,6 +52,10 @@ namespace detail
       void start();
       void shutdown();
 
+      void start_performance_metrics_export();
+      void stop_performance_metrics_export();
+      void export_performance_metrics();
+
       bool is_accessible() const;
       bool filter_by_namespace( const std::string& ns, const std::string& stat ) const;
 
@@ -59,6 +80,13 @@ namespace detail
       uint32_t                                           _statsd_batchsize = 1;
 
       std::unique_ptr< StatsdClient >                    _statsd;
+
+      uint32_t                                           _performance_metrics_interval = 0; // seconds, 0 means no export
+      std::thread                                        _performance_metrics_thread;
+      std::mutex                                         _performance_metrics_mutex;
+      std::condition_variable                            _performance_metrics_cv;
+      bool                                               _performance_metrics_stop = false;
+      performance_metrics::snapshot_t                    _last_performance_metrics;
   };
 
   void statsd_plugin_impl::start()
@@ -81,12 +109,17 @@ namespace detail
 
     _statsd.reset( new StatsdClient( host, port, "hived.", _statsd_batchsize ) );
     _started = true;
+
+    if( _statsd_endpoint.valid() )
+      start_performance_metrics_export();
   }
 
   void statsd_plugin_impl::shutdown()
   {
     ilog("Shutting down statsd Plugin");
 
+    stop_performance_metrics_export();
+
     _shutdown_in_progress.store( true );
 
     //Wait until all operations will be finished during 2 seconds
@@ -98,6 +131,62 @@ namespace detail
     _statsd.reset();
   }
 
+  void statsd_plugin_impl::start_performance_metrics_export()
+  {
+    if( _performance_metrics_interval == 0 || _performance_metrics_thread.joinable() )
+      return;
+
+    _performance_metrics_stop = false;
+    _performance_metrics_thread = std::thread( [this]()
+    {
+      fc::set_thread_name( "statsd_metrics" );
+      std::unique_lock< std::mutex > lock( _performance_metrics_mutex );
+      while( !_performance_metrics_cv.wait_for( lock, std::chrono::seconds( _performance_metrics_interval ),
+        [this]() { return _performance_metrics_stop; } ) )
+      {
+        export_performance_metrics();
+      }
+    } );
+  }
+
+  void statsd_plugin_impl::stop_performance_metrics_export()
+  {
+    if( !_performance_metrics_thread.joinable() )
+      return;
+
+    {
+      std::lock_guard< std::mutex > guard( _performance_metrics_mutex );
+      _performance_metrics_stop = true;
+    }
+    _performance_metrics_cv.notify_all();
+    _performance_metrics_thread.join();
+  }
+
+  void statsd_plugin_impl::export_performance_metrics()
+  {
+    performance_metrics::snapshot_t current = performance_metrics::instance().collect();
+
+    // only samples gathered since previous export are reported
+    for( const auto& entry : current )
+    {
+      histogram_snapshot delta = entry.second;
+      auto previous = _last_performance_metrics.find( entry.first );
+      if( previous != _last_performance_metrics.end() )
+        delta = entry.second - previous->second;
+      if( delta.count == 0 )
+        continue;
+
+      const std::string& stat = entry.first.family;
+      const std::string key = sanitize_key( entry.first.name );
+      count( "perf", stat, key + ".count", delta.count, 1.0f );
+      gauge( "perf", stat, key + ".avg_us", delta.average_ns() / 1000, 1.0f );
+      gauge( "perf", stat, key + ".p50_us", delta.quantile_us( 0.5 ), 1.0f );
+      gauge( "perf", stat, key + ".p99_us", delta.quantile_us( 0.99 ), 1.0f );
+    }
+
+    _last_performance_metrics = std::move( current );
+  }
+
   bool statsd_plugin_impl::is_accessible() const
   {
     return !_shutdown_in_progress.load();
@@ -177,6 +266,7 @@ void statsd_plugin::set_program_options( options_description& cli, options_descr
   cfg.add_options()
     ("statsd-endpoint", bpo::value< std::string >(), "Endpoint to send statsd messages to.")
     ("statsd-batchsize", bpo::value< uint32_t >()->default_value( 1 ), "Size to batch statsd messages." )
+    ("statsd-performance-metrics-interval", bpo::value< uint32_t >()->default_value( 10 ), "Interval (in seconds) of exporting performance metrics (evaluator, block phase and plugin handler timings) to statsd. 0 disables the export." )
     ("statsd-whitelist", bpo::value< vector< std::string > >()->composing(), "Whitelist of statistics to capture.")
     ("statsd-blacklist", bpo::value< vector< std::string > >()->composing(), "Blacklist of statistics to capture.");
 }
@@ -192,6 +282,8 @@ void statsd_plugin::plugin_initialize( const boost::program_options::variables_m
     ilog( "Configured statsd to send to ${ep}", ("ep", endpoints[0]) );
   }
 
+  my->_performance_metrics_interval = options.at( "statsd-performance-metrics-interval" ).as< uint32_t >();
+
   if( options.count( "statsd-whitelist" ) )
   {
     my->_filter_stats = true;
@@ -0,0 +1,188 @@
+#include <hive/plugins/webserver/api_scheduler.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <limits>
+#include <tuple>
+
+namespace hive { namespace plugins { namespace webserver {
+
+using hive::utilities::performance_metrics;
+
+const std::string api_scheduler::default_class_name = "default";
+
+api_scheduler::class_config api_scheduler::class_config::from_string( const std::string& definition )
+{
+  std::vector< std::string > parts;
+  boost::split( parts, definition, boost::is_any_of( ":" ) );
+  FC_ASSERT( parts.size() >= 2 && parts.size() <= 4 && !parts[0].empty(),
+    "API class definition should have form name:workers[:max_queue[:max_wait_ms]], got ${d}", ( "d", definition ) );
+
+  class_config result;
+  try
+  {
+    result.name = parts[0];
+    result.workers = std::stoul( parts[1] );
+    if( parts.size() > 2 )
+      result.max_queue = std::stoul( parts[2] );
+    if( parts.size() > 3 )
+      result.max_wait = fc::milliseconds( std::stoul( parts[3] ) );
+  }
+  catch( const std::logic_error& )
+  {
+    FC_ASSERT( false, "Invalid number in API class definition ${d}", ( "d", definition ) );
+  }
+  FC_ASSERT( result.workers > 0, "API class ${c} needs at least one worker", ( "c", result.name ) );
+  return result;
+}
+
+void api_scheduler::configure( uint32_t default_workers, const std::vector< std::string >& classes, const std::vector< std::string >& method_rules )
+{
+  std::map< std::string, uint32_t > class_indexes;
+  auto add_class = [&]( const class_config& config )
+  {
+    FC_ASSERT( class_indexes.count( config.name ) == 0, "API class ${c} defined more than once", ( "c", config.name ) );
+    class_indexes[ config.name ] = _classes.size();
+    _classes.emplace_back( new cost_class() );
+    _classes.back()->config = config;
+  };
+
+  for( const auto& definition : classes )
+    add_class( class_config::from_string( definition ) );
+
+  if( class_indexes.count( default_class_name ) == 0 )
+  {
+    class_config config;
+    config.name = default_class_name;
+    config.workers = default_workers;
+    add_class( config );
+  }
+  _default_class = class_indexes[ default_class_name ];
+
+  for( const auto& rule : method_rules )
+  {
+    auto separator = rule.rfind( ':' );
+    FC_ASSERT( separator != std::string::npos, "API method rule should have form api.method:class, got ${r}", ( "r", rule ) );
+    std::string method = rule.substr( 0, separator );
+    std::string class_name = rule.substr( separator + 1 );
+    auto itr = class_indexes.find( class_name );
+    FC_ASSERT( itr != class_indexes.end(), "Unknown API class ${c} in rule ${r}", ( "c", class_name )( "r", rule ) );
+    _method_classes[ method ] = itr->second;
+  }
+
+  auto& metrics = performance_metrics::instance();
+  metrics.describe_family( "api_queue_wait", "Time API requests spent waiting for worker, by cost class" );
+  metrics.describe_family( "api_queue_rejected", "Number of API requests rejected due to overload, by cost class" );
+  for( auto& c : _classes )
+  {
+    c->wait_histogram = metrics.get_histogram_id( "api_queue_wait", c->config.name );
+    c->rejected_counter = metrics.get_counter_id( "api_queue_rejected", c->config.name );
+    ilog( "API class ${c}: ${w} workers, max queue ${q}, max wait ${t} ms",
+      ( "c", c->config.name )( "w", c->config.workers )( "q", c->config.max_queue )( "t", c->config.max_wait.count() / 1000 ) );
+  }
+}
+
+void api_scheduler::start()
+{
+  for( auto& c : _classes )
+  {
+    c->work.reset( new boost::asio::io_service::work( c->ios ) );
+    const std::string thread_name = c->config.name == default_class_name ? "api" : "api_" + c->config.name;
+    for( uint32_t i = 0; i < c->config.workers; ++i )
+      c->workers.create_thread( [&ios = c->ios, thread_name]() { fc::set_thread_name( thread_name.c_str() ); ios.run(); } );
+  }
+}
+
+void api_scheduler::stop()
+{
+  for( auto& c : _classes )
+    c->ios.stop();
+  for( auto& c : _classes )
+    c->workers.join_all();
+}
+
+uint32_t api_scheduler::find_class( const std::string& method ) const
+{
+  auto itr = _method_classes.find( method );
+  if( itr != _method_classes.end() )
+    return itr->second;
+
+  auto dot = method.find( '.' );
+  if( dot != std::string::npos )
+  {
+    itr = _method_classes.find( method.substr( 0, dot ) + ".*" );
+    if( itr != _method_classes.end() )
+      return itr->second;
+  }
+  return _default_class;
+}
+
+bool api_scheduler::is_more_restrictive( uint32_t a, uint32_t b ) const
+{
+  if( a == b || a == _default_class )
+    return false;
+  if( b == _default_class )
+    return true;
+
+  // no limit counts as the highest one
+  auto limits = [this]( uint32_t index )
+  {
+    const class_config& config = _classes[ index ]->config;
+    return std::make_tuple( config.workers,
+      config.max_queue != 0 ? config.max_queue : std::numeric_limits< uint32_t >::max(),
+      config.max_wait.count() != 0 ? config.max_wait.count() : std::numeric_limits< int64_t >::max() );
+  };
+  return limits( a ) < limits( b );
+}
+
+uint32_t api_scheduler::get_class( const std::vector< std::string >& methods ) const
+{
+  uint32_t result = _default_class;
+  for( const auto& method : methods )
+  {
+    const uint32_t method_class = find_class( method );
+    if( is_more_restrictive( method_class, result ) )
+      result = method_class;
+  }
+  return result;
+}
+
+void api_scheduler::post( uint32_t class_index, task_t task, reject_t reject )
+{
+  cost_class& c = *_classes[ class_index ];
+
+  if( c.config.max_queue != 0 && c.queued.load( std::memory_order_relaxed ) >= c.config.max_queue )
+  {
+    performance_metrics::instance().add( c.rejected_counter );
+    reject( "Server is busy - too many requests in queue of API class " + c.config.name );
+    return;
+  }
+
+  ++c.queued;
+  const fc::time_point enqueued = fc::time_point::now();
+  c.ios.post( [&c, enqueued, task = std::move( task ), reject = std::move( reject )]()
+  {
+    --c.queued;
+    const fc::microseconds wait = fc::time_point::now() - enqueued;
+    // requests rejected after waiting too long are included, they took their place in queue as well
+    performance_metrics::instance().record( c.wait_histogram, wait.count() * 1000 );
+    if( c.config.max_wait.count() != 0 && wait > c.config.max_wait )
+    {
+      performance_metrics::instance().add( c.rejected_counter );
+      reject( "Server is busy - request waited too long in queue of API class " + c.config.name );
+      return;
+    }
+    task();
+  } );
+}
+
+void api_scheduler::run_in_class( uint32_t class_index, task_t task )
+{
+  _classes[ class_index ]->ios.post( std::move( task ) );
+}
+
+} } } // hive::plugins::webserver
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <hive/utilities/performance_metrics.hpp>
+
+#include <fc/time.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hive { namespace plugins { namespace webserver {
+
+/**
+  * Executes API calls in cost classes. Each class has its own queue and its own worker threads, so expensive calls
+  * (f.e. account history) queue up only behind other calls of their class and can't starve cheap ones.
+  *
+  * Class can limit number of waiting requests and time request can wait in queue. Requests over the limits are
+  * rejected (load shedding) - client gets error instead of response that would come too late anyway.
+  * Time spent in queue is recorded in performance metrics (family api_queue_wait), rejected requests are counted
+  * in api_queue_rejected.
+  *
+  * Calls of methods not assigned to any class go to "default" class. Batch that mixes methods of different classes
+  * goes to the most restrictive of them (see get_class), so it can't be used to get around limits of a class.
+  */
+class api_scheduler
+{
+  public:
+    typedef std::function< void() > task_t;
+    typedef std::function< void( const std::string& reason ) > reject_t;
+
+    struct class_config
+    {
+      std::string       name;
+      uint32_t          workers = 1;
+      /// max number of requests waiting for worker (0 - unlimited)
+      uint32_t          max_queue = 0;
+      /// requests waiting longer are rejected instead of executed (0 - no limit)
+      fc::microseconds  max_wait;
+
+      /// parses class definition in form name:workers[:max_queue[:max_wait_ms]]
+      static class_config from_string( const std::string& definition );
+    };
+
+    static const std::string default_class_name;
+
+    /**
+      * Default class gets given number of workers unless it is explicitly defined in `classes`.
+      * Method rules have form api.method:class or api.*:class.
+      */
+    void configure( uint32_t default_workers, const std::vector< std::string >& classes, const std::vector< std::string >& method_rules );
+
+    void start();
+    void stop();
+
+    /// when false, all calls go to default class and caller does not need to know called methods
+    bool has_method_rules() const { return !_method_classes.empty(); }
+
+    /**
+      * Class for request calling given methods (one for single request, many for batch). For batch mixing classes
+      * it is the most restrictive one: any class other than default, then the one with fewest workers, then with
+      * shortest queue limit and wait limit.
+      */
+    uint32_t get_class( const std::vector< std::string >& methods ) const;
+    uint32_t get_default_class() const { return _default_class; }
+
+    /// queues task in given class; `reject` is called instead of `task` when class is overloaded
+    void post( uint32_t cost_class, task_t task, reject_t reject );
+    /// runs task on worker of given class bypassing queue limits and metrics (for parts of already admitted request)
+    void run_in_class( uint32_t cost_class, task_t task );
+
+  private:
+    struct cost_class
+    {
+      class_config                                  config;
+      boost::asio::io_service                       ios;
+      std::unique_ptr< boost::asio::io_service::work > work;
+      boost::thread_group                           workers;
+      std::atomic< uint32_t >                       queued = { 0 };
+      hive::utilities::performance_metrics::histogram_id wait_histogram = 0;
+      hive::utilities::performance_metrics::counter_id   rejected_counter = 0;
+    };
+
+    uint32_t find_class( const std::string& method ) const;
+    /// true when class a admits less requests than class b (see get_class)
+    bool is_more_restrictive( uint32_t a, uint32_t b ) const;
+
+    std::vector< std::unique_ptr< cost_class > >  _classes;
+    std::map< std::string, uint32_t >             _method_classes;
+    uint32_t                                      _default_class = 0;
+};
+
+} } } // hive::plugins::webserver
@@ -24,9 +24,11 @@ using collector_t = hive::utilities::notifications::collector_t;
   * thread.  The callback can be called from any thread and will
   * automatically propagate the call to the http thread.
   *
-  * The HTTP service will run in its own thread with its own io_service to
+  * The HTTP service will run in its own threads with their own io_services to
   * make sure that HTTP request processing does not interfer with other
-  * plugins.
+  * plugins. Each tcp endpoint can be served by many I/O threads (webserver-io-threads),
+  * each accepting connections on its own socket bound with SO_REUSEPORT, while API
+  * calls are executed by shared thread pool.
   */
 class webserver_plugin : public appbase::plugin< webserver_plugin >
 {
@@ -1,8 +1,11 @@
 #include <hive/plugins/webserver/webserver_plugin.hpp>
+#include <hive/plugins/webserver/api_scheduler.hpp>
 #include <hive/plugins/webserver/local_endpoint.hpp>
 
 #include <hive/plugins/json_rpc/utility.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #include <fc/network/ip.hpp>
 #include <fc/log/logger_config.hpp>
 #include <fc/io/json.hpp>
@@ -255,17 +258,120 @@ class webserver_base
 
     optional<tls_server>                                      tls;
 
+    plugins::json_rpc::json_rpc_plugin*                       api = nullptr;
+    api_scheduler                                             scheduler;
+    /// max number of API threads executing elements of single batch request
+    uint32_t                                                  batch_concurrency = 1;
+
+    struct api_call
+    {
+      std::string                                        body;
+      /// methods and ids of request (only when they were needed to find cost class)
+      fc::optional< plugins::json_rpc::request_summary > summary;
+      uint32_t                                           cost_class = 0;
+    };
+
+    /// finds cost class of request (scanning it only when some methods have their classes, body is parsed by API thread)
+    std::shared_ptr< api_call > prepare_call( std::string body ) const;
+    std::string execute_call( const api_call& call ) const;
+    std::string make_busy_response( const api_call* call, const std::string& reason ) const;
+
+    /// when set, GET /metrics on http endpoints returns performance metrics in Prometheus text format
+    bool                                                      metrics_enabled = false;
+
+    template< typename connection_ptr >
+    bool handle_metrics_request( const connection_ptr& con ) const;
+
     optional< tcp::endpoint >                                 http_endpoint;
     optional< boost::asio::local::stream_protocol::endpoint > unix_endpoint;
     optional< tcp::endpoint >                                 ws_endpoint;
 };
 
+std::shared_ptr< webserver_base::api_call > webserver_base::prepare_call( std::string body ) const
+{
+  auto call = std::make_shared< api_call >();
+  call->body = std::move( body );
+  call->cost_class = scheduler.get_default_class();
+  if( scheduler.has_method_rules() && !call->body.empty() )
+  {
+    // malformed request has no methods, so it goes to default class and json_rpc reports the error
+    call->summary = api->scan_request( call->body );
+    call->cost_class = scheduler.get_class( call->summary->methods );
+  }
+  return call;
+}
+
+std::string webserver_base::execute_call( const api_call& call ) const
+{
+  plugins::json_rpc::batch_execution execution;
+  if( batch_concurrency > 1 )
+  {
+    const uint32_t cost_class = call.cost_class;
+    execution.post = [this, cost_class]( std::function< void() > task ) { scheduler.run_in_class( cost_class, std::move( task ) ); };
+    execution.max_concurrency = batch_concurrency;
+  }
+  return api->call( call.body, execution );
+}
+
+std::string webserver_base::make_busy_response( const api_call* call, const std::string& reason ) const
+{
+  plugins::json_rpc::request_summary summary;
+  if( call != nullptr )
+    summary = call->summary ? *call->summary : api->scan_request( call->body );
+  return api->make_error_response( summary, JSON_RPC_SERVER_BUSY, reason );
+}
+
+template< typename connection_ptr >
+bool webserver_base::handle_metrics_request( const connection_ptr& con ) const
+{
+  if( !metrics_enabled || con->get_request().get_method() != "GET" || con->get_resource() != "/metrics" )
+    return false;
+
+  con->set_body( hive::utilities::performance_metrics::instance().to_prometheus_text() );
+  con->append_header( "Content-Type", "text/plain; version=0.0.4" );
+  con->set_status( websocketpp::http::status_code::ok );
+  con->send_http_response();
+  return true;
+}
+
+/**
+  * Enables SO_REUSEPORT on acceptor before it is bound, so many acceptors (each run by separate I/O thread) can listen
+  * on the same port. Kernel then distributes incoming connections between them.
+  */
+template< typename acceptor_ptr >
+websocketpp::lib::error_code set_reuse_port( acceptor_ptr acceptor )
+{
+#if defined( __APPLE__ ) || defined( __linux__ )
+# ifndef SO_REUSEPORT
+#  define SO_REUSEPORT 15
+# endif
+  typedef asio::detail::socket_option::boolean< SOL_SOCKET, SO_REUSEPORT > reuse_port;
+  boost::system::error_code ec;
+  acceptor->set_option( reuse_port( true ), ec );
+  if( ec )
+  {
+    elog( "Error setting SO_REUSEPORT on webserver acceptor: ${e}", ( "e", ec.message() ) );
+    return websocketpp::transport::asio::error::make_error_code( websocketpp::transport::asio::error::pass_through );
+  }
+#endif
+  return websocketpp::lib::error_code();
+}
+
+/// I/O thread with its own io_service and listening socket; connections accepted by it are handled only by that thread
+template< typename server_type >
+struct reactor
+{
+  asio::io_service                ios;
+  server_type                     server;
+  std::unique_ptr< std::thread >  thread;
+};
+
 template<typename websocket_server_type>
 class webserver_plugin_impl : public webserver_base
 {
   public:
-    webserver_plugin_impl( thread_pool_size_t _thread_pool_size, appbase::application& app ) :
-      thread_pool_size( _thread_pool_size ), theApp( app )
+    webserver_plugin_impl( uint32_t _io_thread_count, appbase::application& app ) :
+      io_thread_count( _io_thread_count ), theApp( app )
     {
     }
 
@@ -279,25 +385,18 @@ class webserver_plugin_impl : public webserver_base
     void handle_http_message( websocket_server_type*, connection_hdl );
     void handle_http_request( websocket_local_server_type*, connection_hdl );
 
-    thread_pool_size_t         thread_pool_size;
+    typedef std::vector< std::unique_ptr< reactor< websocket_server_type > > > tcp_reactors_t;
+
+    /// number of I/O threads (and acceptors) for each tcp endpoint
+    uint32_t                   io_thread_count;
 
-    shared_ptr< std::thread >  http_thread;
-    asio::io_service           http_ios;
-    websocket_server_type      http_server;
+    tcp_reactors_t             http_reactors;
 
     shared_ptr< std::thread >              unix_thread;
     asio::io_service                       unix_ios;
     websocket_local_server_type            unix_server;
 
-    shared_ptr< std::thread >  ws_thread;
-    asio::io_service           ws_ios;
-    websocket_server_type      ws_server;
-
-    boost::thread_group        thread_pool;
-    asio::io_service           thread_pool_ios;
-    std::unique_ptr< asio::io_service::work > thread_pool_work;
-
-    plugins::json_rpc::json_rpc_plugin* api = nullptr;
+    tcp_reactors_t             ws_reactors;
 
     using signal_t = boost::signals2::signal<void(const collector_t &)>;
     signal_t listen;
@@ -307,8 +406,10 @@ class webserver_plugin_impl : public webserver_base
 
     appbase::application& theApp;
 
-    void update_http_endpoint();
-    void update_ws_endpoint();
+    template< typename setup_handler_type >
+    bool start_reactors( tcp_reactors_t& reactors, optional< tcp::endpoint >& endpoint, const std::string& thread_name,
+      setup_handler_type&& setup_handlers );
+    void stop_reactors( tcp_reactors_t& reactors );
 
     void notify( const std::string& type, const optional< tcp::endpoint >& endpoint );
 };
@@ -325,10 +426,7 @@ void webserver_plugin_impl<websocket_server_type>::startup()
 template<typename websocket_server_type>
 void webserver_plugin_impl<websocket_server_type>::prepare_threads()
 {
-  thread_pool_work.reset( new asio::io_service::work( this->thread_pool_ios ) );
-
-  for( uint32_t i = 0; i < thread_pool_size; ++i )
-    thread_pool.create_thread( [&]() { fc::set_thread_name("api"); thread_pool_ios.run(); } );
+  scheduler.start();
 }
 
 template<typename websocket_server_type>
@@ -347,88 +445,134 @@ void webserver_plugin_impl<websocket_server_type>::notify( const std::string& ty
 };
 
 template<typename websocket_server_type>
-void webserver_plugin_impl<websocket_server_type>::start_webserver()
+void update_endpoint(websocket_server_type& server, optional< tcp::endpoint >& endpoint)
 {
-  const bool ws_and_http_uses_same_endpoint = http_endpoint && http_endpoint == ws_endpoint && http_endpoint->port() != 0;
+  if (endpoint->port() == 0)
+  {
+    boost::system::error_code error;
+    auto server_port = server.get_local_endpoint(error).port();
+    FC_ASSERT(!error);
+    endpoint->port(server_port);
+  }
+}
 
-  if( ws_endpoint )
+template<typename websocket_server_type>
+template<typename setup_handler_type>
+bool webserver_plugin_impl<websocket_server_type>::start_reactors( tcp_reactors_t& reactors, optional< tcp::endpoint >& endpoint,
+  const std::string& thread_name, setup_handler_type&& setup_handlers )
+{
+  try
+  {
+    for( uint32_t i = 0; i < io_thread_count; ++i )
+    {
+      reactors.emplace_back( new reactor< websocket_server_type >() );
+      websocket_server_type& server = reactors.back()->server;
+
+      server.clear_access_channels( websocketpp::log::alevel::all );
+      server.clear_error_channels( websocketpp::log::elevel::all );
+      server.init_asio( &reactors.back()->ios );
+      server.set_reuse_addr( true );
+      if( io_thread_count > 1 )
+        server.set_tcp_pre_bind_handler( &set_reuse_port< typename websocket_server_type::acceptor_ptr > );
+
+      setup_handlers( server );
+
+      server.listen( *endpoint );
+      // when port was chosen by system, remaining acceptors have to bind to the same one
+      if( i == 0 )
+        update_endpoint( server, endpoint );
+      server.start_accept();
+    }
+  }
+  catch( ... )
   {
-    ws_thread = std::make_shared<std::thread>( [&, ws_and_http_uses_same_endpoint]()
+    elog( "error thrown when starting ${name} listener", ( "name", thread_name ) );
+    return false;
+  }
+
+  for( uint32_t i = 0; i < reactors.size(); ++i )
+  {
+    const std::string name = reactors.size() > 1 ? thread_name + "_" + std::to_string( i ) : thread_name;
+    reactor< websocket_server_type >& r = *reactors[i];
+    r.thread.reset( new std::thread( [&r, name]()
     {
-      ilog( "start processing ws thread" );
-      fc::set_thread_name("websocket");
-      fc::thread::current().set_name("websocket");
+      ilog( "start processing ${name} thread", ( name ) );
+      fc::set_thread_name( name.c_str() );
+      fc::thread::current().set_name( name );
       try
       {
-        ws_server.clear_access_channels( websocketpp::log::alevel::all );
-        ws_server.clear_error_channels( websocketpp::log::elevel::all );
-        ws_server.init_asio( &ws_ios );
-        ws_server.set_reuse_addr( true );
-
-        ws_server.set_message_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_ws_message, this, &ws_server, _1, _2 ) );
-
-        if( ws_and_http_uses_same_endpoint )
-        {
-          ws_server.set_http_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_http_message, this, &ws_server, _1 ) );
-        }
+        r.ios.run();
+        ilog( "${name} io service exit", ( name ) );
+      }
+      catch( ... )
+      {
+        elog( "error thrown from ${name} io service", ( name ) );
+      }
+    } ) );
+  }
+  return true;
+}
 
-        ws_server.listen( *ws_endpoint );
-        update_ws_endpoint();
-        if( ws_and_http_uses_same_endpoint )
-        {
-          ilog( "start listening for http requests on ${endpoint}", ( "endpoint", boost::lexical_cast<fc::string>( *http_endpoint ) ) );
-        }
-        ilog( "start listening for ws requests on ${endpoint}", ( "endpoint", boost::lexical_cast<fc::string>( *ws_endpoint ) ) );
+template<typename websocket_server_type>
+void webserver_plugin_impl<websocket_server_type>::stop_reactors( tcp_reactors_t& reactors )
+{
+  for( auto& r : reactors )
+    r->ios.stop();
+  for( auto& r : reactors )
+  {
+    if( r->thread )
+      r->thread->join();
+  }
+  reactors.clear();
+}
 
-        notify( "WS", ws_endpoint );
+template<typename websocket_server_type>
+void webserver_plugin_impl<websocket_server_type>::start_webserver()
+{
+  const bool ws_and_http_uses_same_endpoint = http_endpoint && http_endpoint == ws_endpoint && http_endpoint->port() != 0;
 
-        ws_server.start_accept();
+  if( ws_endpoint )
+  {
+    bool started = start_reactors( ws_reactors, ws_endpoint, "websocket", [&]( websocket_server_type& server )
+    {
+      server.set_message_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_ws_message, this, &server, _1, _2 ) );
 
-        ws_ios.run();
-        ilog( "ws io service exit" );
+      if( ws_and_http_uses_same_endpoint )
+      {
+        server.set_http_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_http_message, this, &server, _1 ) );
       }
-      catch( ... )
+    } );
+
+    if( started )
+    {
+      if( ws_and_http_uses_same_endpoint )
       {
-        elog( "error thrown from http io service" );
+        ilog( "start listening for http requests on ${endpoint}", ( "endpoint", boost::lexical_cast<fc::string>( *http_endpoint ) ) );
       }
-    });
+      ilog( "start listening for ws requests on ${endpoint} with ${n} I/O threads",
+        ( "endpoint", boost::lexical_cast<fc::string>( *ws_endpoint ) )( "n", ws_reactors.size() ) );
+
+      notify( "WS", ws_endpoint );
+    }
   }
 
   if( http_endpoint && ( !ws_and_http_uses_same_endpoint || !ws_endpoint ) )
   {
-    http_thread = std::make_shared<std::thread>( [&]()
+    bool started = start_reactors( http_reactors, http_endpoint, "http", [&]( websocket_server_type& server )
     {
-      ilog( "start processing http thread" );
-      fc::set_thread_name("http");
-      fc::thread::current().set_name("http");
-      try
-      {
-        http_server.clear_access_channels( websocketpp::log::alevel::all );
-        http_server.clear_error_channels( websocketpp::log::elevel::all );
-        http_server.init_asio( &http_ios );
-        http_server.set_reuse_addr( true );
-
-        http_server.set_http_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_http_message, this, &http_server, _1 ) );
-
-        if( tls )
-          tls->set_tls_handlers( http_server );
+      server.set_http_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_http_message, this, &server, _1 ) );
 
-        http_server.listen( *http_endpoint );
-        http_server.start_accept();
-        update_http_endpoint();
-        ilog( "start listening for ${type} requests on ${endpoint}",
-            ("type", tls ? "https" : "http")( "endpoint", boost::lexical_cast<fc::string>( *http_endpoint ) ) );
+      if( tls )
+        tls->set_tls_handlers( server );
+    } );
 
-        notify( "HTTP", http_endpoint );
+    if( started )
+    {
+      ilog( "start listening for ${type} requests on ${endpoint} with ${n} I/O threads",
+          ("type", tls ? "https" : "http")( "endpoint", boost::lexical_cast<fc::string>( *http_endpoint ) )( "n", http_reactors.size() ) );
 
-        http_ios.run();
-        ilog( "http io service exit" );
-      }
-      catch( ... )
-      {
-        elog( "error thrown from http io service" );
-      }
-    });
+      notify( "HTTP", http_endpoint );
+    }
   }
 
   if( unix_endpoint ) {
@@ -439,7 +583,7 @@ void webserver_plugin_impl<websocket_server_type>::start_webserver()
       try {
         unix_server.clear_access_channels( websocketpp::log::alevel::all );
         unix_server.clear_error_channels( websocketpp::log::elevel::all );
-        unix_server.init_asio( &http_ios );
+        unix_server.init_asio( &unix_ios );
 
         unix_server.set_http_handler( boost::bind( &webserver_plugin_impl<websocket_server_type>::handle_http_request, this, &unix_server, _1 ) );
         //unix_server.set_http_handler([&](connection_hdl hdl) {
@@ -452,7 +596,7 @@ void webserver_plugin_impl<websocket_server_type>::start_webserver()
         unix_server.start_accept();
 
         ilog( "start running unix http requests" );
-        http_ios.run();
+        unix_ios.run();
         ilog( "unix http io service exit" );
       } catch( ... ) {
         elog( "error thrown from unix http io service" );
@@ -461,49 +605,13 @@ void webserver_plugin_impl<websocket_server_type>::start_webserver()
   }
 }
 
-template<typename websocket_server_type>
-void update_endpoint(websocket_server_type& server, optional< tcp::endpoint >& endpoint)
-{
-  if (endpoint->port() == 0)
-  {
-    boost::system::error_code error;
-    auto server_port = server.get_local_endpoint(error).port();
-    FC_ASSERT(!error);
-    endpoint->port(server_port);
-  }
-}
-
-template<typename websocket_server_type>
-void webserver_plugin_impl<websocket_server_type>::update_http_endpoint()
-{
-  update_endpoint<websocket_server_type>(http_server, http_endpoint);
-}
-
-template<typename websocket_server_type>
-void webserver_plugin_impl<websocket_server_type>::update_ws_endpoint()
-{
-  update_endpoint<websocket_server_type>(ws_server, ws_endpoint);
-}
-
 template<typename websocket_server_type>
 void webserver_plugin_impl<websocket_server_type>::stop_webserver()
 {
-  thread_pool_ios.stop();
-  thread_pool.join_all();
+  scheduler.stop();
 
-  if( ws_thread )
-  {
-    ws_ios.stop();
-    ws_thread->join();
-    ws_thread.reset();
-  }
-
-  if( http_thread )
-  {
-    http_ios.stop();
-    http_thread->join();
-    http_thread.reset();
-  }
+  stop_reactors( ws_reactors );
+  stop_reactors( http_reactors );
 
   if( unix_thread )
   {
@@ -519,18 +627,20 @@ void webserver_plugin_impl<websocket_server_type>::handle_ws_message( websocket_
   auto con = server->get_con_from_hdl( std::move( hdl ) );
 
   fc::time_point arrival_time = fc::time_point::now();
-  thread_pool_ios.post( [con, msg, this, arrival_time]()
+  std::shared_ptr< api_call > call;
+  if( msg->get_opcode() == websocketpp::frame::opcode::text )
+    call = prepare_call( msg->get_payload() );
+
+  scheduler.post( call ? call->cost_class : scheduler.get_default_class(), [con, call, this, arrival_time]()
   {
     LOG_DELAY(arrival_time, fc::seconds(2), "Excessive delay to begin processing ws API call");
 
     try
     {
-      if( msg->get_opcode() == websocketpp::frame::opcode::text )
+      if( call )
       {
-        auto body = msg->get_payload();
-        LOG_DELAY(arrival_time, fc::seconds(4), "Excessive delay to get ws payload");
-
-        auto response =  api->call( body );
+        const auto& body = call->body;
+        auto response = execute_call( *call );
         LOG_DELAY_EX(arrival_time, fc::seconds(10), "Excessive delay to process ws API call: ${body}", (body));
 
         con->send( response );
@@ -562,6 +672,10 @@ void webserver_plugin_impl<websocket_server_type>::handle_ws_message( websocket_
         ulog("${e}", ("e", s.str()) );
       }
     }
+  },
+  [con, call, this]( const std::string& reason )
+  {
+    con->send( make_busy_response( call.get(), reason ) );
   });
 }
 
@@ -572,16 +686,20 @@ void webserver_plugin_impl<websocket_server_type>::handle_http_message( websocke
   con->defer_http_response();
 
   fc::time_point arrival_time = fc::time_point::now();
-  thread_pool_ios.post( [con, this, arrival_time]()
+  auto call = prepare_call( con->get_request_body() );
+
+  scheduler.post( call->cost_class, [con, call, this, arrival_time]()
   {
     LOG_DELAY(arrival_time, fc::seconds(2), "Excessive delay to begin processing API call");
 
-    auto body = con->get_request_body();
-    LOG_DELAY(arrival_time, fc::seconds(4), "Excessive delay to get request_body");
+    if( handle_metrics_request( con ) )
+      return;
+
+    const auto& body = call->body;
 
     try
     {
-      con->set_body( api->call( body ) );
+      con->set_body( execute_call( *call ) );
       con->append_header( "Content-Type", "application/json" );
       con->set_status( websocketpp::http::status_code::ok );
     }
@@ -616,6 +734,13 @@ void webserver_plugin_impl<websocket_server_type>::handle_http_message( websocke
 
     LOG_DELAY_EX(arrival_time, fc::seconds(10), "Excessive delay to process API call ${body}",(body));
     con->send_http_response();
+  },
+  [con, call, this]( const std::string& reason )
+  {
+    con->set_body( make_busy_response( call.get(), reason ) );
+    con->append_header( "Content-Type", "application/json" );
+    con->set_status( websocketpp::http::status_code::service_unavailable );
+    con->send_http_response();
   });
 }
 
@@ -624,13 +749,16 @@ void webserver_plugin_impl<websocket_server_type>::handle_http_request(websocket
   auto con = server->get_con_from_hdl( std::move( hdl ) );
   con->defer_http_response();
 
-  thread_pool_ios.post( [con, this]()
+  auto call = prepare_call( con->get_request_body() );
+
+  scheduler.post( call->cost_class, [con, call, this]()
   {
-    auto body = con->get_request_body();
+    if( handle_metrics_request( con ) )
+      return;
 
     try
     {
-      con->set_body( api->call( body ) );
+      con->set_body( execute_call( *call ) );
       con->append_header( "Content-Type", "application/json" );
       con->set_status( websocketpp::http::status_code::ok );
     }
@@ -661,6 +789,13 @@ void webserver_plugin_impl<websocket_server_type>::handle_http_request(websocket
       }
     }
 
+    con->send_http_response();
+  },
+  [con, call, this]( const std::string& reason )
+  {
+    con->set_body( make_busy_response( call.get(), reason ) );
+    con->append_header( "Content-Type", "application/json" );
+    con->set_status( websocketpp::http::status_code::service_unavailable );
     con->send_http_response();
   });
 }
@@ -692,8 +827,18 @@ void webserver_plugin::set_program_options( options_description&, options_descri
     ("rpc-endpoint", bpo::value< string >(), "Local http and websocket endpoint for webserver requests. Deprecated in favor of webserver-http-endpoint and webserver-ws-endpoint" )
     ("webserver-thread-pool-size", bpo::value<thread_pool_size_t>()->default_value(32),
       "Number of threads used to handle queries. Default: 32.")
+    ("webserver-api-class", bpo::value< std::vector< string > >()->composing(),
+      "Cost class of API calls with its own queue and workers, in form name:workers[:max_queue[:max_wait_ms]]. Requests over max_queue or waiting longer than max_wait_ms are rejected with error. "
+      "Class named default (used for calls not assigned to other classes) gets webserver-thread-pool-size workers unless defined here.")
+    ("webserver-api-method-class", bpo::value< std::vector< string > >()->composing(),
+      "Assigns API method to cost class, in form api.method:class or api.*:class. Batch mixing methods of different classes goes to the most restrictive of their classes.")
+    ("webserver-batch-concurrency", bpo::value<uint32_t>()->default_value(4),
+      "Max number of API threads executing elements of single JSON-RPC batch request concurrently. 1 means serial execution. Default: 4.")
+    ("webserver-io-threads", bpo::value<uint32_t>()->default_value(1),
+      "Number of threads accepting connections and doing network I/O for each http and ws endpoint. Each thread listens on its own socket (SO_REUSEPORT) and keeps connections it accepted. Default: 1.")
     ("webserver-https-certificate-file-name", bpo::value< string >(), "File name with a server's certificate." )
-    ("webserver-https-key-file-name", bpo::value< string >(), "File name with a server's private key." );
+    ("webserver-https-key-file-name", bpo::value< string >(), "File name with a server's private key." )
+    ("webserver-enable-metrics", bpo::value<bool>()->default_value( false ), "Serve performance metrics in Prometheus text format on GET /metrics of http endpoints." )
     ;
 }
 
@@ -704,6 +849,16 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
   FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
   ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
 
+  auto io_thread_count = options.at("webserver-io-threads").as<uint32_t>();
+  FC_ASSERT(io_thread_count > 0, "webserver-io-threads must be greater than 0");
+#if !defined( __APPLE__ ) && !defined( __linux__ )
+  if( io_thread_count > 1 )
+  {
+    wlog("SO_REUSEPORT is not supported on this platform - webserver will use single I/O thread per endpoint");
+    io_thread_count = 1;
+  }
+#endif
+
   auto _ws_deflate_enabled = options.at( "webserver-ws-deflate" ).as< bool >();
   ilog("Compression in webserver is ${_ws_deflate_enabled}", ("_ws_deflate_enabled", _ws_deflate_enabled ? "enabled" : "disabled"));
 
@@ -713,9 +868,9 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
     FC_ASSERT(options.count( "webserver-https-key-file-name" ), "Option `webserver-https-key-file-name` is required");
 
     if( _ws_deflate_enabled )
-      my.reset( new detail::webserver_plugin_impl<detail::websocket_tls_server_type_deflate>( thread_pool_size, get_app() ) );
+      my.reset( new detail::webserver_plugin_impl<detail::websocket_tls_server_type_deflate>( io_thread_count, get_app() ) );
     else
-      my.reset( new detail::webserver_plugin_impl<detail::websocket_tls_server_type_nondeflate>( thread_pool_size, get_app() ) );
+      my.reset( new detail::webserver_plugin_impl<detail::websocket_tls_server_type_nondeflate>( io_thread_count, get_app() ) );
 
     my->tls = detail::tls_server( get_app() );
     my->tls->server_certificate_file_name = options.at( "webserver-https-certificate-file-name" ).as< string >();
@@ -730,9 +885,9 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
       ilog( "Option `webserver-https-key-file-name` is avoided. It's used only for https connection." );
 
     if( _ws_deflate_enabled )
-      my.reset( new detail::webserver_plugin_impl<detail::websocket_server_type_deflate>( thread_pool_size, get_app() ) );
+      my.reset( new detail::webserver_plugin_impl<detail::websocket_server_type_deflate>( io_thread_count, get_app() ) );
     else
-      my.reset( new detail::webserver_plugin_impl<detail::websocket_server_type_nondeflate>( thread_pool_size, get_app() ) );
+      my.reset( new detail::webserver_plugin_impl<detail::websocket_server_type_nondeflate>( io_thread_count, get_app() ) );
   }
 
   if( options.count( "webserver-http-endpoint" ) || options.count( "webserver-https-endpoint" ) )
@@ -785,6 +940,17 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
       ilog( "configured ws to listen on ${ep}", ("ep", endpoints[0]) );
     }
   }
+
+  my->scheduler.configure( thread_pool_size,
+    options.count( "webserver-api-class" ) ? options.at( "webserver-api-class" ).as< std::vector< string > >() : std::vector< string >(),
+    options.count( "webserver-api-method-class" ) ? options.at( "webserver-api-method-class" ).as< std::vector< string > >() : std::vector< string >() );
+
+  my->batch_concurrency = options.at( "webserver-batch-concurrency" ).as< uint32_t >();
+  FC_ASSERT( my->batch_concurrency > 0, "webserver-batch-concurrency must be greater than 0" );
+
+  my->metrics_enabled = options.at( "webserver-enable-metrics" ).as< bool >();
+  if( my->metrics_enabled )
+    ilog( "performance metrics will be served on GET /metrics" );
 }
 
 void webserver_plugin::plugin_startup()
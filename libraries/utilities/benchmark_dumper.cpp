@@ -52,4 +52,26 @@ bool benchmark_dumper::read_mem(pid_t pid, uint64_t* current_virtual, uint64_t*
   return true;
 }
 
+bool benchmark_dumper::read_resident_mem(uint64_t* current_resident, uint64_t* peak_resident)
+{
+  const char* procPath = "/proc/self/status";
+  FILE* input = fopen(procPath, "re");
+  if(input == NULL)
+  {
+    elog( "cannot read: ${file} file.", ("file", procPath) );
+    return false;
+  }
+
+  TScanErrorCallback error_callback = [procPath](const char* key)
+  {
+    elog( "cannot read value of ${key} key in ${file}", ("key", key) ("file", procPath) );
+  };
+
+  *peak_resident = read_u64_value_from( input, "VmHWM:", 6, error_callback );
+  *current_resident = read_u64_value_from( input, "VmRSS:", 6, error_callback );
+
+  fclose(input);
+  return true;
+}
+
 } }
@@ -23,10 +23,12 @@ public:
   struct index_memory_details_t
   {
     index_memory_details_t(std::string&& name, size_t size, size_t i_sizeof,
-      size_t item_add_allocation, size_t add_container_allocation)
+      size_t item_add_allocation, size_t add_container_allocation,
+      size_t pool_reserved = 0, size_t pool_free = 0)
       : index_name(name), index_size(size), item_sizeof(i_sizeof),
         item_additional_allocation(item_add_allocation),
-        additional_container_allocation(add_container_allocation)
+        additional_container_allocation(add_container_allocation),
+        node_pool_reserved(pool_reserved), node_pool_free(pool_free)
     {
       total_index_mem_usage = additional_container_allocation;
       total_index_mem_usage += item_additional_allocation;
@@ -40,6 +42,9 @@ public:
     size_t         item_additional_allocation = 0;
     /// Additional memory used for container internal structures (like tree nodes).
     size_t         additional_container_allocation = 0;
+    /// Memory reserved by node pool of the index size class and its unused part (fragmentation).
+    size_t         node_pool_reserved = 0;
+    size_t         node_pool_free = 0;
     size_t         total_index_mem_usage = 0;
   };
 
@@ -175,6 +180,9 @@ public:
     return _all_data.total_measurement;
   }
 
+  /// reads current and peak resident set size of the process [kB]
+  static bool read_resident_mem(uint64_t* current_resident, uint64_t* peak_resident);
+
 private:
   bool read_mem(pid_t pid, uint64_t* current_virtual, uint64_t* peak_virtual);
   bool is_file_available() const { return !_file_name.empty(); }
@@ -195,7 +203,7 @@ private:
 
 FC_REFLECT( hive::utilities::benchmark_dumper::index_memory_details_t,
         (index_name)(index_size)(item_sizeof)(item_additional_allocation)
-        (additional_container_allocation)(total_index_mem_usage)
+        (additional_container_allocation)(node_pool_reserved)(node_pool_free)(total_index_mem_usage)
         )
 
 FC_REFLECT( hive::utilities::benchmark_dumper::database_object_sizeof_t,
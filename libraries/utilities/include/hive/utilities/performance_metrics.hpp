@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace hive { namespace utilities {
+
+/**
+  * Accumulated contents of one latency histogram.
+  * Bucket `i` (for i < finite_bucket_count) counts samples below 2^i microseconds that did not fit
+  * in any previous bucket, last bucket counts everything else (+Inf).
+  */
+struct histogram_snapshot
+{
+  static constexpr uint32_t finite_bucket_count = 21; // up to ~1s
+  static constexpr uint32_t bucket_count = finite_bucket_count + 1;
+
+  std::array< uint64_t, bucket_count > buckets = {};
+  uint64_t count = 0;
+  uint64_t sum_ns = 0;
+
+  /// upper bound (in microseconds) of given finite bucket
+  static uint64_t bucket_upper_bound_us( uint32_t bucket ) { return uint64_t( 1 ) << bucket; }
+  static uint32_t bucket_for( uint64_t ns );
+
+  /// approximation of given quantile (0..1) as upper bound of bucket that contains it [us]
+  uint64_t quantile_us( double q ) const;
+  uint64_t average_ns() const { return count ? sum_ns / count : 0; }
+
+  histogram_snapshot& operator+=( const histogram_snapshot& other );
+  histogram_snapshot operator-( const histogram_snapshot& older ) const;
+};
+
+/**
+  * Always-on, low overhead registry of latency histograms (as opposed to advanced_benchmark_dumper
+  * that is meant for dedicated benchmark runs). Each histogram belongs to a family (f.e. evaluator
+  * or block processing phase) and is distinguished within it by name. Samples are collected in
+  * thread-local storage, so recording never takes a lock (except first use of given histogram on
+  * given thread); reader merges data from all threads on demand.
+  *
+  * Callers are supposed to obtain histogram id once (see get_histogram_id) and cache it.
+  *
+  * Besides histograms registry holds counters (monotonic values, kept per thread just like histograms),
+  * gauges (current values, f.e. queue depth, set by their owner) and collectors - callbacks that provide
+  * values at the moment of export, for data that is already tracked elsewhere (f.e. by p2p connections
+  * or RocksDB). None of them may take chainbase lock, so export never waits for block processing.
+  */
+class performance_metrics
+{
+public:
+  typedef uint32_t histogram_id;
+  typedef uint32_t counter_id;
+  typedef uint32_t collector_id;
+
+  struct histogram_key
+  {
+    std::string family;
+    std::string name;
+
+    bool operator<( const histogram_key& other ) const
+    {
+      return std::tie( family, name ) < std::tie( other.family, other.name );
+    }
+  };
+
+  typedef histogram_key metric_key;
+
+  typedef std::map< histogram_key, histogram_snapshot > snapshot_t;
+  typedef std::map< metric_key, uint64_t > counter_snapshot_t;
+  typedef std::map< metric_key, int64_t > gauge_snapshot_t;
+
+  /// current value set by its owner; reference obtained from get_gauge stays valid forever
+  class gauge
+  {
+  public:
+    void set( int64_t value ) { _value.store( value, std::memory_order_relaxed ); }
+    int64_t get() const { return _value.load( std::memory_order_relaxed ); }
+
+  private:
+    std::atomic< int64_t > _value = { 0 };
+  };
+
+  /// value provided by collector
+  struct collected_value
+  {
+    metric_key  key;
+    bool        is_counter = false; // gauge otherwise
+    int64_t     value = 0;
+  };
+  typedef std::function< void( std::vector< collected_value >& ) > collector_t;
+
+  static performance_metrics& instance();
+
+  void set_enabled( bool val ) { _enabled.store( val, std::memory_order_relaxed ); }
+  bool is_enabled() const { return _enabled.load( std::memory_order_relaxed ); }
+
+  /// registers description of family of histograms (used in exported metrics)
+  void describe_family( const std::string& family, const std::string& help );
+  /// returns id of histogram (registers new one when needed)
+  histogram_id get_histogram_id( const std::string& family, const std::string& name );
+
+  /// adds sample to given histogram (in local thread storage)
+  void record( histogram_id id, uint64_t ns );
+
+  /// returns id of counter (registers new one when needed)
+  counter_id get_counter_id( const std::string& family, const std::string& name );
+  /// increases given counter (in local thread storage)
+  void add( counter_id id, uint64_t value = 1 );
+
+  /// returns gauge (registers new one when needed)
+  gauge& get_gauge( const std::string& family, const std::string& name );
+
+  /**
+    * Registers callback called during export. Collector is called with internal lock held, so after
+    * remove_collector returns it is guaranteed not to run anymore.
+    */
+  collector_id add_collector( collector_t collector );
+  void remove_collector( collector_id id );
+
+  /// merges data from all threads
+  snapshot_t collect() const;
+  counter_snapshot_t collect_counters() const;
+  gauge_snapshot_t collect_gauges() const;
+  /// collected data in Prometheus text exposition format
+  std::string to_prometheus_text() const;
+
+  /**
+    * RAII helper measuring time spent in its scope. Does nothing if metrics were disabled at the
+    * moment of construction.
+    */
+  class scoped_timer
+  {
+  public:
+    explicit scoped_timer( histogram_id id ) : _id( id )
+    {
+      if( instance().is_enabled() )
+      {
+        _active = true;
+        _start = std::chrono::steady_clock::now();
+      }
+    }
+    ~scoped_timer()
+    {
+      if( _active )
+        instance().record( _id, std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - _start ).count() );
+    }
+
+  private:
+    histogram_id                          _id;
+    bool                                  _active = false;
+    std::chrono::steady_clock::time_point _start;
+  };
+
+private:
+  struct thread_data;
+  friend struct thread_data;
+
+  performance_metrics() = default;
+
+  thread_data& local_data();
+  void retire( thread_data* data );
+
+  std::atomic_bool                               _enabled = { true };
+
+  mutable std::mutex                             _mutex;
+  std::vector< histogram_key >                   _histograms; // index is histogram_id
+  std::map< histogram_key, histogram_id >        _ids;
+  std::vector< metric_key >                      _counters; // index is counter_id
+  std::map< metric_key, counter_id >             _counter_ids;
+  std::deque< gauge >                            _gauges; // deque keeps gauges in place on growth
+  std::map< metric_key, gauge* >                 _gauge_by_key;
+  std::map< std::string, std::string >           _family_help;
+  std::vector< thread_data* >                    _threads;
+  std::vector< histogram_snapshot >              _retired; // data of threads that already finished
+  std::vector< uint64_t >                        _retired_counters;
+
+  mutable std::mutex                             _collectors_mutex;
+  std::map< collector_id, collector_t >          _collectors;
+  collector_id                                   _next_collector_id = 0;
+};
+
+} } // hive::utilities
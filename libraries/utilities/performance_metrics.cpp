@@ -0,0 +1,389 @@
+#include <hive/utilities/performance_metrics.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <sstream>
+
+namespace hive { namespace utilities {
+
+uint32_t histogram_snapshot::bucket_for( uint64_t ns )
+{
+  uint64_t us = ns / 1000;
+  uint32_t bucket = 0;
+  while( us != 0 && bucket < finite_bucket_count )
+  {
+    us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+uint64_t histogram_snapshot::quantile_us( double q ) const
+{
+  if( count == 0 )
+    return 0;
+  uint64_t rank = static_cast< uint64_t >( q * count );
+  if( rank >= count )
+    rank = count - 1;
+  uint64_t seen = 0;
+  for( uint32_t i = 0; i < finite_bucket_count; ++i )
+  {
+    seen += buckets[i];
+    if( seen > rank )
+      return bucket_upper_bound_us( i );
+  }
+  return bucket_upper_bound_us( finite_bucket_count );
+}
+
+histogram_snapshot& histogram_snapshot::operator+=( const histogram_snapshot& other )
+{
+  for( uint32_t i = 0; i < bucket_count; ++i )
+    buckets[i] += other.buckets[i];
+  count += other.count;
+  sum_ns += other.sum_ns;
+  return *this;
+}
+
+histogram_snapshot histogram_snapshot::operator-( const histogram_snapshot& older ) const
+{
+  histogram_snapshot result;
+  for( uint32_t i = 0; i < bucket_count; ++i )
+    result.buckets[i] = buckets[i] - older.buckets[i];
+  result.count = count - older.count;
+  result.sum_ns = sum_ns - older.sum_ns;
+  return result;
+}
+
+struct performance_metrics::thread_data
+{
+  /// only owning thread writes, so counters don't need atomic read-modify-write, just visibility for reader
+  struct histogram
+  {
+    histogram()
+    {
+      for( auto& bucket : buckets )
+        bucket.store( 0, std::memory_order_relaxed );
+    }
+
+    void add( uint32_t bucket, uint64_t ns )
+    {
+      buckets[ bucket ].store( buckets[ bucket ].load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+      count.store( count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+      sum_ns.store( sum_ns.load( std::memory_order_relaxed ) + ns, std::memory_order_relaxed );
+    }
+
+    void read( histogram_snapshot& target ) const
+    {
+      for( uint32_t i = 0; i < histogram_snapshot::bucket_count; ++i )
+        target.buckets[i] += buckets[i].load( std::memory_order_relaxed );
+      target.count += count.load( std::memory_order_relaxed );
+      target.sum_ns += sum_ns.load( std::memory_order_relaxed );
+    }
+
+    std::array< std::atomic< uint64_t >, histogram_snapshot::bucket_count > buckets;
+    std::atomic< uint64_t > count = { 0 };
+    std::atomic< uint64_t > sum_ns = { 0 };
+  };
+
+  struct counter
+  {
+    void add( uint64_t value )
+    {
+      total.store( total.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+    }
+
+    std::atomic< uint64_t > total = { 0 };
+  };
+
+  thread_data( performance_metrics& _owner ) : owner( _owner )
+  {
+    std::lock_guard< std::mutex > guard( owner._mutex );
+    owner._threads.push_back( this );
+  }
+
+  ~thread_data()
+  {
+    owner.retire( this );
+  }
+
+  void read( std::vector< histogram_snapshot >& target ) const
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    for( size_t i = 0; i < histograms.size() && i < target.size(); ++i )
+      histograms[i].read( target[i] );
+  }
+
+  void read( std::vector< uint64_t >& target ) const
+  {
+    std::lock_guard< std::mutex > guard( mutex );
+    for( size_t i = 0; i < counters.size() && i < target.size(); ++i )
+      target[i] += counters[i].total.load( std::memory_order_relaxed );
+  }
+
+  performance_metrics&    owner;
+  mutable std::mutex      mutex; // guards growth of histograms and counters (owner thread) against reads (other threads)
+  std::deque< histogram > histograms; // index is histogram_id; deque keeps existing elements in place on growth
+  std::deque< counter >   counters; // index is counter_id
+};
+
+performance_metrics& performance_metrics::instance()
+{
+  // intentionally never destroyed - thread local data of threads finishing during exit still refers to it
+  static performance_metrics* _instance = new performance_metrics();
+  return *_instance;
+}
+
+void performance_metrics::describe_family( const std::string& family, const std::string& help )
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  _family_help[ family ] = help;
+}
+
+performance_metrics::histogram_id performance_metrics::get_histogram_id( const std::string& family, const std::string& name )
+{
+  histogram_key key{ family, name };
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  auto found = _ids.find( key );
+  if( found != _ids.end() )
+    return found->second;
+
+  histogram_id id = static_cast< histogram_id >( _histograms.size() );
+  _histograms.push_back( key );
+  _ids.emplace( std::move( key ), id );
+  return id;
+}
+
+performance_metrics::thread_data& performance_metrics::local_data()
+{
+  thread_local std::unique_ptr< thread_data > data( new thread_data( *this ) );
+  return *data;
+}
+
+void performance_metrics::record( histogram_id id, uint64_t ns )
+{
+  thread_data& data = local_data();
+  if( id >= data.histograms.size() )
+  {
+    std::lock_guard< std::mutex > guard( data.mutex );
+    while( id >= data.histograms.size() )
+      data.histograms.emplace_back();
+  }
+  data.histograms[ id ].add( histogram_snapshot::bucket_for( ns ), ns );
+}
+
+performance_metrics::counter_id performance_metrics::get_counter_id( const std::string& family, const std::string& name )
+{
+  metric_key key{ family, name };
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  auto found = _counter_ids.find( key );
+  if( found != _counter_ids.end() )
+    return found->second;
+
+  counter_id id = static_cast< counter_id >( _counters.size() );
+  _counters.push_back( key );
+  _counter_ids.emplace( std::move( key ), id );
+  return id;
+}
+
+void performance_metrics::add( counter_id id, uint64_t value )
+{
+  thread_data& data = local_data();
+  if( id >= data.counters.size() )
+  {
+    std::lock_guard< std::mutex > guard( data.mutex );
+    while( id >= data.counters.size() )
+      data.counters.emplace_back();
+  }
+  data.counters[ id ].add( value );
+}
+
+performance_metrics::gauge& performance_metrics::get_gauge( const std::string& family, const std::string& name )
+{
+  metric_key key{ family, name };
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  auto found = _gauge_by_key.find( key );
+  if( found != _gauge_by_key.end() )
+    return *found->second;
+
+  _gauges.emplace_back();
+  _gauge_by_key.emplace( std::move( key ), &_gauges.back() );
+  return _gauges.back();
+}
+
+performance_metrics::collector_id performance_metrics::add_collector( collector_t collector )
+{
+  std::lock_guard< std::mutex > guard( _collectors_mutex );
+  collector_id id = _next_collector_id++;
+  _collectors.emplace( id, std::move( collector ) );
+  return id;
+}
+
+void performance_metrics::remove_collector( collector_id id )
+{
+  std::lock_guard< std::mutex > guard( _collectors_mutex );
+  _collectors.erase( id );
+}
+
+void performance_metrics::retire( thread_data* data )
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  if( _retired.size() < _histograms.size() )
+    _retired.resize( _histograms.size() );
+  data->read( _retired );
+  if( _retired_counters.size() < _counters.size() )
+    _retired_counters.resize( _counters.size() );
+  data->read( _retired_counters );
+  _threads.erase( std::remove( _threads.begin(), _threads.end(), data ), _threads.end() );
+}
+
+performance_metrics::snapshot_t performance_metrics::collect() const
+{
+  snapshot_t result;
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  std::vector< histogram_snapshot > merged( _histograms.size() );
+  for( size_t i = 0; i < _retired.size(); ++i )
+    merged[i] += _retired[i];
+  for( const thread_data* data : _threads )
+    data->read( merged );
+
+  for( size_t i = 0; i < _histograms.size(); ++i )
+  {
+    if( merged[i].count != 0 )
+      result.emplace( _histograms[i], merged[i] );
+  }
+  return result;
+}
+
+performance_metrics::counter_snapshot_t performance_metrics::collect_counters() const
+{
+  counter_snapshot_t result;
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  std::vector< uint64_t > merged( _counters.size() );
+  for( size_t i = 0; i < _retired_counters.size(); ++i )
+    merged[i] += _retired_counters[i];
+  for( const thread_data* data : _threads )
+    data->read( merged );
+
+  for( size_t i = 0; i < _counters.size(); ++i )
+    result.emplace( _counters[i], merged[i] );
+  return result;
+}
+
+performance_metrics::gauge_snapshot_t performance_metrics::collect_gauges() const
+{
+  gauge_snapshot_t result;
+
+  std::lock_guard< std::mutex > guard( _mutex );
+  for( const auto& entry : _gauge_by_key )
+    result.emplace( entry.first, entry.second->get() );
+  return result;
+}
+
+namespace
+{
+  std::string escape_label_value( const std::string& value )
+  {
+    std::string result;
+    result.reserve( value.size() );
+    for( char c : value )
+    {
+      switch( c )
+      {
+        case '\\': result += "\\\\"; break;
+        case '"': result += "\\\""; break;
+        case '\n': result += "\\n"; break;
+        default: result += c;
+      }
+    }
+    return result;
+  }
+
+  std::string format_seconds( uint64_t value, uint64_t units_per_second, int decimals )
+  {
+    char buffer[64];
+    snprintf( buffer, sizeof( buffer ), "%.*f", decimals, double( value ) / double( units_per_second ) );
+    return buffer;
+  }
+}
+
+std::string performance_metrics::to_prometheus_text() const
+{
+  const snapshot_t snapshot = collect();
+  counter_snapshot_t counters = collect_counters();
+  gauge_snapshot_t gauges = collect_gauges();
+  std::map< std::string, std::string > family_help;
+  {
+    std::lock_guard< std::mutex > guard( _mutex );
+    family_help = _family_help;
+  }
+  {
+    std::vector< collected_value > values;
+    std::lock_guard< std::mutex > guard( _collectors_mutex );
+    for( const auto& collector : _collectors )
+      collector.second( values );
+    for( const auto& value : values )
+    {
+      if( value.is_counter )
+        counters[ value.key ] += value.value;
+      else
+        gauges[ value.key ] = value.value;
+    }
+  }
+
+  std::stringstream ss;
+  std::string current_family;
+  auto write_header = [&]( const std::string& family, const std::string& metric, const char* type )
+  {
+    if( family == current_family )
+      return;
+    current_family = family;
+    auto help = family_help.find( current_family );
+    if( help != family_help.end() )
+      ss << "# HELP " << metric << ' ' << help->second << '\n';
+    ss << "# TYPE " << metric << ' ' << type << '\n';
+  };
+
+  for( const auto& entry : snapshot )
+  {
+    const std::string metric = "hived_" + entry.first.family + "_duration_seconds";
+    write_header( entry.first.family, metric, "histogram" );
+
+    const std::string name = escape_label_value( entry.first.name );
+    const histogram_snapshot& data = entry.second;
+    uint64_t cumulative = 0;
+    for( uint32_t i = 0; i < histogram_snapshot::finite_bucket_count; ++i )
+    {
+      cumulative += data.buckets[i];
+      ss << metric << "_bucket{name=\"" << name << "\",le=\""
+        << format_seconds( histogram_snapshot::bucket_upper_bound_us( i ), 1000000, 6 ) << "\"} " << cumulative << '\n';
+    }
+    ss << metric << "_bucket{name=\"" << name << "\",le=\"+Inf\"} " << data.count << '\n';
+    ss << metric << "_sum{name=\"" << name << "\"} " << format_seconds( data.sum_ns, 1000000000, 9 ) << '\n';
+    ss << metric << "_count{name=\"" << name << "\"} " << data.count << '\n';
+  }
+
+  current_family.clear();
+  for( const auto& entry : counters )
+  {
+    const std::string metric = "hived_" + entry.first.family + "_total";
+    write_header( entry.first.family, metric, "counter" );
+    ss << metric << "{name=\"" << escape_label_value( entry.first.name ) << "\"} " << entry.second << '\n';
+  }
+
+  current_family.clear();
+  for( const auto& entry : gauges )
+  {
+    const std::string metric = "hived_" + entry.first.family;
+    write_header( entry.first.family, metric, "gauge" );
+    ss << metric << "{name=\"" << escape_label_value( entry.first.name ) << "\"} " << entry.second << '\n';
+  }
+  return ss.str();
+}
+
+} } // hive::utilities
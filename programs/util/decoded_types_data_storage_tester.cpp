@@ -39,6 +39,7 @@ void do_job()
     auto begin = std::chrono::steady_clock::now();
 
     dtds.register_new_type<hive::chain::account_object>();
+    dtds.register_new_type<hive::chain::account_cold_object>();
     dtds.register_new_type<hive::chain::account_metadata_object>();
     dtds.register_new_type<hive::chain::account_authority_object>();
     dtds.register_new_type<hive::chain::vesting_delegation_object>();
@@ -77,6 +78,7 @@ void do_job()
     dtds.register_new_type<hive::chain::rc_usage_bucket_object>();
     dtds.register_new_type<hive::plugins::account_by_key::key_lookup_object>();
     dtds.register_new_type<hive::plugins::account_history_rocksdb::volatile_operation_object>();
+    dtds.register_new_type<hive::plugins::account_history_rocksdb::volatile_account_operation_object>();
     dtds.register_new_type<hive::plugins::block_log_info::block_log_hash_state_object>();
     dtds.register_new_type<hive::plugins::block_log_info::block_log_pending_message_object>();
     dtds.register_new_type<hive::plugins::follow::follow_object>();
@@ -0,0 +1,78 @@
+#include "benchmark_harness.hpp"
+
+#include <hive/utilities/git_revision.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace hive { namespace chain { namespace test {
+
+benchmark_registry& benchmark_registry::instance()
+{
+  static benchmark_registry _instance;
+  return _instance;
+}
+
+void benchmark_registry::add( const std::string& name, uint64_t iterations, uint64_t ns )
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  for( auto& result : _results )
+  {
+    if( result.name == name )
+    {
+      result.iterations += iterations;
+      result.total_ns += ns;
+      return;
+    }
+  }
+  benchmark_result result;
+  result.name = name;
+  result.iterations = iterations;
+  result.total_ns = ns;
+  _results.emplace_back( std::move( result ) );
+}
+
+std::vector< benchmark_result > benchmark_registry::get_results() const
+{
+  std::lock_guard< std::mutex > guard( _mutex );
+  std::vector< benchmark_result > results = _results;
+  for( auto& result : results )
+    result.ns_per_iteration = result.iterations ? double( result.total_ns ) / result.iterations : 0.0;
+  return results;
+}
+
+void benchmark_registry::write_report() const
+{
+  fc::mutable_variant_object context;
+  context( "date", fc::time_point::now() )
+    ( "git_revision", hive::utilities::git_revision_sha )
+#ifdef NDEBUG
+    ( "build_type", "release" );
+#else
+    ( "build_type", "debug" );
+#endif
+
+  fc::mutable_variant_object report;
+  report( "context", context )( "benchmarks", get_results() );
+  const std::string json = fc::json::to_pretty_string( fc::variant( report ) );
+
+  const char* output = std::getenv( "HIVE_BENCHMARK_OUTPUT" );
+  if( output != nullptr && *output != '\0' )
+  {
+    std::ofstream file( output, std::ios::out | std::ios::trunc );
+    file << json << '\n';
+    std::cout << "Benchmark results written to " << output << std::endl;
+  }
+  else
+  {
+    std::cout << json << std::endl;
+  }
+}
+
+} } } // hive::chain::test
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hive { namespace chain { namespace test {
+
+/// Accumulated measurements of single benchmark
+struct benchmark_result
+{
+  std::string name;
+  uint64_t    iterations = 0;
+  uint64_t    total_ns = 0;
+  double      ns_per_iteration = 0.0;
+};
+
+/**
+  * Collects results of benchmarks executed by chain_benchmarks and writes them in JSON form
+  * (to file pointed by HIVE_BENCHMARK_OUTPUT environment variable or to standard output) when the
+  * program ends, so results of different builds can be compared.
+  */
+class benchmark_registry
+{
+  public:
+    static benchmark_registry& instance();
+
+    /// adds measurement to benchmark of given name (results of repeated measurements are summed)
+    void add( const std::string& name, uint64_t iterations, uint64_t ns );
+
+    std::vector< benchmark_result > get_results() const;
+    void write_report() const;
+
+  private:
+    benchmark_registry() = default;
+
+    mutable std::mutex                _mutex;
+    std::vector< benchmark_result >   _results; // in order of first measurement
+};
+
+/**
+  * Measures time spent in its scope and records it as given number of iterations of benchmark.
+  * Useful when benchmark has to run in batches with untimed preparation in between.
+  */
+class benchmark_scope
+{
+  public:
+    benchmark_scope( const std::string& name, uint64_t iterations )
+      : _name( name ), _iterations( iterations ), _start( std::chrono::steady_clock::now() ) {}
+    ~benchmark_scope()
+    {
+      benchmark_registry::instance().add( _name, _iterations,
+        std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - _start ).count() );
+    }
+
+  private:
+    std::string                           _name;
+    uint64_t                              _iterations;
+    std::chrono::steady_clock::time_point _start;
+};
+
+/// Runs body (that takes iteration number) given number of times and records total time.
+template< typename Body >
+void run_benchmark( const std::string& name, uint64_t iterations, Body&& body )
+{
+  benchmark_scope scope( name, iterations );
+  for( uint64_t i = 0; i < iterations; ++i )
+    body( i );
+}
+
+} } } // hive::chain::test
+
+FC_REFLECT( hive::chain::test::benchmark_result, (name)(iterations)(total_ns)(ns_per_iteration) )
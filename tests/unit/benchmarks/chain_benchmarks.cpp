@@ -0,0 +1,367 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include <hive/chain/block_log.hpp>
+#include <hive/chain/full_block.hpp>
+#include <hive/chain/full_transaction.hpp>
+#include <hive/chain/hive_objects.hpp>
+
+#include <hive/plugins/chain/chain_plugin.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+
+#include "../db_fixture/clean_database_fixture.hpp"
+#include "benchmark_harness.hpp"
+
+using namespace hive;
+using namespace hive::chain;
+using namespace hive::chain::test;
+using namespace hive::protocol;
+
+namespace
+{
+  /// number of transactions pushed between blocks in evaluator benchmarks
+  constexpr uint32_t evaluator_batch_size = 200;
+  /// number of batches in evaluator benchmarks
+  constexpr uint32_t evaluator_batch_count = 10;
+  /// signatures and authorities are measured separately, evaluator benchmarks skip them
+  constexpr uint32_t evaluator_skip_flags = database::skip_transaction_signatures | database::skip_authority_check;
+}
+
+struct chain_benchmark_fixture : public clean_database_fixture
+{
+  full_transaction_ptr make_transaction( const operation& op, const std::vector< fc::ecc::private_key >& keys = {} )
+  {
+    signed_transaction tx;
+    tx.set_expiration( db->head_block_time() + HIVE_MAX_TIME_UNTIL_EXPIRATION );
+    tx.operations.push_back( op );
+    const auto pack = serialization_mode_controller::get_current_pack();
+    full_transaction_ptr ftx = full_transaction_type::create_from_signed_transaction( tx, pack, false );
+    ftx->sign_transaction( keys, db->get_chain_id(), fc::ecc::fc_canonical, pack );
+    return ftx;
+  }
+
+  /**
+    * Measures evaluator cost of operations produced by make_op( batch, index ). Transactions are
+    * prepared before timing starts and a block is produced (untimed) after each batch.
+    */
+  template< typename MakeOp >
+  void benchmark_operation( const std::string& name, MakeOp&& make_op )
+  {
+    for( uint32_t batch = 0; batch < evaluator_batch_count; ++batch )
+    {
+      std::vector< full_transaction_ptr > transactions;
+      transactions.reserve( evaluator_batch_size );
+      for( uint32_t i = 0; i < evaluator_batch_size; ++i )
+        transactions.emplace_back( make_transaction( make_op( batch, i ) ) );
+
+      {
+        benchmark_scope scope( "evaluator/" + name, transactions.size() );
+        for( const auto& ftx : transactions )
+          get_chain_plugin().push_transaction( ftx, evaluator_skip_flags );
+      }
+      generate_block();
+    }
+  }
+
+  /// produces blocks with transfers to have some nontrivial data in block log
+  void fill_blocks( uint32_t block_count, uint32_t transfers_per_block )
+  {
+    for( uint32_t b = 0; b < block_count; ++b )
+    {
+      for( uint32_t i = 0; i < transfers_per_block; ++i )
+      {
+        transfer_operation op;
+        op.from = HIVE_INIT_MINER_NAME;
+        op.to = HIVE_TEMP_ACCOUNT;
+        op.amount = ASSET( "0.001 TESTS" );
+        op.memo = "fill " + std::to_string( b ) + "/" + std::to_string( i );
+        push_transaction( op, init_account_priv_key );
+      }
+      generate_block();
+    }
+  }
+};
+
+BOOST_FIXTURE_TEST_SUITE( chain_benchmarks, chain_benchmark_fixture )
+
+BOOST_AUTO_TEST_CASE( evaluators )
+{
+  try
+  {
+    auto accounts = performance::generate_accounts( this, evaluator_batch_size );
+    generate_block();
+
+    benchmark_operation( "transfer", [&]( uint32_t batch, uint32_t i )
+    {
+      transfer_operation op;
+      op.from = HIVE_INIT_MINER_NAME;
+      op.to = accounts[i].account;
+      op.amount = ASSET( "0.001 TESTS" );
+      op.memo = std::to_string( batch );
+      return op;
+    } );
+
+    benchmark_operation( "transfer_to_vesting", [&]( uint32_t batch, uint32_t i )
+    {
+      transfer_to_vesting_operation op;
+      op.from = HIVE_INIT_MINER_NAME;
+      op.to = accounts[i].account;
+      op.amount = asset( 1000 + batch, HIVE_SYMBOL );
+      return op;
+    } );
+
+    // every author posts once per batch, so root comment interval is not violated as long as
+    // batches don't exceed minimal interval between root comments
+    generate_blocks( db->head_block_time() + HIVE_MIN_ROOT_COMMENT_INTERVAL );
+    benchmark_operation( "comment", [&]( uint32_t batch, uint32_t i )
+    {
+      comment_operation op;
+      op.author = accounts[i].account;
+      op.permlink = "post-" + std::to_string( batch );
+      op.parent_permlink = "benchmark";
+      op.title = "benchmark";
+      op.body = "benchmark post " + std::to_string( batch );
+      return op;
+    } );
+
+    // every voter votes once per batch (block), so minimal vote interval is kept
+    benchmark_operation( "vote", [&]( uint32_t batch, uint32_t i )
+    {
+      vote_operation op;
+      op.voter = accounts[i].account;
+      op.author = accounts[ ( i + 1 ) % accounts.size() ].account;
+      op.permlink = "post-" + std::to_string( batch );
+      op.weight = HIVE_100_PERCENT;
+      return op;
+    } );
+
+    benchmark_operation( "custom_json", [&]( uint32_t batch, uint32_t i )
+    {
+      custom_json_operation op;
+      op.required_posting_auths.insert( accounts[i].account );
+      op.id = "benchmark";
+      op.json = "{\"batch\":" + std::to_string( batch ) + "}";
+      return op;
+    } );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( serialization )
+{
+  try
+  {
+    fill_blocks( 1, 100 );
+    const auto block = get_chain_plugin().block_reader().read_block_by_num( db->head_block_num() );
+    BOOST_REQUIRE( block );
+    const signed_block& sblock = block->get_block();
+    BOOST_REQUIRE( !sblock.transactions.empty() );
+    const signed_transaction& stx = sblock.transactions.front();
+
+    const std::vector< char > packed_block = fc::raw::pack_to_vector( sblock );
+    const std::vector< char > packed_tx = fc::raw::pack_to_vector( stx );
+
+    // results are only summed up in timed loops and checked after measurement
+    size_t total = 0;
+    run_benchmark( "raw/pack_block", 1000, [&]( uint64_t )
+    {
+      auto data = fc::raw::pack_to_vector( sblock );
+      total += data.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 1000 * packed_block.size() );
+
+    total = 0;
+    run_benchmark( "raw/unpack_block", 1000, [&]( uint64_t )
+    {
+      signed_block unpacked;
+      fc::raw::unpack_from_vector( packed_block, unpacked );
+      total += unpacked.transactions.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 1000 * sblock.transactions.size() );
+
+    total = 0;
+    run_benchmark( "raw/pack_transaction", 100000, [&]( uint64_t )
+    {
+      auto data = fc::raw::pack_to_vector( stx );
+      total += data.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 100000 * packed_tx.size() );
+
+    total = 0;
+    run_benchmark( "raw/unpack_transaction", 100000, [&]( uint64_t )
+    {
+      signed_transaction unpacked;
+      fc::raw::unpack_from_vector( packed_tx, unpacked );
+      total += unpacked.operations.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 100000 * stx.operations.size() );
+
+    total = 0;
+    run_benchmark( "json/block_round_trip", 100, [&]( uint64_t )
+    {
+      auto restored = fc::json::from_string( fc::json::to_string( sblock ), fc::json::format_validation_mode::full ).as< signed_block >();
+      total += restored.transactions.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 100 * sblock.transactions.size() );
+
+    total = 0;
+    run_benchmark( "json/transaction_round_trip", 10000, [&]( uint64_t )
+    {
+      auto restored = fc::json::from_string( fc::json::to_string( stx ), fc::json::format_validation_mode::full ).as< signed_transaction >();
+      total += restored.operations.size();
+    } );
+    BOOST_REQUIRE_EQUAL( total, 10000 * stx.operations.size() );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( signature_recovery )
+{
+  try
+  {
+    transfer_operation op;
+    op.from = HIVE_INIT_MINER_NAME;
+    op.to = HIVE_TEMP_ACCOUNT;
+    op.amount = ASSET( "0.001 TESTS" );
+
+    const auto pack = serialization_mode_controller::get_current_pack();
+    const signed_transaction tx = make_transaction( op, { init_account_priv_key } )->get_transaction();
+
+    size_t recovered = 0;
+    run_benchmark( "crypto/signature_recovery", 1000, [&]( uint64_t )
+    {
+      auto keys = tx.get_signature_keys( db->get_chain_id(), fc::ecc::fc_canonical, pack );
+      recovered += keys.size();
+    } );
+    BOOST_REQUIRE_EQUAL( recovered, 1000u );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( undo_sessions )
+{
+  try
+  {
+    const auto& witness = db->get_account( HIVE_INIT_MINER_NAME );
+    const uint64_t iterations = 10000;
+
+    run_benchmark( "undo/session_undo", iterations, [&]( uint64_t i )
+    {
+      auto session = db->start_undo_session();
+      db->modify( witness, [&]( account_object& a ) { a.post_count = i; } );
+      session.undo();
+    } );
+    run_benchmark( "undo/session_squash", iterations, [&]( uint64_t i )
+    {
+      auto outer = db->start_undo_session();
+      {
+        auto session = db->start_undo_session();
+        db->modify( witness, [&]( account_object& a ) { a.post_count = i; } );
+        session.squash();
+      }
+      outer.undo();
+    } );
+    run_benchmark( "undo/session_push", iterations, [&]( uint64_t i )
+    {
+      auto session = db->start_undo_session();
+      db->modify( witness, [&]( account_object& a ) { a.post_count = i; } );
+      session.push();
+      db->undo();
+    } );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( generic_index )
+{
+  try
+  {
+    const uint32_t count = 10000;
+    std::vector< account_name_type > names;
+    names.reserve( count );
+    for( uint32_t i = 0; i < count; ++i )
+      names.emplace_back( "bench" + std::to_string( i ) );
+
+    auto session = db->start_undo_session();
+    std::vector< const account_object* > objects;
+    objects.reserve( count );
+
+    run_benchmark( "index/create", count, [&]( uint64_t i )
+    {
+      objects.push_back( &db->create< account_object >( names[i] ) );
+    } );
+    run_benchmark( "index/modify", count, [&]( uint64_t i )
+    {
+      db->modify( *objects[i], [&]( account_object& a ) { a.post_count = i; } );
+    } );
+    uint32_t found = 0;
+    run_benchmark( "index/find_by_id", count, [&]( uint64_t i )
+    {
+      found += db->find< account_object >( objects[i]->get_id() ) != nullptr;
+    } );
+    BOOST_REQUIRE_EQUAL( found, count );
+    found = 0;
+    run_benchmark( "index/find_by_name", count, [&]( uint64_t i )
+    {
+      found += db->find_account( names[i] ) != nullptr;
+    } );
+    BOOST_REQUIRE_EQUAL( found, count );
+    run_benchmark( "index/remove", count, [&]( uint64_t i )
+    {
+      db->remove( *objects[i] );
+    } );
+    session.undo();
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( block_log_read )
+{
+  try
+  {
+    fill_blocks( 50, 20 );
+    generate_blocks( HIVE_MAX_WITNESSES ); // make filled blocks irreversible (written to block log)
+    const uint32_t last = db->get_last_irreversible_block_num();
+    BOOST_REQUIRE_GT( last, 50u );
+    const auto& reader = get_chain_plugin().block_reader();
+
+    const uint64_t read_iterations = 10 * last;
+    uint64_t blocks_read = 0;
+    run_benchmark( "block_log/read_block_by_num", read_iterations, [&]( uint64_t i )
+    {
+      blocks_read += reader.read_block_by_num( 1 + i % last ) != nullptr;
+    } );
+    BOOST_REQUIRE_EQUAL( blocks_read, read_iterations );
+
+    // blocks served by block reader might come with their decompressed form cached - separate read-only instance
+    // of block log is used instead, so every iteration reads compressed block from file and decompresses it
+    block_log log( theApp );
+    log.open( theApp.data_dir() / "blockchain" / "block_log", get_chain_plugin().get_thread_pool(), true );
+    const uint32_t first = last - 50;
+    const uint32_t block_count = last - first + 1;
+    uint64_t expected_size = 0;
+    for( uint32_t num = first; num <= last; ++num )
+    {
+      auto raw = log.read_raw_block_data_by_num( num );
+      BOOST_REQUIRE( std::get< 2 >( raw ).attributes.flags == block_log::block_flags::zstd );
+      expected_size += reader.read_block_by_num( num )->get_uncompressed_block_size();
+    }
+
+    uint64_t decompressed_size = 0;
+    run_benchmark( "block_log/read_and_decompress_block", 10 * block_count, [&]( uint64_t i )
+    {
+      auto raw = log.read_raw_block_data_by_num( first + i % block_count );
+      auto decompressed = block_log::decompress_raw_block( std::get< 0 >( raw ).get(), std::get< 1 >( raw ),
+        std::get< 2 >( raw ).attributes );
+      decompressed_size += std::get< 1 >( decompressed );
+    } );
+    log.close();
+    BOOST_REQUIRE_EQUAL( decompressed_size, 10 * expected_size );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,19 @@
+#define BOOST_TEST_MODULE chain_benchmarks
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "benchmark_harness.hpp"
+
+/**
+  * Benchmarks are regular Boost test cases (so they can use database fixtures and be selected with
+  * --run_test), results are collected and reported once all selected cases finish.
+  */
+struct benchmark_report
+{
+  ~benchmark_report()
+  {
+    hive::chain::test::benchmark_registry::instance().write_report();
+  }
+};
+
+BOOST_TEST_GLOBAL_FIXTURE( benchmark_report );
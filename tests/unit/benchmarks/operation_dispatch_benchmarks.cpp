@@ -0,0 +1,89 @@
+#include <boost/test/unit_test.hpp>
+
+#include <hive/protocol/operations.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include "benchmark_harness.hpp"
+
+using namespace hive::chain::test;
+
+namespace
+{
+  /// number of visitations of every operation type in single measurement
+  constexpr uint64_t dispatch_iterations = 1000000;
+
+  /// sums sizes of visited types, so the compiler can't drop the visitation
+  struct size_visitor
+  {
+    typedef void result_type;
+
+    size_t& sum;
+
+    template<typename Type>
+    result_type operator()( const Type& op )const { sum += sizeof( Type ); }
+  };
+
+  /// chain of tag comparisons - the way static_variant used to dispatch visitation
+  template< typename StaticVariant, typename... Ts >
+  struct linear_dispatch;
+
+  template< typename StaticVariant >
+  struct linear_dispatch< StaticVariant >
+  {
+    template< typename Visitor >
+    static void apply( const StaticVariant& sv, const Visitor& v ) { FC_ASSERT( false ); }
+  };
+
+  template< typename StaticVariant, typename T, typename... Ts >
+  struct linear_dispatch< StaticVariant, T, Ts... >
+  {
+    template< typename Visitor >
+    static void apply( const StaticVariant& sv, const Visitor& v )
+    {
+      if( sv.which() == StaticVariant::template tag< T >::value )
+        v( sv.template get< T >() );
+      else
+        linear_dispatch< StaticVariant, Ts... >::apply( sv, v );
+    }
+  };
+
+  template< typename StaticVariant >
+  struct linear_visit;
+
+  template< typename... Ts >
+  struct linear_visit< fc::static_variant< Ts... > > : linear_dispatch< fc::static_variant< Ts... >, Ts... > {};
+}
+
+BOOST_AUTO_TEST_SUITE( operation_dispatch_benchmarks )
+
+/// cost of visitation of operation through comparison chain (as reference) and jump table of static_variant
+BOOST_AUTO_TEST_CASE( operation_visit )
+{
+  try
+  {
+    size_t linear_sum = 0;
+    size_t table_sum = 0;
+    size_visitor linear_visitor{ linear_sum };
+    size_visitor table_visitor{ table_sum };
+
+    for( int64_t type_id = 0; type_id < hive::protocol::operation::count(); ++type_id )
+    {
+      hive::protocol::operation op( type_id );
+      run_benchmark( "operation/visit_comparison_chain", dispatch_iterations, [&]( uint64_t )
+      {
+        linear_visit< hive::protocol::operation >::apply( op, linear_visitor );
+      } );
+      run_benchmark( "operation/visit_jump_table", dispatch_iterations, [&]( uint64_t )
+      {
+        op.visit( table_visitor );
+      } );
+    }
+
+    // both ways have to reach the same types
+    BOOST_REQUIRE_EQUAL( linear_sum, table_sum );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -176,27 +176,31 @@ hive::plugins::chain::chain_plugin& hived_fixture::get_chain_plugin() const
   return *_chain;
 }
 
-json_rpc_database_fixture::json_rpc_database_fixture()
+json_rpc_database_fixture::json_rpc_database_fixture( const config_arg_override_t& extra_config )
 {
   try {
 
   configuration_data.set_initial_asset_supply( INITIAL_TEST_SUPPLY, HBD_INITIAL_TEST_SUPPLY );
 
+  config_arg_override_t config =
+  {
+    config_line_t( { "plugin",
+      { HIVE_ACCOUNT_HISTORY_ROCKSDB_PLUGIN_NAME,
+        HIVE_WITNESS_PLUGIN_NAME,
+        HIVE_JSON_RPC_PLUGIN_NAME,
+        HIVE_BLOCK_API_PLUGIN_NAME,
+        HIVE_DATABASE_API_PLUGIN_NAME,
+        HIVE_CONDENSER_API_PLUGIN_NAME } }
+    ),
+    config_line_t( { "shared-file-size",
+      { std::to_string( 1024 * 1024 * shared_file_size_in_mb_64 ) } }
+    )
+  };
+  config.insert( config.end(), extra_config.begin(), extra_config.end() );
+
   hive::plugins::condenser_api::condenser_api_plugin* denser_api_plugin = nullptr;
   postponed_init(
-    {
-      config_line_t( { "plugin",
-        { HIVE_ACCOUNT_HISTORY_ROCKSDB_PLUGIN_NAME,
-          HIVE_WITNESS_PLUGIN_NAME,
-          HIVE_JSON_RPC_PLUGIN_NAME,
-          HIVE_BLOCK_API_PLUGIN_NAME,
-          HIVE_DATABASE_API_PLUGIN_NAME,
-          HIVE_CONDENSER_API_PLUGIN_NAME } }
-      ),
-      config_line_t( { "shared-file-size",
-        { std::to_string( 1024 * 1024 * shared_file_size_in_mb_64 ) } }
-      )
-    },
+    config,
     &ah_plugin,
     &rpc_plugin,
     &denser_api_plugin
@@ -92,13 +92,16 @@ struct json_rpc_database_fixture : public hived_fixture
 
   public:
 
-    json_rpc_database_fixture();
+    /// @param extra_config additional configuration lines, f.e. options of tested feature
+    json_rpc_database_fixture( const config_arg_override_t& extra_config = config_arg_override_t() );
     virtual ~json_rpc_database_fixture();
 
     void make_array_request( std::string& request, int64_t code = 0, bool is_warning = false, bool is_fail = true );
     fc::variant make_request( std::string& request, int64_t code = 0, bool is_warning = false, bool is_fail = true,
       const char* message = nullptr );
     void make_positive_request( std::string& request );
+
+    hive::plugins::json_rpc::json_rpc_plugin& get_rpc_plugin() { return *rpc_plugin; }
 };
 
 } }
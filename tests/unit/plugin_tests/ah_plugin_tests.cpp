@@ -3,11 +3,257 @@
 
 #include "../db_fixture/clean_database_fixture.hpp"
 
+#include <hive/plugins/account_history_rocksdb/account_history_rocksdb_objects.hpp>
+#include <hive/plugins/account_history_api/account_history_api_plugin.hpp>
+#include <hive/plugins/account_history_api/account_history_api.hpp>
+#include <hive/plugins/witness/witness_plugin.hpp>
+
+#include <hive/chain/util/impacted.hpp>
+
+#include <fc/io/json.hpp>
+
 using namespace hive::chain;
 using namespace hive::protocol;
 using namespace hive::plugins;
 using namespace hive::plugins::account_history_rocksdb;
 
+namespace
+{
+
+/// account history entry - its sequence number and position of the operation in blockchain
+typedef std::tuple< unsigned int, uint32_t, uint32_t, uint32_t > history_entry;
+typedef std::vector< history_entry > history_entries;
+
+uint32_t get_op_type( const rocksdb_operation_object& op )
+{
+  return fc::raw::unpack_from_buffer< operation >( op.serialized_op ).which();
+}
+
+history_entry make_entry( unsigned int sequence, const rocksdb_operation_object& op )
+{
+  return history_entry( sequence, op.block, op.trx_in_block, op.op_in_trx );
+}
+
+/// first `limit` entries of types accepted by `accept_type` found in unfiltered account history
+history_entries expected_history( const account_history_rocksdb_plugin& ah, const account_name_type& account,
+  uint64_t start, uint32_t limit, bool include_reversible, const std::function< bool( uint32_t ) >& accept_type )
+{
+  history_entries result;
+  ah.find_account_history_data( account, start, std::numeric_limits< uint32_t >::max(), include_reversible,
+    [&]( unsigned int sequence, const rocksdb_operation_object& op ) -> bool
+    {
+      if( result.size() < limit && accept_type( get_op_type( op ) ) )
+        result.push_back( make_entry( sequence, op ) );
+      return true;
+    } );
+  std::sort( result.begin(), result.end() );
+  return result;
+}
+
+history_entries expected_history_of_type( const account_history_rocksdb_plugin& ah, const account_name_type& account,
+  uint32_t op_type, uint64_t start, uint32_t limit, bool include_reversible )
+{
+  return expected_history( ah, account, start, limit, include_reversible,
+    [op_type]( uint32_t type ) { return type == op_type; } );
+}
+
+/// entries of given type found with search by type (uses index when maintained) or with filtered search (what is used without index)
+history_entries history_of_type( const account_history_rocksdb_plugin& ah, const account_name_type& account,
+  uint32_t op_type, uint64_t start, uint32_t limit, bool include_reversible, bool search_by_type )
+{
+  history_entries result;
+  auto processor = [&]( unsigned int sequence, const rocksdb_operation_object& op ) -> bool
+  {
+    if( get_op_type( op ) != op_type )
+      return false; // reversible operations are passed regardless of type
+    result.push_back( make_entry( sequence, op ) );
+    return true;
+  };
+  if( search_by_type )
+    ah.find_account_history_data_of_type( account, op_type, start, limit, include_reversible, processor );
+  else
+    ah.find_account_history_data( account, start, limit, include_reversible, processor,
+      [op_type]( uint32_t type ) { return type == op_type; } );
+  std::sort( result.begin(), result.end() );
+  return result;
+}
+
+}
+
+#define GET_LOW_OPERATION(OPERATION) static_cast<uint64_t>( account_history::get_account_history_op_filter_low::OPERATION )
+#define GET_HIGH_OPERATION(OPERATION) static_cast<uint64_t>( account_history::get_account_history_op_filter_high::OPERATION )
+
+/// Node with account history API, optionally maintaining index of account history by operation type.
+struct ah_type_index_fixture : public hived_fixture
+{
+  ah_type_index_fixture( bool index_by_operation_type = true )
+  {
+    configuration_data.set_initial_asset_supply( INITIAL_TEST_SUPPLY, HBD_INITIAL_TEST_SUPPLY );
+
+    account_history::account_history_api_plugin* ah_api_plugin = nullptr;
+    postponed_init(
+      {
+        config_line_t( { "plugin",
+          { HIVE_ACCOUNT_HISTORY_ROCKSDB_PLUGIN_NAME,
+            HIVE_ACCOUNT_HISTORY_API_PLUGIN_NAME,
+            HIVE_WITNESS_PLUGIN_NAME } }
+        ),
+        config_line_t( { "account-history-rocksdb-index-by-operation-type",
+          { index_by_operation_type ? "true" : "false" } }
+        ),
+        config_line_t( { "shared-file-size",
+          { std::to_string( 1024 * 1024 * shared_file_size_in_mb_64 ) } }
+        )
+      },
+      &ah_plugin,
+      &ah_api_plugin
+    );
+
+    account_history_api = ah_api_plugin->api.get();
+    BOOST_REQUIRE( account_history_api );
+
+    init_account_pub_key = init_account_priv_key.get_public_key();
+
+    generate_block();
+    db->set_hardfork( HIVE_BLOCKCHAIN_VERSION.minor_v() );
+    generate_block();
+
+    vest( HIVE_INIT_MINER_NAME, ASSET( "10.000 TESTS" ) );
+
+    // Fill up the rest of the required miners
+    for( int i = HIVE_NUM_INIT_MINERS; i < HIVE_MAX_WITNESSES; i++ )
+    {
+      account_create( HIVE_INIT_MINER_NAME + fc::to_string( i ), init_account_pub_key );
+      fund( HIVE_INIT_MINER_NAME + fc::to_string( i ), HIVE_MIN_PRODUCER_REWARD );
+      witness_create( HIVE_INIT_MINER_NAME + fc::to_string( i ), init_account_priv_key, "foo.bar", init_account_pub_key, HIVE_MIN_PRODUCER_REWARD.amount );
+    }
+
+    validate_database();
+  }
+
+  /// gives alice history of several operation types, with newest operations still reversible
+  void create_mixed_history()
+  {
+    ACTORS( (alice)(bob) )
+    generate_block();
+    fund( "alice", ASSET( "1000.000 TESTS" ) );
+    for( int i = 0; i < 10; ++i )
+    {
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ), std::to_string( i ), alice_private_key );
+      vest( "alice", "alice", ASSET( "1.000 TESTS" ), alice_private_key );
+      if( i % 3 == 0 )
+        transfer_to_savings( "alice", "alice", ASSET( "1.000 TESTS" ), std::to_string( i ), alice_private_key );
+      generate_block();
+    }
+    generate_until_irreversible_block( db->head_block_num() );
+
+    transfer( "alice", "bob", ASSET( "1.000 TESTS" ), "reversible", alice_private_key );
+    vest( "alice", "alice", ASSET( "1.000 TESTS" ), alice_private_key );
+    generate_block();
+  }
+
+  /// compares search by type and filtered search with unfiltered account history for various types, starts and limits
+  void check_history_of_type( const account_name_type& account )
+  {
+    const uint32_t op_types[] = { operation::tag< transfer_operation >::value, operation::tag< transfer_to_vesting_operation >::value,
+      operation::tag< transfer_to_savings_operation >::value, operation::tag< vote_operation >::value };
+    for( uint32_t op_type : op_types )
+      for( bool include_reversible : { false, true } )
+        for( uint64_t start : { uint64_t( -1 ), uint64_t( 20 ), uint64_t( 3 ) } )
+          for( uint32_t limit : { 1u, 5u, 1000u } )
+          {
+            const auto expected = expected_history_of_type( *ah_plugin, account, op_type, start, limit, include_reversible );
+            BOOST_REQUIRE( history_of_type( *ah_plugin, account, op_type, start, limit, include_reversible, true ) == expected );
+            BOOST_REQUIRE( history_of_type( *ah_plugin, account, op_type, start, limit, include_reversible, false ) == expected );
+          }
+  }
+
+  /// compares get_account_history with operation filter with unfiltered account history
+  void check_filtered_account_history( const account_name_type& account, uint64_t filter_low, uint64_t filter_high,
+    const std::function< bool( uint32_t ) >& accept_type )
+  {
+    for( bool include_reversible : { false, true } )
+    {
+      const auto all = account_history_api->get_account_history( { account, uint64_t( -1 ), 1000, include_reversible } ).history;
+      for( uint64_t start : { uint64_t( -1 ), uint64_t( 20 ), uint64_t( 5 ) } )
+        for( uint32_t limit : { 1u, 5u, 1000u } )
+        {
+          if( start < limit - 1 )
+            continue;
+          const auto expected = expected_history( *ah_plugin, account, start, limit, include_reversible, accept_type );
+          const auto filtered = account_history_api->get_account_history(
+            { account, start, limit, include_reversible, filter_low, filter_high } ).history;
+          BOOST_REQUIRE_EQUAL( filtered.size(), expected.size() );
+          auto expected_it = expected.begin();
+          for( const auto& item : filtered )
+          {
+            BOOST_REQUIRE_EQUAL( item.first, std::get< 0 >( *expected_it++ ) );
+            BOOST_REQUIRE( all.count( item.first ) );
+            BOOST_REQUIRE_EQUAL( fc::json::to_string( item.second ), fc::json::to_string( all.at( item.first ) ) );
+          }
+        }
+    }
+  }
+
+  /// filters of get_account_history selecting single type, several types of both halves and only types from upper half
+  void check_filtered_account_history( const account_name_type& account )
+  {
+    const uint32_t transfer_type = operation::tag< transfer_operation >::value;
+    const uint32_t vesting_type = operation::tag< transfer_to_vesting_operation >::value;
+    const uint32_t vesting_completed_type = operation::tag< transfer_to_vesting_completed_operation >::value;
+
+    check_filtered_account_history( account, GET_LOW_OPERATION( transfer_operation ), 0,
+      [=]( uint32_t type ) { return type == transfer_type; } );
+    check_filtered_account_history( account,
+      GET_LOW_OPERATION( transfer_operation ) | GET_LOW_OPERATION( transfer_to_vesting_operation ),
+      GET_HIGH_OPERATION( transfer_to_vesting_completed_operation ),
+      [=]( uint32_t type ) { return type == transfer_type || type == vesting_type || type == vesting_completed_type; } );
+    check_filtered_account_history( account, 0, GET_HIGH_OPERATION( transfer_to_vesting_completed_operation ),
+      [=]( uint32_t type ) { return type == vesting_completed_type; } );
+  }
+
+  /// reversible part of account history against all reversible operations filtered by impacted accounts (the way it used to be found)
+  void check_reversible_history( const account_name_type& account )
+  {
+    history_entries expected;
+    const auto& volatile_idx = db->get_index< account_history_rocksdb::volatile_operation_index, account_history_rocksdb::by_block >();
+    for( const auto& volatile_op : volatile_idx )
+    {
+      flat_set< account_name_type > impacted;
+      hive::app::operation_get_impacted_accounts( fc::raw::unpack_from_buffer< operation >( volatile_op.serialized_op ), impacted );
+      if( impacted.count( account ) )
+        expected.emplace_back( 0, volatile_op.block, volatile_op.trx_in_block, volatile_op.op_in_trx );
+    }
+
+    uint32_t irreversible_count = 0;
+    ah_plugin->find_account_history_data( account, -1, 1, false,
+      [&]( unsigned int sequence, const rocksdb_operation_object& ) -> bool { irreversible_count = sequence + 1; return true; } );
+    history_entries reversible;
+    ah_plugin->find_account_history_data( account, -1, std::numeric_limits< uint32_t >::max(), true,
+      [&]( unsigned int sequence, const rocksdb_operation_object& op ) -> bool
+      {
+        if( sequence >= irreversible_count )
+          reversible.push_back( make_entry( sequence, op ) );
+        return true;
+      } );
+    std::sort( reversible.begin(), reversible.end() );
+
+    BOOST_REQUIRE_EQUAL( reversible.size(), expected.size() );
+    for( size_t i = 0; i < expected.size(); ++i )
+    {
+      std::get< 0 >( expected[i] ) = irreversible_count + i; // reversible entries are numbered after irreversible ones
+      BOOST_REQUIRE( reversible[i] == expected[i] );
+    }
+  }
+
+  account_history::account_history_api* account_history_api = nullptr;
+};
+
+struct ah_no_type_index_fixture : public ah_type_index_fixture
+{
+  ah_no_type_index_fixture() : ah_type_index_fixture( false ) {}
+};
+
 BOOST_FIXTURE_TEST_SUITE( ah_plugin_tests, clean_database_fixture )
 
 BOOST_AUTO_TEST_CASE( get_ops_in_block_zero_bug )
@@ -98,6 +344,240 @@ BOOST_AUTO_TEST_CASE( mutex_reentry_bug )
   FC_LOG_AND_RETHROW()
 }
 
+BOOST_FIXTURE_TEST_CASE( history_of_type_with_type_index, ah_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing search of account history by operation type with index by operation type" );
+
+    create_mixed_history();
+    BOOST_REQUIRE( !expected_history_of_type( *ah_plugin, "alice", operation::tag< transfer_operation >::value, -1, 1000, false ).empty() );
+    // results of search through index are compared with filtered search, that is used when index is not maintained
+    check_history_of_type( "alice" );
+    check_history_of_type( "bob" );
+    check_history_of_type( "nobody" );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( history_of_type_without_type_index, ah_no_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing search of account history by operation type without index by operation type" );
+
+    create_mixed_history();
+    check_history_of_type( "alice" );
+    check_history_of_type( "bob" );
+    check_history_of_type( "nobody" );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( type_index_pruning, ah_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing that pruning of account history removes entries of index by operation type" );
+
+    ACTORS( (alice)(bob) )
+    generate_block();
+    fund( "alice", ASSET( "1000.000 TESTS" ) );
+    for( int i = 0; i < 40; ++i )
+    {
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ), std::to_string( i ), alice_private_key );
+      generate_block();
+    }
+    generate_until_irreversible_block( db->head_block_num() );
+
+    const uint32_t transfer_type = operation::tag< transfer_operation >::value;
+    const auto before = history_of_type( *ah_plugin, "alice", transfer_type, -1, 1000, false, true );
+    BOOST_REQUIRE_GE( before.size(), 40u );
+
+    // next operation, more than 30 days after the oldest one, prunes old entries of alice
+    ah_plugin->set_prune_old_entries();
+    generate_days_blocks( 31 );
+    transfer( "alice", "bob", ASSET( "1.000 TESTS" ), "after", alice_private_key );
+    generate_block();
+    generate_until_irreversible_block( db->head_block_num() );
+    ah_plugin->set_prune_old_entries( false );
+
+    // index entries left behind would point to operations no longer present in account history
+    const auto after = history_of_type( *ah_plugin, "alice", transfer_type, -1, 1000, false, true );
+    BOOST_REQUIRE_LT( after.size(), before.size() );
+    BOOST_REQUIRE( after == history_of_type( *ah_plugin, "alice", transfer_type, -1, 1000, false, false ) );
+    BOOST_REQUIRE( after == expected_history_of_type( *ah_plugin, "alice", transfer_type, -1, 1000, false ) );
+    BOOST_REQUIRE( std::get< 0 >( after.front() ) > std::get< 0 >( before.front() ) );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( reversible_history_across_fork_switch, ah_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing reversible account history when blocks are popped and when last irreversible block moves" );
+
+    create_mixed_history();
+    const auto alice_private_key = generate_private_key( "alice" );
+    const auto bob_private_key = generate_private_key( "bob" );
+    auto check_accounts = [&]()
+    {
+      for( const char* account : { "alice", "bob", HIVE_INIT_MINER_NAME } )
+        check_reversible_history( account );
+    };
+
+    for( int i = 0; i < 3; ++i )
+    {
+      transfer( "bob", "alice", ASSET( "0.001 TESTS" ), "before fork " + std::to_string( i ), bob_private_key );
+      generate_block();
+    }
+    const uint32_t fork_point = db->head_block_num();
+    BOOST_REQUIRE_GT( fork_point, db->get_last_irreversible_block_num() + 2 ); // popped blocks have to be reversible
+    check_accounts();
+
+    // operations of popped blocks are undone together with their links to accounts
+    db->pop_block();
+    db->pop_block();
+    check_accounts();
+
+    // other fork with different operations
+    vest( "alice", "bob", ASSET( "1.000 TESTS" ), alice_private_key );
+    generate_block();
+    transfer_to_savings( "bob", "bob", ASSET( "0.001 TESTS" ), "after fork", bob_private_key );
+    generate_block();
+    generate_block();
+    BOOST_REQUIRE_GT( db->head_block_num(), fork_point );
+    check_accounts();
+
+    // operations of blocks that become irreversible move to persistent storage
+    generate_until_irreversible_block( fork_point );
+    check_accounts();
+    transfer( "alice", "bob", ASSET( "1.000 TESTS" ), "after irreversible", alice_private_key );
+    generate_block();
+    check_accounts();
+    check_history_of_type( "alice" );
+    check_history_of_type( "bob" );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( filtered_account_history, ah_no_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing get_account_history with operation filter against unfiltered account history" );
+
+    create_mixed_history();
+    check_filtered_account_history( "alice" );
+    check_filtered_account_history( "bob" );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( filtered_account_history_scan_limit, ah_no_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing limit of entries visited by get_account_history with operation filter" );
+
+    ACTORS( (alice)(bob) )
+    generate_block();
+    fund( "alice", ASSET( "1000.000 TESTS" ) );
+    transfer_to_savings( "alice", "alice", ASSET( "1.000 TESTS" ), "older", alice_private_key );
+    generate_block();
+    for( int i = 0; i < 20; ++i )
+    {
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ), std::to_string( i ), alice_private_key );
+      generate_block();
+    }
+    transfer_to_savings( "alice", "alice", ASSET( "1.000 TESTS" ), "newer", alice_private_key );
+    generate_block();
+    for( int i = 0; i < 3; ++i )
+    {
+      transfer( "alice", "bob", ASSET( "1.000 TESTS" ), std::to_string( i ), alice_private_key );
+      generate_block();
+    }
+    generate_until_irreversible_block( db->head_block_num() );
+
+    const uint64_t savings_filter = GET_LOW_OPERATION( transfer_to_savings_operation );
+    auto found = account_history_api->get_account_history( { "alice", uint64_t( -1 ), 2, false, savings_filter } ).history;
+    BOOST_REQUIRE_EQUAL( found.size(), 2u );
+    const uint32_t older_sequence = found.begin()->first;
+    const uint32_t newer_sequence = found.rbegin()->first;
+    BOOST_REQUIRE_GT( newer_sequence - older_sequence, 20u );
+
+    ah_plugin->set_max_filtered_entries_scanned( 10 );
+
+    // nothing found within limit - caller is told where to continue
+    BOOST_REQUIRE_THROW( account_history_api->get_account_history( { "alice", newer_sequence - 1, 1, false, savings_filter } ),
+      fc::assert_exception );
+    found = account_history_api->get_account_history( { "alice", older_sequence + 5, 1, false, savings_filter } ).history;
+    BOOST_REQUIRE_EQUAL( found.size(), 1u );
+    BOOST_REQUIRE_EQUAL( found.begin()->first, older_sequence );
+
+    // limit reached after something was found - partial result is returned
+    found = account_history_api->get_account_history( { "alice", uint64_t( -1 ), 2, false, savings_filter } ).history;
+    BOOST_REQUIRE_EQUAL( found.size(), 1u );
+    BOOST_REQUIRE_EQUAL( found.begin()->first, newer_sequence );
+
+    // the same applies to search by type of plugin
+    uint32_t count = 0;
+    auto processor = [&]( unsigned int, const rocksdb_operation_object& ) -> bool { ++count; return true; };
+    BOOST_REQUIRE_THROW( ah_plugin->find_account_history_data_of_type( "alice", operation::tag< transfer_to_savings_operation >::value,
+      newer_sequence - 1, 1, false, processor ), fc::assert_exception );
+    BOOST_REQUIRE_EQUAL( count, 0u );
+
+    ah_plugin->set_max_filtered_entries_scanned( 1000000 );
+    found = account_history_api->get_account_history( { "alice", uint64_t( -1 ), 2, false, savings_filter } ).history;
+    BOOST_REQUIRE_EQUAL( found.size(), 2u );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( legacy_store_upgrade, ah_type_index_fixture )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing account history store created by version 1.1 of the plugin (entries without operation type)" );
+
+    create_mixed_history();
+    generate_until_irreversible_block( db->head_block_num() );
+    const auto history_before = account_history_api->get_account_history( { "alice", uint64_t( -1 ), 1000, false } ).history;
+
+    ah_plugin->downgrade_store_and_reopen();
+
+    // type of legacy entries is unknown, so filtered search passes all of them to the processor
+    auto count_passed_by_filter = [&]() -> uint32_t
+    {
+      uint32_t passed = 0;
+      ah_plugin->find_account_history_data( "alice", -1, 1000, false,
+        [&]( unsigned int, const rocksdb_operation_object& ) -> bool { ++passed; return false; },
+        []( uint32_t ) { return false; } );
+      return passed;
+    };
+    BOOST_REQUIRE_EQUAL( count_passed_by_filter(), history_before.size() );
+
+    const auto history_after = account_history_api->get_account_history( { "alice", uint64_t( -1 ), 1000, false } ).history;
+    BOOST_REQUIRE_EQUAL( fc::json::to_string( history_after ), fc::json::to_string( history_before ) );
+    check_filtered_account_history( "alice" );
+    check_history_of_type( "alice" );
+
+    // entries written after upgrade carry operation type again
+    const auto alice_private_key = generate_private_key( "alice" );
+    transfer( "alice", "bob", ASSET( "1.000 TESTS" ), "after upgrade", alice_private_key );
+    vest( "alice", "alice", ASSET( "1.000 TESTS" ), alice_private_key );
+    generate_block();
+    generate_until_irreversible_block( db->head_block_num() );
+    BOOST_REQUIRE_GT( account_history_api->get_account_history( { "alice", uint64_t( -1 ), 1000, false } ).history.size(),
+      history_before.size() );
+    BOOST_REQUIRE_EQUAL( count_passed_by_filter(), history_before.size() );
+    check_filtered_account_history( "alice" );
+    check_history_of_type( "alice" );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
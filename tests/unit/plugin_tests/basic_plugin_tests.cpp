@@ -28,6 +28,8 @@ BOOST_AUTO_TEST_CASE( plugin_object_size )
 
   BOOST_CHECK_EQUAL( sizeof( account_history_rocksdb::volatile_operation_object ), 112u ); //temporary, at most as many as operations in reversible blocks
   BOOST_CHECK_EQUAL( sizeof( account_history_rocksdb::volatile_operation_index::MULTIINDEX_NODE_TYPE ), 176u );
+  BOOST_CHECK_EQUAL( sizeof( account_history_rocksdb::volatile_account_operation_object ), 32u ); //temporary, as many as accounts impacted by operations in reversible blocks
+  BOOST_CHECK_EQUAL( sizeof( account_history_rocksdb::volatile_account_operation_index::MULTIINDEX_NODE_TYPE ), 128u );
 
   //BOOST_CHECK_EQUAL( sizeof( block_log_info::block_log_hash_state_object ), 0 );
   //BOOST_CHECK_EQUAL( sizeof( block_log_info::block_log_pending_message_object ), 0 );
@@ -67,11 +69,12 @@ BOOST_AUTO_TEST_CASE( plugin_object_checksum )
   util::decoded_types_data_storage dtds;
 
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::account_by_key::key_lookup_object>(dtds), "b15664037aaf526e9abf4e295abc58bac301c813" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::account_history_rocksdb::volatile_operation_object>(dtds), "009775c2d4bf3384fa99c350674151b5c5c46b2a" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::account_history_rocksdb::volatile_operation_object>(dtds), "48c61e249c3adc75d38eba70bca05637220d36ed" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::account_history_rocksdb::volatile_account_operation_object>(dtds), "a2df2fa03b72fe14771b453c9ce3a161b12b491f" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::block_log_info::block_log_hash_state_object>(dtds), "1ad502e939386f07fb513d48c8c07f9ff5a76a6a" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::block_log_info::block_log_pending_message_object>(dtds), "b7da18e0b992b242d903ac255ca3023151db5e16" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::follow_object>(dtds), "ec79acbc66b8210e1e6cd31c5edc8fc5d86618fe" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::feed_object>(dtds), "e81464ef261de05536c9ebfb72fbd401400516e3" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::feed_object>(dtds), "3bc13ff2076d96929b269301db657ea5fc851674" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::blog_object>(dtds), "f937a7645c6d33f37ddc38b1d72546abc6724aa5" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::blog_author_stats_object>(dtds), "58e3ac97c4bc94439018638905b3bc9ff14fb7ce" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::plugins::follow::reputation_object>(dtds), "49ee99bdff6ef39bc07ec1c8512a2e8818c74c8b" );
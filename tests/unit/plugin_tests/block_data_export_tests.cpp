@@ -0,0 +1,192 @@
+#ifdef IS_TEST_NET
+#include <boost/test/unit_test.hpp>
+
+#include "../db_fixture/hived_fixture.hpp"
+
+#include <hive/plugins/block_data_export/block_data_export_plugin.hpp>
+#include <hive/plugins/block_data_export/exportable_block_data.hpp>
+#include <hive/plugins/block_data_export/export_records.hpp>
+
+#include <hive/utilities/tempdir.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/variant_object.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+using namespace hive::chain;
+using namespace hive::protocol;
+using namespace hive::plugins::block_data_export;
+
+namespace
+{
+
+/// export data holding number of block it was created for
+class test_export_data : public exportable_block_data
+{
+  public:
+    test_export_data( uint32_t block_num, bool direct_binary ) : _block_num( block_num ), _direct_binary( direct_binary ) {}
+
+    virtual void to_variant( fc::variant& v )const override
+    {
+      v = fc::mutable_variant_object( "block_num", _block_num );
+    }
+
+    virtual void to_binary( std::vector< char >& data )const override
+    {
+      if( _direct_binary )
+        data = fc::raw::pack_to_vector( _block_num );
+      else
+        exportable_block_data::to_binary( data );
+    }
+
+  private:
+    uint32_t _block_num;
+    bool     _direct_binary;
+};
+
+/// reverses test_export_data::to_binary
+uint32_t unpack_block_num( const std::vector< char >& data, bool direct_binary )
+{
+  if( direct_binary )
+  {
+    uint32_t block_num = 0;
+    fc::raw::unpack_from_vector( data, block_num );
+    return block_num;
+  }
+  fc::variant v;
+  fc::raw::unpack_from_vector( data, v );
+  return v[ "block_num" ].as< uint32_t >();
+}
+
+struct block_data_export_fixture : public hived_fixture
+{
+  fc::temp_directory export_dir;
+  fc::path           export_file;
+  /// ids of blocks produced after export data was registered
+  std::vector< block_id_type > exported_blocks;
+
+  block_data_export_fixture() : export_dir( hive::utilities::temp_directory_path() ), export_file( export_dir.path() / "export.bin" ) {}
+
+  void init( const std::string& format )
+  {
+    block_data_export_plugin* export_plugin = nullptr;
+    postponed_init(
+      {
+        config_line_t( { "plugin", { HIVE_BLOCK_DATA_EXPORT_PLUGIN_NAME } } ),
+        config_line_t( { "block-data-export-file", { export_file.string() } } ),
+        config_line_t( { "block-data-export-format", { format } } ),
+        config_line_t( { "shared-file-size",
+          { std::to_string( 1024 * 1024 * shared_file_size_in_mb_64 ) } }
+        )
+      },
+      &export_plugin
+    );
+
+    // "alpha" is serialized directly, "beta" through default (variant) serialization
+    export_plugin->register_export_data_factory( "alpha", [this]() -> std::shared_ptr< exportable_block_data >
+      { return std::make_shared< test_export_data >( db->head_block_num() + 1, true ); } );
+    export_plugin->register_export_data_factory( "beta", [this]() -> std::shared_ptr< exportable_block_data >
+      { return std::make_shared< test_export_data >( db->head_block_num() + 1, false ); } );
+
+    for( int i = 0; i < 10; ++i )
+    {
+      generate_block();
+      exported_blocks.push_back( db->head_block_id() );
+    }
+  }
+
+  /// reads records from export file once output thread writes record of last exported block
+  template< typename Record >
+  std::vector< Record > wait_for_records( const fc::path& file )const
+  {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 10 );
+    std::vector< Record > records;
+    do
+    {
+      records.clear();
+      std::ifstream in( file.string(), std::ios::binary );
+      Record record;
+      try
+      {
+        while( read_export_record( in, record ) )
+          records.push_back( record );
+      }
+      catch( const fc::exception& )
+      {
+        // last record is not completely written yet
+      }
+      if( !records.empty() && records.back().block_id == exported_blocks.back() )
+        return records;
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+    while( std::chrono::steady_clock::now() < deadline );
+    BOOST_FAIL( "Block data export file " + file.string() + " is missing records" );
+    return records;
+  }
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( block_data_export_tests, block_data_export_fixture )
+
+BOOST_AUTO_TEST_CASE( binary_round_trip )
+{
+  try
+  {
+    init( "binary" );
+
+    const auto records = wait_for_records< binary_export_record >( export_file );
+    BOOST_REQUIRE_GE( records.size(), exported_blocks.size() );
+    for( size_t i = 1; i < records.size(); ++i )
+      BOOST_REQUIRE( records[i].previous == records[i-1].block_id );
+
+    // blocks from before registration of export data are exported without entries
+    const size_t first = records.size() - exported_blocks.size();
+    for( size_t i = 0; i < first; ++i )
+      BOOST_REQUIRE( records[i].export_data.empty() );
+    for( size_t i = 0; i < exported_blocks.size(); ++i )
+    {
+      const auto& record = records[ first + i ];
+      const uint32_t block_num = block_header::num_from_id( exported_blocks[i] );
+      BOOST_REQUIRE( record.block_id == exported_blocks[i] );
+      BOOST_REQUIRE_EQUAL( record.export_data.size(), 2u );
+      BOOST_REQUIRE_EQUAL( record.export_data[0].name, "alpha" );
+      BOOST_REQUIRE_EQUAL( unpack_block_num( record.export_data[0].data, true ), block_num );
+      BOOST_REQUIRE_EQUAL( record.export_data[1].name, "beta" );
+      BOOST_REQUIRE_EQUAL( unpack_block_num( record.export_data[1].data, false ), block_num );
+    }
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( binary_per_type_round_trip )
+{
+  try
+  {
+    init( "binary-per-type" );
+
+    for( const auto& type : { std::make_pair( std::string( "alpha" ), true ), std::make_pair( std::string( "beta" ), false ) } )
+    {
+      BOOST_TEST_MESSAGE( "Checking export file of " << type.first );
+      const auto records = wait_for_records< per_type_export_record >( export_file.string() + "." + type.first );
+      BOOST_REQUIRE_EQUAL( records.size(), exported_blocks.size() );
+      for( size_t i = 0; i < exported_blocks.size(); ++i )
+      {
+        BOOST_REQUIRE( records[i].block_id == exported_blocks[i] );
+        if( i > 0 )
+          BOOST_REQUIRE( records[i].previous == exported_blocks[i-1] );
+        BOOST_REQUIRE_EQUAL( unpack_block_num( records[i].data, type.second ), block_header::num_from_id( exported_blocks[i] ) );
+      }
+    }
+    // there is no main export file in this format
+    BOOST_REQUIRE( !fc::exists( export_file ) );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
@@ -5,9 +5,15 @@
 #include <hive/chain/comment_object.hpp>
 #include <hive/protocol/hive_operations.hpp>
 #include <hive/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <hive/plugins/block_api/block_api_plugin.hpp>
+#include <hive/plugins/block_api/block_api.hpp>
+#include <hive/plugins/condenser_api/condenser_api_plugin.hpp>
+#include <hive/plugins/condenser_api/condenser_api.hpp>
 
 #include "../db_fixture/hived_fixture.hpp"
 
+#include <thread>
+
 using namespace hive::chain;
 using namespace hive::protocol;
 
@@ -337,5 +343,132 @@ BOOST_AUTO_TEST_CASE( semantics_validation )
   FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( parallel_batch )
+{
+  try
+  {
+    std::string request = "[";
+    for( int i = 0; i < 20; ++i )
+    {
+      if( i )
+        request += ",";
+      if( i % 5 == 4 ) // some elements fail
+        request += "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.list_accounts\", \"params\":{}, \"id\":" + std::to_string( i ) + "}";
+      else
+        request += "{\"jsonrpc\":\"2.0\", \"method\":\"call\", \"params\":[\"database_api\", \"get_dynamic_global_properties\"], \"id\":" + std::to_string( i ) + "}";
+    }
+    request += "]";
+
+    const std::string serial = get_rpc_plugin().call( request );
+
+    std::vector< std::thread > threads;
+    hive::plugins::json_rpc::batch_execution execution;
+    execution.post = [&]( std::function< void() > task ) { threads.emplace_back( std::move( task ) ); };
+    execution.max_concurrency = 4;
+    const std::string parallel = get_rpc_plugin().call( request, execution );
+    for( auto& t : threads )
+      t.join();
+
+    BOOST_REQUIRE_EQUAL( threads.size(), 3u );
+    BOOST_REQUIRE_EQUAL( serial, parallel );
+
+    fc::variant answer = fc::json::from_string( parallel, fc::json::format_validation_mode::full );
+    BOOST_REQUIRE( answer.is_array() );
+    BOOST_REQUIRE_EQUAL( answer.get_array().size(), 20u );
+    for( int i = 0; i < 20; ++i )
+    {
+      const auto& response = answer.get_array()[i].get_object();
+      BOOST_REQUIRE_EQUAL( response[ "id" ].as_int64(), i );
+      BOOST_REQUIRE_EQUAL( response.contains( "error" ), i % 5 == 4 );
+    }
+
+    // requests rejected without execution get error for each element, with matching ids
+    auto summary = get_rpc_plugin().scan_request( request );
+    BOOST_REQUIRE( summary.is_batch );
+    BOOST_REQUIRE_EQUAL( summary.methods.size(), 20u );
+    BOOST_REQUIRE_EQUAL( summary.methods[0], "database_api.get_dynamic_global_properties" );
+    BOOST_REQUIRE_EQUAL( summary.methods[4], "database_api.list_accounts" );
+
+    answer = fc::json::from_string( get_rpc_plugin().make_error_response( summary, JSON_RPC_SERVER_BUSY, "busy" ), fc::json::format_validation_mode::full );
+    BOOST_REQUIRE_EQUAL( answer.get_array().size(), 20u );
+    BOOST_REQUIRE_EQUAL( answer.get_array()[7][ "id" ].as_int64(), 7 );
+    BOOST_REQUIRE_EQUAL( answer.get_array()[7][ "error" ][ "code" ].as_int64(), JSON_RPC_SERVER_BUSY );
+
+    // scan decodes names the same way as parser, first of duplicated keys wins, skipped values may nest
+    summary = get_rpc_plugin().scan_request( "{\"params\":{\"a\":[[{\"method\":\"x\"}]]},\"method\":\"database_api.\\list_accounts\",\"method\":\"y\",\"id\":\"7\"}" );
+    BOOST_REQUIRE( !summary.is_batch );
+    BOOST_REQUIRE_EQUAL( summary.methods.size(), 1u );
+    BOOST_REQUIRE_EQUAL( summary.methods[0], "database_api.list_accounts" );
+    BOOST_REQUIRE_EQUAL( summary.ids[0].as_string(), "7" );
+    BOOST_REQUIRE( get_rpc_plugin().scan_request( "[{\"method\":\"call\",\"params\":[\"database_api\"" ).methods.empty() );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
+/// JSON cache of block_api is off by default - only this fixture enables it
+struct json_rpc_block_cache_fixture : public json_rpc_database_fixture
+{
+  json_rpc_block_cache_fixture() : json_rpc_database_fixture( { config_line_t( { "block-api-json-cache-size", { "16" } } ) } ) {}
+};
+
+BOOST_FIXTURE_TEST_CASE( block_json_cache, json_rpc_block_cache_fixture )
+{
+  try
+  {
+    auto& block_api_plugin = theApp.get_plugin< hive::plugins::block_api::block_api_plugin >();
+    auto& condenser_api_plugin = theApp.get_plugin< hive::plugins::condenser_api::condenser_api_plugin >();
+    BOOST_REQUIRE( block_api_plugin.json_cache );
+
+    generate_blocks( 20 );
+    const uint32_t head = db->head_block_num();
+
+    // serialization is asynchronous
+    const auto cache_format = 0; // block_api is first to register its format
+    const auto legacy_format = 1; // condenser_api registers its format next
+    for( int i = 0; i < 100 && !( block_api_plugin.json_cache->get( cache_format, head ) &&
+      block_api_plugin.json_cache->get( legacy_format, head ) ); ++i )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+    BOOST_REQUIRE( block_api_plugin.json_cache->get( cache_format, head ) );
+    BOOST_REQUIRE( block_api_plugin.json_cache->get( legacy_format, head ) );
+    // only most recent blocks are kept
+    BOOST_REQUIRE( !block_api_plugin.json_cache->get( cache_format, head - 16 ) );
+
+    auto expected_response = []( const fc::variant& result, int id )
+    {
+      return "{\"jsonrpc\":\"2.0\",\"result\":" + fc::json::to_string( result ) + ",\"id\":" + std::to_string( id ) + "}";
+    };
+
+    // cached responses have to be the same as regular ones
+    std::string request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":" + std::to_string( head ) + "}, \"id\":1}";
+    BOOST_REQUIRE_EQUAL( get_rpc_plugin().call( request ),
+      expected_response( fc::variant( block_api_plugin.api->get_block( { head } ) ), 1 ) );
+
+    request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block_range\", \"params\":{\"starting_block_num\":" + std::to_string( head - 2 ) + ", \"count\":10}, \"id\":2}";
+    BOOST_REQUIRE_EQUAL( get_rpc_plugin().call( request ),
+      expected_response( fc::variant( block_api_plugin.api->get_block_range( { head - 2, 10 } ) ), 2 ) );
+
+    // range reaching out of cache is served regularly
+    request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block_range\", \"params\":{\"starting_block_num\":" + std::to_string( head - 19 ) + ", \"count\":20}, \"id\":3}";
+    BOOST_REQUIRE_EQUAL( get_rpc_plugin().call( request ),
+      expected_response( fc::variant( block_api_plugin.api->get_block_range( { head - 19, 20 } ) ), 3 ) );
+
+    std::vector< fc::variant > condenser_args = { fc::variant( head ) };
+    request = "{\"jsonrpc\":\"2.0\", \"method\":\"call\", \"params\":[\"condenser_api\", \"get_block\", [" + std::to_string( head ) + "]], \"id\":4}";
+    BOOST_REQUIRE_EQUAL( get_rpc_plugin().call( request ),
+      expected_response( fc::variant( condenser_api_plugin.api->get_block( condenser_args ) ), 4 ) );
+
+    // popped block is no longer served from cache
+    db->pop_block();
+    BOOST_REQUIRE( !block_api_plugin.json_cache->get( cache_format, head ) );
+    generate_block();
+    for( int i = 0; i < 100 && !block_api_plugin.json_cache->get( cache_format, head ); ++i )
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+    request = "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":" + std::to_string( head ) + "}, \"id\":5}";
+    BOOST_REQUIRE_EQUAL( get_rpc_plugin().call( request ),
+      expected_response( fc::variant( block_api_plugin.api->get_block( { head } ) ), 5 ) );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
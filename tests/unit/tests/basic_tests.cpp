@@ -27,6 +27,7 @@
 #include <hive/chain/hive_fwd.hpp>
 
 #include <hive/chain/database.hpp>
+#include <hive/chain/database_exceptions.hpp>
 #include <hive/protocol/protocol.hpp>
 
 #include <hive/protocol/hive_operations.hpp>
@@ -41,6 +42,8 @@
 
 #include <hive/chain/util/decoded_types_data_storage.hpp>
 
+#include <hive/utilities/performance_metrics.hpp>
+
 #ifdef HIVE_ENABLE_SMT
 
 #include <hive/chain/smt_objects/smt_token_object.hpp>
@@ -558,6 +561,176 @@ BOOST_AUTO_TEST_CASE( adjust_balance_test )
   BOOST_REQUIRE( db->get_balance( "alice", HBD_SYMBOL ) == asset( 0, HBD_SYMBOL ) );
 }
 
+BOOST_AUTO_TEST_CASE( validate_block_invariants_test )
+{
+  ACTORS( (alice) );
+
+  generate_block();
+
+  BOOST_TEST_MESSAGE( "Testing validate_block_invariants" );
+
+  auto session = db->start_undo_session();
+  BOOST_REQUIRE( db->validate_block_invariants() );
+
+  BOOST_TEST_MESSAGE( " --- Balance change without supply change" );
+  db->adjust_balance( "alice", asset( 50000, HIVE_SYMBOL ) );
+  HIVE_REQUIRE_THROW( db->validate_block_invariants(), fc::assert_exception );
+
+  BOOST_TEST_MESSAGE( " --- Balance change matched by supply change" );
+  db->adjust_supply( asset( 50000, HIVE_SYMBOL ) );
+  BOOST_REQUIRE( db->validate_block_invariants() );
+
+  BOOST_TEST_MESSAGE( " --- Transfer between balance objects" );
+  db->adjust_balance( "alice", asset( -20000, HIVE_SYMBOL ) );
+  db->adjust_savings_balance( db->get_account( "alice" ), asset( 20000, HIVE_SYMBOL ) );
+  BOOST_REQUIRE( db->validate_block_invariants() );
+
+  session.undo();
+  validate_database();
+}
+
+BOOST_AUTO_TEST_CASE( performance_metrics_test )
+{
+  using hive::utilities::performance_metrics;
+  using hive::utilities::histogram_snapshot;
+
+  BOOST_TEST_MESSAGE( "Testing histogram buckets" );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( 0 ), 0u );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( 999 ), 0u );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( 1000 ), 1u );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( 3999 ), 2u );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( 4000 ), 3u );
+  BOOST_REQUIRE_EQUAL( histogram_snapshot::bucket_for( uint64_t( 1 ) << 40 ), histogram_snapshot::finite_bucket_count );
+
+  auto& metrics = performance_metrics::instance();
+  const bool was_enabled = metrics.is_enabled();
+  metrics.set_enabled( true );
+
+  BOOST_TEST_MESSAGE( "Testing samples recorded on multiple threads" );
+  auto id = metrics.get_histogram_id( "test", "performance_metrics_test" );
+  BOOST_REQUIRE_EQUAL( id, metrics.get_histogram_id( "test", "performance_metrics_test" ) );
+  performance_metrics::histogram_key key{ "test", "performance_metrics_test" };
+  histogram_snapshot before;
+  {
+    auto snapshot = metrics.collect();
+    if( snapshot.count( key ) )
+      before = snapshot[ key ];
+  }
+
+  metrics.record( id, 500 );
+  std::thread worker( [&]() { metrics.record( id, 5000 ); metrics.record( id, 5000 ); } );
+  worker.join();
+
+  histogram_snapshot delta = metrics.collect()[ key ] - before;
+  BOOST_REQUIRE_EQUAL( delta.count, 3u );
+  BOOST_REQUIRE_EQUAL( delta.sum_ns, 10500u );
+  BOOST_REQUIRE_EQUAL( delta.buckets[0], 1u );
+  BOOST_REQUIRE_EQUAL( delta.buckets[3], 2u );
+  BOOST_REQUIRE_EQUAL( delta.quantile_us( 0.5 ), 8u );
+
+  BOOST_TEST_MESSAGE( "Testing block processing metrics" );
+  ACTORS( (alice) );
+  generate_block();
+
+  auto snapshot = metrics.collect();
+  BOOST_REQUIRE( snapshot.count( { "block_phase", "process_funds" } ) );
+  BOOST_REQUIRE( snapshot.count( { "block_phase", "process_comment_cashout" } ) );
+  BOOST_REQUIRE( snapshot.count( { "evaluator", "account_create_operation" } ) );
+
+  const std::string text = metrics.to_prometheus_text();
+  BOOST_REQUIRE( text.find( "# TYPE hived_block_phase_duration_seconds histogram" ) != std::string::npos );
+  BOOST_REQUIRE( text.find( "hived_test_duration_seconds_bucket{name=\"performance_metrics_test\",le=\"+Inf\"}" ) != std::string::npos );
+
+  BOOST_TEST_MESSAGE( "Testing counters, gauges and collectors" );
+  performance_metrics::metric_key counter_key{ "test_counter", "performance_metrics_test" };
+  auto counter = metrics.get_counter_id( counter_key.family, counter_key.name );
+  const uint64_t counter_before = metrics.collect_counters()[ counter_key ];
+  metrics.add( counter, 2 );
+  std::thread counting_worker( [&]() { metrics.add( counter ); } );
+  counting_worker.join();
+  BOOST_REQUIRE_EQUAL( metrics.collect_counters()[ counter_key ] - counter_before, 3u );
+
+  performance_metrics::metric_key gauge_key{ "test_gauge", "performance_metrics_test" };
+  metrics.get_gauge( gauge_key.family, gauge_key.name ).set( -7 );
+  BOOST_REQUIRE_EQUAL( &metrics.get_gauge( gauge_key.family, gauge_key.name ), &metrics.get_gauge( gauge_key.family, gauge_key.name ) );
+  BOOST_REQUIRE_EQUAL( metrics.collect_gauges()[ gauge_key ], -7 );
+
+  auto collector = metrics.add_collector( []( std::vector< performance_metrics::collected_value >& values )
+  {
+    values.push_back( { { "test_collected", "performance_metrics_test" }, false, 42 } );
+  } );
+  std::string exported = metrics.to_prometheus_text();
+  BOOST_REQUIRE( exported.find( "# TYPE hived_test_counter_total counter" ) != std::string::npos );
+  BOOST_REQUIRE( exported.find( "hived_test_gauge{name=\"performance_metrics_test\"} -7" ) != std::string::npos );
+  BOOST_REQUIRE( exported.find( "hived_test_collected{name=\"performance_metrics_test\"} 42" ) != std::string::npos );
+  metrics.remove_collector( collector );
+  exported = metrics.to_prometheus_text();
+  BOOST_REQUIRE( exported.find( "hived_test_collected" ) == std::string::npos );
+
+  metrics.set_enabled( was_enabled );
+}
+
+BOOST_AUTO_TEST_CASE( async_block_notification_test )
+{
+  ACTORS( (alice) );
+  generate_block();
+
+  BOOST_TEST_MESSAGE( "Testing delivery of asynchronous block notifications" );
+
+  // handler runs on dispatcher thread - it only records what it got, checks are done here
+  std::vector< uint32_t > blocks;
+  uint32_t transfers = 0;
+  uint32_t mismatched_operations = 0;
+  std::thread::id handler_thread;
+  auto connection = db->add_async_post_apply_block_handler( [&]( const async_block_notification& note )
+  {
+    blocks.push_back( note.block_num );
+    for( const auto& op_note : note.operations )
+    {
+      if( op_note.block != note.block_num )
+        ++mismatched_operations;
+      if( op_note.op.which() == operation::tag< transfer_operation >::value )
+        ++transfers;
+    }
+    handler_thread = std::this_thread::get_id();
+  }, *db_plugin );
+
+  fund( "alice", ASSET( "1.000 TESTS" ) );
+  generate_block();
+  generate_block();
+  db->flush_async_notifications();
+
+  BOOST_REQUIRE_EQUAL( blocks.size(), 2u );
+  BOOST_REQUIRE_EQUAL( blocks.back(), db->head_block_num() );
+  BOOST_REQUIRE_EQUAL( blocks.front() + 1, blocks.back() );
+  BOOST_REQUIRE_EQUAL( transfers, 1u );
+  BOOST_REQUIRE_EQUAL( mismatched_operations, 0u );
+  BOOST_REQUIRE( handler_thread != std::this_thread::get_id() );
+
+  BOOST_TEST_MESSAGE( "Notification of block that failed is dropped" );
+  bool fail_block = true;
+  auto failing_connection = db->add_post_apply_block_handler( [&]( const block_notification& )
+  {
+    if( fail_block )
+      FC_THROW_EXCEPTION( hive::chain::plugin_exception, "block rejected by test" );
+  }, *db_plugin, 0 );
+  const uint32_t failed_block_num = db->head_block_num() + 1;
+  BOOST_REQUIRE_THROW( generate_block(), fc::exception );
+  fail_block = false;
+  generate_block();
+  chain::util::disconnect_signal( failing_connection );
+  db->flush_async_notifications();
+
+  BOOST_REQUIRE_EQUAL( db->head_block_num(), failed_block_num );
+  BOOST_REQUIRE_EQUAL( blocks.size(), 3u );
+  BOOST_REQUIRE_EQUAL( blocks.back(), failed_block_num );
+
+  chain::util::disconnect_signal( connection );
+  generate_block();
+  db->flush_async_notifications();
+  BOOST_REQUIRE_EQUAL( blocks.size(), 3u );
+}
+
 BOOST_AUTO_TEST_CASE( curation_weight_test )
 {
   fc::uint128_t rshares = 856158;
@@ -678,12 +851,14 @@ BOOST_AUTO_TEST_CASE( chain_object_size )
 
   //top RAM gluttons
   BOOST_CHECK_EQUAL( sizeof( comment_object ), 32u ); //85M+ growing fast
-  BOOST_CHECK_EQUAL( sizeof( comment_index::MULTIINDEX_NODE_TYPE ), 96u );
+  BOOST_CHECK_EQUAL( sizeof( comment_index::MULTIINDEX_NODE_TYPE ), 80u );
 
   //permanent objects (no operation to remove)
   BOOST_CHECK_EQUAL( alignof( account_object ), 16u );
-  BOOST_CHECK_EQUAL( sizeof( account_object ), 464u ); //1.3M+
-  BOOST_CHECK_EQUAL( sizeof( account_index::MULTIINDEX_NODE_TYPE ), 656u );
+  BOOST_CHECK_EQUAL( sizeof( account_object ), 448u ); //1.3M+
+  BOOST_CHECK_EQUAL( sizeof( account_index::MULTIINDEX_NODE_TYPE ), 640u );
+  BOOST_CHECK_EQUAL( sizeof( account_cold_object ), 24u ); //as many as account_object
+  BOOST_CHECK_EQUAL( sizeof( account_cold_index::MULTIINDEX_NODE_TYPE ), 56u );
   BOOST_CHECK_EQUAL( sizeof( account_metadata_object ), 72u ); //as many as account_object, but only FatNode (also to be moved to HiveMind)
   BOOST_CHECK_EQUAL( sizeof( account_metadata_index::MULTIINDEX_NODE_TYPE ), 136u );
   BOOST_CHECK_EQUAL( sizeof( account_authority_object ), 248u ); //as many as account_object
@@ -1143,7 +1318,7 @@ BOOST_AUTO_TEST_CASE( decoding_types_mechanism_test )
     BOOST_CHECK( decoded_account_object.reflected );
     BOOST_CHECK( !decoded_account_object.enum_values );
     BOOST_CHECK( decoded_account_object.members );
-    BOOST_CHECK_EQUAL( decoded_account_object.members->size(), 56 );
+    BOOST_CHECK_EQUAL( decoded_account_object.members->size(), 51 );
   }
 
   BOOST_CHECK_EQUAL( dtds.get_decoded_types_data_map().size(), 28 ); // decoded types map size shouldn't change.
@@ -1368,8 +1543,9 @@ BOOST_AUTO_TEST_CASE( chain_object_checksum )
 {
   hive::chain::util::decoded_types_data_storage dtds;
 
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_object>(dtds), "86fa5e3d02041e521715798ae0b7fb4c22182895" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_metadata_object>(dtds), "8a8a73c8a77292e0685109e0caf6040da28ba70c" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_object>(dtds), "cf1c4ae06f4b1408634273aebe944fe3a932f37c" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_cold_object>(dtds), "d2a6220cf9c96cde966015f156ef94a9e3a09795" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_metadata_object>(dtds), "f4a3c40773ce88ba526573fcb223c3e9669b5225" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::account_authority_object>(dtds), "e492c85b420461ce856b14b80edb3649e4996d86" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::vesting_delegation_object>(dtds), "2c140c595e4a83e6aab21cb3090816206b07a5ad" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::vesting_delegation_expiration_object>(dtds), "cf8a309d076970b83c8e7ada88b01277a43dc726" );
@@ -1380,24 +1556,24 @@ BOOST_AUTO_TEST_CASE( chain_object_checksum )
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_object>(dtds), "705a6ee8b2cb1412a29b1ef317e80700b4c7f8b4" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_cashout_ex_object>(dtds), "20fb8b1b3f2a3e8f421ee9b2f4e71cfaa78215b9" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_vote_object>(dtds), "9eac7ca680beea20c545fb03872fb6737cfcebbb" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::proposal_object>(dtds), "49c819c3e8e1be22d21cd22c83560aedbd84546b" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::proposal_object>(dtds), "7adeb28c7b3bda2d931e310b68d1ddb03019059d" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::proposal_vote_object>(dtds), "051b5701bcff97241e81b5c5b2b0218fcac6430d" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::hardfork_property_object>(dtds), "4ecdccee8197fee89331b329ee3f79f143299fea" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::hardfork_property_object>(dtds), "647c4bfac7dab115d675718e8849a9a3d4e60ce2" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::convert_request_object>(dtds), "c6900c99e4d305d0e6a387b9078a06b182e1f9fb" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::collateralized_convert_request_object>(dtds), "dd45554db965f67de4942d51bca7701102daf896" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::escrow_object>(dtds), "c899b91d955519006f5c1f4882730fa716b856e8" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::savings_withdraw_object>(dtds), "7fd02375eac9da2cf26146b2ab7ae9d59bb6d69c" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::savings_withdraw_object>(dtds), "90257846dab066ad10a625bdd325190875edd930" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::liquidity_reward_balance_object>(dtds), "3690a7914aba1105d390489d52328478445a0d29" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::feed_history_object>(dtds), "b78938588bbe8bc33afe39568f179fd824d1d120" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::feed_history_object>(dtds), "d17a2557400cf64278d6e5eb4119f1d9e225eab7" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::limit_order_object>(dtds), "c5472f97a5dc2843f779244110f680e84bbd6b7f" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::withdraw_vesting_route_object>(dtds), "b70b71dab160c4a5fc2f7f896ec85e22e183cce6" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::decline_voting_rights_request_object>(dtds), "4a7b6e131317bdbf49e169e959f913c5e837fdaa" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::reward_fund_object>(dtds), "0e5d4c0a0526b36c8216fcd97db675653f614e2b" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::recurrent_transfer_object>(dtds), "d3196040e50d8e61e8efff85623030d985f6e6f2" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::recurrent_transfer_object>(dtds), "7417631843ec4712dae97eca748f673e96e81a7a" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::transaction_object>(dtds), "e731dc38c978db7dc455b5d7b58680534ece0d98" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::witness_vote_object>(dtds), "3e0889f0fb4a54d281437774045bc9344680bc11" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::witness_schedule_object>(dtds), "28d7d6f26a28bed89b63cf2b8fec1594f9172b55" );
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::witness_object>(dtds), "1c1479858305c40a498663d3b90062e3a7218d73" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::witness_object>(dtds), "d4dda4dd63d251fa9ff42c38d6d37e07b54f9e80" );
 
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::rc_resource_param_object>(dtds), "2b3f6a9591921bd096abd944cbd69a4bb651031f" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::rc_pool_object>(dtds), "4c8c3f7ac723bbc93053bbbc56cca22e6b4febad" );
@@ -1413,11 +1589,11 @@ BOOST_AUTO_TEST_CASE( chain_object_checksum )
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::smt_contribution_object>(dtds), "6a9298578cec55f96e3335d5417dbf041e3532f8" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::smt_ico_object>(dtds), "6934ff28d7e63986e06dcfc9f3859095b978feca" );
 
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_cashout_object>(dtds), "2b3524a7e3cae469e96f8d9efccc6c97ac6d3730" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_cashout_object>(dtds), "cd434bf3ae6a302e0bf19f5d923e2384093adeb4" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::dynamic_global_property_object>(dtds), "c2d37e4721f3b90ac5022ab661a08d065117097f" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::rc_stats_object>(dtds), "e8f7efb3092823f37935d3bd8bcae963b0151d7c" );
   #else
-  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_cashout_object>(dtds), "38b356fdf295b2a709ac9d77b94fbe0fcd3c9267" );
+  BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::comment_cashout_object>(dtds), "4890203bcd68becbd7b6e224b1a1ce2032de20f3" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::dynamic_global_property_object>(dtds), "3cb44980ad38710ceb0099de520239dd03a0b3ce" );
   BOOST_CHECK_EQUAL( get_decoded_type_checksum<hive::chain::rc_stats_object>(dtds), "5ecebd9e709ff9f511dc2600e72c071e022223ca" );
   #endif
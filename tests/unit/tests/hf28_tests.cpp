@@ -331,7 +331,10 @@ BOOST_AUTO_TEST_CASE( declined_voting_rights_between_hf27_and_hf28 )
 
         BOOST_TEST_MESSAGE("Create accounts.");
         for( auto& account : _accounts )
-          executor->db->create< account_object >( account, _ht );
+        {
+          const auto& new_account = executor->db->create< account_object >( account );
+          executor->db->create< account_cold_object >( new_account, _ht );
+        }
       }
       {
         if( level == 1 )
@@ -135,7 +135,7 @@ BOOST_AUTO_TEST_CASE( account_create_apply )
     BOOST_REQUIRE( acct_auth.active == authority( 2, priv_key.get_public_key(), 2 ) );
     BOOST_REQUIRE( acct.memo_key == priv_key.get_public_key() );
     CHECK_NO_PROXY( acct );
-    BOOST_REQUIRE( acct.get_creation_time() == db->head_block_time() );
+    BOOST_REQUIRE( db->get_account_cold( acct ).get_creation_time() == db->head_block_time() );
     BOOST_REQUIRE( acct.get_balance().amount.value == ASSET( "0.000 TESTS" ).amount.value );
     BOOST_REQUIRE( acct.get_hbd_balance().amount.value == ASSET( "0.000 TBD" ).amount.value );
     BOOST_REQUIRE( acct.get_id().get_value() == acct_auth.get_id().get_value() );
@@ -154,7 +154,7 @@ BOOST_AUTO_TEST_CASE( account_create_apply )
     BOOST_REQUIRE( acct_auth.active == authority( 2, priv_key.get_public_key(), 2 ) );
     BOOST_REQUIRE( acct.memo_key == priv_key.get_public_key() );
     CHECK_NO_PROXY( acct );
-    BOOST_REQUIRE( acct.get_creation_time() == db->head_block_time() );
+    BOOST_REQUIRE( db->get_account_cold( acct ).get_creation_time() == db->head_block_time() );
     BOOST_REQUIRE( acct.get_balance().amount.value == ASSET( "0.000 TESTS " ).amount.value );
     BOOST_REQUIRE( acct.get_hbd_balance().amount.value == ASSET( "0.000 TBD" ).amount.value );
     BOOST_REQUIRE( acct.get_vesting().amount.value == 0 );
@@ -199,7 +199,7 @@ BOOST_AUTO_TEST_CASE( account_create_apply )
     tx.operations.push_back( op );
     push_transaction( tx );
 
-    BOOST_REQUIRE( !db->get_account( "bob" ).has_recovery_account() );
+    BOOST_REQUIRE( !db->get_account_cold( db->get_account( "bob" ) ).has_recovery_account() );
     validate_database();
 
   }
@@ -8953,8 +8953,8 @@ BOOST_AUTO_TEST_CASE( create_claimed_account_apply )
     BOOST_REQUIRE( bob_meta.json_metadata == "{\"foo\":\"bar\"}" );
 #endif
     CHECK_NO_PROXY( bob );
-    BOOST_REQUIRE( bob.get_recovery_account() == alice_id );
-    BOOST_REQUIRE( bob.get_creation_time() == db->head_block_time() );
+    BOOST_REQUIRE( db->get_account_cold( bob ).get_recovery_account() == alice_id );
+    BOOST_REQUIRE( db->get_account_cold( bob ).get_creation_time() == db->head_block_time() );
     BOOST_REQUIRE( bob.get_balance().amount.value == ASSET( "0.000 TESTS" ).amount.value );
     BOOST_REQUIRE( bob.get_hbd_balance().amount.value == ASSET( "0.000 TBD" ).amount.value );
     BOOST_REQUIRE( bob.get_vesting().amount.value == ASSET( "0.000000 VESTS" ).amount.value );
@@ -8986,7 +8986,7 @@ BOOST_AUTO_TEST_CASE( create_claimed_account_apply )
     tx.operations.push_back( op );
     push_transaction( tx );
 
-    BOOST_REQUIRE( !db->get_account( "charlie" ).has_recovery_account() );
+    BOOST_REQUIRE( !db->get_account_cold( db->get_account( "charlie" ) ).has_recovery_account() );
     validate_database();
   }
   FC_LOG_AND_RETHROW()
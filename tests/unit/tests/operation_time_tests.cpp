@@ -149,6 +149,91 @@ BOOST_AUTO_TEST_CASE( comment_payout_equalize )
   FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( comment_payout_parallel_computation )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing: comment payouts computed on multiple threads" );
+
+    ACTORS( (ulysses)(vivian)(wendy) )
+
+    // set a ridiculously high HIVE price ($1 / satoshi) to disable dust threshold
+    set_price_feed( price( ASSET( "1.000 TBD" ), ASSET( "0.001 TESTS" ) ) );
+
+    std::vector< std::pair< std::string, fc::ecc::private_key > > voters = {
+      { "ulysses", ulysses_private_key }, { "vivian", vivian_private_key }, { "wendy", wendy_private_key } };
+    for( const auto& voter : voters )
+      vest( voter.first, ASSET( "10.000 TESTS" ) );
+
+    // enough comments to engage more than one thread
+    const size_t author_count = 64;
+    std::vector< std::string > authors;
+    for( size_t i = 0; i < author_count; ++i )
+    {
+      std::string name = "author" + std::to_string( i );
+      auto key = generate_private_key( name );
+      account_create( name, key.get_public_key(), generate_private_key( name + "_post" ).get_public_key() );
+      post_comment( name, "mypost", "title", "body", "test", key );
+      authors.push_back( name );
+    }
+    generate_blocks(1);
+
+    // votes of different strength so curation claims differ between comments
+    for( size_t i = 0; i < author_count; ++i )
+      for( const auto& voter : voters )
+        vote( authors[i], "mypost", voter.first, HIVE_100_PERCENT - int16_t( i % 7 ) * HIVE_1_PERCENT, voter.second );
+    generate_blocks(10);
+
+    std::vector< std::string > accounts = authors;
+    for( const auto& voter : voters )
+      accounts.push_back( voter.first );
+    auto get_payout_results = [&]()
+    {
+      std::vector< std::string > results;
+      for( const auto& name : accounts )
+      {
+        const auto& account = db->get_account( name );
+        results.push_back( fc::json::to_string( fc::mutable_variant_object()
+          ( "balance", account.get_balance() )( "hbd_balance", account.get_hbd_balance() )( "vesting", account.get_vesting() )
+          ( "rewards", account.get_rewards() )( "hbd_rewards", account.get_hbd_rewards() )( "vest_rewards", account.get_vest_rewards() )
+          ( "posting_rewards", account.posting_rewards )( "curation_rewards", account.curation_rewards ) ) );
+      }
+      // virtual operations of payout block (and some older ones, which are the same in both runs anyway)
+      results.push_back( fc::json::to_string( get_last_operations( 1000 ) ) );
+      return results;
+    };
+
+    const auto cashout_time = db->find_comment_cashout( db->get_comment( authors.front(), string( "mypost" ) ) )->get_cashout_time();
+    const auto before_payout = get_payout_results();
+
+    db->set_comment_cashout_threads( 4 );
+    generate_blocks( cashout_time, true );
+    const auto parallel_payout = get_payout_results();
+    for( const auto& author : authors )
+    {
+      BOOST_REQUIRE( db->find_comment_cashout( db->get_comment( author, string( "mypost" ) ) ) == nullptr );
+      BOOST_REQUIRE( db->get_account( author ).posting_rewards.amount > 0 );
+    }
+    for( const auto& voter : voters )
+      BOOST_REQUIRE( db->get_account( voter.first ).curation_rewards.amount > 0 );
+    validate_database();
+
+    // the same block produced again with serial computation has to give identical balances and virtual operations
+    db->pop_block();
+    BOOST_REQUIRE( get_payout_results() == before_payout );
+    db->set_comment_cashout_threads( 0 );
+    generate_blocks( cashout_time, true );
+    const auto serial_payout = get_payout_results();
+    BOOST_REQUIRE_EQUAL( serial_payout.size(), parallel_payout.size() );
+    for( size_t i = 0; i < serial_payout.size(); ++i )
+      BOOST_REQUIRE_EQUAL( serial_payout[i], parallel_payout[i] );
+    BOOST_REQUIRE( serial_payout != before_payout );
+
+    validate_database();
+  }
+  FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( comment_payout_dust )
 {
   try
@@ -66,4 +66,37 @@ BOOST_AUTO_TEST_CASE(bad_object) {
   BOOST_TEST_MESSAGE("End of static_variant type checks");
 }
 
+struct tag_visitor
+{
+  typedef int64_t result_type;
+
+  template<typename Type>
+  result_type operator()( const Type& op )const { return hive::protocol::operation::tag< Type >::value; }
+};
+
+BOOST_AUTO_TEST_CASE( dispatch_to_proper_type ) {
+  try {
+    BOOST_TEST_MESSAGE( "Checking static_variant dispatch for every operation type" );
+    tag_visitor visitor;
+    for( int64_t type_id = 0; type_id < hive::protocol::operation::count(); ++type_id )
+    {
+      hive::protocol::operation op( type_id );
+      BOOST_REQUIRE_EQUAL( op.visit( visitor ), type_id );
+
+      hive::protocol::operation copy( op );
+      BOOST_REQUIRE_EQUAL( copy.visit( visitor ), type_id );
+
+      hive::protocol::operation moved( std::move( copy ) );
+      BOOST_REQUIRE_EQUAL( moved.visit( visitor ), type_id );
+
+      const hive::protocol::operation& const_op = moved;
+      BOOST_REQUIRE_EQUAL( const_op.visit( visitor ), type_id );
+    }
+
+    BOOST_REQUIRE_THROW( hive::protocol::operation invalid( hive::protocol::operation::count() ), fc::assert_exception );
+    BOOST_REQUIRE_THROW( hive::protocol::operation invalid( int64_t( -1 ) ), fc::assert_exception );
+  }
+  FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -143,6 +143,20 @@ private: //just because it is (almost unused) part of signal registration
   virtual void plugin_shutdown() override {}
 };
 
+struct operation_counter : appbase::plugin< operation_counter >
+{
+  std::map< int64_t, uint32_t > all_operations;
+  std::map< int64_t, uint32_t > typed_operations;
+
+  static const std::string& name() { static std::string name = "test_counter"; return name; }
+private: //just because it is (almost unused) part of signal registration
+  virtual void set_program_options( appbase::options_description& cli, appbase::options_description& cfg ) override {}
+  virtual void plugin_for_each_dependency( plugin_processor&& processor ) override {}
+  virtual void plugin_initialize( const appbase::variables_map& options ) override {}
+  virtual void plugin_startup() override {}
+  virtual void plugin_shutdown() override {}
+};
+
 BOOST_FIXTURE_TEST_SUITE( tx_status_tests, clean_database_fixture )
 
 BOOST_AUTO_TEST_CASE( regular_transactions )
@@ -730,5 +744,75 @@ BOOST_AUTO_TEST_CASE( failure_during_fork_switch )
   FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( typed_operation_handlers )
+{
+  try
+  {
+    BOOST_TEST_MESSAGE( "Testing operation handlers registered for selected operation types" );
+
+    ACTORS( (alice)(bob) )
+    fund( "alice", ASSET( "10.000 TESTS" ) );
+    generate_block();
+
+    const int64_t transfer_type = operation::tag< transfer_operation >::value;
+    const int64_t comment_type = operation::tag< comment_operation >::value;
+    const int64_t vote_type = operation::tag< vote_operation >::value;
+
+    operation_counter counter;
+    auto all_conn = db->add_post_apply_operation_handler( [&]( const operation_notification& note )
+      { ++counter.all_operations[ note.op.which() ]; }, counter, 0 );
+    auto typed_conn = db->add_post_apply_operation_handler( [&]( const operation_notification& note )
+      { ++counter.typed_operations[ note.op.which() ]; },
+      database::make_operation_type_set< transfer_operation, comment_operation >(), counter, 0 );
+    auto vote_conn = db->add_pre_apply_operation_handler( [&]( const operation_notification& note )
+      { ++counter.typed_operations[ note.op.which() ]; },
+      database::make_operation_type_set< vote_operation >(), counter, 0 );
+    BOOST_SCOPE_EXIT( &all_conn, &typed_conn, &vote_conn )
+    {
+      chain::util::disconnect_signal( all_conn );
+      chain::util::disconnect_signal( typed_conn );
+      chain::util::disconnect_signal( vote_conn );
+    } BOOST_SCOPE_EXIT_END
+
+    transfer_operation transfer;
+    transfer.from = "alice";
+    transfer.to = "bob";
+    transfer.amount = ASSET( "1.000 TESTS" );
+    push_transaction( transfer, alice_private_key );
+
+    comment_operation comment;
+    comment.parent_permlink = "typed";
+    comment.author = "alice";
+    comment.permlink = "test";
+    comment.title = "no title";
+    comment.body = "empty";
+    push_transaction( comment, alice_private_key );
+    generate_block();
+
+    BOOST_REQUIRE_GT( counter.all_operations[ transfer_type ], 0u );
+    BOOST_REQUIRE_GT( counter.all_operations[ comment_type ], 0u );
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.count( transfer_type ), 1u );
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.count( comment_type ), 1u );
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.at( transfer_type ), counter.all_operations.at( transfer_type ) );
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.at( comment_type ), counter.all_operations.at( comment_type ) );
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.count( vote_type ), 0u );
+    // virtual operations of produced blocks reached only the handler of all operations
+    for( const auto& entry : counter.typed_operations )
+      BOOST_REQUIRE( entry.first == transfer_type || entry.first == comment_type );
+    BOOST_REQUIRE_GT( counter.all_operations.size(), 2u );
+
+    BOOST_TEST_MESSAGE( "Disconnected typed handler is no longer called" );
+    chain::util::disconnect_signal( typed_conn );
+    const uint32_t typed_transfers = counter.typed_operations.at( transfer_type );
+    transfer.amount = ASSET( "2.000 TESTS" );
+    push_transaction( transfer, alice_private_key );
+    generate_block();
+    BOOST_REQUIRE_EQUAL( counter.typed_operations.at( transfer_type ), typed_transfers );
+    BOOST_REQUIRE_GT( counter.all_operations.at( transfer_type ), typed_transfers );
+
+    validate_database();
+  }
+  FC_LOG_AND_RETHROW()
+}
 
 BOOST_AUTO_TEST_SUITE_END()